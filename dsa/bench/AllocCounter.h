@@ -0,0 +1,53 @@
+#ifndef ALLOCCOUNTER
+#define ALLOCCOUNTER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// AllocCounter replaces the global operator new and delete with versions that count allocations and live heap bytes.
+// Because it defines the replacement operators it must be included by exactly one translation unit per program.
+//
+// Live bytes are measured with malloc_usable_size so that both the allocation and the matching free see the same size
+// regardless of which form of operator delete is called. Adding malloc's per chunk header gives the real heap footprint,
+// which is what matters when comparing a container that allocates per element with one that doesn't.
+struct AllocCounter{
+    static const std::size_t CHUNK_HEADER = sizeof(std::size_t);
+
+    static std::atomic<std::uint64_t>& allocations(){
+        static std::atomic<std::uint64_t> count{0};
+        return count;
+    }
+    static std::atomic<std::int64_t>& live_bytes(){
+        static std::atomic<std::int64_t> bytes{0};
+        return bytes;
+    }
+};
+
+inline void* alloc_counter_allocate(std::size_t size){
+    void* ptr = std::malloc(size ? size : 1);
+    if(ptr == nullptr){
+        throw std::bad_alloc();
+    }
+    AllocCounter::allocations().fetch_add(1, std::memory_order_relaxed);
+    AllocCounter::live_bytes().fetch_add(malloc_usable_size(ptr) + AllocCounter::CHUNK_HEADER, std::memory_order_relaxed);
+    return ptr;
+}
+inline void alloc_counter_free(void* ptr){
+    if(ptr != nullptr){
+        AllocCounter::live_bytes().fetch_sub(malloc_usable_size(ptr) + AllocCounter::CHUNK_HEADER, std::memory_order_relaxed);
+        std::free(ptr);
+    }
+}
+
+void* operator new(std::size_t size){return alloc_counter_allocate(size);}
+void* operator new[](std::size_t size){return alloc_counter_allocate(size);}
+void  operator delete(void* ptr) noexcept{alloc_counter_free(ptr);}
+void  operator delete[](void* ptr) noexcept{alloc_counter_free(ptr);}
+void  operator delete(void* ptr, std::size_t) noexcept{alloc_counter_free(ptr);}
+void  operator delete[](void* ptr, std::size_t) noexcept{alloc_counter_free(ptr);}
+
+#endif
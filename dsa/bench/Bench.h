@@ -0,0 +1,123 @@
+#ifndef BENCH
+#define BENCH
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Small helpers shared by the benchmark programs in this directory. Each benchmark is its own executable built by the
+// bench target in test/Makefile.
+
+// do_not_optimize forces the compiler to materialise value, so that a benchmark loop whose result is otherwise unused
+// isn't optimised away.
+template <class T>
+inline void do_not_optimize(const T& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class BenchTimer{
+private:
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    BenchTimer() : m_start(std::chrono::steady_clock::now()){};
+
+    void reset(){m_start = std::chrono::steady_clock::now();}
+    double elapsed_ns() const{
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count();
+    }
+    double elapsed_s() const{
+        return elapsed_ns() * 1e-9;
+    }
+};
+
+// pin_thread binds the calling thread to a CPU so that thread to thread benchmarks measure the same core placement on
+// every run. cpu is taken modulo the number of CPUs, so on a small machine threads share cores rather than failing.
+inline bool pin_thread(unsigned cpu){
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % cpus, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// Prints one result row: the benchmark name, the number of operations and the time per operation.
+inline void print_result(const char* name, std::uint64_t operations, double elapsed_ns){
+    std::printf("%-48s %12llu ops %10.2f ns/op %14.0f ops/s\n", name, (unsigned long long)operations,
+                elapsed_ns / operations, operations / (elapsed_ns * 1e-9));
+}
+
+// The given percentile (0 to 1) of a sorted, non empty set of samples.
+inline double percentile(const std::vector<double>& sorted, double fraction){
+    return sorted[std::min(sorted.size() - 1, std::size_t(fraction * sorted.size()))];
+}
+
+// Prints the 50th, 99th and 99.9th percentile and the maximum of a set of latency samples in nanoseconds. The samples
+// are sorted in place.
+inline void print_latency(const char* name, std::vector<double>& samples){
+    if(samples.empty()){
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    std::printf("%-48s %12zu samples p50 %10.0f ns p99 %10.0f ns p99.9 %10.0f ns max %10.0f ns\n", name,
+                samples.size(), percentile(samples, 0.5), percentile(samples, 0.99), percentile(samples, 0.999),
+                samples.back());
+}
+
+// BenchJson collects result rows and writes them out as a single JSON document, so that the results of a run can be
+// kept and compared with a run of another commit. Rows are written in the order they were added and a benchmark adds
+// them in a fixed order, so two files line up row for row under a plain diff. Each row is a flat object of its name
+// and named numbers.
+class BenchJson{
+private:
+    struct Row{
+        std::string                                 m_name;
+        std::vector<std::pair<std::string, double>> m_values;
+    };
+    std::vector<Row> m_rows;
+
+    static void write_string(std::FILE* file, const std::string& text){
+        std::fputc('"', file);
+        for(char c : text){
+            if(c == '"' || c == '\\'){
+                std::fputc('\\', file);
+            }
+            std::fputc(c, file);
+        }
+        std::fputc('"', file);
+    }
+
+public:
+    void add(const std::string& name, std::vector<std::pair<std::string, double>> values){
+        m_rows.push_back(Row{name, std::move(values)});
+    }
+
+    bool write(const char* path) const{
+        std::FILE* file = std::fopen(path, "w");
+        if(file == nullptr){
+            return false;
+        }
+        std::fprintf(file, "{\"benchmarks\": [");
+        for(std::size_t i = 0; i < m_rows.size(); ++i){
+            std::fprintf(file, i ? ",\n  {\"name\": " : "\n  {\"name\": ");
+            write_string(file, m_rows[i].m_name);
+            for(const std::pair<std::string, double>& value : m_rows[i].m_values){
+                std::fprintf(file, ", ");
+                write_string(file, value.first);
+                std::fprintf(file, ": %.6g", value.second);
+            }
+            std::fprintf(file, "}");
+        }
+        std::fprintf(file, "\n]}\n");
+        return std::fclose(file) == 0;
+    }
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef PERFCOUNTERS
+#define PERFCOUNTERS
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// PerfCounters reads the CPU's hardware performance counters for the calling thread through perf_event_open, so that a
+// benchmark can say why something is slow as well as how slow: cycles and instructions (and so IPC), L1 data cache and
+// last level cache misses, branch mispredictions and data TLB misses.
+//
+// Each counter is opened on its own rather than as one group, so that a counter the CPU or kernel doesn't have (or
+// isn't allowed to give out: perf_event_paranoid above 2, a container without the syscall, a VM without a virtual PMU)
+// just reads as unavailable and the rest still work. Counters only count user space, which is all an unprivileged
+// process may see under the default paranoid setting of 2. When there are more counters than the PMU has registers the
+// kernel multiplexes them, and the values are scaled up by the fraction of time each one was actually counting.
+//
+// The counters run only between start() and stop(), and counts accumulate over every start/stop pair until reset(). The
+// start and stop calls are a system call per counter each, so they belong around a whole timed loop rather than inside
+// it. reset() doesn't zero the kernel's counts: PERF_EVENT_IOC_RESET clears the value but not the enabled and running
+// times that scaling uses, so reset() records a baseline reading instead and values are scaled from the differences.
+class PerfCounters{
+public:
+    enum Counter{CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, NUM_COUNTERS};
+
+private:
+    struct Reading{
+        std::uint64_t m_value;
+        std::uint64_t m_time_enabled;
+        std::uint64_t m_time_running;
+    };
+
+    int     m_fds[NUM_COUNTERS];
+    Reading m_baseline[NUM_COUNTERS];     // Each counter's reading at the last reset.
+
+    static std::uint64_t cache_config(std::uint64_t cache, std::uint64_t op, std::uint64_t result){
+        return cache | op << 8 | result << 16;
+    }
+    static int open_counter(std::uint32_t type, std::uint64_t config){
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = type;
+        attr.config         = config;
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    bool read_counter(Counter counter, Reading& reading) const{
+        return m_fds[counter] >= 0 && read(m_fds[counter], &reading, sizeof(reading)) == ssize_t(sizeof(reading));
+    }
+
+public:
+    PerfCounters(){
+        std::uint64_t l1d_read_miss  = cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                                    PERF_COUNT_HW_CACHE_RESULT_MISS);
+        std::uint64_t dtlb_read_miss = cache_config(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                                    PERF_COUNT_HW_CACHE_RESULT_MISS);
+        m_fds[CYCLES]        = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        m_fds[INSTRUCTIONS]  = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        m_fds[L1D_MISSES]    = open_counter(PERF_TYPE_HW_CACHE, l1d_read_miss);
+        m_fds[LLC_MISSES]    = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        m_fds[BRANCH_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        m_fds[DTLB_MISSES]   = open_counter(PERF_TYPE_HW_CACHE, dtlb_read_miss);
+        reset();
+    }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters(){
+        for(int fd : m_fds){
+            if(fd >= 0){
+                close(fd);
+            }
+        }
+    }
+
+    static const char* name(Counter counter){
+        static const char* const names[NUM_COUNTERS] = {"cycles", "instructions", "l1d_misses", "llc_misses",
+                                                        "branch_misses", "dtlb_misses"};
+        return names[counter];
+    }
+
+    bool is_available(Counter counter) const {return m_fds[counter] >= 0;}
+    bool any_available() const{
+        for(int fd : m_fds){
+            if(fd >= 0){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void reset(){
+        for(int counter = 0; counter < NUM_COUNTERS; ++counter){
+            if(!read_counter(Counter(counter), m_baseline[counter])){
+                m_baseline[counter] = Reading{0, 0, 0};
+            }
+        }
+    }
+    void start(){
+        for(int fd : m_fds){
+            if(fd >= 0){
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+    void stop(){
+        for(int fd : m_fds){
+            if(fd >= 0){
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+    }
+
+    // The count since the last reset, or -1 if the counter is unavailable or never got scheduled onto the PMU.
+    double value(Counter counter) const{
+        Reading reading;
+        if(!read_counter(counter, reading)){
+            return -1;
+        }
+        const Reading& baseline = m_baseline[counter];
+        std::uint64_t running = reading.m_time_running - baseline.m_time_running;
+        if(running == 0){
+            return -1;
+        }
+        return double(reading.m_value - baseline.m_value) * double(reading.m_time_enabled - baseline.m_time_enabled) /
+               double(running);
+    }
+
+    // Instructions per cycle, and a count per operation; both are -1 when a counter they need is unavailable.
+    double ipc() const{
+        double cycles = value(CYCLES), instructions = value(INSTRUCTIONS);
+        return cycles > 0 && instructions >= 0 ? instructions / cycles : -1;
+    }
+    double per_op(Counter counter, std::uint64_t operations) const{
+        double count = value(counter);
+        return count >= 0 && operations > 0 ? count / double(operations) : -1;
+    }
+
+    // Prints one line of derived metrics for a benchmark row, indented under it: IPC, then cycles and each kind of miss
+    // per operation. Unavailable counters print as "-".
+    void print(std::uint64_t operations) const{
+        std::printf("%-56s", "");
+        print_number("IPC", ipc());
+        print_number("cycles/op", per_op(CYCLES, operations));
+        print_number("L1d/op", per_op(L1D_MISSES, operations));
+        print_number("LLC/op", per_op(LLC_MISSES, operations));
+        print_number("br/op", per_op(BRANCH_MISSES, operations));
+        print_number("dTLB/op", per_op(DTLB_MISSES, operations));
+        std::printf("\n");
+    }
+
+private:
+    static void print_number(const char* label, double number){
+        if(number < 0){
+            std::printf(" %s %8s", label, "-");
+        }else{
+            std::printf(" %s %8.3f", label, number);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,134 @@
+// Hand off latency of BlockingQueue in two regimes, against a naive mutex + condition variable queue that calls
+// notify_all on every push and never spins.
+//
+//  - idle: one item every 100us, so the consumer has usually gone to sleep by the time the item arrives. This measures
+//    the cost of waking a parked consumer.
+//  - saturated: producers push back to back and several consumers drain in batches. This measures throughput and the
+//    queueing delay when nobody should ever need to sleep.
+//
+// Each item carries its push timestamp and the consumer records now - timestamp.
+//
+// Usage: blocking_queue_bench [idle_items] [saturated_items]
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/BlockingQueue.h"
+
+static std::int64_t now_ns(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class NaiveQueue{
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::queue<std::int64_t> m_queue;
+
+public:
+    void push(std::int64_t value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push(value);
+        m_not_empty.notify_all();
+    }
+    std::size_t pop_many(std::vector<std::int64_t>& out, std::size_t max_count){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]{return !m_queue.empty();});
+        std::size_t count = 0;
+        while(count < max_count && !m_queue.empty()){
+            out.push_back(m_queue.front());
+            m_queue.pop();
+            count++;
+        }
+        return count;
+    }
+};
+
+// A negative timestamp tells a consumer to stop, and one is pushed for each consumer at the end.
+template <class Q>
+static void run(const char* name, const char* regime, std::size_t items, int producers, int consumers,
+                std::chrono::microseconds gap){
+    Q queue;
+    std::vector<std::vector<double>> latencies(consumers);
+    std::vector<std::thread> threads;
+    for(int c = 0; c < consumers; ++c){
+        threads.emplace_back([&, c]{
+            pin_thread(c + 1);
+            std::vector<std::int64_t> batch;
+            while(true){
+                batch.clear();
+                queue.pop_many(batch, 64);
+                std::int64_t received = now_ns();
+                int stops = 0;
+                for(std::int64_t stamp : batch){
+                    if(stamp < 0){
+                        stops++;
+                    }else{
+                        latencies[c].push_back(double(received - stamp));
+                    }
+                }
+                if(stops){
+                    // A batch can sweep up other consumers' stop markers too, so hand the extras back.
+                    for(int i = 1; i < stops; ++i){
+                        queue.push(-1);
+                    }
+                    return;
+                }
+            }
+        });
+    }
+
+    BenchTimer timer;
+    std::vector<std::thread> senders;
+    for(int p = 0; p < producers; ++p){
+        senders.emplace_back([&, p]{
+            pin_thread(consumers + 1 + p);
+            for(std::size_t i = 0; i < items / producers; ++i){
+                if(gap.count()){
+                    std::this_thread::sleep_for(gap);
+                }
+                queue.push(now_ns());
+            }
+        });
+    }
+    for(std::thread& sender : senders){
+        sender.join();
+    }
+    for(int c = 0; c < consumers; ++c){
+        queue.push(-1);
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    double ns = timer.elapsed_ns();
+
+    std::vector<double> all;
+    for(std::vector<double>& samples : latencies){
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/%s/throughput", name, regime);
+    print_result(label, all.size(), ns);
+    std::snprintf(label, sizeof(label), "%s/%s/latency", name, regime);
+    print_latency(label, all);
+}
+
+int main(int argc, char** argv){
+    std::size_t idle_items      = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000;
+    std::size_t saturated_items = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+
+    run<BlockingQueue<std::int64_t>>("BlockingQueue", "idle", idle_items, 1, 1, std::chrono::microseconds(100));
+    run<NaiveQueue>("naive_cv_queue", "idle", idle_items, 1, 1, std::chrono::microseconds(100));
+    run<BlockingQueue<std::int64_t>>("BlockingQueue", "saturated", saturated_items, 2, 4, std::chrono::microseconds(0));
+    run<NaiveQueue>("naive_cv_queue", "saturated", saturated_items, 2, 4, std::chrono::microseconds(0));
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Events per second through BroadcastRing with 1, 2, 4 and 8 consumers that each see every event, for each wait strategy,
+// against the fan out it replaces: the producer copying every event into one SPSCQueue per consumer.
+//
+// Events are 64 bytes. The producer claims and publishes up to BATCH events at a time, and consumers process whatever
+// is available in one go. BusySpinWait is only run when there is a core for every thread, since a spinning thread that
+// shares a core with the thread it waits for just delays it.
+//
+// Usage: broadcast_bench [events] [max_consumers]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/BroadcastRing.h"
+#include "../src/include/Concurrency.h"
+#include "../src/include/SPSCQueue.h"
+
+static const std::size_t CAPACITY = 4096;
+static const std::size_t BATCH = 64;
+
+struct Event{
+    std::uint64_t m_sequence;
+    std::uint64_t m_payload[7];
+};
+
+static void backoff(unsigned& spins){
+    if(++spins % 256 == 0){
+        std::this_thread::yield();
+    }else{
+        cpu_relax();
+    }
+}
+
+template <class WaitStrategy>
+static void run_ring(const char* name, std::size_t events, int consumers){
+    typedef BroadcastRing<Event, WaitStrategy> Ring;
+    Ring ring(CAPACITY);
+    std::vector<typename Ring::Consumer> handles;
+    for(int c = 0; c < consumers; ++c){
+        handles.push_back(ring.add_consumer());
+    }
+    std::vector<std::uint64_t> sums(consumers * 8, 0);     // Spaced out to keep the consumers' sums on separate lines.
+    std::vector<std::thread> threads;
+    for(int c = 0; c < consumers; ++c){
+        threads.emplace_back([&, c]{
+            pin_thread(c + 1);
+            std::uint64_t sum = 0;
+            for(std::size_t seen = 0; seen < events;){
+                seen += handles[c].consume([&](const Event& event, std::int64_t){sum += event.m_sequence + event.m_payload[6];});
+            }
+            sums[c * 8] = sum;
+        });
+    }
+
+    pin_thread(0);
+    BenchTimer timer;
+    for(std::size_t sent = 0; sent < events;){
+        std::size_t count = std::min(BATCH, events - sent);
+        std::int64_t first = ring.claim(count);
+        for(std::size_t i = 0; i < count; ++i){
+            Event& event = ring[first + std::int64_t(i)];
+            event.m_sequence   = sent + i;
+            event.m_payload[6] = i;
+        }
+        ring.publish(first + std::int64_t(count) - 1);
+        sent += count;
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sums[0]);
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "BroadcastRing<%s>/consumers:%d", name, consumers);
+    print_result(label, events, ns);
+}
+
+static void run_fan_out(std::size_t events, int consumers){
+    std::vector<std::unique_ptr<SPSCQueue<Event>>> queues;
+    for(int c = 0; c < consumers; ++c){
+        queues.emplace_back(new SPSCQueue<Event>(CAPACITY));
+    }
+    std::vector<std::uint64_t> sums(consumers * 8, 0);
+    std::vector<std::thread> threads;
+    for(int c = 0; c < consumers; ++c){
+        threads.emplace_back([&, c]{
+            pin_thread(c + 1);
+            std::vector<Event> out(BATCH);
+            std::uint64_t sum = 0;
+            unsigned spins = 0;
+            for(std::size_t seen = 0; seen < events;){
+                std::size_t count = queues[c]->pop_bulk(out.data(), BATCH);
+                if(count == 0){
+                    backoff(spins);
+                }
+                for(std::size_t i = 0; i < count; ++i){
+                    sum += out[i].m_sequence + out[i].m_payload[6];
+                }
+                seen += count;
+            }
+            sums[c * 8] = sum;
+        });
+    }
+
+    pin_thread(0);
+    std::vector<Event> batch(BATCH);
+    BenchTimer timer;
+    unsigned spins = 0;
+    for(std::size_t sent = 0; sent < events;){
+        std::size_t count = std::min(BATCH, events - sent);
+        for(std::size_t i = 0; i < count; ++i){
+            batch[i].m_sequence   = sent + i;
+            batch[i].m_payload[6] = i;
+        }
+        // Every queue gets its own copy of the batch.
+        for(int c = 0; c < consumers; ++c){
+            for(std::size_t pushed = 0; pushed < count;){
+                std::size_t n = queues[c]->push_bulk(batch.data() + pushed, count - pushed);
+                if(n == 0){
+                    backoff(spins);
+                }
+                pushed += n;
+            }
+        }
+        sent += count;
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sums[0]);
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "SPSCQueue_fan_out/consumers:%d", consumers);
+    print_result(label, events, ns);
+}
+
+int main(int argc, char** argv){
+    std::size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+    int max_consumers  = argc > 2 ? std::atoi(argv[2]) : 8;
+    int cores = int(std::thread::hardware_concurrency());
+
+    for(int consumers = 1; consumers <= max_consumers; consumers *= 2){
+        if(consumers + 1 <= cores){
+            run_ring<BusySpinWait>("BusySpinWait", events, consumers);
+        }else{
+            std::printf("BroadcastRing<BusySpinWait>/consumers:%d skipped, only %d cores\n", consumers, cores);
+        }
+        run_ring<YieldingWait>("YieldingWait", events, consumers);
+        run_ring<BlockingWait>("BlockingWait", events, consumers);
+        run_fan_out(events, consumers);
+    }
+    return 0;
+}
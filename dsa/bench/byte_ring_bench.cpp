@@ -0,0 +1,140 @@
+// Parse throughput of a newline delimited record stream buffered through MirroredByteRing, against a ring on a plain
+// buffer that has to copy its readable bytes out into a linear buffer before they can be parsed.
+//
+// The input is fed in chunks, as it would arrive from recv(). Both rings take each chunk with one memcpy, standing in for
+// the recv() itself. Then:
+//
+//  - MirroredByteRing parses straight out of read_data(), since every readable region is contiguous, and consumes up to
+//    the end of the last complete record.
+//  - CopyingRing copies everything readable (in two pieces when it wraps) into the parser's buffer, after the partial
+//    record left over from last time, parses that and moves the new partial record to the front.
+//
+// Each record is "<number>,<text>\n" and parsing sums the numbers.
+//
+// Usage: byte_ring_bench [megabytes]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/MirroredByteRing.h"
+
+static const std::size_t RING_CAPACITY = 64 * 1024;
+
+class CopyingRing{
+private:
+    std::vector<char> m_buffer;
+    std::uint64_t m_read;
+    std::uint64_t m_write;
+
+public:
+    explicit CopyingRing(std::size_t capacity) : m_buffer(capacity), m_read(0), m_write(0){};
+
+    std::size_t write(const char* bytes, std::size_t count){
+        std::size_t capacity = m_buffer.size();
+        count = std::min(count, capacity - std::size_t(m_write - m_read));
+        std::size_t offset = std::size_t(m_write % capacity);
+        std::size_t first = std::min(count, capacity - offset);
+        std::memcpy(m_buffer.data() + offset, bytes, first);
+        std::memcpy(m_buffer.data(), bytes + first, count - first);
+        m_write += count;
+        return count;
+    }
+    std::size_t read(char* bytes, std::size_t count){
+        std::size_t capacity = m_buffer.size();
+        count = std::min(count, std::size_t(m_write - m_read));
+        std::size_t offset = std::size_t(m_read % capacity);
+        std::size_t first = std::min(count, capacity - offset);
+        std::memcpy(bytes, m_buffer.data() + offset, first);
+        std::memcpy(bytes + first, m_buffer.data(), count - first);
+        m_read += count;
+        return count;
+    }
+};
+
+// Parses every complete record in [data, data + length), adding to sum and records, and returns the number of bytes
+// they take up.
+static std::size_t parse(const char* data, std::size_t length, std::uint64_t& sum, std::uint64_t& records){
+    const char* end = data + length;
+    const char* record = data;
+    while(true){
+        const char* newline = static_cast<const char*>(std::memchr(record, '\n', std::size_t(end - record)));
+        if(newline == nullptr){
+            break;
+        }
+        std::uint64_t number = 0;
+        for(const char* c = record; *c != ','; ++c){
+            number = number * 10 + std::uint64_t(*c - '0');
+        }
+        sum += number;
+        records++;
+        record = newline + 1;
+    }
+    return std::size_t(record - data);
+}
+
+static std::string make_stream(std::size_t bytes){
+    std::mt19937_64 rng(9);
+    std::string stream;
+    stream.reserve(bytes + 256);
+    while(stream.size() < bytes){
+        stream += std::to_string(rng() % 1000000);
+        stream += ',';
+        stream.append(8 + rng() % 120, 'a' + char(rng() % 26));
+        stream += '\n';
+    }
+    return stream;
+}
+
+static void report(const char* name, std::size_t chunk, std::size_t bytes, double ns, std::uint64_t records){
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/chunk:%zu", name, chunk);
+    print_result(label, records, ns);
+    std::printf("%-50s %10.1f MB/s\n", "", double(bytes) / ns * 1e3);
+}
+
+static void run_mirrored(const std::string& stream, std::size_t chunk){
+    MirroredByteRing ring(RING_CAPACITY);
+    std::uint64_t sum = 0, records = 0;
+    BenchTimer timer;
+    for(std::size_t fed = 0; fed < stream.size();){
+        fed += ring.write(stream.data() + fed, std::min(chunk, stream.size() - fed));
+        ring.consume(parse(ring.read_data(), ring.readable(), sum, records));
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    report("MirroredByteRing", chunk, stream.size(), ns, records);
+}
+
+static void run_copying(const std::string& stream, std::size_t chunk){
+    CopyingRing ring(RING_CAPACITY);
+    std::vector<char> linear(RING_CAPACITY * 2);
+    std::size_t pending = 0;
+    std::uint64_t sum = 0, records = 0;
+    BenchTimer timer;
+    for(std::size_t fed = 0; fed < stream.size();){
+        fed += ring.write(stream.data() + fed, std::min(chunk, stream.size() - fed));
+        pending += ring.read(linear.data() + pending, linear.size() - pending);
+        std::size_t parsed = parse(linear.data(), pending, sum, records);
+        std::memmove(linear.data(), linear.data() + parsed, pending - parsed);
+        pending -= parsed;
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    report("CopyingRing", chunk, stream.size(), ns, records);
+}
+
+int main(int argc, char** argv){
+    std::size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+    std::string stream = make_stream(megabytes << 20);
+    for(std::size_t chunk : {std::size_t(1500), std::size_t(16384), std::size_t(65536)}){
+        run_mirrored(stream, chunk);
+        run_copying(stream, chunk);
+    }
+    return 0;
+}
@@ -0,0 +1,415 @@
+// The container suite: List, Stack, Queue and HashTable against their std equivalents, for element counts from 100 up to
+// max_count in powers of ten and, for the element containers, 8 and 64 byte elements.
+//
+//  - List (against std::forward_list and std::list): insert after the first element, walk to the last element, and
+//    pop_front until empty.
+//  - Stack (against std::stack over std::deque and over std::vector): push count elements, then pop them all.
+//  - Queue (against std::queue over std::deque): fill_drain enqueues count elements then dequeues them all;
+//    steady_state keeps count elements queued and does count enqueue/dequeue pairs.
+//  - HashTable (against std::unordered_set<int>): insert count distinct keys, search for each of them, search for count
+//    absent keys, and remove every key.
+//
+// Every row repeats its workload on a fresh container until it has done at least min_ops operations, so that the small
+// counts are measured for as long as the large ones. Operations are timed in batches of 64 and each batch gives one
+// sample of the time per operation, from which the percentiles are taken (so p99 is the 99th percentile batch, which
+// smooths single slow operations, such as a growth, into their batch). The List walk is timed per walk. Allocations
+// per operation count the calls to operator new made by the timed operations only, not by the setup around them.
+//
+// Where perf_event_open gives access to the hardware counters, each row is followed by a line of IPC, cycles per
+// operation and cache, branch and dTLB misses per operation, counted over the timed loops only (see PerfCounters.h).
+// --no-counters turns them off; where they aren't available the rows are printed without them.
+//
+// The container_bench_stats build (-DDSA_HASHTABLE_STATS) follows each HashTable row with HashTable::dump_stats for the
+// table of the row's last round: probe counts, displacement, resizes and load factor, counted over the whole round,
+// setup included. Its timings carry the cost of gathering them, so compare rows within one build only.
+//
+// Rows whose name doesn't contain filter are skipped. With --json the results are also written to file, one object per
+// row, for comparing runs across commits. Counts of 1e7 and 1e8 need several gigabytes for the 64 byte elements.
+//
+// Usage: container_bench [max_count] [--min-ops N] [--filter text] [--json file] [--no-counters]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <forward_list>
+#include <iterator>
+#include <list>
+#include <queue>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "Bench.h"
+#include "PerfCounters.h"
+#include "../src/include/HashTable.h"
+#include "../src/include/List.h"
+#include "../src/include/Queue.h"
+#include "../src/include/Stack.h"
+
+template <std::size_t BYTES>
+struct Element{
+    std::uint64_t m_words[BYTES / 8];
+    Element() = default;
+    Element(std::uint64_t value){m_words[0] = value;}
+    std::uint64_t value() const {return m_words[0];}
+};
+
+struct Options{
+    std::size_t m_max_count = 1000000;
+    std::size_t m_min_ops   = 1000000;
+    const char* m_filter    = "";
+    const char* m_json      = nullptr;
+    bool        m_counters  = true;
+};
+
+static Options       options;
+static BenchJson     json;
+static PerfCounters* counters = nullptr;       // Null when the hardware counters are off or unavailable.
+
+static const std::size_t BATCH = 64;
+
+struct Measurement{
+    std::vector<double> m_samples;      // ns per operation of each timed batch.
+    std::uint64_t       m_operations = 0;
+    std::uint64_t       m_allocations = 0;
+    double              m_ns = 0;
+};
+
+// timed calls op(i) for i from 0 to count - 1 in batches of BATCH, taking one sample per batch.
+template <class Op>
+static void timed(Measurement& measurement, std::size_t count, Op&& op){
+    if(counters != nullptr){
+        counters->start();
+    }
+    for(std::size_t i = 0; i < count; i += BATCH){
+        std::size_t end = std::min(count, i + BATCH);
+        std::uint64_t allocations = AllocCounter::allocations().load(std::memory_order_relaxed);
+        BenchTimer timer;
+        for(std::size_t j = i; j < end; ++j){
+            op(j);
+        }
+        double ns = timer.elapsed_ns();
+        // The counter is read before push_back, which allocates whenever m_samples grows, so that only op's own
+        // allocations are counted.
+        measurement.m_allocations += AllocCounter::allocations().load(std::memory_order_relaxed) - allocations;
+        measurement.m_samples.push_back(ns / double(end - i));
+        measurement.m_ns += ns;
+    }
+    if(counters != nullptr){
+        counters->stop();
+    }
+    measurement.m_operations += count;
+}
+
+// run repeats round(count, measurement) until min_ops operations have been timed, then prints and records the row.
+template <class Round>
+static void run(const std::string& name, std::size_t count, Round&& round){
+    if(std::strstr(name.c_str(), options.m_filter) == nullptr){
+        return;
+    }
+    Measurement measurement;
+    if(counters != nullptr){
+        counters->reset();
+    }
+    do{
+        round(count, measurement);
+    }while(measurement.m_operations < options.m_min_ops);
+
+    std::vector<double>& samples = measurement.m_samples;
+    std::sort(samples.begin(), samples.end());
+    double ops           = double(measurement.m_operations);
+    double ns_per_op     = measurement.m_ns / ops;
+    double allocs_per_op = double(measurement.m_allocations) / ops;
+    double p50 = percentile(samples, 0.5), p99 = percentile(samples, 0.99), p999 = percentile(samples, 0.999);
+    std::printf("%-56s %12llu ops %9.2f ns/op %8.4f allocs/op p50 %8.2f p99 %8.2f p99.9 %8.2f ns\n", name.c_str(),
+                (unsigned long long)measurement.m_operations, ns_per_op, allocs_per_op, p50, p99, p999);
+    std::vector<std::pair<std::string, double>> values = {{"operations", ops}, {"ns_per_op", ns_per_op},
+                                                           {"allocs_per_op", allocs_per_op}, {"p50_ns", p50},
+                                                           {"p99_ns", p99}, {"p999_ns", p999}, {"max_ns", samples.back()}};
+    if(counters != nullptr){
+        counters->print(measurement.m_operations);
+        // Only the counters that could be read go into the JSON, so a missing key means unavailable rather than zero.
+        if(counters->ipc() >= 0){
+            values.emplace_back("ipc", counters->ipc());
+        }
+        for(int i = 0; i < PerfCounters::NUM_COUNTERS; ++i){
+            PerfCounters::Counter counter = PerfCounters::Counter(i);
+            double per_op = counters->per_op(counter, measurement.m_operations);
+            if(per_op >= 0){
+                values.emplace_back(std::string(PerfCounters::name(counter)) + "_per_op", per_op);
+            }
+        }
+    }
+    json.add(name, std::move(values));
+}
+
+static std::string row_name(const char* container, const char* test, std::size_t bytes, std::size_t count){
+    char name[128];
+    if(bytes){
+        std::snprintf(name, sizeof(name), "%s/%s/bytes:%zu/count:%zu", container, test, bytes, count);
+    }else{
+        std::snprintf(name, sizeof(name), "%s/%s/count:%zu", container, test, count);
+    }
+    return name;
+}
+
+
+// Lists. List has no iterators, so the walk is at(count - 1), which follows every link once.
+template <class T> struct DsaListOps{
+    List<T> m_list;
+    void seed(T value){m_list.push_back(value);}
+    void insert(T value){m_list.insert_back(value, 0);}
+    std::uint64_t walk(std::size_t count){return m_list.at(int(count) - 1).value();}
+    void pop_front(){m_list.pop_front();}
+};
+template <class T> struct ForwardListOps{
+    std::forward_list<T> m_list;
+    void seed(T value){m_list.push_front(value);}
+    void insert(T value){m_list.insert_after(m_list.begin(), value);}
+    std::uint64_t walk(std::size_t count){
+        auto node = m_list.begin();
+        for(std::size_t i = 1; i < count; ++i){
+            ++node;
+        }
+        return node->value();
+    }
+    void pop_front(){m_list.pop_front();}
+};
+template <class T> struct StdListOps{
+    std::list<T> m_list;
+    void seed(T value){m_list.push_front(value);}
+    void insert(T value){m_list.insert(std::next(m_list.begin()), value);}
+    std::uint64_t walk(std::size_t count){
+        auto node = m_list.begin();
+        for(std::size_t i = 1; i < count; ++i){
+            ++node;
+        }
+        return node->value();
+    }
+    void pop_front(){m_list.pop_front();}
+};
+
+template <class T, class Ops>
+static void run_list(const char* container, std::size_t count){
+    auto build = [](Ops& ops, std::size_t count){
+        ops.seed(T(0));
+        for(std::size_t i = 1; i < count; ++i){
+            ops.insert(T(i));
+        }
+    };
+    run(row_name(container, "insert", sizeof(T), count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        ops.seed(T(0));
+        timed(measurement, count - 1, [&](std::size_t i){ops.insert(T(i));});
+    });
+    run(row_name(container, "walk", sizeof(T), count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        build(ops, count);
+        if(counters != nullptr){
+            counters->start();
+        }
+        BenchTimer timer;
+        do_not_optimize(ops.walk(count));
+        double ns = timer.elapsed_ns();
+        if(counters != nullptr){
+            counters->stop();
+        }
+        measurement.m_samples.push_back(ns / double(count));
+        measurement.m_ns += ns;
+        measurement.m_operations += count;
+    });
+    run(row_name(container, "pop_front", sizeof(T), count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        build(ops, count);
+        timed(measurement, count, [&](std::size_t){ops.pop_front();});
+    });
+}
+
+
+// Stacks and queues.
+template <class T> struct DsaStackOps{
+    Stack<T> m_stack;
+    void push(T value){m_stack.push(value);}
+    T pop(){return m_stack.pop();}
+};
+template <class T, class Container> struct StdStackOps{
+    std::stack<T, Container> m_stack;
+    void push(T value){m_stack.push(value);}
+    T pop(){T value = m_stack.top(); m_stack.pop(); return value;}
+};
+template <class T> struct DsaQueueOps{
+    Queue<T> m_queue;
+    void push(T value){m_queue.enqueue(value);}
+    T pop(){return m_queue.dequeue();}
+};
+template <class T> struct StdQueueOps{
+    std::queue<T> m_queue;
+    void push(T value){m_queue.push(value);}
+    T pop(){T value = m_queue.front(); m_queue.pop(); return value;}
+};
+
+template <class T, class Ops>
+static void run_fill_drain(const char* container, const char* test, std::size_t count){
+    run(row_name(container, test, sizeof(T), count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        std::uint64_t sum = 0;
+        timed(measurement, count, [&](std::size_t i){ops.push(T(i));});
+        timed(measurement, count, [&](std::size_t){sum += ops.pop().value();});
+        do_not_optimize(sum);
+    });
+}
+template <class T, class Ops>
+static void run_steady_state(const char* container, std::size_t count){
+    run(row_name(container, "steady_state", sizeof(T), count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        std::uint64_t sum = 0;
+        for(std::size_t i = 0; i < count; ++i){
+            ops.push(T(i));
+        }
+        timed(measurement, count, [&](std::size_t i){
+            ops.push(T(i));
+            sum += ops.pop().value();
+        });
+        do_not_optimize(sum);
+    });
+}
+
+
+// Hash sets of ints. Key i is i times an odd constant modulo 2^31, which is a permutation of the non-negative ints, so
+// keys 0 to count - 1 are distinct, scattered, and disjoint from keys count to 2 count - 1 (the absent ones).
+static int key(std::size_t i){
+    return int((std::uint64_t(i) * 2654435761u) & 0x7fffffff);
+}
+struct DsaHashOps{
+    HashTable m_table{16};
+    void insert(int value){m_table.insert(value);}
+    bool contains(int value){return m_table.search(value) != -1;}
+    void erase(int value){m_table.remove(value);}
+    void keep_stats(std::string& stats) const{
+#ifdef DSA_HASHTABLE_STATS
+        std::ostringstream os;
+        m_table.dump_stats(os);
+        stats = os.str();
+#else
+        (void)stats;
+#endif
+    }
+};
+struct StdHashOps{
+    std::unordered_set<int> m_table;
+    void insert(int value){m_table.insert(value);}
+    bool contains(int value){return m_table.count(value) != 0;}
+    void erase(int value){m_table.erase(value);}
+    void keep_stats(std::string&) const{}
+};
+
+// Prints and clears the stats kept by the last round of a row, if there are any.
+static void print_stats(std::string& stats){
+    if(!stats.empty()){
+        std::fputs(stats.c_str(), stdout);
+        stats.clear();
+    }
+}
+
+template <class Ops>
+static void run_hash(const char* container, std::size_t count){
+    auto build = [](Ops& ops, std::size_t count){
+        for(std::size_t i = 0; i < count; ++i){
+            ops.insert(key(i));
+        }
+    };
+    std::string stats;
+    run(row_name(container, "insert", 0, count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        timed(measurement, count, [&](std::size_t i){ops.insert(key(i));});
+        ops.keep_stats(stats);
+    });
+    print_stats(stats);
+    run(row_name(container, "search_hit", 0, count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        build(ops, count);
+        std::size_t found = 0;
+        timed(measurement, count, [&](std::size_t i){found += ops.contains(key(i));});
+        do_not_optimize(found);
+        ops.keep_stats(stats);
+    });
+    print_stats(stats);
+    run(row_name(container, "search_miss", 0, count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        build(ops, count);
+        std::size_t found = 0;
+        timed(measurement, count, [&](std::size_t i){found += ops.contains(key(count + i));});
+        do_not_optimize(found);
+        ops.keep_stats(stats);
+    });
+    print_stats(stats);
+    run(row_name(container, "remove", 0, count), count, [&](std::size_t count, Measurement& measurement){
+        Ops ops;
+        build(ops, count);
+        timed(measurement, count, [&](std::size_t i){ops.erase(key(i));});
+        ops.keep_stats(stats);
+    });
+    print_stats(stats);
+}
+
+
+template <class T>
+static void run_elements(std::size_t count){
+    run_list<T, DsaListOps<T>>("List", count);
+    run_list<T, ForwardListOps<T>>("std::forward_list", count);
+    run_list<T, StdListOps<T>>("std::list", count);
+
+    run_fill_drain<T, DsaStackOps<T>>("Stack", "push_pop", count);
+    run_fill_drain<T, StdStackOps<T, std::deque<T>>>("std::stack<deque>", "push_pop", count);
+    run_fill_drain<T, StdStackOps<T, std::vector<T>>>("std::stack<vector>", "push_pop", count);
+
+    run_fill_drain<T, DsaQueueOps<T>>("Queue", "fill_drain", count);
+    run_fill_drain<T, StdQueueOps<T>>("std::queue", "fill_drain", count);
+    run_steady_state<T, DsaQueueOps<T>>("Queue", count);
+    run_steady_state<T, StdQueueOps<T>>("std::queue", count);
+}
+
+int main(int argc, char** argv){
+    for(int i = 1; i < argc; ++i){
+        if(std::strcmp(argv[i], "--min-ops") == 0 && i + 1 < argc){
+            options.m_min_ops = std::strtoull(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc){
+            options.m_filter = argv[++i];
+        }else if(std::strcmp(argv[i], "--json") == 0 && i + 1 < argc){
+            options.m_json = argv[++i];
+        }else if(std::strcmp(argv[i], "--no-counters") == 0){
+            options.m_counters = false;
+        }else{
+            options.m_max_count = std::strtoull(argv[i], nullptr, 10);
+        }
+    }
+
+    PerfCounters perf_counters;
+    if(options.m_counters){
+        if(perf_counters.any_available()){
+            counters = &perf_counters;
+        }else{
+            std::fprintf(stderr, "container_bench: no hardware counters available (perf_event_paranoid, container or VM "
+                                 "without a PMU), reporting time only\n");
+        }
+    }
+
+    for(std::size_t count = 100; count <= options.m_max_count; count *= 10){
+        run_elements<Element<8>>(count);
+        run_elements<Element<64>>(count);
+        run_hash<DsaHashOps>("HashTable", count);
+        run_hash<StdHashOps>("std::unordered_set", count);
+    }
+
+    if(options.m_json != nullptr && !json.write(options.m_json)){
+        std::fprintf(stderr, "container_bench: can't write %s\n", options.m_json);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Compares Deque<T> against std::deque<T> for a small (8 byte) and a large (1KB) T:
+//
+//  - push_back / push_front: fill from one end, then clear.
+//  - steady_state: push at the back, pop at the front, with a fixed number of elements in flight.
+//  - random_access: read n random indices.
+//
+// Each line also reports the heap allocations made per element pushed. For the 1KB type std::deque (libstdc++) uses one
+// element per block, so it allocates once per element, while Deque's default 16 element blocks allocate once per 16.
+//
+// Usage: deque_bench [operations]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "Bench.h"
+#include "../src/include/Deque.h"
+
+struct Large{
+    std::uint64_t m_words[128];
+    Large() = default;
+    explicit Large(std::uint64_t value){m_words[0] = value;}
+    std::uint64_t value() const {return m_words[0];}
+};
+static std::uint64_t value_of(std::uint64_t value){return value;}
+static std::uint64_t value_of(const Large& value){return value.value();}
+
+// Adapters so that one benchmark body can drive both containers.
+template <class T> struct DequeOps{
+    Deque<T> m_deque;
+    void push_back(T value){m_deque.push_back(std::move(value));}
+    void push_front(T value){m_deque.push_front(std::move(value));}
+    T pop_front(){return m_deque.pop_front();}
+    const T& operator[](std::size_t index) const {return m_deque[index];}
+};
+template <class T> struct StdDequeOps{
+    std::deque<T> m_deque;
+    void push_back(T value){m_deque.push_back(std::move(value));}
+    void push_front(T value){m_deque.push_front(std::move(value));}
+    T pop_front(){T value = std::move(m_deque.front()); m_deque.pop_front(); return value;}
+    const T& operator[](std::size_t index) const {return m_deque[index];}
+};
+
+static void report(const char* name, const char* test, std::size_t operations, double ns, std::uint64_t allocations){
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/%s", name, test);
+    print_result(label, operations, ns);
+    std::printf("%-50s %10.4f allocs/op\n", "", double(allocations) / double(operations));
+}
+
+template <class Ops, class T>
+static void run(const char* name, std::size_t operations){
+    std::uint64_t sum = 0;
+    for(bool front : {false, true}){
+        std::uint64_t allocations = AllocCounter::allocations().load();
+        BenchTimer timer;
+        {
+            Ops ops;
+            for(std::size_t i = 0; i < operations; ++i){
+                front ? ops.push_front(T(i)) : ops.push_back(T(i));
+            }
+            sum += value_of(ops[operations / 2]);
+        }
+        double ns = timer.elapsed_ns();
+        report(name, front ? "push_front" : "push_back", operations, ns, AllocCounter::allocations().load() - allocations);
+    }
+
+    {
+        Ops ops;
+        const std::size_t depth = 1000;
+        for(std::size_t i = 0; i < depth; ++i){
+            ops.push_back(T(i));
+        }
+        std::uint64_t allocations = AllocCounter::allocations().load();
+        BenchTimer timer;
+        for(std::size_t i = 0; i < operations; ++i){
+            ops.push_back(T(i));
+            sum += value_of(ops.pop_front());
+        }
+        double ns = timer.elapsed_ns();
+        report(name, "steady_state", operations, ns, AllocCounter::allocations().load() - allocations);
+    }
+
+    {
+        Ops ops;
+        for(std::size_t i = 0; i < operations; ++i){
+            ops.push_back(T(i));
+        }
+        std::mt19937_64 rng(1);
+        std::vector<std::size_t> indices(operations);
+        for(std::size_t& index : indices){
+            index = rng() % operations;
+        }
+        BenchTimer timer;
+        for(std::size_t index : indices){
+            sum += value_of(ops[index]);
+        }
+        double ns = timer.elapsed_ns();
+        report(name, "random_access", operations, ns, 0);
+    }
+    do_not_optimize(sum);
+}
+
+int main(int argc, char** argv){
+    std::size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    run<DequeOps<std::uint64_t>, std::uint64_t>("Deque<uint64_t>", operations);
+    run<StdDequeOps<std::uint64_t>, std::uint64_t>("std::deque<uint64_t>", operations);
+    run<DequeOps<Large>, Large>("Deque<1KB>", operations / 64);
+    run<StdDequeOps<Large>, Large>("std::deque<1KB>", operations / 64);
+    return 0;
+}
@@ -0,0 +1,242 @@
+// Read-side cost of EpochDomain against the other ways of protecting readers of a structure that a writer replaces
+// and frees under them:
+//
+//  - unprotected: plain loads and nothing is ever freed. The floor that the others are measured against.
+//  - epoch: one EpochGuard per traversal.
+//  - hazard_pointer: a minimal hazard pointer scheme, where every hop publishes the next node in the reader's slot, fences
+//    and re-checks that the node is still linked before using it.
+//  - shared_mutex: readers take a std::shared_mutex in shared mode.
+//
+// The structure is a linked list of length nodes; readers walk all of it and sum the values. A writer thread replaces the
+// whole list every 50us (copy on write) and frees the old one through the scheme being measured. Each result is the
+// total number of traversals across all readers over the wall clock time, for 1 to max_threads readers and for a list
+// of 1 node (one pointer read per critical section) and of 16 nodes.
+//
+// Usage: epoch_bench [traversals_per_thread] [max_threads]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/Concurrency.h"
+#include "../src/include/EpochReclamation.h"
+
+struct Node{
+    std::atomic<Node*> m_next;
+    std::uint64_t      m_value;
+};
+
+static Node* make_list(std::size_t length, std::uint64_t value){
+    Node* head = nullptr;
+    for(std::size_t i = 0; i < length; ++i){
+        head = new Node{{head}, value + i};
+    }
+    return head;
+}
+static void free_list(Node* head){
+    while(head != nullptr){
+        Node* next = head->m_next.load(std::memory_order_relaxed);
+        delete head;
+        head = next;
+    }
+}
+
+struct Unprotected{
+    std::atomic<Node*> m_head;
+    std::vector<Node*> m_graveyard;
+
+    std::uint64_t read(){
+        std::uint64_t sum = 0;
+        for(Node* node = m_head.load(std::memory_order_acquire); node != nullptr; node = node->m_next.load(std::memory_order_acquire)){
+            sum += node->m_value;
+        }
+        return sum;
+    }
+    void replace(Node* head){
+        m_graveyard.push_back(m_head.exchange(head, std::memory_order_acq_rel));
+    }
+    ~Unprotected(){
+        for(Node* old : m_graveyard){
+            free_list(old);
+        }
+    }
+};
+
+struct Epoch{
+    std::atomic<Node*> m_head;
+    EpochDomain        m_domain;
+
+    std::uint64_t read(){
+        EpochGuard guard(m_domain);
+        std::uint64_t sum = 0;
+        for(Node* node = m_head.load(std::memory_order_acquire); node != nullptr; node = node->m_next.load(std::memory_order_acquire)){
+            sum += node->m_value;
+        }
+        return sum;
+    }
+    void replace(Node* head){
+        Node* old = m_head.exchange(head, std::memory_order_acq_rel);
+        m_domain.retire(old, [](void* ptr){free_list(static_cast<Node*>(ptr));});
+    }
+};
+
+// Two hazard slots per reader are enough to walk a list hand over hand. The writer frees an old list once no slot
+// points into it.
+struct HazardPointers{
+    struct alignas(CACHE_LINE_SIZE) Slots{
+        std::atomic<Node*> m_hazard[2];
+    };
+
+    std::atomic<Node*> m_head;
+    Slots              m_slots[MAX_THREADS];
+
+    // Publishes the node that source points to in hazard and returns it once it is known to still be linked there.
+    static Node* protect(std::atomic<Node*>& source, std::atomic<Node*>& hazard){
+        Node* node = source.load(std::memory_order_acquire);
+        while(true){
+            hazard.store(node, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            Node* again = source.load(std::memory_order_acquire);
+            if(again == node){
+                return node;
+            }
+            node = again;
+        }
+    }
+    std::uint64_t read(){
+        Slots& slots = m_slots[thread_index()];
+        std::uint64_t sum = 0;
+        int current = 0;
+        for(Node* node = protect(m_head, slots.m_hazard[current]); node != nullptr;){
+            sum += node->m_value;
+            current ^= 1;
+            node = protect(node->m_next, slots.m_hazard[current]);
+        }
+        slots.m_hazard[0].store(nullptr, std::memory_order_release);
+        slots.m_hazard[1].store(nullptr, std::memory_order_release);
+        return sum;
+    }
+    bool is_hazardous(const std::vector<Node*>& nodes){
+        std::size_t limit = thread_index_limit().load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for(std::size_t i = 0; i < limit; ++i){
+            for(std::atomic<Node*>& hazard : m_slots[i].m_hazard){
+                Node* protected_node = hazard.load(std::memory_order_acquire);
+                for(Node* node : nodes){
+                    if(node == protected_node){
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+    void replace(Node* head){
+        Node* old = m_head.exchange(head, std::memory_order_acq_rel);
+        // Detaching the old list's nodes makes the re-check in protect fail for a reader still walking it, so once the
+        // scan finds no slot pointing into the list no reader can step onto one of its nodes again.
+        std::vector<Node*> nodes;
+        for(Node* node = old; node != nullptr; node = node->m_next.exchange(nullptr, std::memory_order_acq_rel)){
+            nodes.push_back(node);
+        }
+        while(is_hazardous(nodes)){
+            std::this_thread::yield();
+        }
+        for(Node* node : nodes){
+            delete node;
+        }
+    }
+};
+
+struct SharedMutex{
+    std::shared_mutex m_mutex;
+    Node*             m_head = nullptr;
+
+    std::uint64_t read(){
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        std::uint64_t sum = 0;
+        for(Node* node = m_head; node != nullptr; node = node->m_next.load(std::memory_order_relaxed)){
+            sum += node->m_value;
+        }
+        return sum;
+    }
+    void replace(Node* head){
+        Node* old;
+        {
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+            old  = m_head;
+            m_head = head;
+        }
+        free_list(old);
+    }
+};
+
+template <class Scheme>
+static void run(const char* name, std::size_t length, std::size_t traversals, int readers){
+    Scheme* scheme = new Scheme();
+    scheme->replace(make_list(length, 0));
+    std::atomic<int> ready(0), finished(0);
+    std::atomic<bool> go(false);
+    std::atomic<std::uint64_t> total(0);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < readers; ++t){
+        threads.emplace_back([&, t]{
+            pin_thread(t);
+            ready++;
+            while(!go.load()){
+                std::this_thread::yield();
+            }
+            std::uint64_t sum = 0;
+            for(std::size_t i = 0; i < traversals; ++i){
+                sum += scheme->read();
+            }
+            total += sum;
+            finished++;
+        });
+    }
+    std::thread writer([&]{
+        std::uint64_t version = 1;
+        while(finished.load() < readers){
+            scheme->replace(make_list(length, version++));
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+    while(ready.load() < readers){
+        std::this_thread::yield();
+    }
+    BenchTimer timer;
+    go = true;
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    double ns = timer.elapsed_ns();
+    writer.join();
+    do_not_optimize(total.load());
+    delete scheme;
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/length:%zu/readers:%d", name, length, readers);
+    print_result(label, traversals * std::size_t(readers), ns);
+}
+
+int main(int argc, char** argv){
+    std::size_t traversals = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int max_threads        = argc > 2 ? std::atoi(argv[2]) : 64;
+
+    for(std::size_t length : {std::size_t(1), std::size_t(16)}){
+        for(int readers = 1; readers <= max_threads; readers *= 2){
+            run<Unprotected>("unprotected", length, traversals, readers);
+            run<Epoch>("epoch", length, traversals, readers);
+            run<HazardPointers>("hazard_pointer", length, traversals, readers);
+            run<SharedMutex>("shared_mutex", length, traversals, readers);
+        }
+    }
+    return 0;
+}
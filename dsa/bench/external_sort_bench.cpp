@@ -0,0 +1,134 @@
+// external_sort on a file several times larger than its memory budget, the budget standing in for RAM so that the run
+// stays small enough for a test machine. Pass the real RAM size as memory_mb (and have ratio times that much disk, three
+// times over) to sort a true larger-than-memory file.
+//
+// Records are 16 bytes, a random 64 bit key and a 64 bit payload. Rows:
+//
+//  - external_sort: the default 1MB blocks, a fan in of memory_mb / 2 - 1, which merges ratio times the budget in one
+//    pass for any budget of 16MB or more.
+//  - external_sort fan_in 3: blocks of budget / 8, the smallest fan in external_sort allows, so the merge takes
+//    ceil(log3(runs)) passes. This is the cost of a budget that is too small for the input.
+//  - in_memory std::sort: reading the whole file, std::sort and writing it out, ignoring the budget, as the floor.
+//
+// Each row is ns per record, followed by the run and pass counts and the disk traffic in MB/s. Page cache effects are
+// not controlled for: an input that fits in the machine's page cache is read from memory, so on a small input this
+// measures the CPU side of the sort more than the disk.
+//
+// Usage: external_sort_bench [memory_mb] [ratio] [threads] [directory]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Bench.h"
+#include "../src/include/ExternalSort.h"
+
+struct Record{
+    std::uint64_t m_key;
+    std::uint64_t m_payload;
+};
+
+struct KeyLess{
+    bool operator()(const Record& a, const Record& b) const {return a.m_key < b.m_key;}
+};
+
+static void generate(const std::string& path, std::uint64_t records){
+    std::mt19937_64 rng(records);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::vector<Record> block(1 << 16);
+    for(std::uint64_t written = 0; written < records; written += block.size()){
+        std::size_t count = std::size_t(std::min<std::uint64_t>(block.size(), records - written));
+        for(std::size_t i = 0; i < count; ++i){
+            block[i] = Record{rng(), written + i};
+        }
+        file.write(reinterpret_cast<const char*>(block.data()), std::streamsize(count * sizeof(Record)));
+    }
+}
+
+// Checks the output is sorted and holds every record, by key order and by payload sum.
+static bool verify(const std::string& path, std::uint64_t records){
+    std::ifstream file(path, std::ios::binary);
+    std::vector<Record> block(1 << 16);
+    std::uint64_t seen = 0, payload_sum = 0, previous = 0;
+    while(file){
+        file.read(reinterpret_cast<char*>(block.data()), std::streamsize(block.size() * sizeof(Record)));
+        std::size_t count = std::size_t(file.gcount()) / sizeof(Record);
+        for(std::size_t i = 0; i < count; ++i){
+            if(block[i].m_key < previous){
+                return false;
+            }
+            previous = block[i].m_key;
+            payload_sum += block[i].m_payload;
+        }
+        seen += count;
+    }
+    return seen == records && payload_sum == records * (records - 1) / 2;
+}
+
+static void report(const char* name, const std::string& output, std::uint64_t records, double elapsed_ns,
+                   const ExternalSortStats& stats){
+    if(!verify(output, records)){
+        std::fprintf(stderr, "%s: output is not a sort of the input\n", name);
+        std::exit(1);
+    }
+    print_result(name, records, elapsed_ns);
+    double megabytes = double(stats.bytes_read + stats.bytes_written) / (1 << 20);
+    std::printf("%-48s runs %zu fan_in %zu passes %zu, %.0f MB of I/O at %.0f MB/s\n", "", stats.runs, stats.fan_in,
+                stats.merge_passes, megabytes, megabytes / (elapsed_ns * 1e-9));
+}
+
+int main(int argc, char** argv){
+    std::size_t memory_mb = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+    std::size_t ratio     = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+    std::size_t threads   = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+    std::string directory = argc > 4 ? argv[4] : std::filesystem::temp_directory_path().string();
+
+    std::string input = directory + "/external_sort_bench_input_" + std::to_string(getpid());
+    std::string output = directory + "/external_sort_bench_output_" + std::to_string(getpid());
+    std::uint64_t records = std::uint64_t(memory_mb) * ratio * (1 << 20) / sizeof(Record);
+    generate(input, records);
+    std::printf("%llu records, %zu MB input, %zu MB budget\n", (unsigned long long)records, memory_mb * ratio,
+                memory_mb);
+
+    ExternalSortOptions options;
+    options.memory_budget = memory_mb << 20;
+    options.threads = threads;
+    options.temp_directory = directory;
+    {
+        BenchTimer timer;
+        ExternalSortStats stats = external_sort<Record, KeyLess>(input, output, options);
+        report("external_sort", output, records, timer.elapsed_ns(), stats);
+    }
+    {
+        ExternalSortOptions small = options;
+        small.block_size = options.memory_budget / 8;
+        BenchTimer timer;
+        ExternalSortStats stats = external_sort<Record, KeyLess>(input, output, small);
+        report("external_sort fan_in 3", output, records, timer.elapsed_ns(), stats);
+    }
+    {
+        BenchTimer timer;
+        std::vector<Record> data(records);
+        std::ifstream(input, std::ios::binary)
+            .read(reinterpret_cast<char*>(data.data()), std::streamsize(records * sizeof(Record)));
+        std::sort(data.begin(), data.end(), KeyLess());
+        std::ofstream(output, std::ios::binary | std::ios::trunc)
+            .write(reinterpret_cast<const char*>(data.data()), std::streamsize(records * sizeof(Record)));
+        double elapsed_ns = timer.elapsed_ns();
+        ExternalSortStats stats;
+        stats.runs = 1;
+        stats.bytes_read = stats.bytes_written = records * sizeof(Record);
+        report("in_memory std::sort", output, records, elapsed_ns, stats);
+    }
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Throughput of the flat combining wrappers against a std::mutex around the same sequential structure and against a
+// lock-free structure, at 1 to max_threads threads. Every thread runs the same loop of a push followed by a pop, so the
+// structure stays at about its initial size and every operation contends for the same end (stack) or ends (queue).
+//
+// The lock-free queue is MPMCQueue, which is bounded, so it is sized to never fill up. The lock-free stack is
+// LockFreeStack with its default elimination array.
+//
+// Usage: flat_combining_bench [operations] [max_threads]
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/FlatCombining.h"
+#include "../src/include/LockFreeStack.h"
+#include "../src/include/MPMCQueue.h"
+#include "../src/include/Queue.h"
+
+static const std::size_t INITIAL_SIZE = 1000;
+
+class MutexQueue{
+private:
+    std::mutex m_mutex;
+    Queue<std::uint64_t> m_queue;
+
+public:
+    void push(std::uint64_t value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.enqueue(value);
+    }
+    bool pop(std::uint64_t& value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_queue.is_empty()){
+            return false;
+        }
+        value = m_queue.dequeue();
+        return true;
+    }
+};
+class MutexStack{
+private:
+    std::mutex m_mutex;
+    std::vector<std::uint64_t> m_stack;
+
+public:
+    void push(std::uint64_t value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stack.push_back(value);
+    }
+    bool pop(std::uint64_t& value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_stack.empty()){
+            return false;
+        }
+        value = m_stack.back();
+        m_stack.pop_back();
+        return true;
+    }
+};
+
+// Adapters giving every structure the push/pop interface used by run().
+struct FCQueue{
+    FlatCombiningQueue<std::uint64_t> m_queue;
+    void push(std::uint64_t value){m_queue.enqueue(value);}
+    bool pop(std::uint64_t& value){return m_queue.try_dequeue(value);}
+};
+struct FCStack{
+    FlatCombiningStack<std::uint64_t> m_stack;
+    void push(std::uint64_t value){m_stack.push(value);}
+    bool pop(std::uint64_t& value){return m_stack.try_pop(value);}
+};
+struct LockFreeQueue{
+    MPMCQueue<std::uint64_t> m_queue{std::size_t(1) << 16};
+    void push(std::uint64_t value){m_queue.push(value);}
+    bool pop(std::uint64_t& value){return m_queue.try_pop(value);}
+};
+struct LockFreeStackOps{
+    LockFreeStack<std::uint64_t> m_stack;
+    void push(std::uint64_t value){m_stack.push(value);}
+    bool pop(std::uint64_t& value){return m_stack.try_pop(value);}
+};
+
+template <class Structure>
+static void run(const char* name, std::size_t operations, int threads){
+    Structure structure;
+    for(std::size_t i = 0; i < INITIAL_SIZE; ++i){
+        structure.push(i);
+    }
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<std::uint64_t> sum(0);
+    std::vector<std::thread> workers;
+    std::size_t per_thread = operations / 2 / std::size_t(threads);
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&, t]{
+            pin_thread(t);
+            ready++;
+            while(!go.load()){
+                std::this_thread::yield();
+            }
+            std::uint64_t local = 0, value;
+            for(std::size_t i = 0; i < per_thread; ++i){
+                structure.push(i);
+                if(structure.pop(value)){
+                    local += value;
+                }
+            }
+            sum += local;
+        });
+    }
+    while(ready.load() < threads){
+        std::this_thread::yield();
+    }
+    BenchTimer timer;
+    go = true;
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum.load());
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/threads:%d", name, threads);
+    print_result(label, per_thread * 2 * std::size_t(threads), ns);
+}
+
+int main(int argc, char** argv){
+    std::size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    int max_threads        = argc > 2 ? std::atoi(argv[2]) : 64;
+
+    for(int threads = 1; threads <= max_threads; threads *= 2){
+        run<FCQueue>("FlatCombiningQueue", operations, threads);
+        run<MutexQueue>("mutex_Queue", operations, threads);
+        run<LockFreeQueue>("MPMCQueue", operations, threads);
+        run<FCStack>("FlatCombiningStack", operations, threads);
+        run<MutexStack>("mutex_stack", operations, threads);
+        run<LockFreeStackOps>("LockFreeStack", operations, threads);
+    }
+    return 0;
+}
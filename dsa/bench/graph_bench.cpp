@@ -0,0 +1,140 @@
+// Traversal rates of the Graph.h algorithms on a synthetic RMAT graph, in traversed edges per second.
+//
+// The graph is Graph500's: 2^scale vertices and edge_factor * 2^scale undirected edges from the recursive matrix
+// generator with (a, b, c, d) = (0.57, 0.19, 0.19, 0.05), which gives the skewed degrees and small diameter of social and
+// web graphs, with vertex numbers randomly permuted so that high degree vertices aren't clustered at low numbers. It is
+// stored SYMMETRIC and WEIGHTED (weights uniform in 1 to 255), so each undirected edge is two CSR edges.
+//
+//  - build: constructing the CsrGraph from the edge list, in input edges per second.
+//  - bfs, dfs, dijkstra: the serial algorithms. A search's edge count is the sum of the out degrees of the vertices it
+//    reached, i.e. every edge a top down search looks at, whichever direction the search actually ran in.
+//  - parallel_bfs: ParallelBreadthFirstSearch direction optimizing and top down only, for 1 to max_threads threads.
+//
+// Each search runs from the same searches random sources, picked among vertices with at least one edge, and the row is
+// their total.
+//
+// Usage: graph_bench [scale] [edge_factor] [max_threads] [searches]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/Graph.h"
+
+typedef CsrGraph::Vertex Vertex;
+
+static std::vector<CsrGraph::Edge> rmat_edges(unsigned scale, std::uint64_t count, unsigned seed){
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double a = 0.57, b = 0.19, c = 0.19;
+    std::vector<Vertex> permutation(std::size_t(1) << scale);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::shuffle(permutation.begin(), permutation.end(), rng);
+
+    std::vector<CsrGraph::Edge> edges(count);
+    for(CsrGraph::Edge& edge : edges){
+        Vertex from = 0, to = 0;
+        for(unsigned bit = 0; bit < scale; ++bit){
+            double quadrant = uniform(rng);
+            if(quadrant >= a + b + c){
+                from |= Vertex(1) << bit;
+                to |= Vertex(1) << bit;
+            }else if(quadrant >= a + b){
+                from |= Vertex(1) << bit;
+            }else if(quadrant >= a){
+                to |= Vertex(1) << bit;
+            }
+        }
+        edge.m_from = permutation[from];
+        edge.m_to = permutation[to];
+        edge.m_weight = 1 + std::uint32_t(rng() % 255);
+    }
+    return edges;
+}
+
+static std::uint64_t reached_edges(const CsrGraph& graph, const std::vector<std::uint32_t>& depths){
+    std::uint64_t edges = 0;
+    for(Vertex v = 0; v < graph.vertex_count(); ++v){
+        if(depths[v] != UNREACHED){
+            edges += graph.degree(v);
+        }
+    }
+    return edges;
+}
+
+// Times search(source) for every source, leaving count(result), the number of edges the search reached, out of the time.
+template <class Search, class Count>
+static void run_searches(const char* name, const std::vector<Vertex>& sources, Search search, Count count){
+    std::uint64_t edges = 0;
+    double elapsed_ns = 0;
+    for(Vertex source : sources){
+        BenchTimer timer;
+        auto result = search(source);
+        elapsed_ns += timer.elapsed_ns();
+        do_not_optimize(result.data());
+        edges += count(result);
+    }
+    print_result(name, edges, elapsed_ns);
+}
+
+int main(int argc, char** argv){
+    unsigned scale           = argc > 1 ? unsigned(std::atoi(argv[1])) : 20;
+    std::uint64_t factor     = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16;
+    std::size_t max_threads  = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 8;
+    std::size_t num_searches = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 8;
+
+    Vertex vertices = Vertex(1) << scale;
+    std::vector<CsrGraph::Edge> edges = rmat_edges(scale, factor * vertices, 1);
+    BenchTimer build_timer;
+    CsrGraph graph(vertices, edges, CsrGraph::SYMMETRIC | CsrGraph::WEIGHTED);
+    print_result("build", edges.size(), build_timer.elapsed_ns());
+    edges = std::vector<CsrGraph::Edge>();
+    std::printf("rmat scale %u: %u vertices, %llu directed edges\n", scale, vertices,
+                (unsigned long long)graph.edge_count());
+
+    std::mt19937 rng(2);
+    std::vector<Vertex> sources;
+    while(sources.size() < num_searches){
+        Vertex source = Vertex(rng() % vertices);
+        if(graph.degree(source) > 0){
+            sources.push_back(source);
+        }
+    }
+
+    auto count_depths = [&](const std::vector<std::uint32_t>& depths){return reached_edges(graph, depths);};
+    run_searches("bfs", sources, [&](Vertex source){return breadth_first_search(graph, source);}, count_depths);
+    run_searches("dfs", sources, [&](Vertex source){return depth_first_order(graph, source);},
+                 [&](const std::vector<Vertex>& order){
+                     std::uint64_t reached = 0;
+                     for(Vertex vertex : order){
+                         reached += graph.degree(vertex);
+                     }
+                     return reached;
+                 });
+    run_searches("dijkstra", sources, [&](Vertex source){return dijkstra(graph, source);},
+                 [&](const std::vector<std::uint64_t>& distances){
+                     std::uint64_t reached = 0;
+                     for(Vertex v = 0; v < vertices; ++v){
+                         if(distances[v] != INFINITE_DISTANCE){
+                             reached += graph.degree(v);
+                         }
+                     }
+                     return reached;
+                 });
+    for(std::size_t threads = 1; threads <= max_threads; threads *= 2){
+        char name[64];
+        for(bool direction_optimizing : {true, false}){
+            std::snprintf(name, sizeof(name), "parallel_bfs %s %zu threads",
+                          direction_optimizing ? "direction_optimizing" : "top_down", threads);
+            ParallelBreadthFirstSearch search(graph, graph, threads, direction_optimizing);
+            run_searches(name, sources, [&](Vertex source){return search.run(source);}, count_depths);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Measures GROUP BY throughput in rows/sec for HashAggregator, PartitionedHashAggregate and a row at a time
+// std::unordered_map baseline, at group cardinalities from 10 up to the number of rows.
+//
+// Usage: hash_aggregate_bench [rows] [threads]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/HashAggregate.h"
+
+struct Aggregate{
+    std::int64_t m_count = 0;
+    std::int64_t m_sum   = 0;
+    std::int64_t m_min   = INT64_MAX;
+    std::int64_t m_max   = INT64_MIN;
+};
+
+int main(int argc, char** argv){
+    std::size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    int threads = argc > 2 ? std::atoi(argv[2]) : int(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<std::int64_t> keys(rows), values(rows);
+    std::mt19937_64 rng(1);
+    for(std::size_t i = 0; i < rows; ++i){
+        values[i] = std::int64_t(rng() % 1000);
+    }
+
+    char label[128];
+    for(std::uint64_t cardinality = 10; cardinality <= rows; cardinality *= 10){
+        for(std::size_t i = 0; i < rows; ++i){
+            keys[i] = std::int64_t(rng() % cardinality);
+        }
+
+        {
+            BenchTimer timer;
+            HashAggregator aggregator;
+            aggregator.add(keys.data(), values.data(), rows);
+            double ns = timer.elapsed_ns();
+            do_not_optimize(aggregator.size());
+            std::snprintf(label, sizeof(label), "HashAggregator/groups:%llu", (unsigned long long)cardinality);
+            print_result(label, rows, ns);
+        }
+        {
+            BenchTimer timer;
+            PartitionedHashAggregate aggregate(threads);
+            aggregate.add(keys.data(), values.data(), rows);
+            double ns = timer.elapsed_ns();
+            do_not_optimize(aggregate.size());
+            std::snprintf(label, sizeof(label), "PartitionedHashAggregate/threads:%d/groups:%llu", threads,
+                          (unsigned long long)cardinality);
+            print_result(label, rows, ns);
+        }
+        {
+            BenchTimer timer;
+            std::unordered_map<std::int64_t, Aggregate> groups;
+            for(std::size_t i = 0; i < rows; ++i){
+                Aggregate& group = groups[keys[i]];
+                group.m_count++;
+                group.m_sum += values[i];
+                group.m_min  = std::min(group.m_min, values[i]);
+                group.m_max  = std::max(group.m_max, values[i]);
+            }
+            double ns = timer.elapsed_ns();
+            do_not_optimize(groups.size());
+            std::snprintf(label, sizeof(label), "std::unordered_map/groups:%llu", (unsigned long long)cardinality);
+            print_result(label, rows, ns);
+        }
+    }
+    return 0;
+}
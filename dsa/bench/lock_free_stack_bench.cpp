@@ -0,0 +1,128 @@
+// Throughput of LockFreeStack with and without its elimination array, against a Stack behind a std::mutex, at 1 to
+// max_threads threads:
+//
+//  - pairs: every thread pushes and then pops, as threads sharing a free list of buffers do.
+//  - split: half the threads only push and the other half only pop, as in a task pool. Pushes and pops are equally
+//    likely to meet, which is where elimination pays off.
+//
+// Elimination only helps when the head is contended, which needs threads actually running at the same time: with fewer
+// cores than threads the results mostly measure the scheduler.
+//
+// Usage: lock_free_stack_bench [operations] [max_threads]
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/LockFreeStack.h"
+#include "../src/include/Stack.h"
+
+class MutexStack{
+private:
+    std::mutex m_mutex;
+    Stack<std::uint64_t> m_stack;
+
+public:
+    void push(std::uint64_t value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stack.push(value);
+    }
+    bool try_pop(std::uint64_t& value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_stack.is_empty()){
+            return false;
+        }
+        value = m_stack.pop();
+        return true;
+    }
+};
+struct EliminationStack : LockFreeStack<std::uint64_t>{
+    EliminationStack() : LockFreeStack<std::uint64_t>(DEFAULT_ELIMINATION_SLOTS){};
+};
+struct TreiberStack : LockFreeStack<std::uint64_t>{
+    TreiberStack() : LockFreeStack<std::uint64_t>(0){};
+};
+
+template <class Structure>
+static void run(const char* name, bool split, std::size_t operations, int threads){
+    Structure stack;
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<std::uint64_t> sum(0), popped(0);
+    std::vector<std::thread> workers;
+    // In split mode the pushers do all the pushes between them and the poppers keep going until everything is popped.
+    int pushers = split ? std::max(threads / 2, 1) : threads;
+    std::size_t per_thread = split ? operations / 2 / std::size_t(pushers) : operations / 2 / std::size_t(threads);
+    std::uint64_t total = per_thread * std::uint64_t(pushers);
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&, t]{
+            pin_thread(t);
+            ready++;
+            while(!go.load()){
+                std::this_thread::yield();
+            }
+            std::uint64_t local = 0, value;
+            if(!split){
+                for(std::size_t i = 0; i < per_thread; ++i){
+                    stack.push(i);
+                    if(stack.try_pop(value)){
+                        local += value;
+                    }
+                }
+            }else if(t < pushers){
+                for(std::size_t i = 0; i < per_thread; ++i){
+                    stack.push(i);
+                }
+            }else{
+                unsigned spins = 0;
+                while(popped.load(std::memory_order_relaxed) < total){
+                    if(stack.try_pop(value)){
+                        local += value;
+                        popped.fetch_add(1, std::memory_order_relaxed);
+                    }else if(++spins % 256 == 0){
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            sum += local;
+        });
+    }
+    while(ready.load() < threads){
+        std::this_thread::yield();
+    }
+    BenchTimer timer;
+    go = true;
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    // With a single thread split mode has no popper; drain here so every mode does the same work.
+    std::uint64_t value;
+    while(stack.try_pop(value)){
+        sum += value;
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum.load());
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/%s/threads:%d", name, split ? "split" : "pairs", threads);
+    print_result(label, total * 2, ns);
+}
+
+int main(int argc, char** argv){
+    std::size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    int max_threads        = argc > 2 ? std::atoi(argv[2]) : 64;
+
+    for(bool split : {false, true}){
+        for(int threads = 1; threads <= max_threads; threads *= 2){
+            run<EliminationStack>("LockFreeStack", split, operations, threads);
+            run<TreiberStack>("LockFreeStack/no_elimination", split, operations, threads);
+            run<MutexStack>("mutex_Stack", split, operations, threads);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Throughput of MPMCQueue against a std::mutex protecting a std::queue, with N producers and N consumers for N from 1
+// to 32. Producers push a fixed total number of items between them and the time runs until the consumers have popped
+// them all.
+//
+// Usage: mpmc_bench [items] [max_threads]
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/Concurrency.h"
+#include "../src/include/MPMCQueue.h"
+
+static const std::size_t CAPACITY = 1024;
+
+// Bounded like MPMCQueue so that producers can't run arbitrarily far ahead of consumers in either case.
+class MutexQueue{
+private:
+    std::mutex m_mutex;
+    std::queue<std::uint64_t> m_queue;
+
+public:
+    bool try_push(std::uint64_t value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_queue.size() == CAPACITY){
+            return false;
+        }
+        m_queue.push(value);
+        return true;
+    }
+    bool try_pop(std::uint64_t& value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_queue.empty()){
+            return false;
+        }
+        value = m_queue.front();
+        m_queue.pop();
+        return true;
+    }
+};
+
+static void backoff(unsigned& spins){
+    if(++spins % 256 == 0){
+        std::this_thread::yield();
+    }else{
+        cpu_relax();
+    }
+}
+
+template <class Q>
+static void run(const char* name, Q& queue, std::size_t items, int threads){
+    std::atomic<std::uint64_t> consumed(0);
+    std::atomic<std::uint64_t> sum(0);
+    std::atomic<int> ready(0);
+    std::atomic<bool> start(false);
+    std::vector<std::thread> workers;
+
+    std::size_t per_producer = items / threads;
+    std::size_t total = per_producer * threads;
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&, t]{
+            pin_thread(2 * t);
+            ready++;
+            while(!start.load()){
+                cpu_relax();
+            }
+            unsigned spins = 0;
+            for(std::size_t i = 0; i < per_producer; ++i){
+                while(!queue.try_push(i)){
+                    backoff(spins);
+                }
+            }
+        });
+        workers.emplace_back([&, t]{
+            pin_thread(2 * t + 1);
+            ready++;
+            while(!start.load()){
+                cpu_relax();
+            }
+            std::uint64_t local_sum = 0, value;
+            unsigned spins = 0;
+            while(consumed.load(std::memory_order_relaxed) < total){
+                if(queue.try_pop(value)){
+                    local_sum += value;
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }else{
+                    backoff(spins);
+                }
+            }
+            sum += local_sum;
+        });
+    }
+    while(ready.load() < 2 * threads){
+        std::this_thread::yield();
+    }
+
+    BenchTimer timer;
+    start = true;
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum.load());
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/producers:%d/consumers:%d", name, threads, threads);
+    print_result(label, total, ns);
+}
+
+int main(int argc, char** argv){
+    std::size_t items = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    int max_threads   = argc > 2 ? std::atoi(argv[2]) : 32;
+
+    for(int threads = 1; threads <= max_threads; threads *= 2){
+        {
+            MPMCQueue<std::uint64_t> queue(CAPACITY);
+            run("MPMCQueue", queue, items, threads);
+        }
+        {
+            MutexQueue queue;
+            run("mutex+std::queue", queue, items, threads);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Push/pop throughput of PriorityQueue with D = 2, 4 and 8 against std::priority_queue, at several heap sizes.
+//
+//  - build: construct a heap from n values (PriorityQueue uses its O(n) bulk constructor, std::priority_queue its
+//    range constructor, which is also make_heap).
+//  - push_pop: the "hold" model, popping the top and pushing a new random value so the heap stays at n elements.
+//  - drain: pop all n values.
+//
+// Usage: priority_queue_bench [max_size]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/PriorityQueue.h"
+
+template <class Q>
+static void run(const char* name, const std::vector<std::uint64_t>& values, const std::vector<std::uint64_t>& extra){
+    char label[128];
+    std::size_t n = values.size();
+
+    BenchTimer timer;
+    Q queue(values.begin(), values.end());
+    double build_ns = timer.elapsed_ns();
+
+    std::uint64_t sum = 0;
+    timer.reset();
+    for(std::uint64_t value : extra){
+        sum += queue.top();
+        queue.pop();
+        queue.push(value);
+    }
+    double hold_ns = timer.elapsed_ns();
+
+    timer.reset();
+    while(!queue.empty()){
+        sum += queue.top();
+        queue.pop();
+    }
+    double drain_ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+
+    std::snprintf(label, sizeof(label), "%s/build/n:%zu", name, n);
+    print_result(label, n, build_ns);
+    std::snprintf(label, sizeof(label), "%s/push_pop/n:%zu", name, n);
+    print_result(label, extra.size(), hold_ns);
+    std::snprintf(label, sizeof(label), "%s/drain/n:%zu", name, n);
+    print_result(label, n, drain_ns);
+}
+
+// Gives PriorityQueue the std::priority_queue interface used by run().
+template <std::size_t D>
+struct DaryQueue : PriorityQueue<std::uint64_t, std::less<std::uint64_t>, D>{
+    typedef PriorityQueue<std::uint64_t, std::less<std::uint64_t>, D> Base;
+    template <class Iterator>
+    DaryQueue(Iterator first, Iterator last) : Base(first, last){};
+    bool empty() const {return Base::is_empty();}
+    void pop() {Base::pop();}
+};
+
+int main(int argc, char** argv){
+    std::size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    std::mt19937_64 rng(3);
+
+    for(std::size_t n = 1000; n <= max_size; n *= 10){
+        std::vector<std::uint64_t> values(n), extra(std::max<std::size_t>(n, 1000000));
+        for(std::uint64_t& value : values){
+            value = rng();
+        }
+        for(std::uint64_t& value : extra){
+            value = rng();
+        }
+        run<DaryQueue<2>>("PriorityQueue<D=2>", values, extra);
+        run<DaryQueue<4>>("PriorityQueue<D=4>", values, extra);
+        run<DaryQueue<8>>("PriorityQueue<D=8>", values, extra);
+        run<std::priority_queue<std::uint64_t>>("std::priority_queue", values, extra);
+    }
+    return 0;
+}
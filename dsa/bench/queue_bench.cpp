@@ -0,0 +1,131 @@
+// Compares Queue<T> against std::deque<T> and std::queue<T> for a steady state FIFO (the queue hovers around a fixed
+// depth while elements stream through it), a fill then drain, and Queue's bulk APIs, for a small and a large T.
+//
+// Usage: queue_bench [operations]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/Queue.h"
+
+struct Large{
+    std::uint64_t m_words[8];
+    Large() = default;
+    explicit Large(std::uint64_t value){
+        for(std::uint64_t& word : m_words){
+            word = value;
+        }
+    }
+    std::uint64_t value() const {return m_words[0];}
+};
+static std::uint64_t value_of(std::uint64_t value){return value;}
+static std::uint64_t value_of(const Large& value){return value.value();}
+
+// Adapters so that one benchmark body can drive every container.
+template <class T> struct QueueOps{
+    Queue<T> m_queue;
+    void push(T value){m_queue.enqueue(std::move(value));}
+    T pop(){return m_queue.dequeue();}
+};
+template <class T> struct DequeOps{
+    std::deque<T> m_queue;
+    void push(T value){m_queue.push_back(std::move(value));}
+    T pop(){T value = std::move(m_queue.front()); m_queue.pop_front(); return value;}
+};
+template <class T> struct StdQueueOps{
+    std::queue<T> m_queue;
+    void push(T value){m_queue.push(std::move(value));}
+    T pop(){T value = std::move(m_queue.front()); m_queue.pop(); return value;}
+};
+
+template <class Ops, class T>
+static void steady_state(const char* name, std::size_t operations, std::size_t depth){
+    Ops ops;
+    for(std::size_t i = 0; i < depth; ++i){
+        ops.push(T(i));
+    }
+    std::uint64_t sum = 0;
+    BenchTimer timer;
+    for(std::size_t i = 0; i < operations; ++i){
+        ops.push(T(i));
+        sum += value_of(ops.pop());
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/steady_state/depth:%zu", name, depth);
+    print_result(label, operations, ns);
+}
+
+template <class Ops, class T>
+static void fill_drain(const char* name, std::size_t operations){
+    std::uint64_t sum = 0;
+    BenchTimer timer;
+    {
+        Ops ops;
+        for(std::size_t i = 0; i < operations; ++i){
+            ops.push(T(i));
+        }
+        for(std::size_t i = 0; i < operations; ++i){
+            sum += value_of(ops.pop());
+        }
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/fill_drain", name);
+    print_result(label, operations, ns);
+}
+
+template <class T>
+static void bulk(const char* name, std::size_t operations, std::size_t batch){
+    Queue<T> queue;
+    std::vector<T> in(batch), out(batch);
+    for(std::size_t i = 0; i < batch; ++i){
+        in[i] = T(i);
+    }
+    std::uint64_t sum = 0;
+    BenchTimer timer;
+    for(std::size_t done = 0; done < operations; done += batch){
+        queue.enqueue_bulk(in.data(), batch);
+        queue.dequeue_bulk(out.data(), batch);
+        sum += value_of(out[0]);
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/bulk/batch:%zu", name, batch);
+    print_result(label, operations, ns);
+}
+
+template <class T>
+static void run_all(const char* type, std::size_t operations){
+    char name[64];
+    for(std::size_t depth : {std::size_t(16), std::size_t(100000)}){
+        std::snprintf(name, sizeof(name), "Queue<%s>", type);
+        steady_state<QueueOps<T>, T>(name, operations, depth);
+        std::snprintf(name, sizeof(name), "std::deque<%s>", type);
+        steady_state<DequeOps<T>, T>(name, operations, depth);
+        std::snprintf(name, sizeof(name), "std::queue<%s>", type);
+        steady_state<StdQueueOps<T>, T>(name, operations, depth);
+    }
+    std::snprintf(name, sizeof(name), "Queue<%s>", type);
+    fill_drain<QueueOps<T>, T>(name, operations);
+    bulk<T>(name, operations, 64);
+    std::snprintf(name, sizeof(name), "std::deque<%s>", type);
+    fill_drain<DequeOps<T>, T>(name, operations);
+    std::snprintf(name, sizeof(name), "std::queue<%s>", type);
+    fill_drain<StdQueueOps<T>, T>(name, operations);
+}
+
+int main(int argc, char** argv){
+    std::size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    run_all<std::uint64_t>("uint64_t", operations);
+    run_all<Large>("64B", operations / 4);
+    return 0;
+}
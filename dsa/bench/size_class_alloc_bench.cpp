@@ -0,0 +1,152 @@
+// Container churn with the default std::allocator (glibc malloc underneath) against SizeClassAllocator, for each of the
+// dsa containers that take an Allocator:
+//
+//  - List: push_back k elements, then pop_front them all. One node allocation and free per element.
+//  - Queue: a fresh Queue per round, enqueue k elements and dequeue them all. The buffer grows while it fills.
+//  - Stack: as Queue, with no inline storage so that every round allocates.
+//  - Deque: push_back k elements and pop_front them all, with 16 element blocks allocated and freed as it goes.
+//
+// k is random between 1 and 64 (16 for List, whose push_back walks the list). Every thread churns its own containers,
+// all at once, so malloc's arenas and SizeClassPool's thread caches are both being hit from threads threads. Results are
+// the total number of elements pushed across all threads over the wall clock time.
+//
+// Usage: size_class_alloc_bench [rounds_per_thread] [threads]
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/Deque.h"
+#include "../src/include/List.h"
+#include "../src/include/Queue.h"
+#include "../src/include/SizeClassAllocator.h"
+#include "../src/include/Stack.h"
+
+template <template <class> class Allocator>
+struct ListChurn{
+    static constexpr std::uint64_t MAX_ROUND = 16;
+
+    static std::uint64_t round(std::uint64_t count){
+        List<std::uint64_t, Allocator<std::uint64_t>> list;
+        for(std::uint64_t i = 0; i < count; ++i){
+            list.push_back(i);
+        }
+        std::uint64_t sum = list.at(0);
+        for(std::uint64_t i = 0; i < count; ++i){
+            list.pop_front();
+        }
+        return sum;
+    }
+};
+
+template <template <class> class Allocator>
+struct QueueChurn{
+    static constexpr std::uint64_t MAX_ROUND = 64;
+
+    static std::uint64_t round(std::uint64_t count){
+        Queue<std::uint64_t, Allocator<std::uint64_t>> queue;
+        for(std::uint64_t i = 0; i < count; ++i){
+            queue.enqueue(i);
+        }
+        std::uint64_t sum = 0;
+        while(!queue.is_empty()){
+            sum += queue.dequeue();
+        }
+        return sum;
+    }
+};
+
+template <template <class> class Allocator>
+struct StackChurn{
+    static constexpr std::uint64_t MAX_ROUND = 64;
+
+    static std::uint64_t round(std::uint64_t count){
+        Stack<std::uint64_t, 0, Allocator<std::uint64_t>> stack;
+        for(std::uint64_t i = 0; i < count; ++i){
+            stack.push(i);
+        }
+        std::uint64_t sum = 0;
+        while(!stack.is_empty()){
+            sum += stack.pop();
+        }
+        return sum;
+    }
+};
+
+template <template <class> class Allocator>
+struct DequeChurn{
+    static constexpr std::uint64_t MAX_ROUND = 64;
+
+    static std::uint64_t round(std::uint64_t count){
+        Deque<std::uint64_t, 16, Allocator<std::uint64_t>> deque;
+        for(std::uint64_t i = 0; i < count; ++i){
+            deque.push_back(i);
+        }
+        std::uint64_t sum = 0;
+        while(!deque.is_empty()){
+            sum += deque.pop_front();
+        }
+        return sum;
+    }
+};
+
+template <class Churn>
+static void run(const char* name, std::size_t rounds, int threads){
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<std::uint64_t> pushed(0), total(0);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&, t]{
+            pin_thread(t);
+            std::mt19937_64 rng(t + 1);
+            ready++;
+            while(!go.load()){
+                std::this_thread::yield();
+            }
+            std::uint64_t count = 0, sum = 0;
+            for(std::size_t r = 0; r < rounds; ++r){
+                std::uint64_t k = 1 + rng() % Churn::MAX_ROUND;
+                sum += Churn::round(k);
+                count += k;
+            }
+            pushed += count;
+            total += sum;
+        });
+    }
+    while(ready.load() < threads){
+        std::this_thread::yield();
+    }
+    BenchTimer timer;
+    go = true;
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(total.load());
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/threads:%d", name, threads);
+    print_result(label, pushed.load(), ns);
+}
+
+int main(int argc, char** argv){
+    std::size_t rounds = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    int threads        = argc > 2 ? std::atoi(argv[2]) : 16;
+
+    run<ListChurn<std::allocator>>("List/std::allocator", rounds, threads);
+    run<ListChurn<SizeClassAllocator>>("List/SizeClassAllocator", rounds, threads);
+    run<QueueChurn<std::allocator>>("Queue/std::allocator", rounds, threads);
+    run<QueueChurn<SizeClassAllocator>>("Queue/SizeClassAllocator", rounds, threads);
+    run<StackChurn<std::allocator>>("Stack/std::allocator", rounds, threads);
+    run<StackChurn<SizeClassAllocator>>("Stack/SizeClassAllocator", rounds, threads);
+    run<DequeChurn<std::allocator>>("Deque/std::allocator", rounds, threads);
+    run<DequeChurn<SizeClassAllocator>>("Deque/SizeClassAllocator", rounds, threads);
+    return 0;
+}
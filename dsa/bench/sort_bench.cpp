@@ -0,0 +1,126 @@
+// The Sort.h sorts against std::sort and std::stable_sort, on 64 bit keys and on 64 bit key/value pairs.
+//
+// Key counts go up by 10x from 1e6 to max_keys. Each count runs three distributions:
+//
+//  - uniform: random 64 bit keys.
+//  - skewed: u^4 scaled to 32 bits for u uniform in [0, 1), so half the keys are below 2^28 and small values repeat
+//    heavily, the shape of sizes or counts more than of ids.
+//  - nearly_sorted: 0 to n - 1 in order with n / 100 random pairs of keys swapped, as when new data is appended to an
+//    already sorted run.
+//
+// Key/value pairs run only on uniform keys, and only against the stable sorts, since that is what pairs are usually
+// sorted for. The parallel sample sorts use threads threads (by default one per CPU). Every result is checked.
+// Each row is ns per key.
+//
+// Usage: sort_bench [max_keys] [threads]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/Sort.h"
+
+typedef std::pair<std::uint64_t, std::uint64_t> KeyValue;
+
+static std::vector<std::uint64_t> make_keys(const std::string& distribution, std::size_t count){
+    std::mt19937_64 rng(count);
+    std::vector<std::uint64_t> keys(count);
+    if(distribution == "uniform"){
+        for(std::uint64_t& key : keys){
+            key = rng();
+        }
+    }else if(distribution == "skewed"){
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for(std::uint64_t& key : keys){
+            key = std::uint64_t(std::pow(uniform(rng), 4) * 4294967296.0);
+        }
+    }else{
+        for(std::size_t i = 0; i < count; ++i){
+            keys[i] = i;
+        }
+        for(std::size_t i = 0; i < count / 100; ++i){
+            std::swap(keys[rng() % count], keys[rng() % count]);
+        }
+    }
+    return keys;
+}
+
+// Sorts a copy of input with sort, reports the time and checks the result with is_sorted(copy).
+template <class T, class Sort, class Check>
+static void run_sort(const std::string& name, const std::vector<T>& input, Sort sort, Check is_sorted){
+    std::vector<T> data = input;
+    BenchTimer timer;
+    sort(data);
+    double elapsed_ns = timer.elapsed_ns();
+    if(!is_sorted(data)){
+        std::fprintf(stderr, "%s: result is not sorted\n", name.c_str());
+        std::exit(1);
+    }
+    print_result(name.c_str(), data.size(), elapsed_ns);
+}
+
+static void run_keys(const std::string& distribution, std::size_t count, std::size_t threads){
+    std::vector<std::uint64_t> keys = make_keys(distribution, count);
+    std::string prefix = distribution + " " + std::to_string(count) + " ";
+    auto sorted = [](const std::vector<std::uint64_t>& data){return std::is_sorted(data.begin(), data.end());};
+    typedef std::vector<std::uint64_t> Keys;
+
+    run_sort(prefix + "std::sort", keys, [](Keys& data){std::sort(data.begin(), data.end());}, sorted);
+    run_sort(prefix + "std::stable_sort", keys, [](Keys& data){std::stable_sort(data.begin(), data.end());}, sorted);
+    run_sort(prefix + "radix_sort", keys, [](Keys& data){radix_sort(data.begin(), data.end());}, sorted);
+    run_sort(prefix + "radix_sort_in_place", keys, [](Keys& data){radix_sort_in_place(data.begin(), data.end());},
+             sorted);
+    run_sort(prefix + "sample_sort", keys, [&](Keys& data){
+        parallel_sample_sort(data.data(), data.data() + data.size(), threads);
+    }, sorted);
+    run_sort(prefix + "stable_sample_sort", keys, [&](Keys& data){
+        parallel_stable_sample_sort(data.data(), data.data() + data.size(), threads);
+    }, sorted);
+}
+
+static void run_pairs(std::size_t count, std::size_t threads){
+    std::vector<std::uint64_t> keys = make_keys("uniform", count);
+    std::vector<KeyValue> pairs(count);
+    for(std::size_t i = 0; i < count; ++i){
+        pairs[i] = KeyValue(keys[i], i);
+    }
+    std::string prefix = "pairs " + std::to_string(count) + " ";
+    auto key_less = [](const KeyValue& a, const KeyValue& b){return a.first < b.first;};
+    auto sorted = [&](const std::vector<KeyValue>& data){return std::is_sorted(data.begin(), data.end(), key_less);};
+    typedef std::vector<KeyValue> Pairs;
+
+    run_sort(prefix + "std::stable_sort", pairs, [&](Pairs& data){
+        std::stable_sort(data.begin(), data.end(), key_less);
+    }, sorted);
+    run_sort(prefix + "radix_sort", pairs, [](Pairs& data){
+        radix_sort(data.begin(), data.end(), [](const KeyValue& pair){return pair.first;});
+    }, sorted);
+    run_sort(prefix + "stable_sample_sort", pairs, [&](Pairs& data){
+        parallel_stable_sample_sort(data.data(), data.data() + data.size(), threads, key_less);
+    }, sorted);
+}
+
+int main(int argc, char** argv){
+    std::size_t max_keys = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    std::size_t threads  = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for(std::size_t count = 1000000; count <= max_keys; count *= 10){
+        for(const char* distribution : {"uniform", "skewed", "nearly_sorted"}){
+            run_keys(distribution, count, threads);
+        }
+        run_pairs(count, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// SPSCQueue between two threads pinned to different CPUs.
+//
+//  - ping_pong: two queues, one in each direction. Each message is echoed back before the next is sent, so the time
+//    per round trip divided by two is the one way hand off latency.
+//  - throughput: the producer streams items as fast as it can, one at a time or in batches with push_bulk/pop_bulk.
+//    A mutex protected Queue<T> is run the same way as a baseline.
+//
+// Waits spin with cpu_relax and fall back to yielding now and then, so the benchmark still makes progress (slowly) if
+// both threads end up on one CPU.
+//
+// Usage: spsc_bench [items] [round_trips]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/Concurrency.h"
+#include "../src/include/Queue.h"
+#include "../src/include/SPSCQueue.h"
+
+static const std::size_t CAPACITY = 4096;
+
+static void backoff(unsigned& spins){
+    if(++spins % 1024 == 0){
+        std::this_thread::yield();
+    }else{
+        cpu_relax();
+    }
+}
+
+static void ping_pong(std::size_t round_trips){
+    SPSCQueue<std::uint64_t> ping(CAPACITY), pong(CAPACITY);
+    std::thread echo([&]{
+        pin_thread(1);
+        for(std::size_t i = 0; i < round_trips; ++i){
+            std::uint64_t value;
+            unsigned spins = 0;
+            while(!ping.try_pop(value)){
+                backoff(spins);
+            }
+            while(!pong.try_push(value)){
+                backoff(spins);
+            }
+        }
+    });
+
+    pin_thread(0);
+    BenchTimer timer;
+    for(std::size_t i = 0; i < round_trips; ++i){
+        unsigned spins = 0;
+        while(!ping.try_push(i)){
+            backoff(spins);
+        }
+        std::uint64_t value;
+        while(!pong.try_pop(value)){
+            backoff(spins);
+        }
+    }
+    double ns = timer.elapsed_ns();
+    echo.join();
+    print_result("SPSCQueue/ping_pong/round_trip", round_trips, ns);
+    std::printf("%-48s %12.2f ns one way\n", "SPSCQueue/ping_pong", ns / round_trips / 2);
+}
+
+static void throughput(std::size_t items, std::size_t batch){
+    SPSCQueue<std::uint64_t> queue(CAPACITY);
+    std::uint64_t sum = 0;
+    std::thread consumer([&]{
+        pin_thread(1);
+        std::vector<std::uint64_t> out(batch);
+        std::size_t received = 0;
+        unsigned spins = 0;
+        while(received < items){
+            std::size_t count = batch == 1 ? queue.try_pop(out[0]) : queue.pop_bulk(out.data(), batch);
+            if(count == 0){
+                backoff(spins);
+            }
+            for(std::size_t i = 0; i < count; ++i){
+                sum += out[i];
+            }
+            received += count;
+        }
+    });
+
+    pin_thread(0);
+    std::vector<std::uint64_t> in(batch);
+    BenchTimer timer;
+    unsigned spins = 0;
+    for(std::size_t sent = 0; sent < items;){
+        std::size_t count;
+        if(batch == 1){
+            count = queue.try_push(sent);
+        }else{
+            std::size_t wanted = std::min(batch, items - sent);
+            for(std::size_t i = 0; i < wanted; ++i){
+                in[i] = sent + i;
+            }
+            count = queue.push_bulk(in.data(), wanted);
+        }
+        if(count == 0){
+            backoff(spins);
+        }
+        sent += count;
+    }
+    consumer.join();
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    char label[128];
+    std::snprintf(label, sizeof(label), "SPSCQueue/throughput/batch:%zu", batch);
+    print_result(label, items, ns);
+}
+
+static void mutex_throughput(std::size_t items){
+    Queue<std::uint64_t> queue;
+    std::mutex mutex;
+    std::uint64_t sum = 0;
+    std::thread consumer([&]{
+        pin_thread(1);
+        std::size_t received = 0;
+        unsigned spins = 0;
+        while(received < items){
+            bool got = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!queue.is_empty()){
+                    sum += queue.dequeue();
+                    got = true;
+                }
+            }
+            if(got){
+                received++;
+            }else{
+                backoff(spins);
+            }
+        }
+    });
+
+    pin_thread(0);
+    BenchTimer timer;
+    for(std::size_t sent = 0; sent < items; ++sent){
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.enqueue(sent);
+    }
+    consumer.join();
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    print_result("mutex+Queue/throughput", items, ns);
+}
+
+int main(int argc, char** argv){
+    std::size_t items       = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50000000;
+    std::size_t round_trips = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+    ping_pong(round_trips);
+    throughput(items, 1);
+    throughput(items, 64);
+    mutex_throughput(items / 10);
+    return 0;
+}
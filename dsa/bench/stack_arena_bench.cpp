@@ -0,0 +1,147 @@
+// Replays a request-shaped allocation trace against malloc/free, StackArena and std::pmr::monotonic_buffer_resource.
+//
+// Each request makes between 20 and 200 allocations, mostly small (16 to 128 bytes) with some medium ones (up to 1KB)
+// and the occasional large buffer (up to 16KB), and opens a nested scope now and then whose allocations are all freed
+// when it closes, like a helper that builds temporaries and returns. At the end of the request everything is freed.
+// malloc frees every allocation individually in LIFO order, the arena releases to a mark per scope, and the monotonic
+// resource can only release everything at the end of the request. Each allocation gets one byte written to it so the
+// memory is actually touched.
+//
+// Usage: stack_arena_bench [requests]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/StackArena.h"
+
+// The trace is a sequence of events: a positive size is an allocation, OPEN and CLOSE bracket a nested scope and END
+// finishes the request.
+static const std::int64_t OPEN  = -1;
+static const std::int64_t CLOSE = -2;
+static const std::int64_t END   = -3;
+
+static std::vector<std::int64_t> make_trace(std::size_t requests, std::size_t& allocations){
+    std::mt19937_64 rng(42);
+    std::vector<std::int64_t> trace;
+    allocations = 0;
+    for(std::size_t r = 0; r < requests; ++r){
+        std::size_t count = 20 + rng() % 181;
+        int depth = 0;
+        for(std::size_t i = 0; i < count; ++i){
+            unsigned roll = unsigned(rng() % 100);
+            if(roll < 5 && depth < 4){
+                trace.push_back(OPEN);
+                depth++;
+            }else if(roll < 10 && depth > 0){
+                trace.push_back(CLOSE);
+                depth--;
+            }
+            unsigned kind = unsigned(rng() % 100);
+            std::int64_t size = kind < 70 ? 16 + std::int64_t(rng() % 113) : kind < 95 ? 128 + std::int64_t(rng() % 897)
+                                                                           : 1024 + std::int64_t(rng() % 15361);
+            trace.push_back(size);
+            allocations++;
+        }
+        while(depth-- > 0){
+            trace.push_back(CLOSE);
+        }
+        trace.push_back(END);
+    }
+    return trace;
+}
+
+static void report(const char* name, std::size_t allocations, double ns){
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/request_trace", name);
+    print_result(label, allocations, ns);
+}
+
+static void run_malloc(const std::vector<std::int64_t>& trace, std::size_t allocations){
+    std::vector<void*> live;
+    std::vector<std::size_t> scopes;
+    std::uint64_t sum = 0;
+    auto free_to = [&](std::size_t size){
+        while(live.size() > size){
+            std::free(live.back());
+            live.pop_back();
+        }
+    };
+    BenchTimer timer;
+    for(std::int64_t event : trace){
+        if(event > 0){
+            unsigned char* ptr = static_cast<unsigned char*>(std::malloc(std::size_t(event)));
+            ptr[0] = 1;
+            sum += reinterpret_cast<std::uintptr_t>(ptr);
+            live.push_back(ptr);
+        }else if(event == OPEN){
+            scopes.push_back(live.size());
+        }else if(event == CLOSE){
+            free_to(scopes.back());
+            scopes.pop_back();
+        }else{
+            free_to(0);
+        }
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    report("malloc", allocations, ns);
+}
+
+static void run_arena(const std::vector<std::int64_t>& trace, std::size_t allocations){
+    StackArena arena;
+    std::vector<StackArena::Mark> scopes;
+    std::uint64_t sum = 0;
+    BenchTimer timer;
+    for(std::int64_t event : trace){
+        if(event > 0){
+            unsigned char* ptr = static_cast<unsigned char*>(arena.allocate(std::size_t(event)));
+            ptr[0] = 1;
+            sum += reinterpret_cast<std::uintptr_t>(ptr);
+        }else if(event == OPEN){
+            scopes.push_back(arena.mark());
+        }else if(event == CLOSE){
+            arena.release_to(scopes.back());
+            scopes.pop_back();
+        }else{
+            arena.reset();
+        }
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    report("StackArena", allocations, ns);
+    std::printf("%-50s %10zu bytes reserved\n", "", arena.reserved());
+}
+
+static void run_monotonic(const std::vector<std::int64_t>& trace, std::size_t allocations){
+    std::pmr::monotonic_buffer_resource resource;
+    std::uint64_t sum = 0;
+    BenchTimer timer;
+    for(std::int64_t event : trace){
+        if(event > 0){
+            unsigned char* ptr = static_cast<unsigned char*>(resource.allocate(std::size_t(event)));
+            ptr[0] = 1;
+            sum += reinterpret_cast<std::uintptr_t>(ptr);
+        }else if(event == END){
+            resource.release();
+        }
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum);
+    report("pmr::monotonic_buffer_resource", allocations, ns);
+}
+
+int main(int argc, char** argv){
+    std::size_t requests = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    std::size_t allocations;
+    std::vector<std::int64_t> trace = make_trace(requests, allocations);
+
+    run_malloc(trace, allocations);
+    run_arena(trace, allocations);
+    run_monotonic(trace, allocations);
+    return 0;
+}
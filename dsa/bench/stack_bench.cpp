@@ -0,0 +1,111 @@
+// Compares Stack<T> against std::vector<T>, std::stack<T> (over std::deque) and a stack that allocates every element
+// separately, the way Stack.h used to:
+//
+//  - traversal: many short iterative depth first walks of a complete binary tree, each with a fresh stack, as in a
+//    search that keeps its explicit stack in a local variable. The stack never gets deeper than the tree height, so
+//    Stack keeps everything in its inline buffer.
+//  - push_pop: a single stack filled to a large depth and drained again, repeatedly.
+//
+// Each line also reports the heap allocations per push.
+//
+// Usage: stack_bench [operations]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <stack>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "Bench.h"
+#include "../src/include/Stack.h"
+
+// Adapters so that one benchmark body can drive every container.
+template <class T, std::size_t INLINE_SIZE = default_stack_inline_size(sizeof(T))> struct StackOps{
+    Stack<T, INLINE_SIZE> m_stack;
+    void push(T value){m_stack.push(value);}
+    T pop(){return m_stack.pop();}
+    bool is_empty() const {return m_stack.is_empty();}
+};
+template <class T> struct VectorOps{
+    std::vector<T> m_stack;
+    void push(T value){m_stack.push_back(value);}
+    T pop(){T value = m_stack.back(); m_stack.pop_back(); return value;}
+    bool is_empty() const {return m_stack.empty();}
+};
+template <class T> struct StdStackOps{
+    std::stack<T> m_stack;
+    void push(T value){m_stack.push(value);}
+    T pop(){T value = m_stack.top(); m_stack.pop(); return value;}
+    bool is_empty() const {return m_stack.empty();}
+};
+template <class T> struct PerElementOps{
+    std::vector<std::unique_ptr<T>> m_stack;
+    PerElementOps(){m_stack.reserve(64);}
+    void push(T value){m_stack.push_back(std::make_unique<T>(value));}
+    T pop(){T value = *m_stack.back(); m_stack.pop_back(); return value;}
+    bool is_empty() const {return m_stack.empty();}
+};
+
+static void report(const char* name, const char* test, std::size_t operations, double ns, std::uint64_t allocations){
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/%s", name, test);
+    print_result(label, operations, ns);
+    std::printf("%-50s %10.4f allocs/op\n", "", double(allocations) / double(operations));
+}
+
+template <class Ops>
+static void run(const char* name, std::size_t operations){
+    std::uint64_t sum = 0;
+    {
+        // Node n of the tree has children 2n + 1 and 2n + 2; a walk visits all NODES nodes, pushing each one once.
+        const std::uint64_t NODES = (1u << 10) - 1;
+        std::size_t walks = operations / NODES;
+        std::uint64_t allocations = AllocCounter::allocations().load();
+        BenchTimer timer;
+        for(std::size_t walk = 0; walk < walks; ++walk){
+            Ops ops;
+            ops.push(0);
+            while(!ops.is_empty()){
+                std::uint64_t node = ops.pop();
+                sum += node;
+                if(2 * node + 2 < NODES){
+                    ops.push(2 * node + 2);
+                    ops.push(2 * node + 1);
+                }
+            }
+        }
+        double ns = timer.elapsed_ns();
+        report(name, "traversal", walks * NODES, ns, AllocCounter::allocations().load() - allocations);
+    }
+    {
+        const std::size_t depth = 100000;
+        std::size_t rounds = std::max<std::size_t>(operations / depth, 1);
+        Ops ops;
+        std::uint64_t allocations = AllocCounter::allocations().load();
+        BenchTimer timer;
+        for(std::size_t round = 0; round < rounds; ++round){
+            for(std::size_t i = 0; i < depth; ++i){
+                ops.push(i);
+            }
+            for(std::size_t i = 0; i < depth; ++i){
+                sum += ops.pop();
+            }
+        }
+        double ns = timer.elapsed_ns();
+        report(name, "push_pop", rounds * depth, ns, AllocCounter::allocations().load() - allocations);
+    }
+    do_not_optimize(sum);
+}
+
+int main(int argc, char** argv){
+    std::size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+    run<StackOps<std::uint64_t>>("Stack<uint64_t>", operations);
+    run<StackOps<std::uint64_t, 0>>("Stack<uint64_t, 0>", operations);
+    run<VectorOps<std::uint64_t>>("std::vector<uint64_t>", operations);
+    run<StdStackOps<std::uint64_t>>("std::stack<uint64_t>", operations);
+    run<PerElementOps<std::uint64_t>>("per_element_allocation", operations);
+    return 0;
+}
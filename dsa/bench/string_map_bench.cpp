@@ -0,0 +1,106 @@
+// Compares StringHashMap against std::unordered_map<std::string, V> for insert, hit and miss lookups and heap bytes per
+// entry.
+//
+// Usage: string_map_bench [entries]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "Bench.h"
+#include "../src/include/StringHashMap.h"
+
+// Keys look like identifiers from a real workload: a short common prefix and a variable length numeric tail, between
+// roughly 10 and 40 characters so that a good share of them are too long for std::string's small buffer.
+static std::vector<std::string> make_keys(std::size_t count, std::uint64_t seed){
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for(std::size_t i = 0; i < count; ++i){
+        std::string key = "user:" + std::to_string(i) + ":";
+        std::size_t padding = rng() % 28;
+        for(std::size_t j = 0; j < padding; ++j){
+            key.push_back(char('a' + rng() % 26));
+        }
+        keys.push_back(std::move(key));
+    }
+    return keys;
+}
+
+template <class Map, class Insert, class Find>
+static void run(const char* name, const std::vector<std::string>& keys, const std::vector<std::string>& lookups,
+                const std::vector<std::string>& misses, Insert insert, Find find){
+    std::int64_t bytes_before = AllocCounter::live_bytes().load();
+    std::uint64_t allocations_before = AllocCounter::allocations().load();
+    char label[128];
+    {
+        Map map;
+        BenchTimer timer;
+        for(std::size_t i = 0; i < keys.size(); ++i){
+            insert(map, keys[i], std::uint64_t(i));
+        }
+        double insert_ns = timer.elapsed_ns();
+        std::int64_t bytes = AllocCounter::live_bytes().load() - bytes_before;
+        std::uint64_t allocations = AllocCounter::allocations().load() - allocations_before;
+
+        timer.reset();
+        std::uint64_t sum = 0;
+        for(const std::string& key : lookups){
+            sum += find(map, key);
+        }
+        double hit_ns = timer.elapsed_ns();
+
+        timer.reset();
+        for(const std::string& key : misses){
+            sum += find(map, key);
+        }
+        double miss_ns = timer.elapsed_ns();
+        do_not_optimize(sum);
+
+        std::snprintf(label, sizeof(label), "%s/insert", name);
+        print_result(label, keys.size(), insert_ns);
+        std::snprintf(label, sizeof(label), "%s/find_hit", name);
+        print_result(label, lookups.size(), hit_ns);
+        std::snprintf(label, sizeof(label), "%s/find_miss", name);
+        print_result(label, misses.size(), miss_ns);
+        std::printf("%-48s %12.1f bytes/entry %8.3f allocs/entry\n", name, double(bytes) / keys.size(),
+                    double(allocations) / keys.size());
+    }
+}
+
+int main(int argc, char** argv){
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    std::vector<std::string> keys = make_keys(count, 1);
+    std::vector<std::string> lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937_64(2));
+    std::vector<std::string> misses = make_keys(count, 3);
+    for(std::string& key : misses){
+        key[0] = 'x';
+    }
+
+    run<StringHashMap<std::uint64_t>>("StringHashMap", keys, lookups, misses,
+        [](StringHashMap<std::uint64_t>& map, std::string_view key, std::uint64_t value){
+            map.insert(key, value);
+        },
+        [](StringHashMap<std::uint64_t>& map, std::string_view key) -> std::uint64_t{
+            std::uint64_t* value = map.find(key);
+            return value ? *value : 0;
+        });
+    run<std::unordered_map<std::string, std::uint64_t>>("std::unordered_map<std::string>", keys, lookups, misses,
+        [](std::unordered_map<std::string, std::uint64_t>& map, const std::string& key, std::uint64_t value){
+            map.emplace(key, value);
+        },
+        [](std::unordered_map<std::string, std::uint64_t>& map, const std::string& key) -> std::uint64_t{
+            auto it = map.find(key);
+            return it != map.end() ? it->second : 0;
+        });
+    return 0;
+}
@@ -0,0 +1,173 @@
+// Throughput of WorkStealingDeque against a std::deque behind a std::mutex with the same push/pop/steal interface.
+//
+//  - steal: one owner pushes every item and never pops, and 1 to max_threads thieves take them all with steal(). This
+//    is the worst case for the deque, since every item goes through the CAS on m_top and all thieves contend on it.
+//  - tree: a scheduler in miniature. Each worker has its own deque, runs a binary task tree that starts as one root task
+//    on worker 0, pops its own work LIFO and steals from a random victim when it runs dry. Nearly all operations are the
+//    owner's push and pop, which is the case the deque is designed for.
+//
+// Usage: work_stealing_bench [steal_items] [tree_depth] [max_threads]
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/include/Concurrency.h"
+#include "../src/include/WorkStealingDeque.h"
+
+class MutexDeque{
+private:
+    std::mutex m_mutex;
+    std::deque<std::uint32_t> m_deque;
+
+public:
+    void push(std::uint32_t value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_deque.push_back(value);
+    }
+    bool pop(std::uint32_t& value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_deque.empty()){
+            return false;
+        }
+        value = m_deque.back();
+        m_deque.pop_back();
+        return true;
+    }
+    bool steal(std::uint32_t& value){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_deque.empty()){
+            return false;
+        }
+        value = m_deque.front();
+        m_deque.pop_front();
+        return true;
+    }
+};
+
+static void backoff(unsigned& spins){
+    if(++spins % 256 == 0){
+        std::this_thread::yield();
+    }else{
+        cpu_relax();
+    }
+}
+
+template <class D>
+static void run_steal(const char* name, std::size_t items, int thieves){
+    D deque;
+    std::atomic<std::uint64_t> taken(0);
+    std::atomic<std::uint64_t> sum(0);
+    std::vector<std::thread> threads;
+
+    BenchTimer timer;
+    for(int t = 0; t < thieves; ++t){
+        threads.emplace_back([&, t]{
+            pin_thread(t + 1);
+            std::uint32_t item;
+            std::uint64_t local_sum = 0;
+            unsigned spins = 0;
+            while(taken.load(std::memory_order_relaxed) < items){
+                if(deque.steal(item)){
+                    local_sum += item;
+                    taken.fetch_add(1, std::memory_order_relaxed);
+                }else{
+                    backoff(spins);
+                }
+            }
+            sum += local_sum;
+        });
+    }
+    pin_thread(0);
+    for(std::size_t i = 0; i < items; ++i){
+        deque.push(std::uint32_t(i));
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    double ns = timer.elapsed_ns();
+    do_not_optimize(sum.load());
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/steal/thieves:%d", name, thieves);
+    print_result(label, items, ns);
+}
+
+// A task is its remaining depth. Running a task of depth d > 0 spawns two tasks of depth d - 1.
+template <class D>
+static void run_tree(const char* name, int depth, int workers){
+    std::vector<std::unique_ptr<D>> deques;
+    for(int w = 0; w < workers; ++w){
+        deques.emplace_back(new D());
+    }
+    std::atomic<std::int64_t> pending(1);
+    std::atomic<std::uint64_t> steals(0);
+    deques[0]->push(std::uint32_t(depth));
+
+    BenchTimer timer;
+    std::vector<std::thread> threads;
+    for(int w = 0; w < workers; ++w){
+        threads.emplace_back([&, w]{
+            pin_thread(w);
+            D& own = *deques[w];
+            std::mt19937 rng(w);
+            std::uint64_t local_steals = 0;
+            unsigned spins = 0;
+            std::uint32_t task;
+            while(pending.load(std::memory_order_acquire) > 0){
+                bool found = own.pop(task);
+                if(!found && workers > 1){
+                    int victim = int(rng() % (workers - 1));
+                    victim += victim >= w;
+                    found = deques[victim]->steal(task);
+                    local_steals += found;
+                }
+                if(!found){
+                    backoff(spins);
+                    continue;
+                }
+                if(task > 0){
+                    pending.fetch_add(2, std::memory_order_relaxed);
+                    own.push(task - 1);
+                    own.push(task - 1);
+                }
+                pending.fetch_sub(1, std::memory_order_release);
+            }
+            steals += local_steals;
+        });
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    double ns = timer.elapsed_ns();
+
+    std::size_t tasks = (std::size_t(1) << (depth + 1)) - 1;
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s/tree/workers:%d", name, workers);
+    print_result(label, tasks, ns);
+    std::printf("%-50s %10.4f%% of tasks stolen\n", "", 100.0 * double(steals.load()) / double(tasks));
+}
+
+int main(int argc, char** argv){
+    std::size_t steal_items = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    int tree_depth          = argc > 2 ? std::atoi(argv[2]) : 21;
+    int max_threads         = argc > 3 ? std::atoi(argv[3]) : 8;
+
+    for(int thieves = 1; thieves <= max_threads; thieves *= 2){
+        run_steal<WorkStealingDeque<std::uint32_t>>("WorkStealingDeque", steal_items, thieves);
+        run_steal<MutexDeque>("mutex_deque", steal_items, thieves);
+    }
+    for(int workers = 1; workers <= max_threads; workers *= 2){
+        run_tree<WorkStealingDeque<std::uint32_t>>("WorkStealingDeque", tree_depth, workers);
+        run_tree<MutexDeque>("mutex_deque", tree_depth, workers);
+    }
+    return 0;
+}
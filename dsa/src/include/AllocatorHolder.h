@@ -0,0 +1,77 @@
+#ifndef ALLOCATORHOLDER
+#define ALLOCATORHOLDER
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// AllocatorHolder is the base the allocator aware containers keep their allocator in. Most allocators (std::allocator,
+// SizeClassAllocator) are empty classes, and a member of an empty class still takes a byte and usually a word of
+// padding, so an empty allocator is held as a base class instead, where the empty base optimisation makes it free. An
+// allocator with state, such as std::pmr::polymorphic_allocator, is held as an ordinary member.
+template <class Allocator, bool EMPTY = std::is_empty<Allocator>::value && !std::is_final<Allocator>::value>
+class AllocatorHolder : private Allocator{
+protected:
+    explicit AllocatorHolder(const Allocator& allocator) : Allocator(allocator){}
+
+    Allocator& allocator() {return *this;}
+    const Allocator& allocator() const {return *this;}
+};
+template <class Allocator>
+class AllocatorHolder<Allocator, false>{
+private:
+    Allocator m_allocator;
+
+protected:
+    explicit AllocatorHolder(const Allocator& allocator) : m_allocator(allocator){}
+
+    Allocator& allocator() {return m_allocator;}
+    const Allocator& allocator() const {return m_allocator;}
+};
+
+// The allocator_traits rules for what happens to a container's allocator when the container is copied, assigned or
+// swapped. Copy and move assignment and swap only take the other container's allocator if the allocator asks for it
+// with the matching propagate_on_container_* trait; a polymorphic_allocator never does, so its containers stay on the
+// memory resource they were made with.
+template <class Allocator>
+Allocator select_copy_allocator(const Allocator& allocator){
+    return std::allocator_traits<Allocator>::select_on_container_copy_construction(allocator);
+}
+template <class Allocator>
+void copy_assign_allocator(Allocator& to, const Allocator& from){
+    if constexpr(std::allocator_traits<Allocator>::propagate_on_container_copy_assignment::value){
+        to = from;
+    }
+}
+template <class Allocator>
+void move_assign_allocator(Allocator& to, Allocator& from){
+    if constexpr(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value){
+        to = std::move(from);
+    }
+}
+template <class Allocator>
+void swap_allocators(Allocator& a, Allocator& b){
+    if constexpr(std::allocator_traits<Allocator>::propagate_on_container_swap::value){
+        using std::swap;
+        swap(a, b);
+    }
+}
+// Whether move assignment can always take the other container's storage: either the allocator goes along with it, or
+// any two of these allocators can free each other's memory. Otherwise it depends on the two allocators comparing equal,
+// and when they don't the elements have to be moved one by one into memory from this container's own allocator.
+template <class Allocator>
+constexpr bool move_assignment_steals = std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+                                     || std::allocator_traits<Allocator>::is_always_equal::value;
+template <class Allocator>
+bool can_steal_storage(const Allocator& to, const Allocator& from){
+    return move_assignment_steals<Allocator> || to == from;
+}
+// swap exchanges the containers' storage, so without propagate_on_container_swap the allocators have to be equal.
+template <class Allocator>
+bool can_swap_storage(const Allocator& a, const Allocator& b){
+    return std::allocator_traits<Allocator>::propagate_on_container_swap::value
+        || std::allocator_traits<Allocator>::is_always_equal::value || a == b;
+}
+
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef BLOCKINGQUEUE
+#define BLOCKINGQUEUE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Concurrency.h"
+#include "Queue.h"
+
+// BlockingQueue wraps Queue with a mutex so that consumers can wait for work instead of polling is_empty in a loop.
+//
+// A consumer that finds the queue empty first spins for a short while (SPIN_LIMIT checks of an atomic size, without
+// taking the lock), because in a busy pipeline the next item usually turns up within a few hundred nanoseconds and
+// parking and unparking a thread costs several microseconds. Only if nothing arrives does it park on a condition
+// variable, which on Linux is a futex wait.
+//
+// Producers only signal when they move the queue from empty to non-empty, and only if some consumer is actually
+// parked. While the queue has items in it no consumer can be asleep waiting for one, so waking on every push would be
+// a wasted system call; waking only on the transition avoids that and also avoids the thundering herd of notify_all.
+// A bulk push notifies as many consumers as it has items for, rather than one per item or all of them.
+//
+// Because later pushes onto a non-empty queue don't signal, a consumer that takes an item and leaves more behind wakes
+// the next parked consumer itself. Wakeups therefore cascade one at a time only as far as there is work to hand out.
+//
+// Allocator is passed through to the Queue underneath. It is only ever used with the lock held.
+template <class T, class Allocator = std::allocator<T>>
+class BlockingQueue{
+private:
+    static constexpr int SPIN_LIMIT = 2000;
+
+    Queue<T, Allocator>     m_queue;
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_not_empty;
+    int                     m_waiting;                  // Consumers parked on m_not_empty, guarded by m_mutex.
+    std::atomic<std::size_t> m_size;                    // Mirrors m_queue.size() for lock free spinning.
+
+    // Spins until the queue looks non-empty or the spin budget runs out. Returns whether it saw an item.
+    bool spin() const{
+        for(int i = 0; i < SPIN_LIMIT; ++i){
+            if(m_size.load(std::memory_order_relaxed) != 0){
+                return true;
+            }
+            cpu_relax();
+        }
+        return false;
+    }
+
+    // Called with the lock held after count items were added to a queue that held was_size items.
+    void notify_after_push(std::size_t was_size, std::size_t count){
+        if(was_size != 0 || m_waiting == 0){
+            return;
+        }
+        for(std::size_t i = 0; i < count && int(i) < m_waiting; ++i){
+            m_not_empty.notify_one();
+        }
+    }
+
+    // Called with the lock held after a consumer has taken its items.
+    void wake_next(){
+        m_size.store(m_queue.size(), std::memory_order_relaxed);
+        if(!m_queue.is_empty() && m_waiting > 0){
+            m_not_empty.notify_one();
+        }
+    }
+
+    T take_front(){
+        T value = m_queue.dequeue();
+        wake_next();
+        return value;
+    }
+
+public:
+    BlockingQueue() : BlockingQueue(Allocator()){};
+    explicit BlockingQueue(const Allocator& allocator) : m_queue(allocator), m_waiting(0), m_size(0){};
+    BlockingQueue(const BlockingQueue&) = delete;
+    BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+    void push(const T& value){emplace(value);}
+    void push(T&& value){emplace(std::move(value));}
+    template <class... Args>
+    void emplace(Args&&... args){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::size_t was_size = m_queue.size();
+        m_queue.emplace(std::forward<Args>(args)...);
+        m_size.store(was_size + 1, std::memory_order_relaxed);
+        notify_after_push(was_size, 1);
+    }
+    void push_bulk(const T* values, std::size_t count){
+        if(count == 0){
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::size_t was_size = m_queue.size();
+        m_queue.enqueue_bulk(values, count);
+        m_size.store(was_size + count, std::memory_order_relaxed);
+        notify_after_push(was_size, count);
+    }
+
+    // try_pop never blocks. It returns false if the queue is empty.
+    bool try_pop(T& out){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_queue.is_empty()){
+            return false;
+        }
+        out = take_front();
+        return true;
+    }
+
+    // pop blocks until an item is available.
+    T pop(){
+        spin();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_queue.is_empty()){
+            m_waiting++;
+            m_not_empty.wait(lock, [this]{return !m_queue.is_empty();});
+            m_waiting--;
+        }
+        return take_front();
+    }
+
+    // pop_for blocks for at most timeout, returning false if no item arrived in that time.
+    template <class Rep, class Period>
+    bool pop_for(T& out, const std::chrono::duration<Rep, Period>& timeout){
+        spin();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_queue.is_empty()){
+            m_waiting++;
+            bool arrived = m_not_empty.wait_for(lock, timeout, [this]{return !m_queue.is_empty();});
+            m_waiting--;
+            if(!arrived){
+                return false;
+            }
+        }
+        out = take_front();
+        return true;
+    }
+
+    // pop_many blocks until at least one item is available, then moves up to max_count items into out (appending) under
+    // a single acquisition of the lock. Returns the number of items taken.
+    std::size_t pop_many(std::vector<T>& out, std::size_t max_count){
+        if(max_count == 0){
+            return 0;
+        }
+        spin();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_queue.is_empty()){
+            m_waiting++;
+            m_not_empty.wait(lock, [this]{return !m_queue.is_empty();});
+            m_waiting--;
+        }
+        std::size_t count = std::min(max_count, m_queue.size());
+        std::size_t start = out.size();
+        out.resize(start + count);
+        m_queue.dequeue_bulk(out.data() + start, count);
+        wake_next();
+        return count;
+    }
+
+    std::size_t size() const {return m_size.load(std::memory_order_relaxed);}
+    bool is_empty() const {return size() == 0;}
+    // The Queue's allocator never changes after construction, so reading it needs no lock.
+    Allocator get_allocator() const {return m_queue.get_allocator();}
+};
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef BROADCASTRING
+#define BROADCASTRING
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Concurrency.h"
+
+// Wait strategies decide what a BroadcastRing thread does while it waits, either a consumer waiting for the producer to
+// publish or the producer waiting for the slowest consumer to free a slot. wait(ready) returns once ready() is true, and
+// signal() is called after every publish and every release so that a strategy which sleeps can wake its waiters.
+//
+// BusySpinWait has the lowest latency but burns a core per waiting thread, so only use it when every thread has a core
+// of its own. YieldingWait spins for a while and then yields the core on each check, which costs little latency while
+// the ring is busy and lets other threads run when it isn't. BlockingWait parks on a condition variable, for consumers
+// that can sit idle for long periods; its signal() costs a fence and a load when nobody is waiting.
+struct BusySpinWait{
+    template <class Ready>
+    void wait(Ready ready){
+        while(!ready()){
+            cpu_relax();
+        }
+    }
+    void signal(){}
+};
+
+struct YieldingWait{
+    static constexpr int SPIN_LIMIT = 100;
+
+    template <class Ready>
+    void wait(Ready ready){
+        for(int spins = 0; !ready(); ++spins){
+            if(spins < SPIN_LIMIT){
+                cpu_relax();
+            }else{
+                std::this_thread::yield();
+            }
+        }
+    }
+    void signal(){}
+};
+
+class BlockingWait{
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::atomic<int> m_waiting{0};
+
+public:
+    template <class Ready>
+    void wait(Ready ready){
+        if(ready()){
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_waiting.fetch_add(1);
+        m_changed.wait(lock, ready);
+        m_waiting.fetch_sub(1);
+    }
+    // The fence orders the caller's store of its sequence before the load of m_waiting, pairing with the fetch_add in
+    // wait, so either the waiter sees the new sequence when it checks ready() or signal sees the waiter.
+    void signal(){
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_waiting.load(std::memory_order_relaxed) > 0){
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_changed.notify_all();
+        }
+    }
+};
+
+
+// BroadcastRing is a single producer ring buffer in the style of the LMAX Disruptor, where every consumer sees every
+// event. Events are written into the ring once and read in place, so there are no copies per consumer, unlike fanning
+// out into one queue per consumer.
+//
+// Each event has a 64 bit sequence number, and event s lives in slot s & mask. The producer publishes by advancing
+// m_cursor, the sequence of the last published event. Each consumer has its own sequence, the last event it has finished
+// with, on its own cache line, and the producer may only reuse a slot once every consumer has moved past it; so the ring
+// runs at the speed of the slowest consumer, and consumers never contend with each other. The producer caches the
+// minimum of the consumer sequences and only rescans them when the cache says the ring is full.
+//
+// Both sides work in batches. The producer claims a run of slots, fills them and publishes them with one store. A
+// consumer asks for the next sequence and gets back the highest sequence available, which may be many events ahead, and
+// releases them all with one store once it has processed them.
+//
+// Consumers must be added with add_consumer before the producer publishes anything.
+//
+// The slots come from Allocator, which only the constructor and destructor use, so it needn't be thread safe. The
+// consumers' sequences, one cache line each and allocated once per add_consumer, still come from new.
+template <class T, class WaitStrategy = YieldingWait, class Allocator = std::allocator<T>>
+class BroadcastRing{
+private:
+    struct alignas(CACHE_LINE_SIZE) Sequence{
+        std::atomic<std::int64_t> m_value{-1};
+    };
+
+    alignas(CACHE_LINE_SIZE) Sequence m_cursor;
+    alignas(CACHE_LINE_SIZE) std::int64_t m_next;           // Producer only: the next sequence to claim.
+    std::int64_t m_cached_gate;                              // Producer only: a lower bound on the slowest consumer.
+    std::vector<std::unique_ptr<Sequence>> m_consumers;
+    T*           m_slots;
+    std::int64_t m_mask;
+    Allocator    m_allocator;
+    WaitStrategy m_wait;
+
+    std::int64_t slowest_consumer() const{
+        std::int64_t slowest = std::numeric_limits<std::int64_t>::max();
+        for(const std::unique_ptr<Sequence>& consumer : m_consumers){
+            slowest = std::min(slowest, consumer->m_value.load(std::memory_order_acquire));
+        }
+        return slowest;
+    }
+
+public:
+    class Consumer;
+
+    // capacity is rounded up to a power of two.
+    explicit BroadcastRing(std::size_t capacity, const Allocator& allocator = Allocator())
+        : m_next(0), m_cached_gate(-1), m_allocator(allocator){
+        std::size_t size = 1;
+        while(size < capacity){
+            size *= 2;
+        }
+        // The slots are default initialised, as new T[size] would leave them.
+        m_slots = m_allocator.allocate(size);
+        try{
+            std::uninitialized_default_construct(m_slots, m_slots + size);
+        }catch(...){
+            m_allocator.deallocate(m_slots, size);
+            throw;
+        }
+        m_mask = std::int64_t(size) - 1;
+    }
+    BroadcastRing(const BroadcastRing&) = delete;
+    BroadcastRing& operator=(const BroadcastRing&) = delete;
+    ~BroadcastRing(){
+        std::destroy(m_slots, m_slots + m_mask + 1);
+        m_allocator.deallocate(m_slots, std::size_t(m_mask + 1));
+    }
+
+    Consumer add_consumer(){
+        assert(m_cursor.m_value.load() == -1 && "Consumers must be added to a BroadcastRing before the first publish");
+        m_consumers.emplace_back(new Sequence());
+        return Consumer(this, m_consumers.back().get());
+    }
+
+    // claim waits until count slots are free and returns the sequence of the first. The caller fills slots first ...
+    // first + count - 1 through operator[] and then publishes them with publish(first + count - 1).
+    std::int64_t claim(std::size_t count = 1){
+        assert(count > 0 && std::int64_t(count) <= m_mask + 1 && "BroadcastRing can't claim more slots than it has");
+        std::int64_t first = m_next;
+        std::int64_t wrap_point = first + std::int64_t(count) - 1 - (m_mask + 1);
+        if(wrap_point > m_cached_gate){
+            m_wait.wait([&]{
+                m_cached_gate = slowest_consumer();
+                return wrap_point <= m_cached_gate;
+            });
+        }
+        m_next += std::int64_t(count);
+        return first;
+    }
+    // try_claim is claim that returns false instead of waiting when the slots aren't free yet.
+    bool try_claim(std::size_t count, std::int64_t& first){
+        assert(count > 0 && std::int64_t(count) <= m_mask + 1 && "BroadcastRing can't claim more slots than it has");
+        std::int64_t wrap_point = m_next + std::int64_t(count) - 1 - (m_mask + 1);
+        if(wrap_point > m_cached_gate){
+            m_cached_gate = slowest_consumer();
+            if(wrap_point > m_cached_gate){
+                return false;
+            }
+        }
+        first = m_next;
+        m_next += std::int64_t(count);
+        return true;
+    }
+    T& operator[](std::int64_t sequence) {return m_slots[sequence & m_mask];}
+    // publish makes every claimed event up to and including sequence visible to the consumers.
+    void publish(std::int64_t sequence){
+        m_cursor.m_value.store(sequence, std::memory_order_release);
+        m_wait.signal();
+    }
+    void push(const T& value){
+        std::int64_t sequence = claim(1);
+        m_slots[sequence & m_mask] = value;
+        publish(sequence);
+    }
+
+    std::int64_t cursor() const {return m_cursor.m_value.load(std::memory_order_acquire);}
+    std::size_t capacity() const {return std::size_t(m_mask + 1);}
+    std::size_t consumers() const {return m_consumers.size();}
+    Allocator get_allocator() const {return m_allocator;}
+};
+
+// A Consumer is one reader's view of the ring; each must be used by a single thread.
+template <class T, class WaitStrategy, class Allocator>
+class BroadcastRing<T, WaitStrategy, Allocator>::Consumer{
+private:
+    BroadcastRing* m_ring;
+    Sequence*      m_sequence;
+    std::int64_t   m_next;              // The next sequence this consumer will read.
+    std::int64_t   m_available;         // The highest sequence known to be published.
+
+    friend class BroadcastRing;
+    Consumer(BroadcastRing* ring, Sequence* sequence) : m_ring(ring), m_sequence(sequence), m_next(0), m_available(-1){};
+
+public:
+    // wait_for waits until sequence is published and returns the highest published sequence, which may be later.
+    std::int64_t wait_for(std::int64_t sequence){
+        if(m_available < sequence){
+            m_ring->m_wait.wait([&]{
+                m_available = m_ring->cursor();
+                return m_available >= sequence;
+            });
+        }
+        return m_available;
+    }
+    const T& operator[](std::int64_t sequence) const {return m_ring->m_slots[sequence & m_ring->m_mask];}
+    // release tells the producer that this consumer is done with every event up to and including sequence.
+    void release(std::int64_t sequence){
+        m_next = sequence + 1;
+        m_sequence->m_value.store(sequence, std::memory_order_release);
+        m_ring->m_wait.signal();
+    }
+
+    // consume waits for at least one event, passes every available event (up to max_count) to handler(event, sequence)
+    // in order and releases them together. It returns how many it handled.
+    template <class Handler>
+    std::size_t consume(Handler handler, std::size_t max_count = std::numeric_limits<std::size_t>::max()){
+        std::int64_t last = wait_for(m_next);
+        if(std::size_t(last - m_next) >= max_count){
+            last = m_next + std::int64_t(max_count) - 1;
+        }
+        for(std::int64_t sequence = m_next; sequence <= last; ++sequence){
+            handler((*this)[sequence], sequence);
+        }
+        std::size_t count = std::size_t(last - m_next + 1);
+        release(last);
+        return count;
+    }
+    // try_consume is consume that returns 0 instead of waiting when nothing has been published.
+    template <class Handler>
+    std::size_t try_consume(Handler handler, std::size_t max_count = std::numeric_limits<std::size_t>::max()){
+        if(m_available < m_next){
+            m_available = m_ring->cursor();
+            if(m_available < m_next){
+                return 0;
+            }
+        }
+        return consume(handler, max_count);
+    }
+
+    std::int64_t next_sequence() const {return m_next;}
+};
+
+#endif
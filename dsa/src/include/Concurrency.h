@@ -0,0 +1,108 @@
+#ifndef CONCURRENCY
+#define CONCURRENCY
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Shared definitions for the concurrent containers.
+
+// Fields written by different threads are aligned to CACHE_LINE_SIZE so that they don't share a cache line, otherwise
+// every write by one thread invalidates the line the other thread is reading (false sharing). 64 bytes covers x86 and
+// most ARM cores; std::hardware_destructive_interference_size isn't used because GCC warns that its value can change
+// between compiler versions, which would silently change the layout of these classes.
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// cpu_relax is called in spin loops. On x86 the pause instruction stops the core from speculatively running ahead in
+// the loop, which saves power and avoids a memory order mis-speculation when the awaited value finally changes.
+inline void cpu_relax(){
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Structures that keep a slot per thread (flat combining's publication list, for example) index their slots with
+// thread_index(), a small number that is unique among the threads alive at the time. A thread claims the lowest free
+// index the first time it calls thread_index and gives it back when it exits, so the indices stay dense even in a program
+// that keeps starting new threads, and arrays of MAX_THREADS slots are enough.
+constexpr std::size_t MAX_THREADS = 256;
+
+inline std::atomic<bool>* thread_index_claims(){
+    static std::atomic<bool> claims[MAX_THREADS];
+    return claims;
+}
+// The highest index claimed so far plus one, so that code scanning every thread's slot can stop early.
+inline std::atomic<std::size_t>& thread_index_limit(){
+    static std::atomic<std::size_t> limit{0};
+    return limit;
+}
+
+inline std::size_t thread_index(){
+    struct Claim{
+        std::size_t m_index;
+
+        Claim(){
+            std::atomic<bool>* claims = thread_index_claims();
+            for(m_index = 0; m_index < MAX_THREADS; ++m_index){
+                if(!claims[m_index].load(std::memory_order_relaxed) && !claims[m_index].exchange(true, std::memory_order_acquire)){
+                    break;
+                }
+            }
+            assert(m_index < MAX_THREADS && "More than MAX_THREADS threads are using thread_index");
+            std::size_t limit = thread_index_limit().load(std::memory_order_relaxed);
+            while(limit < m_index + 1 && !thread_index_limit().compare_exchange_weak(limit, m_index + 1)){
+            }
+        }
+        ~Claim(){
+            thread_index_claims()[m_index].store(false, std::memory_order_release);
+        }
+    };
+    thread_local Claim claim;
+    return claim.m_index;
+}
+
+// ThreadBarrier blocks each of a fixed number of threads in wait() until all of them have called it, and can be reused
+// straight away for the next phase. Parallel algorithms that run in rounds (a BFS level, a sort pass) use it between
+// rounds. Waiting threads sleep on a condition variable rather than spin, since rounds are long compared to the cost of a
+// wake up and the threads may outnumber the cores.
+class ThreadBarrier{
+private:
+    std::mutex              m_mutex;
+    std::condition_variable m_released;
+    std::size_t             m_threads;
+    std::size_t             m_waiting;
+    std::uint64_t           m_generation;
+
+public:
+    explicit ThreadBarrier(std::size_t threads) : m_threads(threads), m_waiting(0), m_generation(0){
+        assert(threads > 0 && "ThreadBarrier needs at least one thread");
+    }
+    ThreadBarrier(const ThreadBarrier&) = delete;
+    ThreadBarrier& operator=(const ThreadBarrier&) = delete;
+
+    void wait(){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        std::uint64_t generation = m_generation;
+        if(++m_waiting == m_threads){
+            m_waiting = 0;
+            m_generation++;
+            m_released.notify_all();
+        }else{
+            m_released.wait(lock, [&]{return m_generation != generation;});
+        }
+    }
+};
+
+#endif
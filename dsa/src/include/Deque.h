@@ -0,0 +1,328 @@
+#ifndef DEQUE
+#define DEQUE
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "AllocatorHolder.h"
+
+// The default number of elements per block: as many as fit in 4KB, rounded down to a power of two, but never fewer
+// than 16. std::deque (libstdc++) uses 512 byte blocks, which for any T over 512 bytes means one element per block and
+// so one allocation and one map slot per element. Keeping at least 16 elements per block bounds that overhead.
+constexpr std::size_t default_deque_block_size(std::size_t element_size){
+    std::size_t count = 16;
+    while(count * 2 * element_size <= 4096){
+        count *= 2;
+    }
+    return count;
+}
+
+// Deque is a double ended queue stored as fixed size blocks of BLOCK_SIZE elements, plus a map: an array of pointers to
+// the blocks in order. Element i lives at position m_first + i, in block (position / BLOCK_SIZE) at offset
+// (position % BLOCK_SIZE); BLOCK_SIZE is a power of two so both are a shift and a mask, and operator[] is O(1).
+//
+// Pushing at either end writes into the end block, or into a newly allocated block when that one is full, and popping
+// frees a block once it is empty. Elements are never moved or copied once constructed, so references and pointers to
+// them stay valid until that element is popped; only the map of block pointers is ever reallocated, and only when a
+// push runs off one of its ends.
+//
+// A single spare block is kept when a block empties so that a deque which hovers around a block boundary (a queue that
+// is usually nearly empty, say) doesn't allocate and free a block on every other push.
+//
+// Blocks come from Allocator and the map from Allocator rebound to T*. The deque keeps one Allocator, which costs nothing
+// when it is stateless, rebinds a copy of it for the map, and passes it on when copied, assigned or swapped as
+// allocator_traits says.
+template <class T, std::size_t BLOCK_SIZE = default_deque_block_size(sizeof(T)), class Allocator = std::allocator<T>>
+class Deque : private AllocatorHolder<Allocator>{
+    static_assert(BLOCK_SIZE > 0 && (BLOCK_SIZE & (BLOCK_SIZE - 1)) == 0, "Deque BLOCK_SIZE must be a power of two");
+    static_assert(std::is_same<typename Allocator::value_type, T>::value, "Deque Allocator must allocate T");
+
+private:
+    static constexpr std::size_t MIN_MAP_SIZE = 8;
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<T*> MapAllocator;
+
+    T**         m_map;
+    std::size_t m_map_size;
+    std::size_t m_first;        // Position of the front element, counted from the start of block m_map[0].
+    std::size_t m_size;
+    T*          m_spare;
+
+    static std::size_t block(std::size_t position) {return position / BLOCK_SIZE;}
+    static std::size_t offset(std::size_t position) {return position % BLOCK_SIZE;}
+    T* address(std::size_t position) const {return m_map[block(position)] + offset(position);}
+
+    void acquire_block(std::size_t index){
+        if(m_map[index] == nullptr){
+            m_map[index] = m_spare ? m_spare : this->allocator().allocate(BLOCK_SIZE);
+            m_spare = nullptr;
+        }
+    }
+    void release_block(std::size_t index){
+        if(m_spare == nullptr){
+            m_spare = m_map[index];
+        }else{
+            this->allocator().deallocate(m_map[index], BLOCK_SIZE);
+        }
+        m_map[index] = nullptr;
+    }
+    // Frees the spare block and the map. The deque must be empty.
+    void release();
+    // Takes other's map and blocks, leaving other empty. This deque must have no map.
+    void steal(Deque& other) noexcept;
+
+    // Makes room in the map for one more block at each end. If the blocks in use take up less than half of the map they
+    // are just recentred in it, otherwise the map doubles.
+    void expand_map();
+
+public:
+    Deque() : Deque(Allocator()){};
+    explicit Deque(const Allocator& allocator)
+        : AllocatorHolder<Allocator>(allocator), m_map(nullptr), m_map_size(0), m_first(0), m_size(0), m_spare(nullptr){};
+    Deque(const Deque& other);
+    Deque(Deque&& other) noexcept;
+    Deque& operator=(const Deque& other);
+    Deque& operator=(Deque&& other) noexcept(move_assignment_steals<Allocator>);
+    ~Deque();
+
+    void swap(Deque& other) noexcept{
+        assert(can_swap_storage(this->allocator(), other.allocator()) && "Can't swap Deques with unequal allocators");
+        using std::swap;
+        swap_allocators(this->allocator(), other.allocator());
+        swap(m_map, other.m_map);
+        swap(m_map_size, other.m_map_size);
+        swap(m_first, other.m_first);
+        swap(m_size, other.m_size);
+        swap(m_spare, other.m_spare);
+    }
+    Allocator get_allocator() const {return this->allocator();}
+
+    void push_back(const T& value){emplace_back(value);}
+    void push_back(T&& value){emplace_back(std::move(value));}
+    void push_front(const T& value){emplace_front(value);}
+    void push_front(T&& value){emplace_front(std::move(value));}
+    template <class... Args>
+    T& emplace_back(Args&&... args);
+    template <class... Args>
+    T& emplace_front(Args&&... args);
+    T pop_back();
+    T pop_front();
+
+    T& operator[](std::size_t index){
+        assert(index < m_size && "Deque index out of range");
+        return *address(m_first + index);
+    }
+    const T& operator[](std::size_t index) const{
+        assert(index < m_size && "Deque index out of range");
+        return *address(m_first + index);
+    }
+    T& front(){
+        assert(m_size > 0 && "Can't read the front of an empty Deque");
+        return *address(m_first);
+    }
+    T& back(){
+        assert(m_size > 0 && "Can't read the back of an empty Deque");
+        return *address(m_first + m_size - 1);
+    }
+
+    void clear();
+
+    bool is_empty() const {return m_size == 0;}
+    std::size_t size() const {return m_size;}
+    static constexpr std::size_t block_size() {return BLOCK_SIZE;}
+};
+
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+void Deque<T, BLOCK_SIZE, Allocator>::expand_map(){
+    // An empty deque owns no blocks, so the map only has to have room and the front can start anywhere in it.
+    std::size_t first_block = m_size ? block(m_first) : 0;
+    std::size_t used = m_size ? block(m_first + m_size - 1) - first_block + 1 : 0;
+
+    std::size_t map_size = m_map_size;
+    if(map_size < MIN_MAP_SIZE || 2 * (used + 1) > map_size){
+        map_size = map_size < MIN_MAP_SIZE ? MIN_MAP_SIZE : map_size * 2;
+    }
+    // Centre the blocks in use. The map is at least twice the size of the blocks in use plus one, so that leaves at
+    // least one free slot on each side.
+    std::size_t new_first_block = (map_size - used) / 2;
+
+    if(map_size == m_map_size){
+        std::memmove(static_cast<void*>(m_map + new_first_block), m_map + first_block, used * sizeof(T*));
+        if(new_first_block > first_block){
+            std::fill(m_map + first_block, m_map + new_first_block, nullptr);
+        }else{
+            std::fill(m_map + new_first_block + used, m_map + first_block + used, nullptr);
+        }
+    }else{
+        MapAllocator map_allocator(this->allocator());
+        T** map = map_allocator.allocate(map_size);
+        std::fill(map, map + map_size, nullptr);
+        if(used){
+            std::memcpy(static_cast<void*>(map + new_first_block), m_map + first_block, used * sizeof(T*));
+        }
+        if(m_map != nullptr){
+            map_allocator.deallocate(m_map, m_map_size);
+        }
+        m_map      = map;
+        m_map_size = map_size;
+    }
+    m_first = new_first_block * BLOCK_SIZE + (m_size ? offset(m_first) : BLOCK_SIZE / 2);
+}
+
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+void Deque<T, BLOCK_SIZE, Allocator>::release(){
+    if(m_spare != nullptr){
+        this->allocator().deallocate(m_spare, BLOCK_SIZE);
+    }
+    if(m_map != nullptr){
+        MapAllocator(this->allocator()).deallocate(m_map, m_map_size);
+    }
+    m_map      = nullptr;
+    m_map_size = 0;
+    m_first    = 0;
+    m_spare    = nullptr;
+}
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+void Deque<T, BLOCK_SIZE, Allocator>::steal(Deque& other) noexcept{
+    m_map      = other.m_map;
+    m_map_size = other.m_map_size;
+    m_first    = other.m_first;
+    m_size     = other.m_size;
+    m_spare    = other.m_spare;
+    other.m_map      = nullptr;
+    other.m_map_size = 0;
+    other.m_first    = 0;
+    other.m_size     = 0;
+    other.m_spare    = nullptr;
+}
+
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+Deque<T, BLOCK_SIZE, Allocator>::Deque(const Deque& other) : Deque(select_copy_allocator(other.allocator())){
+    for(std::size_t i = 0; i < other.m_size; ++i){
+        emplace_back(other[i]);
+    }
+}
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+Deque<T, BLOCK_SIZE, Allocator>::Deque(Deque&& other) noexcept : Deque(other.allocator()){
+    steal(other);
+}
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+Deque<T, BLOCK_SIZE, Allocator>& Deque<T, BLOCK_SIZE, Allocator>::operator=(const Deque& other){
+    if(this != &other){
+        clear();
+        if(std::allocator_traits<Allocator>::propagate_on_container_copy_assignment::value
+           && !(this->allocator() == other.allocator())){
+            // The spare block and the map have to go back to the allocator that gave them out before it is replaced.
+            release();
+            copy_assign_allocator(this->allocator(), other.allocator());
+        }
+        for(std::size_t i = 0; i < other.m_size; ++i){
+            emplace_back(other[i]);
+        }
+    }
+    return *this;
+}
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+Deque<T, BLOCK_SIZE, Allocator>& Deque<T, BLOCK_SIZE, Allocator>::operator=(Deque&& other) noexcept(move_assignment_steals<Allocator>){
+    if(this != &other){
+        clear();
+        if(can_steal_storage(this->allocator(), other.allocator())){
+            release();
+            move_assign_allocator(this->allocator(), other.allocator());
+            steal(other);
+        }else{
+            // other's blocks belong to a different allocator, which stays with other, so the elements move over one by
+            // one into blocks from this deque's own allocator.
+            for(std::size_t i = 0; i < other.m_size; ++i){
+                emplace_back(std::move(other[i]));
+            }
+            other.clear();
+        }
+    }
+    return *this;
+}
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+Deque<T, BLOCK_SIZE, Allocator>::~Deque(){
+    clear();
+    release();
+}
+
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+template <class... Args>
+T& Deque<T, BLOCK_SIZE, Allocator>::emplace_back(Args&&... args){
+    std::size_t position = m_first + m_size;
+    if(m_map_size == 0 || block(position) >= m_map_size){
+        expand_map();
+        position = m_first + m_size;
+    }
+    acquire_block(block(position));
+    T* back = address(position);
+    ::new (static_cast<void*>(back)) T(std::forward<Args>(args)...);
+    m_size++;
+    return *back;
+}
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+template <class... Args>
+T& Deque<T, BLOCK_SIZE, Allocator>::emplace_front(Args&&... args){
+    if(m_map_size == 0 || m_first == 0){
+        expand_map();
+    }
+    std::size_t position = m_first - 1;
+    acquire_block(block(position));
+    T* front = address(position);
+    ::new (static_cast<void*>(front)) T(std::forward<Args>(args)...);
+    m_first = position;
+    m_size++;
+    return *front;
+}
+
+// A block is empty once the element just removed was the last one in the deque, or the last one in its block on the side
+// it was removed from.
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+T Deque<T, BLOCK_SIZE, Allocator>::pop_back(){
+    assert(m_size > 0 && "Deque underflow would occur with pop_back");
+    std::size_t position = m_first + m_size - 1;
+    T* back = address(position);
+    T tmp(std::move(*back));
+    back->~T();
+    m_size--;
+    if(m_size == 0 || offset(position) == 0){
+        release_block(block(position));
+    }
+    return tmp;
+}
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+T Deque<T, BLOCK_SIZE, Allocator>::pop_front(){
+    assert(m_size > 0 && "Deque underflow would occur with pop_front");
+    std::size_t position = m_first;
+    T* front = address(position);
+    T tmp(std::move(*front));
+    front->~T();
+    m_first++;
+    m_size--;
+    if(m_size == 0 || offset(position) == BLOCK_SIZE - 1){
+        release_block(block(position));
+    }
+    return tmp;
+}
+
+template <class T, std::size_t BLOCK_SIZE, class Allocator>
+void Deque<T, BLOCK_SIZE, Allocator>::clear(){
+    while(m_size > 0){
+        std::size_t position = m_first + m_size - 1;
+        address(position)->~T();
+        m_size--;
+        if(m_size == 0 || offset(position) == 0){
+            release_block(block(position));
+        }
+    }
+}
+
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef EPOCHRECLAMATION
+#define EPOCHRECLAMATION
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Concurrency.h"
+
+// EpochDomain is epoch-based reclamation (Fraser, "Practical Lock-Freedom", 2004): a way for a lock-free structure to
+// free a node that it has unlinked while other threads may still be reading it.
+//
+// Readers bracket every access to the shared structure with a critical section (an EpochGuard). On entry a thread
+// announces the global epoch it saw; on exit it announces that it is inactive. A node unlinked during epoch e is
+// retired rather than freed: it goes onto the retiring thread's limbo list for e. The global epoch can only move from
+// e to e + 1 once every thread inside a critical section has announced e, so by the time it reaches e + 2 every
+// thread that could have loaded a pointer to the node in epoch e (or before) has left its critical section, and the
+// node can be freed.
+//
+// The read side costs one store of the thread's own epoch word and a fence on entry, and one store on exit. Unlike
+// hazard pointers there is nothing to do per pointer read, so a traversal that follows many pointers pays the same as
+// one that follows a single one. The price is that a thread that stalls inside a critical section holds up all
+// reclamation until it leaves (memory then grows, but nothing is freed early).
+//
+// Threads register implicitly: each thread uses the record at its thread_index(), on its own cache line. Retired nodes
+// are batched: every RETIRE_BATCH retirements the thread tries to advance the global epoch and frees whichever of its
+// limbo lists have become safe. A thread's leftover limbo lists stay in its record when it exits and are picked up by
+// the next thread that gets the same index, or freed when the domain is destroyed.
+class EpochDomain{
+private:
+    static constexpr std::size_t RETIRE_BATCH = 64;
+    static constexpr std::uint64_t ACTIVE     = 1;    // The low bit of a record's epoch word; the epoch is above it.
+
+    struct Retired{
+        void* m_ptr;
+        void  (*m_deleter)(void*);
+    };
+    struct Limbo{
+        std::uint64_t        m_epoch = 0;
+        std::vector<Retired> m_retired;
+    };
+    struct alignas(CACHE_LINE_SIZE) Record{
+        std::atomic<std::uint64_t> m_announced{0};     // epoch << 1 | ACTIVE while in a critical section.
+        std::size_t                m_nesting = 0;
+        std::size_t                m_since_collect = 0;
+        Limbo                      m_limbo[3];         // Indexed by epoch % 3.
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_epoch;
+    Record m_records[MAX_THREADS];
+
+    Record& record() {return m_records[thread_index()];}
+
+    static void free_all(Limbo& limbo){
+        for(const Retired& retired : limbo.m_retired){
+            retired.m_deleter(retired.m_ptr);
+        }
+        limbo.m_retired.clear();
+    }
+    // Frees the calling thread's limbo lists that were filled at least two epochs before epoch.
+    static void collect(Record& self, std::uint64_t epoch){
+        for(Limbo& limbo : self.m_limbo){
+            if(!limbo.m_retired.empty() && limbo.m_epoch + 2 <= epoch){
+                free_all(limbo);
+            }
+        }
+    }
+
+public:
+    EpochDomain() : m_epoch(0){};
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+    // No thread may be in a critical section of the domain when it is destroyed.
+    ~EpochDomain(){
+        for(Record& self : m_records){
+            for(Limbo& limbo : self.m_limbo){
+                free_all(limbo);
+            }
+        }
+    }
+
+    // enter and exit delimit a critical section; EpochGuard calls them. Critical sections may nest.
+    void enter(){
+        Record& self = record();
+        if(self.m_nesting++ == 0){
+            self.m_announced.store(m_epoch.load(std::memory_order_relaxed) << 1 | ACTIVE, std::memory_order_relaxed);
+            // The announcement must be visible before any pointer into the structure is read, otherwise an advancing
+            // thread could miss it and free the node this thread is about to read.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+    void exit(){
+        Record& self = record();
+        assert(self.m_nesting > 0 && "EpochDomain exit without a matching enter");
+        if(--self.m_nesting == 0){
+            self.m_announced.store(self.m_announced.load(std::memory_order_relaxed) & ~ACTIVE, std::memory_order_release);
+        }
+    }
+
+    // retire schedules ptr to be passed to deleter once no thread can still be reading it. ptr must already be
+    // unreachable from the shared structure.
+    void retire(void* ptr, void (*deleter)(void*));
+    template <class T>
+    void retire(T* ptr){
+        retire(static_cast<void*>(ptr), [](void* p){delete static_cast<T*>(p);});
+    }
+
+    // try_advance moves the global epoch on by one if every thread in a critical section has seen the current one.
+    bool try_advance();
+    // reclaim frees everything the calling thread has retired, advancing the epoch as often as that takes. It waits for
+    // other threads to leave their critical sections, so the caller must not be inside one.
+    void reclaim();
+    // try_reclaim is reclaim without the waiting: it advances the epoch as far as it can right now, at most twice, and
+    // frees whatever of the calling thread's retirements that made safe. It suits a thread that retires too rarely for
+    // RETIRE_BATCH to ever come round, and may be called at any convenient point outside a critical section.
+    void try_reclaim();
+
+    std::uint64_t epoch() const {return m_epoch.load(std::memory_order_relaxed);}
+    // The number of nodes the calling thread has retired that haven't been freed yet.
+    std::size_t pending(){
+        std::size_t count = 0;
+        for(const Limbo& limbo : record().m_limbo){
+            count += limbo.m_retired.size();
+        }
+        return count;
+    }
+};
+
+inline void EpochDomain::retire(void* ptr, void (*deleter)(void*)){
+    Record& self = record();
+    // The node is filed under the global epoch as it is now, after the unlink. That can be one ahead of the epoch this
+    // thread announced, and has to be: a reader that announced the newer epoch may have loaded the node just before it
+    // was unlinked.
+    std::uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+    Limbo& limbo = self.m_limbo[epoch % 3];
+    if(limbo.m_epoch != epoch){
+        // The list holds nodes from three epochs ago, which are safe by now.
+        free_all(limbo);
+        limbo.m_epoch = epoch;
+    }
+    limbo.m_retired.push_back(Retired{ptr, deleter});
+    if(++self.m_since_collect >= RETIRE_BATCH){
+        self.m_since_collect = 0;
+        try_advance();
+        collect(self, m_epoch.load(std::memory_order_acquire));
+    }
+}
+
+inline bool EpochDomain::try_advance(){
+    std::uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::size_t limit = thread_index_limit().load(std::memory_order_acquire);
+    for(std::size_t i = 0; i < limit; ++i){
+        std::uint64_t announced = m_records[i].m_announced.load(std::memory_order_acquire);
+        if((announced & ACTIVE) && (announced >> 1) != epoch){
+            return false;
+        }
+    }
+    return m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+}
+
+inline void EpochDomain::reclaim(){
+    Record& self = record();
+    assert(self.m_nesting == 0 && "EpochDomain reclaim inside a critical section would never finish");
+    for(unsigned spins = 0; pending() > 0; ++spins){
+        try_advance();
+        collect(self, m_epoch.load(std::memory_order_acquire));
+        if(spins % 64 == 63){
+            std::this_thread::yield();
+        }else{
+            cpu_relax();
+        }
+    }
+}
+
+inline void EpochDomain::try_reclaim(){
+    Record& self = record();
+    assert(self.m_nesting == 0 && "EpochDomain try_reclaim inside a critical section can't advance past it");
+    if(try_advance()){
+        try_advance();
+    }
+    collect(self, m_epoch.load(std::memory_order_acquire));
+}
+
+// EpochGuard is a critical section of an EpochDomain: pointers read from the structure while it is alive stay valid
+// until it is destroyed.
+class EpochGuard{
+private:
+    EpochDomain& m_domain;
+
+public:
+    explicit EpochGuard(EpochDomain& domain) : m_domain(domain) {m_domain.enter();}
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+    ~EpochGuard() {m_domain.exit();}
+};
+
+#endif
@@ -0,0 +1,615 @@
+#ifndef EXTERNALSORT
+#define EXTERNALSORT
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BlockingQueue.h"
+#include "Queue.h"
+#include "Sort.h"
+
+// AsyncIo runs file reads and writes on a background thread, so that the thread that asks for them can keep computing
+// while they happen. Each call queues one request and returns a future for the number of bytes transferred; a request
+// that fails sets a std::system_error on its future instead. Requests run one at a time in the order they were made,
+// which for the sequential streams of a merge sort is the order the disk wants them in anyway, and which means a read
+// queued after a write to the same bytes sees the write.
+//
+// The memory a request reads into or writes from must stay valid until its future is ready.
+class AsyncIo{
+private:
+    enum Kind{READ, WRITE, STOP};
+
+    struct Request{
+        Kind                      m_kind;
+        int                       m_fd;
+        char*                     m_data;
+        std::size_t               m_size;
+        off_t                     m_offset;
+        std::promise<std::size_t> m_done;
+    };
+
+    BlockingQueue<Request> m_requests;
+    std::thread            m_thread;
+
+    static std::size_t transfer(const Request& request);
+    void run();
+
+    std::future<std::size_t> submit(Kind kind, int fd, char* data, std::size_t size, off_t offset){
+        Request request{kind, fd, data, size, offset, std::promise<std::size_t>()};
+        std::future<std::size_t> done = request.m_done.get_future();
+        m_requests.push(std::move(request));
+        return done;
+    }
+
+public:
+    AsyncIo() : m_thread(&AsyncIo::run, this){};
+    AsyncIo(const AsyncIo&) = delete;
+    AsyncIo& operator=(const AsyncIo&) = delete;
+    ~AsyncIo(){
+        submit(STOP, -1, nullptr, 0, 0);
+        m_thread.join();
+    }
+
+    // read transfers fewer than size bytes only at the end of the file.
+    std::future<std::size_t> read(int fd, void* data, std::size_t size, off_t offset){
+        return submit(READ, fd, static_cast<char*>(data), size, offset);
+    }
+    std::future<std::size_t> write(int fd, const void* data, std::size_t size, off_t offset){
+        return submit(WRITE, fd, static_cast<char*>(const_cast<void*>(data)), size, offset);
+    }
+};
+
+inline std::size_t AsyncIo::transfer(const Request& request){
+    std::size_t done = 0;
+    while(done < request.m_size){
+        ssize_t result = request.m_kind == WRITE
+            ? pwrite(request.m_fd, request.m_data + done, request.m_size - done, request.m_offset + off_t(done))
+            : pread(request.m_fd, request.m_data + done, request.m_size - done, request.m_offset + off_t(done));
+        if(result < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), request.m_kind == WRITE ? "pwrite" : "pread");
+        }
+        if(result == 0){
+            break;
+        }
+        done += std::size_t(result);
+    }
+    return done;
+}
+
+inline void AsyncIo::run(){
+    while(true){
+        Request request = m_requests.pop();
+        if(request.m_kind == STOP){
+            return;
+        }
+        try{
+            request.m_done.set_value(transfer(request));
+        }catch(...){
+            request.m_done.set_exception(std::current_exception());
+        }
+    }
+}
+
+
+// RunReader reads count records of T starting at offset in a file, a block at a time, with the next block always being
+// read into a second buffer while the current one is consumed. current() is the record at the front, or nullptr once the
+// run is used up.
+template <class T>
+class RunReader{
+private:
+    AsyncIo&                 m_io;
+    int                      m_fd;
+    off_t                    m_next_offset;
+    std::uint64_t            m_unrequested;     // Records not yet asked for.
+    std::size_t              m_block_records;
+    std::unique_ptr<T[]>     m_buffers;         // Two blocks.
+    std::size_t              m_active;          // The block being consumed.
+    std::size_t              m_pending_records;
+    std::future<std::size_t> m_pending;         // The read of the other block.
+    T*                       m_current;
+    T*                       m_end;
+
+    void request(std::size_t block){
+        m_pending_records = std::size_t(std::min<std::uint64_t>(m_unrequested, m_block_records));
+        std::size_t bytes = m_pending_records * sizeof(T);
+        m_pending = m_io.read(m_fd, m_buffers.get() + block * m_block_records, bytes, m_next_offset);
+        m_next_offset += off_t(bytes);
+        m_unrequested -= m_pending_records;
+    }
+    void refill(){
+        if(!m_pending.valid()){
+            m_current = m_end = nullptr;
+            return;
+        }
+        if(m_pending.get() != m_pending_records * sizeof(T)){
+            throw std::system_error(EIO, std::generic_category(), "RunReader read past the end of the file");
+        }
+        m_active ^= 1;
+        m_current = m_buffers.get() + m_active * m_block_records;
+        m_end = m_current + m_pending_records;
+        if(m_unrequested > 0){
+            request(m_active ^ 1);
+        }
+    }
+
+public:
+    RunReader(AsyncIo& io, int fd, off_t offset, std::uint64_t count, std::size_t block_records)
+        : m_io(io), m_fd(fd), m_next_offset(offset), m_unrequested(count), m_block_records(block_records),
+          m_buffers(new T[2 * block_records]), m_active(1), m_pending_records(0), m_current(nullptr), m_end(nullptr){
+        if(m_unrequested > 0){
+            request(0);
+        }
+        refill();
+    }
+    RunReader(const RunReader&) = delete;
+    RunReader& operator=(const RunReader&) = delete;
+    // The buffer a read is still filling can't be freed under it.
+    ~RunReader(){
+        if(m_pending.valid()){
+            m_pending.wait();
+        }
+    }
+
+    const T* current() const {return m_current;}
+    void advance(){
+        if(++m_current == m_end){
+            refill();
+        }
+    }
+};
+
+// RunWriter appends records of T to a file from offset on. Records are gathered into one block while the previous block
+// is being written, so the writer only waits when it fills a block before the last one has reached the file.
+template <class T>
+class RunWriter{
+private:
+    AsyncIo&                 m_io;
+    int                      m_fd;
+    off_t                    m_offset;
+    std::size_t              m_block_records;
+    std::unique_ptr<T[]>     m_buffers;         // Two blocks.
+    T*                       m_begin;           // The block being filled.
+    T*                       m_current;
+    T*                       m_end;
+    std::size_t              m_pending_bytes;
+    std::future<std::size_t> m_pending;         // The write of the other block.
+
+    void wait(){
+        if(m_pending.valid() && m_pending.get() != m_pending_bytes){
+            throw std::system_error(EIO, std::generic_category(), "RunWriter short write");
+        }
+    }
+    void flush(){
+        if(m_current == m_begin){
+            return;
+        }
+        wait();
+        m_pending_bytes = std::size_t(m_current - m_begin) * sizeof(T);
+        m_pending = m_io.write(m_fd, m_begin, m_pending_bytes, m_offset);
+        m_offset += off_t(m_pending_bytes);
+        m_begin = m_begin == m_buffers.get() ? m_buffers.get() + m_block_records : m_buffers.get();
+        m_current = m_begin;
+        m_end = m_begin + m_block_records;
+    }
+
+public:
+    RunWriter(AsyncIo& io, int fd, off_t offset, std::size_t block_records)
+        : m_io(io), m_fd(fd), m_offset(offset), m_block_records(block_records),
+          m_buffers(new T[2 * block_records]), m_begin(m_buffers.get()), m_current(m_begin),
+          m_end(m_begin + block_records), m_pending_bytes(0){};
+    RunWriter(const RunWriter&) = delete;
+    RunWriter& operator=(const RunWriter&) = delete;
+    ~RunWriter(){
+        if(m_pending.valid()){
+            m_pending.wait();
+        }
+    }
+
+    void push(const T& record){
+        *m_current = record;
+        if(++m_current == m_end){
+            flush();
+        }
+    }
+    void push(const T* records, std::size_t count){
+        while(count > 0){
+            std::size_t span = std::min(count, std::size_t(m_end - m_current));
+            m_current = std::copy(records, records + span, m_current);
+            records += span;
+            count -= span;
+            if(m_current == m_end){
+                flush();
+            }
+        }
+    }
+    // Writes out whatever is buffered and waits until all of it is in the file.
+    void finish(){
+        flush();
+        wait();
+    }
+};
+
+
+// LoserTree picks the smallest of k sorted sequences' front elements in log2(k) comparisons, for k way merging. It is a
+// tournament tree in which each internal node keeps the loser of the match played there and the overall winner is kept
+// apart. When the winner's sequence moves on to its next element, only the matches on the path from its leaf to the root
+// are replayed, each against the stored loser, and unlike a heap's sift down that is one comparison per level.
+//
+// Sequences are represented by pointers to their front elements, nullptr for a sequence that has run out, which loses
+// to everything. Equal elements are won by the lower numbered sequence, so merging runs in input order is stable.
+template <class T, class Compare = std::less<T>>
+class LoserTree{
+private:
+    std::size_t              m_sources;
+    std::vector<const T*>    m_keys;        // Each sequence's front element.
+    std::vector<std::size_t> m_losers;      // Internal nodes 1 to m_sources - 1; m_losers[0] is the winner.
+    Compare                  m_compare;
+
+    bool beats(std::size_t a, std::size_t b) const{
+        if(m_keys[a] == nullptr){
+            return false;
+        }
+        if(m_keys[b] == nullptr){
+            return true;
+        }
+        if(m_compare(*m_keys[a], *m_keys[b])){
+            return true;
+        }
+        return !m_compare(*m_keys[b], *m_keys[a]) && a < b;
+    }
+
+public:
+    explicit LoserTree(std::size_t sources, const Compare& compare = Compare())
+        : m_sources(sources), m_keys(sources, nullptr), m_losers(sources, 0), m_compare(compare){
+        assert(sources > 0 && "LoserTree needs at least one sequence");
+    }
+
+    // Sets each sequence's first element, then build() plays the whole tournament.
+    void set(std::size_t source, const T* key){
+        assert(source < m_sources && "LoserTree sequence out of range");
+        m_keys[source] = key;
+    }
+    void build();
+
+    std::size_t winner() const {return m_losers[0];}
+    const T* top() const {return m_keys[m_losers[0]];}
+    bool is_empty() const {return top() == nullptr;}
+
+    // Replaces the winning sequence's front element with its next one, or nullptr if it has run out.
+    void replace(const T* key);
+};
+
+template <class T, class Compare>
+void LoserTree<T, Compare>::build(){
+    // Node i's children are 2i and 2i + 1, and index m_sources + s stands for sequence s's leaf, which for any k is a
+    // complete binary tree with the internal nodes 1 to k - 1.
+    std::vector<std::size_t> winners(m_sources);
+    auto winner_of = [&](std::size_t node){return node >= m_sources ? node - m_sources : winners[node];};
+    for(std::size_t node = m_sources - 1; node >= 1; --node){
+        std::size_t left = winner_of(2 * node), right = winner_of(2 * node + 1);
+        if(beats(left, right)){
+            winners[node] = left;
+            m_losers[node] = right;
+        }else{
+            winners[node] = right;
+            m_losers[node] = left;
+        }
+    }
+    m_losers[0] = m_sources == 1 ? 0 : winners[1];
+}
+
+template <class T, class Compare>
+void LoserTree<T, Compare>::replace(const T* key){
+    std::size_t winner = m_losers[0];
+    m_keys[winner] = key;
+    for(std::size_t node = (winner + m_sources) / 2; node >= 1; node /= 2){
+        if(beats(m_losers[node], winner)){
+            std::swap(m_losers[node], winner);
+        }
+    }
+    m_losers[0] = winner;
+}
+
+
+struct ExternalSortOptions{
+    std::size_t memory_budget = std::size_t(256) << 20;   // Bytes of buffers and sort arrays, all told.
+    std::size_t block_size    = std::size_t(1) << 20;     // Bytes per I/O request; lowered for small budgets.
+    std::size_t threads       = 1;                        // For sorting runs.
+    std::string temp_directory;                           // Empty for the system's temporary directory.
+};
+
+struct ExternalSortStats{
+    std::uint64_t records      = 0;
+    std::size_t   runs         = 0;
+    std::size_t   fan_in       = 0;     // The most runs merged at once.
+    std::size_t   merge_passes = 0;     // The most merges any record went through.
+    std::uint64_t bytes_read   = 0;
+    std::uint64_t bytes_written = 0;
+};
+
+// external_sort sorts a file of fixed width records of T into another file, in the memory given by
+// options.memory_budget, however large the file. T is the record's layout in the file, so it must be trivially
+// copyable.
+//
+// First, runs: the input is read a memory load at a time, each load is sorted with parallel_sample_sort and written to
+// a temporary file. The memory is split between two run arrays, so that reading the next run and writing the last one
+// happen while the current one is sorted, at the cost of runs half as long. Then the runs are merged, as many at once
+// as the budget allows, with a LoserTree picking each next record. Every run being merged needs two blocks of buffer
+// (one being consumed, one being read) and so does the output, so the fan in is budget / (2 * block) - 1, and the block
+// size is lowered if needed to give a fan in of at least 3.
+//
+// Each merge pass reads and writes the whole data set, so the number of passes is what matters. With R runs and fan in
+// k that is ceil(log_k R), and a 1GB budget with 1MB blocks merges 511 runs of 512MB in one pass, enough for a quarter
+// of a terabyte of input. When one pass isn't enough, the first merge takes just enough runs ((R - 2) % (k - 1) + 2)
+// that every later merge, the last one included, is a full k way merge, which is the fewest merges and keeps the extra
+// passes to as little of the data as possible. The last merge writes straight to the output file, as does run
+// generation if the whole input fits in one run.
+//
+// Temporary files are unlinked as soon as they are created, so nothing is left behind if the process dies. Failures to
+// read or write throw std::system_error, and an input whose size isn't a whole number of records throws
+// std::invalid_argument.
+template <class T, class Compare = std::less<T>>
+class ExternalSorter{
+    static_assert(std::is_trivially_copyable<T>::value, "ExternalSorter records are copied to and from files as bytes");
+
+private:
+    struct Run{
+        int           m_fd;
+        std::uint64_t m_count;
+        std::size_t   m_passes;     // Merges its records have been through.
+    };
+
+    ExternalSortOptions m_options;
+    Compare             m_compare;
+    std::size_t         m_block_records;
+    std::size_t         m_fan_in;
+    ExternalSortStats   m_stats;
+    AsyncIo             m_io;
+
+    [[noreturn]] static void fail(const char* what){
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+    int temporary_file() const;
+    void make_runs(int input, std::uint64_t records, int output, Queue<Run>& runs);
+    // Merges runs into output and closes their files, even if it fails.
+    Run merge(Run* runs, std::size_t count, int output);
+
+public:
+    ExternalSorter(const ExternalSortOptions& options, const Compare& compare = Compare());
+
+    std::size_t fan_in() const {return m_fan_in;}
+    std::size_t block_records() const {return m_block_records;}
+
+    ExternalSortStats sort(const std::string& input_path, const std::string& output_path);
+};
+
+template <class T, class Compare>
+ExternalSorter<T, Compare>::ExternalSorter(const ExternalSortOptions& options, const Compare& compare)
+    : m_options(options), m_compare(compare){
+    assert(options.threads > 0 && "ExternalSorter needs at least one thread");
+    std::size_t block_bytes = std::min(options.block_size, options.memory_budget / 8);
+    m_block_records = std::max<std::size_t>(1, block_bytes / sizeof(T));
+    m_fan_in = options.memory_budget / (2 * m_block_records * sizeof(T)) - 1;
+    assert(m_fan_in >= 2 && "ExternalSorter memory budget is too small for a merge");
+    if(m_options.temp_directory.empty()){
+        m_options.temp_directory = std::filesystem::temp_directory_path().string();
+    }
+}
+
+template <class T, class Compare>
+int ExternalSorter<T, Compare>::temporary_file() const{
+    std::string path = m_options.temp_directory + "/dsa-external-sort-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if(fd < 0){
+        fail("mkstemp");
+    }
+    unlink(path.c_str());
+    return fd;
+}
+
+template <class T, class Compare>
+ExternalSortStats ExternalSorter<T, Compare>::sort(const std::string& input_path, const std::string& output_path){
+    m_stats = ExternalSortStats();
+    int input = open(input_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(input < 0){
+        fail("open");
+    }
+    struct stat status;
+    if(fstat(input, &status) != 0){
+        int error = errno;
+        close(input);
+        errno = error;
+        fail("fstat");
+    }
+    if(std::uint64_t(status.st_size) % sizeof(T) != 0){
+        close(input);
+        throw std::invalid_argument("external_sort input is not a whole number of records");
+    }
+    int output = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(output < 0){
+        int error = errno;
+        close(input);
+        errno = error;
+        fail("open");
+    }
+    m_stats.records = std::uint64_t(status.st_size) / sizeof(T);
+
+    Queue<Run> runs;
+    try{
+        make_runs(input, m_stats.records, output, runs);
+        close(input);
+        input = -1;
+        if(runs.size() > 1){
+            // The first merge is cut short so that every later one merges a full m_fan_in runs.
+            std::size_t first = runs.size() <= m_fan_in ? runs.size() : (runs.size() - 2) % (m_fan_in - 1) + 2;
+            std::vector<Run> group;
+            for(std::size_t take = first; !runs.is_empty(); take = std::min(m_fan_in, runs.size())){
+                group.clear();
+                for(std::size_t i = 0; i < take; ++i){
+                    group.push_back(runs.dequeue());
+                }
+                bool last = runs.is_empty();
+                int target = last ? output : temporary_file();
+                Run merged;
+                try{
+                    merged = merge(group.data(), group.size(), target);
+                }catch(...){
+                    if(!last){
+                        close(target);
+                    }
+                    throw;
+                }
+                if(last){
+                    m_stats.merge_passes = merged.m_passes;
+                }else{
+                    runs.enqueue(merged);
+                }
+            }
+        }
+    }catch(...){
+        while(!runs.is_empty()){
+            close(runs.dequeue().m_fd);
+        }
+        if(input >= 0){
+            close(input);
+        }
+        close(output);
+        throw;
+    }
+    if(close(output) != 0){
+        fail("close");
+    }
+    return m_stats;
+}
+
+template <class T, class Compare>
+void ExternalSorter<T, Compare>::make_runs(int input, std::uint64_t records, int output, Queue<Run>& runs){
+    // parallel_sample_sort needs a scratch array as large as the run plus a two byte bucket number per record. An input
+    // that fits in one run gets one array the size of the budget. Otherwise there are two arrays of half that, each run
+    // read and written in one request straight from the array it is sorted in, and while one array is being sorted the
+    // I/O thread writes the previous run out of the other and then reads the next run into it. AsyncIo runs requests in
+    // order, so a read into an array never starts before the write out of it has finished.
+    std::size_t scratch = m_options.threads > 1 ? sizeof(T) + 2 : 0;
+    bool single = records <= m_options.memory_budget / (sizeof(T) + scratch);
+    std::size_t run_records = single ? std::size_t(records)
+                                     : std::max(m_block_records, m_options.memory_budget / (2 * sizeof(T) + scratch));
+    std::unique_ptr<T[]> arrays[2];
+    for(std::size_t i = 0; i < (single ? 1u : 2u); ++i){
+        arrays[i].reset(new T[run_records]);
+    }
+    std::future<std::size_t> reads[2], writes[2];
+    std::size_t read_bytes[2] = {0, 0}, write_bytes[2] = {0, 0};
+    auto complete = [](std::future<std::size_t>& transfer, std::size_t bytes){
+        if(transfer.valid() && transfer.get() != bytes){
+            throw std::system_error(EIO, std::generic_category(), "external_sort short read or write");
+        }
+    };
+    auto read_run = [&](std::size_t array, std::uint64_t first){
+        read_bytes[array] = std::size_t(std::min<std::uint64_t>(run_records, records - first)) * sizeof(T);
+        reads[array] = m_io.read(input, arrays[array].get(), read_bytes[array], off_t(first * sizeof(T)));
+    };
+
+    try{
+        read_run(0, 0);
+        std::size_t array = 0;
+        for(std::uint64_t first = 0; first < records || m_stats.runs == 0; first += run_records, array ^= 1){
+            // The write of the run two before this one went ahead of this array's read, so both are done.
+            complete(writes[array], write_bytes[array]);
+            complete(reads[array], read_bytes[array]);
+            std::size_t count = read_bytes[array] / sizeof(T);
+            if(first + count < records){
+                read_run(array ^ 1, first + count);
+            }
+            T* data = arrays[array].get();
+            parallel_sample_sort(data, data + count, m_options.threads, m_compare);
+            // A single run is the sorted output. A temporary run is queued before its write so that sort closes it if
+            // anything fails from here on.
+            Run run{single ? output : temporary_file(), count, 0};
+            if(!single){
+                runs.enqueue(run);
+            }
+            write_bytes[array] = count * sizeof(T);
+            writes[array] = m_io.write(run.m_fd, data, write_bytes[array], 0);
+            m_stats.runs++;
+            m_stats.bytes_read += count * sizeof(T);
+            m_stats.bytes_written += count * sizeof(T);
+        }
+        complete(writes[0], write_bytes[0]);
+        complete(writes[1], write_bytes[1]);
+    }catch(...){
+        // The arrays can't be freed while the I/O thread may still be using them.
+        for(std::future<std::size_t>* transfer : {&reads[0], &reads[1], &writes[0], &writes[1]}){
+            if(transfer->valid()){
+                transfer->wait();
+            }
+        }
+        throw;
+    }
+}
+
+template <class T, class Compare>
+typename ExternalSorter<T, Compare>::Run ExternalSorter<T, Compare>::merge(Run* runs, std::size_t count, int output){
+    Run merged{output, 0, 0};
+    try{
+        std::vector<std::unique_ptr<RunReader<T>>> readers;
+        LoserTree<T, Compare> tree(count, m_compare);
+        for(std::size_t i = 0; i < count; ++i){
+            readers.emplace_back(new RunReader<T>(m_io, runs[i].m_fd, 0, runs[i].m_count, m_block_records));
+            tree.set(i, readers[i]->current());
+            merged.m_count += runs[i].m_count;
+            merged.m_passes = std::max(merged.m_passes, runs[i].m_passes + 1);
+        }
+        tree.build();
+        RunWriter<T> writer(m_io, output, 0, m_block_records);
+        while(!tree.is_empty()){
+            RunReader<T>& reader = *readers[tree.winner()];
+            writer.push(*tree.top());
+            reader.advance();
+            tree.replace(reader.current());
+        }
+        writer.finish();
+    }catch(...){
+        for(std::size_t i = 0; i < count; ++i){
+            close(runs[i].m_fd);
+        }
+        throw;
+    }
+    for(std::size_t i = 0; i < count; ++i){
+        close(runs[i].m_fd);
+    }
+    m_stats.fan_in = std::max(m_stats.fan_in, count);
+    m_stats.bytes_read += merged.m_count * sizeof(T);
+    m_stats.bytes_written += merged.m_count * sizeof(T);
+    return merged;
+}
+
+template <class T, class Compare = std::less<T>>
+ExternalSortStats external_sort(const std::string& input_path, const std::string& output_path,
+                                const ExternalSortOptions& options = ExternalSortOptions(),
+                                const Compare& compare = Compare()){
+    return ExternalSorter<T, Compare>(options, compare).sort(input_path, output_path);
+}
+
+#endif
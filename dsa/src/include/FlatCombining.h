@@ -0,0 +1,181 @@
+#ifndef FLATCOMBINING
+#define FLATCOMBINING
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+
+#include "Concurrency.h"
+#include "Queue.h"
+#include "Stack.h"
+
+// FlatCombining turns a sequential data structure into a concurrent one (Hendler, Incze, Shavit and Tzafrir, "Flat
+// Combining and the Synchronization-Parallelism Tradeoff", SPAA 2010). Rather than every thread taking a lock in turn,
+// or racing on a CAS that most of them lose, each thread writes its operation into its own slot and one thread, the
+// combiner, applies everyone's operations in a batch:
+//
+//  - A thread publishes a pointer to its Request in slot thread_index(). The slots are on separate cache lines.
+//  - If the combiner lock is free it takes it and becomes the combiner. It scans the slots, runs each pending request
+//    against the structure and clears the slot to say it is done, then scans again a few times to pick up requests that
+//    arrived in the meantime.
+//  - Otherwise it waits on its own slot, which only the combiner writes, until the slot is cleared or the lock is free
+//    again.
+//
+// Under contention the lock changes hands once per batch rather than once per operation, and the structure's own
+// cache lines stay in the combiner's cache for the whole batch instead of moving between cores on every operation.
+//
+// A Request is any type with an execute(Structure&) member, which runs on the combiner's thread; results are written
+// back into the request. FlatCombiningQueue and FlatCombiningStack below are the ready made wrappers.
+template <class Structure, class Request>
+class FlatCombining{
+private:
+    static constexpr int COMBINE_PASSES = 3;
+
+    struct alignas(CACHE_LINE_SIZE) Slot{
+        std::atomic<Request*> m_request{nullptr};
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> m_locked;
+    alignas(CACHE_LINE_SIZE) Structure m_structure;
+    Slot m_slots[MAX_THREADS];
+
+    void combine(){
+        for(int pass = 0; pass < COMBINE_PASSES; ++pass){
+            bool found = false;
+            std::size_t limit = thread_index_limit().load(std::memory_order_acquire);
+            for(std::size_t i = 0; i < limit; ++i){
+                Request* request = m_slots[i].m_request.load(std::memory_order_acquire);
+                if(request != nullptr){
+                    request->execute(m_structure);
+                    m_slots[i].m_request.store(nullptr, std::memory_order_release);
+                    found = true;
+                }
+            }
+            if(!found){
+                break;
+            }
+        }
+    }
+
+public:
+    template <class... Args>
+    explicit FlatCombining(Args&&... args) : m_locked(false), m_structure(std::forward<Args>(args)...){};
+    FlatCombining(const FlatCombining&) = delete;
+    FlatCombining& operator=(const FlatCombining&) = delete;
+
+    // apply returns once request has been executed, by this thread or by another one acting as the combiner.
+    void apply(Request& request){
+        Slot& slot = m_slots[thread_index()];
+        slot.m_request.store(&request, std::memory_order_release);
+        for(unsigned spins = 0;; ++spins){
+            if(!m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire)){
+                combine();
+                m_locked.store(false, std::memory_order_release);
+            }
+            if(slot.m_request.load(std::memory_order_acquire) == nullptr){
+                return;
+            }
+            if(spins % 64 == 63){
+                std::this_thread::yield();
+            }else{
+                cpu_relax();
+            }
+        }
+    }
+
+    // Access to the structure without synchronisation, e.g. to fill it before any other thread starts.
+    Structure& unsafe_structure() {return m_structure;}
+};
+
+
+template <class T>
+struct FlatCombiningQueueRequest{
+    enum Operation{ENQUEUE, DEQUEUE};
+
+    Operation m_operation;
+    bool      m_done;
+    T         m_value;
+
+    void execute(Queue<T>& queue){
+        if(m_operation == ENQUEUE){
+            queue.enqueue(std::move(m_value));
+            m_done = true;
+        }else if(!queue.is_empty()){
+            m_value = queue.dequeue();
+            m_done  = true;
+        }else{
+            m_done = false;
+        }
+    }
+};
+
+// FlatCombiningQueue is a Queue that any number of threads can use concurrently.
+template <class T>
+class FlatCombiningQueue{
+private:
+    typedef FlatCombiningQueueRequest<T> Request;
+    FlatCombining<Queue<T>, Request> m_combining;
+
+public:
+    void enqueue(T value){
+        Request request{Request::ENQUEUE, false, std::move(value)};
+        m_combining.apply(request);
+    }
+    // try_dequeue returns false if the queue was empty.
+    bool try_dequeue(T& value){
+        Request request{Request::DEQUEUE, false, T()};
+        m_combining.apply(request);
+        if(request.m_done){
+            value = std::move(request.m_value);
+        }
+        return request.m_done;
+    }
+};
+
+
+template <class T>
+struct FlatCombiningStackRequest{
+    enum Operation{PUSH, POP};
+
+    Operation m_operation;
+    bool      m_done;
+    T         m_value;
+
+    void execute(Stack<T>& stack){
+        if(m_operation == PUSH){
+            stack.push(std::move(m_value));
+            m_done = true;
+        }else if(!stack.is_empty()){
+            m_value = stack.pop();
+            m_done  = true;
+        }else{
+            m_done = false;
+        }
+    }
+};
+
+// FlatCombiningStack is a Stack that any number of threads can use concurrently.
+template <class T>
+class FlatCombiningStack{
+private:
+    typedef FlatCombiningStackRequest<T> Request;
+    FlatCombining<Stack<T>, Request> m_combining;
+
+public:
+    void push(T value){
+        Request request{Request::PUSH, false, std::move(value)};
+        m_combining.apply(request);
+    }
+    // try_pop returns false if the stack was empty.
+    bool try_pop(T& value){
+        Request request{Request::POP, false, T()};
+        m_combining.apply(request);
+        if(request.m_done){
+            value = std::move(request.m_value);
+        }
+        return request.m_done;
+    }
+};
+
+#endif
@@ -0,0 +1,512 @@
+#ifndef GRAPH
+#define GRAPH
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Concurrency.h"
+#include "PriorityQueue.h"
+#include "Queue.h"
+#include "Stack.h"
+
+// CsrGraph is a directed graph in compressed sparse row form: the targets of every vertex's out edges are stored
+// contiguously, vertex by vertex, in one array, and m_offsets[v] is where vertex v's run starts (m_offsets[v + 1] is
+// where it ends). Iterating over a vertex's neighbours is a linear scan of part of one array, and the whole graph costs
+// 8 bytes per vertex and 4 per edge (8 with weights), against at least a pointer and an allocation per edge for
+// adjacency lists. The price is that the graph is immutable once built.
+//
+// Vertices are numbered 0 to vertex_count - 1 and fit in 32 bits; edge indices are 64 bit, so a graph can have more than
+// 4 billion edges. Construction from an edge list is a counting sort by source, O(V + E), and keeps the edges of each
+// vertex in the order they were given. With SYMMETRIC every edge is also added in the opposite direction, which is how
+// an undirected graph is stored; such a graph is its own transpose. With WEIGHTED each edge keeps its weight, otherwise
+// every edge has weight 1 and no weight array is stored.
+class CsrGraph{
+public:
+    typedef std::uint32_t Vertex;
+    typedef std::uint64_t EdgeIndex;
+
+    static constexpr unsigned SYMMETRIC = 1;
+    static constexpr unsigned WEIGHTED  = 2;
+
+    struct Edge{
+        Vertex        m_from;
+        Vertex        m_to;
+        std::uint32_t m_weight = 1;
+    };
+
+    // The targets of one vertex's out edges, for use in a range for loop.
+    struct Neighbors{
+        const Vertex* m_begin;
+        const Vertex* m_end;
+
+        const Vertex* begin() const {return m_begin;}
+        const Vertex* end() const {return m_end;}
+        std::size_t size() const {return std::size_t(m_end - m_begin);}
+    };
+
+private:
+    std::vector<EdgeIndex>     m_offsets;       // vertex_count + 1 entries.
+    std::vector<Vertex>        m_targets;
+    std::vector<std::uint32_t> m_weights;       // Parallel to m_targets, or empty when unweighted.
+
+public:
+    CsrGraph() : m_offsets(1, 0){};
+    CsrGraph(Vertex vertex_count, const std::vector<Edge>& edges, unsigned options = 0);
+
+    Vertex vertex_count() const {return Vertex(m_offsets.size() - 1);}
+    EdgeIndex edge_count() const {return m_targets.size();}
+    bool is_weighted() const {return !m_weights.empty();}
+
+    EdgeIndex first_edge(Vertex vertex) const {return m_offsets[vertex];}
+    EdgeIndex end_edge(Vertex vertex) const {return m_offsets[vertex + 1];}
+    EdgeIndex degree(Vertex vertex) const {return m_offsets[vertex + 1] - m_offsets[vertex];}
+    Vertex target(EdgeIndex edge) const {return m_targets[edge];}
+    std::uint32_t weight(EdgeIndex edge) const {return m_weights.empty() ? 1 : m_weights[edge];}
+    Neighbors neighbors(Vertex vertex) const{
+        const Vertex* targets = m_targets.data();
+        return Neighbors{targets + m_offsets[vertex], targets + m_offsets[vertex + 1]};
+    }
+
+    // The graph with every edge reversed, for algorithms that need each vertex's in edges.
+    CsrGraph transpose() const;
+};
+
+inline CsrGraph::CsrGraph(Vertex vertex_count, const std::vector<Edge>& edges, unsigned options)
+    : m_offsets(std::size_t(vertex_count) + 1, 0){
+    bool symmetric = (options & SYMMETRIC) != 0;
+    EdgeIndex count = EdgeIndex(edges.size()) * (symmetric ? 2 : 1);
+    // Count the out degrees into m_offsets[v + 1] and turn them into start offsets with a prefix sum. The fill loop then
+    // uses m_offsets[v] as vertex v's insertion cursor, which leaves every offset one vertex too far, so it is shifted
+    // back afterwards.
+    for(const Edge& edge : edges){
+        assert(edge.m_from < vertex_count && edge.m_to < vertex_count && "CsrGraph edge endpoint out of range");
+        m_offsets[edge.m_from + 1]++;
+        if(symmetric){
+            m_offsets[edge.m_to + 1]++;
+        }
+    }
+    for(Vertex v = 0; v < vertex_count; ++v){
+        m_offsets[v + 1] += m_offsets[v];
+    }
+    m_targets.resize(count);
+    if(options & WEIGHTED){
+        m_weights.resize(count);
+    }
+    auto add = [&](Vertex from, Vertex to, std::uint32_t weight){
+        EdgeIndex slot = m_offsets[from]++;
+        m_targets[slot] = to;
+        if(!m_weights.empty()){
+            m_weights[slot] = weight;
+        }
+    };
+    for(const Edge& edge : edges){
+        add(edge.m_from, edge.m_to, edge.m_weight);
+        if(symmetric){
+            add(edge.m_to, edge.m_from, edge.m_weight);
+        }
+    }
+    for(Vertex v = vertex_count; v > 0; --v){
+        m_offsets[v] = m_offsets[v - 1];
+    }
+    m_offsets[0] = 0;
+}
+
+inline CsrGraph CsrGraph::transpose() const{
+    CsrGraph reversed;
+    Vertex vertices = vertex_count();
+    reversed.m_offsets.assign(std::size_t(vertices) + 1, 0);
+    for(Vertex target : m_targets){
+        reversed.m_offsets[target + 1]++;
+    }
+    for(Vertex v = 0; v < vertices; ++v){
+        reversed.m_offsets[v + 1] += reversed.m_offsets[v];
+    }
+    reversed.m_targets.resize(m_targets.size());
+    if(is_weighted()){
+        reversed.m_weights.resize(m_weights.size());
+    }
+    // Same cursor scheme as the constructor, but the cursors are a copy so the offsets don't need shifting back.
+    std::vector<EdgeIndex> cursor(reversed.m_offsets.begin(), reversed.m_offsets.end() - 1);
+    for(Vertex from = 0; from < vertices; ++from){
+        for(EdgeIndex edge = m_offsets[from]; edge < m_offsets[from + 1]; ++edge){
+            EdgeIndex slot = cursor[m_targets[edge]]++;
+            reversed.m_targets[slot] = from;
+            if(is_weighted()){
+                reversed.m_weights[slot] = m_weights[edge];
+            }
+        }
+    }
+    return reversed;
+}
+
+
+// The depth every search below gives a vertex it never reached.
+constexpr std::uint32_t UNREACHED = UINT32_MAX;
+
+// breadth_first_search returns every vertex's depth (its distance in edges) from source, or UNREACHED, visiting
+// vertices in order of depth with a Queue as the frontier.
+inline std::vector<std::uint32_t> breadth_first_search(const CsrGraph& graph, CsrGraph::Vertex source){
+    assert(source < graph.vertex_count() && "breadth_first_search source out of range");
+    std::vector<std::uint32_t> depths(graph.vertex_count(), UNREACHED);
+    Queue<CsrGraph::Vertex> frontier;
+    depths[source] = 0;
+    frontier.enqueue(source);
+    while(!frontier.is_empty()){
+        CsrGraph::Vertex vertex = frontier.dequeue();
+        for(CsrGraph::Vertex next : graph.neighbors(vertex)){
+            if(depths[next] == UNREACHED){
+                depths[next] = depths[vertex] + 1;
+                frontier.enqueue(next);
+            }
+        }
+    }
+    return depths;
+}
+
+// depth_first_order returns the vertices reachable from source in the order a recursive depth first search would first
+// visit them (following each vertex's edges in stored order). The recursion is a Stack of (vertex, next edge to try)
+// frames, so a path of millions of vertices doesn't overflow the call stack, and the Stack never holds more than one
+// frame per vertex on the current path.
+inline std::vector<CsrGraph::Vertex> depth_first_order(const CsrGraph& graph, CsrGraph::Vertex source){
+    assert(source < graph.vertex_count() && "depth_first_order source out of range");
+    std::vector<bool> visited(graph.vertex_count(), false);
+    std::vector<CsrGraph::Vertex> order;
+    Stack<std::pair<CsrGraph::Vertex, CsrGraph::EdgeIndex>> path;
+    visited[source] = true;
+    order.push_back(source);
+    path.push(std::make_pair(source, graph.first_edge(source)));
+    while(!path.is_empty()){
+        std::pair<CsrGraph::Vertex, CsrGraph::EdgeIndex>& frame = path.peek();
+        if(frame.second == graph.end_edge(frame.first)){
+            path.pop();
+            continue;
+        }
+        CsrGraph::Vertex next = graph.target(frame.second++);
+        if(!visited[next]){
+            visited[next] = true;
+            order.push_back(next);
+            path.push(std::make_pair(next, graph.first_edge(next)));
+        }
+    }
+    return order;
+}
+
+// The distance dijkstra gives a vertex it never reached.
+constexpr std::uint64_t INFINITE_DISTANCE = UINT64_MAX;
+
+// dijkstra returns the length of the shortest path from source to every vertex, using the graph's edge weights (all 1 if
+// it is unweighted), or INFINITE_DISTANCE. Each reached vertex has one entry in an AddressablePriorityQueue whose key is
+// lowered in place when a shorter path turns up, so the heap never holds more than one entry per vertex, unlike the
+// usual std::priority_queue version that pushes duplicates and skips stale ones.
+inline std::vector<std::uint64_t> dijkstra(const CsrGraph& graph, CsrGraph::Vertex source){
+    assert(source < graph.vertex_count() && "dijkstra source out of range");
+    typedef std::pair<std::uint64_t, CsrGraph::Vertex> Entry;
+    typedef AddressablePriorityQueue<Entry, std::greater<Entry>> Heap;
+    const Heap::Handle NO_HANDLE = UINT32_MAX;
+
+    std::vector<std::uint64_t> distances(graph.vertex_count(), INFINITE_DISTANCE);
+    std::vector<Heap::Handle>  handles(graph.vertex_count(), NO_HANDLE);
+    // A handle is recycled once its vertex is popped, so settled vertices are tracked separately.
+    std::vector<bool>          settled(graph.vertex_count(), false);
+    Heap heap;
+    distances[source] = 0;
+    handles[source] = heap.push(Entry(0, source));
+    while(!heap.is_empty()){
+        CsrGraph::Vertex vertex = heap.pop().second;
+        settled[vertex] = true;
+        for(CsrGraph::EdgeIndex edge = graph.first_edge(vertex); edge < graph.end_edge(vertex); ++edge){
+            CsrGraph::Vertex next = graph.target(edge);
+            std::uint64_t distance = distances[vertex] + graph.weight(edge);
+            if(settled[next] || distance >= distances[next]){
+                continue;
+            }
+            distances[next] = distance;
+            if(handles[next] == NO_HANDLE){
+                handles[next] = heap.push(Entry(distance, next));
+            }else{
+                heap.decrease_key(handles[next], Entry(distance, next));
+            }
+        }
+    }
+    return distances;
+}
+
+
+// ParallelBreadthFirstSearch is Beamer, Asanovic and Patterson's direction optimizing BFS ("Direction-Optimizing
+// Breadth-First Search", SC 2012), run level by level on a fixed set of threads.
+//
+//  - Top down, each frontier vertex checks its out edges for unvisited vertices, claiming each one with a compare and
+//    swap on its depth. This is the usual BFS, and is cheap while the frontier is small.
+//  - Bottom up, each unvisited vertex checks its in edges for a parent in the frontier and stops at the first one it
+//    finds. When the frontier holds a large part of the graph, as it does for a few levels in the middle of a search on
+//    a small world graph, most unvisited vertices find a parent within their first few edges, so far fewer edges are
+//    examined than top down, where every frontier edge is. The frontier is a bitmap so the membership test is one bit,
+//    and each thread writes whole words of the next frontier's bitmap, so no atomics are needed.
+//
+// The search switches to bottom up when the edges out of the frontier exceed 1/ALPHA of the edges into unvisited vertices
+// and back to top down when the frontier shrinks below 1/BETA of the vertices, the paper's heuristic and constants.
+// Within a level the threads take chunks of the frontier (top down) or of the vertex range (bottom up) from a shared
+// counter, which balances the very uneven degrees of power law graphs.
+//
+// Bottom up steps need in edges, so the search takes the graph and its transpose; for a SYMMETRIC graph they are the same
+// object.
+class ParallelBreadthFirstSearch{
+public:
+    typedef CsrGraph::Vertex    Vertex;
+    typedef CsrGraph::EdgeIndex EdgeIndex;
+
+    static constexpr EdgeIndex ALPHA = 14;
+    static constexpr Vertex    BETA  = 24;
+
+private:
+    static constexpr std::size_t TOP_DOWN_CHUNK  = 64;        // Frontier vertices per claim.
+    static constexpr std::size_t BOTTOM_UP_CHUNK = 64 * 64;   // Vertices per claim; a whole number of bitmap words.
+
+    struct alignas(CACHE_LINE_SIZE) Local{
+        std::vector<Vertex> m_next;             // Vertices this thread added to the next frontier, top down.
+        Vertex              m_found = 0;        // Vertices this thread added to the next frontier, bottom up.
+        EdgeIndex           m_out_edges = 0;    // Out degrees of the vertices it added.
+        EdgeIndex           m_in_edges = 0;     // In degrees of the vertices it added.
+    };
+
+    const CsrGraph& m_graph;
+    const CsrGraph& m_transpose;
+    std::size_t     m_threads;
+    bool            m_direction_optimizing;
+
+    std::unique_ptr<std::atomic<std::uint32_t>[]> m_depths;
+    std::vector<Vertex>        m_frontier;      // The frontier while top down.
+    std::vector<std::uint64_t> m_bits;          // The frontier while bottom up.
+    std::vector<std::uint64_t> m_next_bits;
+    std::vector<Local>         m_locals;
+    std::atomic<std::size_t>   m_next_chunk;
+    ThreadBarrier              m_barrier;
+
+    // Set by thread 0 between levels, while every other thread waits at the barrier.
+    std::uint32_t m_level;
+    bool          m_bottom_up;
+    bool          m_done;
+    Vertex        m_frontier_size;
+    EdgeIndex     m_frontier_edges;     // Out edges of the frontier.
+    EdgeIndex     m_unvisited_edges;    // In edges of the vertices not reached yet.
+
+    bool in_frontier(Vertex vertex) const {return (m_bits[vertex / 64] >> (vertex % 64)) & 1;}
+
+    void top_down_step(Local& local);
+    void bottom_up_step(Local& local);
+    // Gathers the threads' results into the next frontier and chooses the direction of the next level.
+    void finish_level();
+    void worker(std::size_t index);
+
+public:
+    ParallelBreadthFirstSearch(const CsrGraph& graph, const CsrGraph& transpose, std::size_t threads,
+                               bool direction_optimizing = true);
+
+    // Returns every vertex's depth from source, or UNREACHED, the same as breadth_first_search.
+    std::vector<std::uint32_t> run(Vertex source);
+};
+
+inline ParallelBreadthFirstSearch::ParallelBreadthFirstSearch(const CsrGraph& graph, const CsrGraph& transpose,
+                                                              std::size_t threads, bool direction_optimizing)
+    : m_graph(graph), m_transpose(transpose), m_threads(threads), m_direction_optimizing(direction_optimizing),
+      m_locals(threads), m_next_chunk(0), m_barrier(threads){
+    assert(threads > 0 && "ParallelBreadthFirstSearch needs at least one thread");
+    assert(graph.vertex_count() == transpose.vertex_count() && graph.edge_count() == transpose.edge_count() &&
+           "ParallelBreadthFirstSearch transpose doesn't match the graph");
+}
+
+inline std::vector<std::uint32_t> ParallelBreadthFirstSearch::run(Vertex source){
+    Vertex vertices = m_graph.vertex_count();
+    assert(source < vertices && "ParallelBreadthFirstSearch source out of range");
+    m_depths.reset(new std::atomic<std::uint32_t>[vertices]);
+    for(Vertex v = 0; v < vertices; ++v){
+        m_depths[v].store(UNREACHED, std::memory_order_relaxed);
+    }
+    m_depths[source].store(0, std::memory_order_relaxed);
+    m_bits.assign((std::size_t(vertices) + 63) / 64, 0);
+    m_next_bits.assign(m_bits.size(), 0);
+    m_frontier.assign(1, source);
+    m_level           = 0;
+    m_bottom_up       = false;
+    m_done            = false;
+    m_frontier_size   = 1;
+    m_frontier_edges  = m_graph.degree(source);
+    m_unvisited_edges = m_transpose.edge_count() - m_transpose.degree(source);
+    m_next_chunk.store(0, std::memory_order_relaxed);
+
+    std::vector<std::thread> workers;
+    for(std::size_t t = 1; t < m_threads; ++t){
+        workers.emplace_back(&ParallelBreadthFirstSearch::worker, this, t);
+    }
+    worker(0);
+    for(std::thread& thread : workers){
+        thread.join();
+    }
+
+    std::vector<std::uint32_t> depths(vertices);
+    for(Vertex v = 0; v < vertices; ++v){
+        depths[v] = m_depths[v].load(std::memory_order_relaxed);
+    }
+    m_depths.reset();
+    return depths;
+}
+
+inline void ParallelBreadthFirstSearch::worker(std::size_t index){
+    Local& local = m_locals[index];
+    while(true){
+        // The barrier orders thread 0's setup of the level before everyone's step, and everyone's step before thread 0
+        // gathers the results.
+        m_barrier.wait();
+        if(m_done){
+            return;
+        }
+        if(m_bottom_up){
+            bottom_up_step(local);
+        }else{
+            top_down_step(local);
+        }
+        m_barrier.wait();
+        if(index == 0){
+            finish_level();
+        }
+    }
+}
+
+inline void ParallelBreadthFirstSearch::top_down_step(Local& local){
+    std::uint32_t depth = m_level + 1;
+    std::size_t size = m_frontier.size();
+    while(true){
+        std::size_t begin = m_next_chunk.fetch_add(TOP_DOWN_CHUNK, std::memory_order_relaxed);
+        if(begin >= size){
+            break;
+        }
+        std::size_t end = std::min(size, begin + TOP_DOWN_CHUNK);
+        for(std::size_t i = begin; i < end; ++i){
+            for(Vertex next : m_graph.neighbors(m_frontier[i])){
+                std::uint32_t expected = UNREACHED;
+                // The plain load filters out most visited vertices without the cost of a failed compare and swap.
+                if(m_depths[next].load(std::memory_order_relaxed) == UNREACHED &&
+                   m_depths[next].compare_exchange_strong(expected, depth, std::memory_order_relaxed)){
+                    local.m_next.push_back(next);
+                    local.m_out_edges += m_graph.degree(next);
+                    local.m_in_edges += m_transpose.degree(next);
+                }
+            }
+        }
+    }
+}
+
+inline void ParallelBreadthFirstSearch::bottom_up_step(Local& local){
+    std::uint32_t depth = m_level + 1;
+    Vertex vertices = m_graph.vertex_count();
+    while(true){
+        std::size_t begin = m_next_chunk.fetch_add(BOTTOM_UP_CHUNK, std::memory_order_relaxed);
+        if(begin >= vertices){
+            break;
+        }
+        std::size_t end = std::min<std::size_t>(vertices, begin + BOTTOM_UP_CHUNK);
+        for(std::size_t base = begin; base < end; base += 64){
+            std::uint64_t word = 0;
+            std::size_t word_end = std::min<std::size_t>(end, base + 64);
+            for(std::size_t v = base; v < word_end; ++v){
+                if(m_depths[v].load(std::memory_order_relaxed) != UNREACHED){
+                    continue;
+                }
+                for(Vertex parent : m_transpose.neighbors(Vertex(v))){
+                    if(in_frontier(parent)){
+                        // Only this thread looks at vertices in its chunk during a bottom up step, so a plain store
+                        // will do.
+                        m_depths[v].store(depth, std::memory_order_relaxed);
+                        word |= std::uint64_t(1) << (v - base);
+                        local.m_found++;
+                        local.m_out_edges += m_graph.degree(Vertex(v));
+                        local.m_in_edges += m_transpose.degree(Vertex(v));
+                        break;
+                    }
+                }
+            }
+            m_next_bits[base / 64] = word;
+        }
+    }
+}
+
+inline void ParallelBreadthFirstSearch::finish_level(){
+    Vertex    previous_size = m_frontier_size;
+    Vertex    found = 0;
+    EdgeIndex out_edges = 0, in_edges = 0;
+    for(Local& local : m_locals){
+        found += local.m_found + Vertex(local.m_next.size());
+        out_edges += local.m_out_edges;
+        in_edges += local.m_in_edges;
+    }
+    m_level++;
+    m_frontier_size   = found;
+    m_frontier_edges  = out_edges;
+    m_unvisited_edges -= in_edges;
+    m_next_chunk.store(0, std::memory_order_relaxed);
+    if(found == 0){
+        m_done = true;
+        return;
+    }
+
+    bool bottom_up = m_bottom_up;
+    if(m_direction_optimizing){
+        if(!m_bottom_up && m_frontier_edges > m_unvisited_edges / ALPHA){
+            bottom_up = true;
+        }else if(m_bottom_up && found < previous_size && found < m_graph.vertex_count() / BETA){
+            bottom_up = false;
+        }
+    }
+
+    if(m_bottom_up){
+        m_bits.swap(m_next_bits);
+        if(!bottom_up){
+            m_frontier.clear();
+            for(std::size_t w = 0; w < m_bits.size(); ++w){
+                for(std::uint64_t word = m_bits[w]; word != 0; word &= word - 1){
+                    m_frontier.push_back(Vertex(w * 64 + __builtin_ctzll(word)));
+                }
+            }
+        }
+    }else{
+        m_frontier.clear();
+        for(Local& local : m_locals){
+            m_frontier.insert(m_frontier.end(), local.m_next.begin(), local.m_next.end());
+        }
+        if(bottom_up){
+            std::fill(m_bits.begin(), m_bits.end(), 0);
+            for(Vertex vertex : m_frontier){
+                m_bits[vertex / 64] |= std::uint64_t(1) << (vertex % 64);
+            }
+        }
+    }
+    for(Local& local : m_locals){
+        local.m_next.clear();
+        local.m_found = 0;
+        local.m_out_edges = 0;
+        local.m_in_edges = 0;
+    }
+    m_bottom_up = bottom_up;
+}
+
+// parallel_breadth_first_search runs a ParallelBreadthFirstSearch once. transpose must be graph.transpose(); the second
+// form is for SYMMETRIC graphs, which are their own transpose.
+inline std::vector<std::uint32_t> parallel_breadth_first_search(const CsrGraph& graph, const CsrGraph& transpose,
+                                                                CsrGraph::Vertex source, std::size_t threads,
+                                                                bool direction_optimizing = true){
+    return ParallelBreadthFirstSearch(graph, transpose, threads, direction_optimizing).run(source);
+}
+inline std::vector<std::uint32_t> parallel_breadth_first_search(const CsrGraph& symmetric_graph, CsrGraph::Vertex source,
+                                                                std::size_t threads, bool direction_optimizing = true){
+    return ParallelBreadthFirstSearch(symmetric_graph, symmetric_graph, threads, direction_optimizing).run(source);
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef HASH
+#define HASH
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64 bit hash functions shared by the hashed containers. Both are built from the same multiply/xor-shift mix so that
+// every bit of the input affects the low bits of the output, which matters because the tables mask off the low bits
+// to pick a slot rather than taking a modulo.
+
+// mix_64 is the splitmix64 finaliser. It's a bijection, so distinct integer keys never collide on the full hash.
+inline std::uint64_t mix_64(std::uint64_t value){
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+inline std::uint64_t hash_int(std::uint64_t value){
+    return mix_64(value + 0x9e3779b97f4a7c15ULL);
+}
+
+// hash_bytes is MurmurHash64A. It consumes eight bytes per step, using memcpy for the loads so that unaligned keys
+// (e.g. keys packed back to back in an arena) are fine.
+inline std::uint64_t hash_bytes(const char* data, std::size_t length, std::uint64_t seed = 0){
+    const std::uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    std::uint64_t h = seed ^ (length * m);
+
+    const char* end = data + (length & ~std::size_t(7));
+    for(; data != end; data += 8){
+        std::uint64_t k;
+        std::memcpy(&k, data, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    std::uint64_t tail = 0;
+    switch(length & 7){
+        case 7: tail ^= std::uint64_t(std::uint8_t(data[6])) << 48; [[fallthrough]];
+        case 6: tail ^= std::uint64_t(std::uint8_t(data[5])) << 40; [[fallthrough]];
+        case 5: tail ^= std::uint64_t(std::uint8_t(data[4])) << 32; [[fallthrough]];
+        case 4: tail ^= std::uint64_t(std::uint8_t(data[3])) << 24; [[fallthrough]];
+        case 3: tail ^= std::uint64_t(std::uint8_t(data[2])) << 16; [[fallthrough]];
+        case 2: tail ^= std::uint64_t(std::uint8_t(data[1])) << 8;  [[fallthrough]];
+        case 1: tail ^= std::uint64_t(std::uint8_t(data[0]));
+                h ^= tail;
+                h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+#endif
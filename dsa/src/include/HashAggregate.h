@@ -0,0 +1,336 @@
+#ifndef HASHAGGREGATE
+#define HASHAGGREGATE
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Hash.h"
+
+// HashAggregator implements GROUP BY key with COUNT, SUM, MIN and MAX over int64 key/value columns. The hash table is
+// the same linear probing, power of two design as HashTable and StringHashMap, but it is driven a batch at a time
+// rather than a row at a time:
+//
+//  1. hash every key in the batch in one loop. The slot hash is a single multiply by 2^64 / phi, taking the top bits
+//     of the product as the slot (Fibonacci hashing), which spreads sequential and strided integer keys well and is
+//     several times cheaper than the full hash_int mix,
+//  2. find or insert every key, producing a group index per row (prefetching the slots of rows a little further on
+//     so that cache misses on a large table overlap instead of being paid one after another),
+//  3. apply the aggregates in one branch free loop over the group indices and values.
+//
+// Each of these loops does one thing over contiguous arrays, which keeps the branchy probing out of the aggregate loop
+// and lets the compiler vectorise the hashing. Aggregate state is stored as a structure of arrays indexed by group, so
+// groups are numbered densely in the order they were first seen.
+class HashAggregator{
+public:
+    static constexpr std::size_t BATCH_SIZE = 1024;
+
+    struct Group{
+        std::int64_t m_key;
+        std::int64_t m_count;
+        std::int64_t m_sum;
+        std::int64_t m_min;
+        std::int64_t m_max;
+    };
+
+private:
+    static constexpr std::uint32_t EMPTY = UINT32_MAX;
+    static constexpr std::size_t MIN_CAPACITY = 16;
+    static constexpr std::size_t PREFETCH_DISTANCE = 16;
+    static constexpr std::uint64_t FIBONACCI = 0x9e3779b97f4a7c15ULL;
+
+    struct Slot{
+        std::int64_t  m_key;
+        std::uint32_t m_group;
+    };
+
+    std::vector<Slot>         m_slots;
+    std::size_t               m_mask;
+    int                       m_shift;      // 64 - log2(capacity), the slot is hash >> m_shift.
+    std::vector<std::int64_t> m_keys;
+    std::vector<std::int64_t> m_count;
+    std::vector<std::int64_t> m_sum;
+    std::vector<std::int64_t> m_min;
+    std::vector<std::int64_t> m_max;
+
+    // Scratch space for one batch, kept as members so processing a batch never allocates.
+    std::vector<std::uint64_t> m_hashes;
+    std::vector<std::uint32_t> m_groups;
+
+    static std::uint64_t slot_hash(std::int64_t key){
+        return std::uint64_t(key) * FIBONACCI;
+    }
+
+    void set_capacity(std::size_t capacity){
+        m_mask  = capacity - 1;
+        m_shift = 64;
+        while(capacity > 1){
+            capacity >>= 1;
+            m_shift--;
+        }
+    }
+
+    void rehash(std::size_t capacity){
+        std::vector<Slot> old_slots(capacity, Slot{0, EMPTY});
+        old_slots.swap(m_slots);
+        set_capacity(capacity);
+        for(const Slot& slot : old_slots){
+            if(slot.m_group == EMPTY){
+                continue;
+            }
+            std::size_t position = slot_hash(slot.m_key) >> m_shift;
+            while(m_slots[position].m_group != EMPTY){
+                position = (position + 1) & m_mask;
+            }
+            m_slots[position] = slot;
+        }
+    }
+
+    // Growing is done up front for the worst case of every row in the batch being a new group, so that the probing
+    // loop never has to check whether the table is full.
+    void reserve_for(std::size_t rows){
+        std::size_t capacity = m_slots.size();
+        while((m_keys.size() + rows) * 4 > capacity * 3){
+            capacity *= 2;
+        }
+        if(capacity != m_slots.size()){
+            rehash(capacity);
+        }
+    }
+
+    std::uint32_t add_group(std::int64_t key){
+        m_keys.push_back(key);
+        m_count.push_back(0);
+        m_sum.push_back(0);
+        m_min.push_back(std::numeric_limits<std::int64_t>::max());
+        m_max.push_back(std::numeric_limits<std::int64_t>::min());
+        return std::uint32_t(m_keys.size() - 1);
+    }
+
+    std::uint32_t find_or_insert(std::int64_t key, std::uint64_t hash){
+        std::size_t position = hash >> m_shift;
+        while(true){
+            Slot& slot = m_slots[position];
+            if(slot.m_group == EMPTY){
+                slot.m_key   = key;
+                slot.m_group = add_group(key);
+                return slot.m_group;
+            }
+            if(slot.m_key == key){
+                return slot.m_group;
+            }
+            position = (position + 1) & m_mask;
+        }
+    }
+
+    void process_batch(const std::int64_t* keys, const std::int64_t* values, std::size_t rows){
+        reserve_for(rows);
+        std::uint64_t* hashes = m_hashes.data();
+        std::uint32_t* groups = m_groups.data();
+
+        for(std::size_t i = 0; i < rows; ++i){
+            hashes[i] = slot_hash(keys[i]);
+        }
+        for(std::size_t i = 0; i < rows; ++i){
+            if(i + PREFETCH_DISTANCE < rows){
+                __builtin_prefetch(&m_slots[hashes[i + PREFETCH_DISTANCE] >> m_shift]);
+            }
+            groups[i] = find_or_insert(keys[i], hashes[i]);
+        }
+
+        std::int64_t* count = m_count.data();
+        std::int64_t* sum   = m_sum.data();
+        std::int64_t* min   = m_min.data();
+        std::int64_t* max   = m_max.data();
+        for(std::size_t i = 0; i < rows; ++i){
+            std::uint32_t group = groups[i];
+            std::int64_t  value = values[i];
+            count[group]++;
+            sum[group] += value;
+            min[group]  = std::min(min[group], value);
+            max[group]  = std::max(max[group], value);
+        }
+    }
+
+public:
+    explicit HashAggregator(std::size_t expected_groups = 0) : m_mask(0), m_shift(64), m_hashes(BATCH_SIZE), m_groups(BATCH_SIZE){
+        std::size_t capacity = MIN_CAPACITY;
+        while(capacity * 3 < expected_groups * 4){
+            capacity *= 2;
+        }
+        m_slots.assign(capacity, Slot{0, EMPTY});
+        set_capacity(capacity);
+    }
+
+    // add aggregates rows rows of the key and value columns. keys[i] and values[i] make up row i.
+    void add(const std::int64_t* keys, const std::int64_t* values, std::size_t rows){
+        for(std::size_t start = 0; start < rows; start += BATCH_SIZE){
+            process_batch(keys + start, values + start, std::min(BATCH_SIZE, rows - start));
+        }
+    }
+
+    // merge folds the groups of other into this aggregator, as if all of the rows other saw had been added here.
+    void merge(const HashAggregator& other){
+        for(std::size_t start = 0; start < other.size(); start += BATCH_SIZE){
+            std::size_t rows = std::min(BATCH_SIZE, other.size() - start);
+            reserve_for(rows);
+            for(std::size_t i = start; i < start + rows; ++i){
+                std::uint32_t group = find_or_insert(other.m_keys[i], slot_hash(other.m_keys[i]));
+                m_count[group] += other.m_count[i];
+                m_sum[group]   += other.m_sum[i];
+                m_min[group]    = std::min(m_min[group], other.m_min[i]);
+                m_max[group]    = std::max(m_max[group], other.m_max[i]);
+            }
+        }
+    }
+
+    std::size_t size() const {return m_keys.size();}
+
+    Group group(std::size_t index) const{
+        assert(index < size() && "Cannot read a group beyond the end of the aggregator");
+        return Group{m_keys[index], m_count[index], m_sum[index], m_min[index], m_max[index]};
+    }
+
+    // Returns the index of the group for key, or -1 if no row with that key has been added.
+    std::ptrdiff_t find(std::int64_t key) const{
+        std::size_t position = slot_hash(key) >> m_shift;
+        while(m_slots[position].m_group != EMPTY){
+            if(m_slots[position].m_key == key){
+                return m_slots[position].m_group;
+            }
+            position = (position + 1) & m_mask;
+        }
+        return -1;
+    }
+};
+
+
+// PartitionedHashAggregate runs HashAggregator across several threads. The key space is split into one partition per
+// thread on the top bits of hash_int(key), a different hash to the one that picks a slot, so each partition's keys
+// still spread over all of its table. Each thread aggregates a contiguous chunk of the input with no sharing at all,
+// into one table per partition: every batch of its rows is radix scattered by partition into a buffer and each
+// partition's run of the buffer is added to that partition's table. Merge thread p then reads only the partition p
+// tables of the other threads, so the merge touches every group once, needs no locking, and the final result is the
+// set of partitions.
+class PartitionedHashAggregate{
+private:
+    std::vector<HashAggregator> m_partitions;
+    int m_partition_bits;
+
+    std::size_t partition_of(std::uint64_t hash) const{
+        return m_partition_bits ? std::size_t(hash >> (64 - m_partition_bits)) : 0;
+    }
+
+    // Aggregates rows rows into tables, one table per partition.
+    void add_partitioned(HashAggregator* tables, const std::int64_t* keys, const std::int64_t* values,
+                         std::size_t rows) const;
+
+public:
+    // threads is rounded up to a power of two so that a partition is just a bit field of the hash.
+    explicit PartitionedHashAggregate(int threads) : m_partition_bits(0){
+        assert(threads > 0 && "PartitionedHashAggregate needs at least one thread");
+        while((1 << m_partition_bits) < threads){
+            m_partition_bits++;
+        }
+        m_partitions.resize(std::size_t(1) << m_partition_bits);
+    }
+
+    void add(const std::int64_t* keys, const std::int64_t* values, std::size_t rows){
+        std::size_t threads = m_partitions.size();
+        // local[t * threads + p] holds thread t's groups of partition p.
+        std::vector<HashAggregator> local(threads * threads);
+        std::vector<std::thread> workers;
+
+        std::size_t chunk = (rows + threads - 1) / threads;
+        for(std::size_t t = 0; t < threads; ++t){
+            std::size_t start = std::min(rows, t * chunk);
+            std::size_t end   = std::min(rows, start + chunk);
+            workers.emplace_back([this, &local, threads, t, keys, values, start, end]{
+                add_partitioned(&local[t * threads], keys + start, values + start, end - start);
+            });
+        }
+        for(std::thread& worker : workers){
+            worker.join();
+        }
+        workers.clear();
+
+        for(std::size_t p = 0; p < threads; ++p){
+            workers.emplace_back([this, &local, threads, p]{
+                for(std::size_t t = 0; t < threads; ++t){
+                    HashAggregator& table = local[t * threads + p];
+                    if(m_partitions[p].size() == 0){
+                        m_partitions[p] = std::move(table);
+                    }else{
+                        m_partitions[p].merge(table);
+                    }
+                }
+            });
+        }
+        for(std::thread& worker : workers){
+            worker.join();
+        }
+    }
+
+    std::size_t size() const{
+        std::size_t total = 0;
+        for(const HashAggregator& partition : m_partitions){
+            total += partition.size();
+        }
+        return total;
+    }
+
+    // Looks up the group for key, returning false if no row with that key has been added.
+    bool find(std::int64_t key, HashAggregator::Group& group) const{
+        const HashAggregator& partition = m_partitions[partition_of(hash_int(key))];
+        std::ptrdiff_t index = partition.find(key);
+        if(index < 0){
+            return false;
+        }
+        group = partition.group(index);
+        return true;
+    }
+
+    const std::vector<HashAggregator>& partitions() const {return m_partitions;}
+};
+
+inline void PartitionedHashAggregate::add_partitioned(HashAggregator* tables, const std::int64_t* keys,
+                                                      const std::int64_t* values, std::size_t rows) const{
+    std::size_t partitions = m_partitions.size();
+    if(partitions == 1){
+        tables[0].add(keys, values, rows);
+        return;
+    }
+    std::vector<std::uint32_t> partition(HashAggregator::BATCH_SIZE);
+    std::vector<std::int64_t> scattered_keys(HashAggregator::BATCH_SIZE), scattered_values(HashAggregator::BATCH_SIZE);
+    std::vector<std::size_t> offsets(partitions + 1);
+    for(std::size_t start = 0; start < rows; start += HashAggregator::BATCH_SIZE){
+        std::size_t count = std::min(HashAggregator::BATCH_SIZE, rows - start);
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for(std::size_t i = 0; i < count; ++i){
+            partition[i] = std::uint32_t(partition_of(hash_int(keys[start + i])));
+            offsets[partition[i] + 1]++;
+        }
+        for(std::size_t p = 0; p < partitions; ++p){
+            offsets[p + 1] += offsets[p];
+        }
+        // Scattering advances each offset to the start of the next partition, so afterwards partition p's rows are
+        // [offsets[p - 1], offsets[p]).
+        for(std::size_t i = 0; i < count; ++i){
+            std::size_t position = offsets[partition[i]]++;
+            scattered_keys[position]   = keys[start + i];
+            scattered_values[position] = values[start + i];
+        }
+        for(std::size_t p = 0, begin = 0; p < partitions; begin = offsets[p], ++p){
+            if(offsets[p] > begin){
+                tables[p].add(&scattered_keys[begin], &scattered_values[begin], offsets[p] - begin);
+            }
+        }
+    }
+}
+
+#endif
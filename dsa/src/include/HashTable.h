@@ -3,67 +3,181 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <ostream>
 #include <vector>
 
-int* ptr(new int[10]);
+#include "HashTableStats.h"
+
+#ifdef DSA_HASHTABLE_STATS
+#include <chrono>
+#endif
+
+// HashTable is an open addressing table of ints using linear probing. The table is kept at or below MAX_LOAD_FACTOR
+// so that there is always an empty slot to terminate a probe sequence, and remove uses backward shift deletion
+// rather than tombstones so that a long lived table doesn't slowly fill up with dead slots.
 class HashTable{
 private:
     struct HashNode{
         int m_data;
         int m_key;
-        int m_size;
         bool m_init;
         HashNode() : m_init(false){};
-        HashNode(int value, int size) : m_data(value), m_size(size), m_init(true){
-            m_key = m_data % size;
+        HashNode(int value, int size) : m_data(value), m_init(true){
+            rehash_key(size);
         };
         void rehash_key(int size){
             assert(m_init && "HashNode must be initialised before hash_key function can be called");
             m_key = m_data % size;
+            if(m_key < 0){
+                m_key += size;
+            }
         }
     };
 
-    int m_size(){return m_hashTable.size();};
+    static constexpr double MAX_LOAD_FACTOR = 0.75;
+
+    int m_size() const {return m_hashTable.size();};
     std::vector<HashNode> m_hashTable;
-    int hash_key(int value){
-        return value % m_size();
+    int m_count;
+    HASHTABLE_STAT(HashTableStats m_stats;)
+
+    int hash_key(int value) const{
+        int key = value % m_size();
+        return key < 0 ? key + m_size() : key;
+    }
+    // The number of slots a node sits past its home slot, taking into account wrapping around the end of the table.
+    int displacement(int position, int key) const{
+        return position >= key ? position - key : position + m_size() - key;
     }
+    // find_slot is search without the stats, for insert and remove, so that the probe histogram only counts lookups
+    // made by callers. probes is set to the number of slots examined.
+    int find_slot(int value, int& probes) const;
+
 public:
-    HashTable(int size){
+    explicit HashTable(int size) : m_count(0){
+        assert(size > 0 && "HashTable must be created with at least one slot");
         m_hashTable = std::vector<HashNode>(size);
     }
 
 
+    // search returns the slot holding value, or -1 if value isn't in the table.
     int  search(int value);
     void resize();
     void insert(int value);
     void remove(int value);
+
+    int size() const {return m_count;}
+    int capacity() const {return m_size();}
+    double load_factor() const {return double(m_count) / m_size();}
+
+    // dump_stats prints the telemetry gathered in a -DDSA_HASHTABLE_STATS build, otherwise it just says that stats are
+    // disabled. This lets benchmarks call it unconditionally.
+    void dump_stats(std::ostream& os) const;
+#ifdef DSA_HASHTABLE_STATS
+    const HashTableStats& stats() const {return m_stats;}
+#endif
 };
 
 
 
-int HashTable::search(int value){
+inline int HashTable::find_slot(int value, int& probes) const{
     int position = hash_key(value);
-    while(m_hashTable.at(position).m_data != value && position <= m_size()){
-        position++;
-    }
-    if(position == m_size()){
-        this->resize();
-        this->search(value);
+    probes = 1;
+    while(m_hashTable[position].m_init && probes <= m_size()){
+        if(m_hashTable[position].m_data == value){
+            return position;
+        }
+        position = position + 1 == m_size() ? 0 : position + 1;
+        probes++;
     }
+    return -1;
+}
+inline int HashTable::search(int value){
+    int probes;
+    int position = find_slot(value, probes);
+    HASHTABLE_STAT(m_stats.record_search(probes, position != -1);)
     return position;
 }
-void HashTable::resize(){
-    int size_before = m_size();
-    int size_after = 2 * size_before;
-    std::vector<int> tmp(2 * size_before);
-
-    for(ptrdiff_t i = 0; i < size_before; ++i){
-        m_hashTable.at(i).rehash_key(size_after);
-        
+inline void HashTable::resize(){
+    HASHTABLE_STAT(
+        m_stats.record_load(load_factor());
+        auto start = std::chrono::steady_clock::now();
+    )
+
+    int size_after = 2 * m_size();
+    std::vector<HashNode> old_table(size_after);
+    old_table.swap(m_hashTable);
+
+    for(HashNode& node : old_table){
+        if(!node.m_init){
+            continue;
+        }
+        node.rehash_key(size_after);
+        int position = node.m_key;
+        while(m_hashTable[position].m_init){
+            position = position + 1 == size_after ? 0 : position + 1;
+        }
+        m_hashTable[position] = node;
+        HASHTABLE_STAT(m_stats.m_max_displacement = std::max(m_stats.m_max_displacement, displacement(position, node.m_key));)
+    }
+
+    HASHTABLE_STAT(
+        m_stats.record_resize(std::chrono::steady_clock::now() - start);
+        m_stats.record_load(load_factor());
+    )
+}
+inline void HashTable::insert(int value){
+    int probes;
+    if(find_slot(value, probes) != -1){
+        return;
+    }
+    if(m_count + 1 > MAX_LOAD_FACTOR * m_size()){
+        resize();
+    }
+
+    HashNode node(value, m_size());
+    int position = node.m_key;
+    while(m_hashTable[position].m_init){
+        position = position + 1 == m_size() ? 0 : position + 1;
+    }
+    m_hashTable[position] = node;
+    m_count++;
+    HASHTABLE_STAT(m_stats.record_insert(displacement(position, node.m_key), load_factor());)
+}
+inline void HashTable::remove(int value){
+    int probes;
+    int hole = find_slot(value, probes);
+    if(hole == -1){
+        return;
+    }
+    m_hashTable[hole].m_init = false;
+    m_count--;
+
+    // Backward shift: walk the cluster after the hole and pull back any node whose home slot isn't between the hole
+    // and where it currently sits, otherwise a later search for it would stop early at the hole.
+    int position = hole;
+    while(true){
+        position = position + 1 == m_size() ? 0 : position + 1;
+        HashNode& node = m_hashTable[position];
+        if(!node.m_init){
+            break;
+        }
+        if(displacement(position, node.m_key) >= displacement(position, hole)){
+            m_hashTable[hole] = node;
+            node.m_init = false;
+            hole = position;
+        }
     }
 }
-void HashTable::insert(int value){}
-void HashTable::remove(int value){}
+
+inline void HashTable::dump_stats(std::ostream& os) const{
+#ifdef DSA_HASHTABLE_STATS
+    os << "hashtable.size " << m_count << " capacity " << m_size() << " load_factor " << load_factor() << "\n";
+    m_stats.dump(os);
+#else
+    os << "hashtable.stats disabled (build with -DDSA_HASHTABLE_STATS)\n";
+#endif
+}
 
 #endif
@@ -0,0 +1,108 @@
+#ifndef HASHTABLESTATS
+#define HASHTABLESTATS
+
+// Opt-in instrumentation for HashTable. Build with -DDSA_HASHTABLE_STATS to record probe lengths, displacement,
+// load factor and resize timings. Without the define HASHTABLE_STAT expands to nothing, so neither the HashTableStats
+// member nor any of the bookkeeping calls exist in the compiled table.
+#ifdef DSA_HASHTABLE_STATS
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#define HASHTABLE_STAT(...) __VA_ARGS__
+
+struct HashTableStats{
+    // Probe lengths are counted as the number of slots examined, so a hit in the home slot is 1 probe. Anything
+    // longer than the last bucket is folded into it.
+    static const int HISTOGRAM_BUCKETS = 32;
+    // The load factor is sampled every LOAD_SAMPLE_INTERVAL inserts as well as either side of every resize.
+    static const int LOAD_SAMPLE_INTERVAL = 1024;
+
+    struct LoadSample{
+        std::uint64_t m_operation;
+        double        m_load_factor;
+    };
+
+    std::uint64_t m_hit_histogram[HISTOGRAM_BUCKETS]  = {};
+    std::uint64_t m_miss_histogram[HISTOGRAM_BUCKETS] = {};
+    std::uint64_t m_operations        = 0;      // Searches and inserts, the x axis of the load samples.
+    std::uint64_t m_inserts           = 0;
+    int           m_max_displacement  = 0;
+    std::uint64_t m_resize_count      = 0;
+    std::chrono::nanoseconds m_resize_time{0};
+    std::chrono::nanoseconds m_max_resize_time{0};
+    std::vector<LoadSample>  m_load_samples;
+
+    void record_search(int probes, bool hit){
+        int bucket = std::min(probes, HISTOGRAM_BUCKETS - 1);
+        if(hit){
+            m_hit_histogram[bucket]++;
+        }else{
+            m_miss_histogram[bucket]++;
+        }
+        m_operations++;
+    }
+    void record_insert(int displacement, double load_factor){
+        m_max_displacement = std::max(m_max_displacement, displacement);
+        m_operations++;
+        if(m_inserts++ % LOAD_SAMPLE_INTERVAL == 0){
+            record_load(load_factor);
+        }
+    }
+    void record_load(double load_factor){
+        m_load_samples.push_back({m_operations, load_factor});
+    }
+    void record_resize(std::chrono::nanoseconds duration){
+        m_resize_count++;
+        m_resize_time += duration;
+        m_max_resize_time = std::max(m_max_resize_time, duration);
+    }
+
+    static std::uint64_t total(const std::uint64_t (&histogram)[HISTOGRAM_BUCKETS]){
+        std::uint64_t sum = 0;
+        for(int i = 0; i < HISTOGRAM_BUCKETS; ++i){
+            sum += histogram[i];
+        }
+        return sum;
+    }
+    static double mean(const std::uint64_t (&histogram)[HISTOGRAM_BUCKETS]){
+        std::uint64_t weighted = 0;
+        for(int i = 0; i < HISTOGRAM_BUCKETS; ++i){
+            weighted += histogram[i] * i;
+        }
+        std::uint64_t count = total(histogram);
+        return count ? double(weighted) / count : 0.0;
+    }
+
+    void dump(std::ostream& os) const{
+        os << "hashtable.searches.hit "   << total(m_hit_histogram)  << " mean_probes " << mean(m_hit_histogram)  << "\n";
+        os << "hashtable.searches.miss "  << total(m_miss_histogram) << " mean_probes " << mean(m_miss_histogram) << "\n";
+        os << "hashtable.max_displacement " << m_max_displacement << "\n";
+        os << "hashtable.resizes " << m_resize_count
+           << " total_ns " << m_resize_time.count()
+           << " max_ns "   << m_max_resize_time.count() << "\n";
+        os << "hashtable.probe_histogram probes hit miss\n";
+        for(int i = 1; i < HISTOGRAM_BUCKETS; ++i){
+            if(m_hit_histogram[i] || m_miss_histogram[i]){
+                os << "  " << i << (i == HISTOGRAM_BUCKETS - 1 ? "+" : "")
+                   << " " << m_hit_histogram[i] << " " << m_miss_histogram[i] << "\n";
+            }
+        }
+        os << "hashtable.load_factor operation load\n";
+        for(const LoadSample& sample : m_load_samples){
+            os << "  " << sample.m_operation << " " << sample.m_load_factor << "\n";
+        }
+    }
+};
+
+#else
+
+#define HASHTABLE_STAT(...)
+
+#endif
+
+#endif
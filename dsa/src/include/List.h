@@ -3,16 +3,22 @@
 #include <stdexcept>
 #include <iterator>     // iterator
 #include <iostream>
+#include <memory>       // allocator_traits
 #include <type_traits>  // remove_cv
 #include <utility>      // swap
 #include <string>
 #include <typeinfo>
 #include <vector>
 
+#include "AllocatorHolder.h"
+
 
 //<editor-fold LIST CLASS DECLARATION
-template <class U>
-class List{
+// Nodes are allocated through Allocator, rebound to Node. The List keeps its Allocator (at no cost when it is stateless)
+// and hands it to every Node it creates or destroys, and passes it on when copied, assigned or swapped as allocator_traits
+// says, so a polymorphic_allocator works as well as std::allocator or SizeClassAllocator.
+template <class U, class Allocator = std::allocator<U>>
+class List : private AllocatorHolder<Allocator>{
 private:
     // The Node class is used to manage the memory of each element in the list as well as the Node it points to.
     // This is done so as to allow the List class to act purely as an interface to each Node without the user
@@ -32,6 +38,26 @@ private:
     Node m_head;
     int m_size;
 
+    // Destroys every Node after the head, front first.
+    void destroy_nodes(){
+        ForwardIterator itr(m_head);
+        for(; m_size > 0; m_size--){
+            itr.remove_back(this->allocator());
+        }
+    }
+    // Copies other's elements into this list, which must be empty. The copy reads other through a ForwardIterator, which
+    // only has a non-const constructor, but never changes it.
+    void copy_nodes(const List& other){
+        ForwardIterator source(const_cast<Node&>(other.m_head));
+        ForwardIterator itr(m_head);
+        for(ptrdiff_t i = 0; i < other.m_size; i++){
+            ++source;
+            itr.insert_back(this->allocator(), *source);
+            ++itr;
+            m_size++;
+        }
+    }
+
 public:
     // ForwardIterator is defined as a public class because it needs to be callable outside of List, e.g supplying an iterator to
     // other functions. However, the creation of an iterator using a Node is restricted to ForwardIterator and friends only as other
@@ -47,18 +73,67 @@ public:
     // loop over said list to insert the elements.
     //
     // Size and is_init are fairly self explanitory. Is_init is mainly used in list itself for testing but could be useful outside of list.
-    List() : m_size(0) {};
-    List(int size, const U& value) : m_size(size){
-        // This will only be executed if m_size > 0
-        if(m_size){
-            ForwardIterator itr(m_head);
-            for(ptrdiff_t i = 0; i < m_size; i++){
-                itr.insert_back(value);
-                ++itr;
-            }
-
+    List() : List(Allocator()) {};
+    explicit List(const Allocator& allocator) : AllocatorHolder<Allocator>(allocator), m_size(0) {};
+    // m_size counts the Nodes as they are made, so that if one of them throws the destructor frees the ones before it.
+    List(int size, const U& value, const Allocator& allocator = Allocator()) : List(allocator){
+        ForwardIterator itr(m_head);
+        for(ptrdiff_t i = 0; i < size; i++){
+            itr.insert_back(this->allocator(), value);
+            ++itr;
+            m_size++;
         }
     };
+
+    // Copying a list copies each element into a new Node. Moving a list, or swapping two, only hands over the chain of Nodes
+    // hanging off the head Node, so nothing is allocated or copied. The compiler generated versions would copy the head
+    // Node's pointer instead, leaving both lists owning (and later deleting) the same chain.
+    //
+    // Assigning from a list whose allocator is different, and doesn't propagate, can't take its Nodes either, since they
+    // have to be freed by the allocator that made them; the elements are copied into new Nodes instead.
+    List(const List& other) : List(select_copy_allocator(other.allocator())){
+        copy_nodes(other);
+    }
+    List(List&& other) noexcept : List(other.allocator()){
+        swap(other);
+    }
+    List& operator=(const List& other){
+        if(this != &other){
+            destroy_nodes();
+            copy_assign_allocator(this->allocator(), other.allocator());
+            copy_nodes(other);
+        }
+        return *this;
+    }
+    List& operator=(List&& other) noexcept(move_assignment_steals<Allocator>){
+        if(this != &other){
+            destroy_nodes();
+            if(can_steal_storage(this->allocator(), other.allocator())){
+                move_assign_allocator(this->allocator(), other.allocator());
+                ForwardIterator mine(m_head);
+                ForwardIterator theirs(other.m_head);
+                mine.swap_next(theirs);
+                std::swap(m_size, other.m_size);
+            }else{
+                copy_nodes(other);
+                other.destroy_nodes();
+            }
+        }
+        return *this;
+    }
+    ~List(){
+        destroy_nodes();
+    }
+    void swap(List& other) noexcept{
+        assert(can_swap_storage(this->allocator(), other.allocator()) && "Can't swap Lists with unequal allocators");
+        swap_allocators(this->allocator(), other.allocator());
+        ForwardIterator mine(m_head);
+        ForwardIterator theirs(other.m_head);
+        mine.swap_next(theirs);
+        std::swap(m_size, other.m_size);
+    }
+    Allocator get_allocator() const {return this->allocator();}
+
     const int& size(){return m_size;}
     bool is_init(){return bool(m_size);}
 
@@ -78,7 +153,7 @@ public:
         for(ptrdiff_t i = 0; i <= position; i++){
             ++itr;
         }
-        itr.insert_back(value);
+        itr.insert_back(this->allocator(), value);
 
         m_size++;
     }
@@ -89,7 +164,7 @@ public:
         for(ptrdiff_t i = 0; i <= position; i++){
             ++itr;
         }
-        itr.insert_front(value);
+        itr.insert_front(this->allocator(), value);
 
         m_size++;
     }
@@ -108,7 +183,7 @@ public:
         for(ptrdiff_t i = 0; i <= position - 2; i++){
             ++itr;
         }
-        itr.remove_back();
+        itr.remove_back(this->allocator());
 
         m_size--;
     }
@@ -175,8 +250,8 @@ public:
 //</editor-fold>
 
 //<editor-fold NODE CLASS DECLARATION
-template <class U>
-class List<U>::Node{
+template <class U, class Allocator>
+class List<U, Allocator>::Node{
 private:
     // The only classes that can actually interact with Node are the ForwardIterator and the List class.
     // This means that if at any point some other class is given access to List's private members then it still can
@@ -185,7 +260,7 @@ private:
     //
     // To initialise Node with a value we make it an explicit initialisation as we need to ensure that
     // Node is of the same type as the List containing it and to stop and undefined behaviour.
-    friend List<U>::ForwardIterator;
+    friend List<U, Allocator>::ForwardIterator;
     explicit Node(const U& value) : m_next(nullptr), m_value(value){};
 
 
@@ -197,27 +272,46 @@ private:
     U        m_value;
 
 
+    // Every Node other than a List's head is created and destroyed through these, so that it comes from the List's
+    // Allocator rather than from new and delete. The List passes its Allocator down through ForwardIterator.
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+    static Node* create(const Allocator& allocator, const U& value){
+        NodeAllocator node_allocator(allocator);
+        Node* node = node_allocator.allocate(1);
+        try{
+            ::new (static_cast<void*>(node)) Node(value);
+        }catch(...){
+            node_allocator.deallocate(node, 1);
+            throw;
+        }
+        return node;
+    }
+    static void destroy(const Allocator& allocator, Node* node){
+        node->~Node();
+        NodeAllocator(allocator).deallocate(node, 1);
+    }
+
+
     // The insert functions are used to connect an existing Node to a new Node with a given input value. This allows us to insert
     // elements into a list. There are two ways in which an insert could occur; the element can either be inserted before or after a
     // given Node. These two options are given as insert_front and insert_back respectively.
     //
     // Insert_front creates a new node that points to the Node we are inserting an element in front of. The new Node is then given the
     // value currently held by the Node we are inserting in front of. Finally, the old Node has it's value set to the user supplied value
-    // and the pointer to the new Node is set to null. This means that when the new Node pointer goes out of scope it's destructor is not
-    // called as otherwise no new Node would be inserted. However, ownership of the new Node now falls to the old Node and so care must
-    // be taken to avoid memory leaks. This is addressed in the destructor.
+    // and the pointer to the new Node is set to null. The new Node is now reachable only through the old Node, and so care must
+    // be taken to avoid memory leaks. This is addressed in List's destructor.
     //
     // Insert_back works similarly to insert_front except the value of the new Node is set to the user supplied value and the old Node
     // retains its value. This is equivalent to inserting after the old Node.
-    void insert_front(const U& value){
-        Node* tmp = new Node(this->m_value);
+    void insert_front(const Allocator& allocator, const U& value){
+        Node* tmp = create(allocator, this->m_value);
         tmp->m_next = this->m_next;
         this->m_next = tmp;
         this->m_value = value;
         tmp = nullptr;
     }
-    void insert_back(const U& value){
-        Node* tmp = new Node(value);
+    void insert_back(const Allocator& allocator, const U& value){
+        Node* tmp = create(allocator, value);
         tmp->m_next = this->m_next;
         this->m_next = tmp;
         tmp = nullptr;
@@ -233,51 +327,43 @@ private:
     // points to a nullptr, i.e it is the end of a list, then remove_back should not be called and instead we call assert.
     // We then delete the Node that the current Node points to and set the current Node to point to the temporary node. This recconects
     // the list. Finally we set the temporary Node pointer to nullptr.
-    void remove_back(){
+    void remove_back(const Allocator& allocator){
         assert(m_next != nullptr && "Cannot remove nullptr node");
         Node* tmp = m_next->m_next;
-        delete m_next;
+        destroy(allocator, m_next);
         m_next = tmp;
         tmp = nullptr;
     }
+
+    // swap_next exchanges everything after this Node with everything after other, which is how whole lists are moved and
+    // swapped without touching their Nodes.
+    void swap_next(Node& other){
+        std::swap(m_next, other.m_next);
+    }
 public:
     // This constructor is used by any class not friends with Node to be able to pass a Node to an iterator.
     explicit Node() : m_next(nullptr){};
 
 
-    // Earlier we mentioned that care needs to be taken to avoid memory leaks. For example, if we created a list of Nodes, due to the way in which
-    // new Nodes/elements are inserted into the list we would end up with the top node in the list having ownership over all of the nodes beneath it.
-    // Therefore, if we were delete this top Node without creating a a proper destructor then we would end up leaking the memory of all of the Nodes.
-    //
-    // To avoid this we must call delete iteratively on each Node connected to the top Node. This could be done from the list class since we would
-    // know the size of the list and therefore easily avoid trying to double free memory. Doing this from the Node destructor means that we only need
-    // to worry about deallocating memory once, in one Node. We check to see if the next Node is a nullptr, if it is we set this to be nullptr. If
-    // however, the current Node points to an actual Node then we must delete that Node as well to avoid a memory leak. Doing so will call that Nodes
-    // destrutor which in turn will call its next Nodes destructor and so on. This way we don't need to know the size of the list as each destructor
-    // will call the next nodes destructor iteratively until the last node at which point each destructor will return thereby deallocating all of the
-    // memory.
+    // Earlier we mentioned that care needs to be taken to avoid memory leaks. Due to the way in which new Nodes/elements are inserted
+    // into a list, the head Node ends up as the only way to reach all of the Nodes beneath it. Node can't free them itself, as a Node
+    // doesn't know which allocator it came from; only the List holds that. So the List destroys its Nodes one by one, front first,
+    // with its own Allocator (see List::destroy_nodes), and a Node's destructor leaves the Node it points to alone. Walking the
+    // list rather than having each destructor delete the next Node also means a long list doesn't recurse once per Node.
     //
     // One thing to be careful of is setting temporary Node pointers to null before the function using them returns as otherwise the temporary Node will be
     // deleted and the list will behave improperly. Restricting access to creating new Nodes will help prevent this and we want to really only create new Nodes
     // using the Node class.
-    ~Node(){
-        assert(this != nullptr && "Can't delete nullptr");
-        if(this->m_next == nullptr){
-        }else{
-            delete this->m_next;
-        }
-    }
-
 };
 //</editor-fold>
 
 //<editor-fold LIST::FORWARD_ITERATOR CLASS DECLARATION
-template <class U>
-class List<U>::ForwardIterator : public std::iterator<std::forward_iterator_tag, std::remove_cv<U>, std::ptrdiff_t, U*, U&> {
+template <class U, class Allocator>
+class List<U, Allocator>::ForwardIterator : public std::iterator<std::forward_iterator_tag, std::remove_cv<U>, std::ptrdiff_t, U*, U&> {
     private:
         // ForwardIterator needs to be friends with List in order to have access to the Node class, for which it is an iterator.
         // This makes
-        friend class List<U>;
+        friend class List<U, Allocator>;
 
 
         // This is the heart of the iterator, it points to a Node and allows the iterator to access all of the Node's functions and
@@ -347,14 +433,17 @@ class List<U>::ForwardIterator : public std::iterator<std::forward_iterator_tag,
         
 
         // Here are the Node specific functions that allow List to insert and delete Nodes.
-        void insert_front(const U& value){
-                m_itr->insert_front(value);
+        void insert_front(const Allocator& allocator, const U& value){
+                m_itr->insert_front(allocator, value);
             }
-        void insert_back(const U& value){
-                m_itr->insert_back(value);
+        void insert_back(const Allocator& allocator, const U& value){
+                m_itr->insert_back(allocator, value);
+        }
+        void remove_back(const Allocator& allocator){
+            m_itr->remove_back(allocator);
         }
-        void remove_back(){
-            m_itr->remove_back();
+        void swap_next(ForwardIterator& other){
+            m_itr->swap_next(*other.m_itr);
         }
 };
 
@@ -0,0 +1,282 @@
+#ifndef LOCKFREESTACK
+#define LOCKFREESTACK
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "Concurrency.h"
+
+// LockFreeStack is a LIFO that any number of threads can push to and pop from concurrently: a Treiber stack (a linked
+// list whose head is swung with a CAS) with an elimination array in front of it (Hendler, Shavit and Yerushalmi, "A
+// Scalable Lock-free Stack Algorithm", SPAA 2004).
+//
+// ABA. A pop reads the head node and its next pointer and then CASes the head from that node to next. If between the
+// read and the CAS the node is popped, reused and pushed again, a plain pointer CAS would still succeed and install a
+// stale next. So the head is a single 64 bit word holding a 32 bit node index and a 32 bit tag that every successful CAS
+// increments; the CAS fails if anything at all happened to the head in between. The tag wraps after 2^32 updates, and
+// a thread would have to be stalled between its read and its CAS for exactly that many to be fooled.
+//
+// Reclamation. A thread that lost the race can still read the next field of a node that has just been popped, so nodes
+// can't be handed back to the allocator while other threads are running. Nodes instead live in chunks owned by the
+// stack and go onto a free list (itself a tagged Treiber stack) when popped; a node is only ever reused as another node
+// of the same stack, so a stale read returns a harmless wrong value that the tag CAS then rejects. The chunks are freed
+// when the stack is destroyed. Chunk k holds FIRST_CHUNK_SIZE << k nodes, so a node index maps to its chunk and offset
+// with a bit scan, and the memory held is at most about twice the largest size the stack has reached.
+//
+// Elimination. Under contention most CASes on the head fail. A push and a pop that collide can instead cancel each
+// other out: after a failed CAS a thread picks a random slot of the elimination array and either finds an offer from
+// the opposite operation there and takes it, or leaves its own offer and waits briefly for a partner. A push hands its
+// node straight to the pop, so an eliminated pair never touches the head at all, and the result is still a valid LIFO
+// history because the pair can be ordered one right after the other. Only the thread that made an offer clears its
+// slot back to EMPTY, so a slot can't be reused while its owner is still looking at it.
+//
+// The chunks come from Allocator, rebound to the node type. Any pushing thread may allocate a chunk, and several may do
+// so at once (see allocate_node), so Allocator has to be thread safe: std::allocator and SizeClassAllocator are, as is
+// a polymorphic_allocator over a synchronized_pool_resource. The elimination array is allocated once, with new.
+template <class T, class Allocator = std::allocator<T>>
+class LockFreeStack{
+private:
+    static constexpr std::uint32_t NIL              = 0xffffffffu;
+    static constexpr std::size_t   FIRST_CHUNK_SIZE = 64;
+    static constexpr std::size_t   MAX_CHUNKS       = 26;       // FIRST_CHUNK_SIZE << MAX_CHUNKS stays below NIL.
+    static constexpr unsigned      ELIMINATION_SPINS = 64;
+
+    // Elimination slot states. PUSH and HANDED carry a node index in the low 32 bits.
+    static constexpr std::uint64_t EMPTY  = 0;
+    static constexpr std::uint64_t PUSH   = std::uint64_t(1) << 32;   // A push is offering its node.
+    static constexpr std::uint64_t POP    = std::uint64_t(2) << 32;   // A pop is waiting for a node.
+    static constexpr std::uint64_t HANDED = std::uint64_t(3) << 32;   // A push gave its node to the waiting pop.
+    static constexpr std::uint64_t TAKEN  = std::uint64_t(4) << 32;   // A pop took the offered node.
+
+    struct Node{
+        std::atomic<std::uint32_t> m_next;
+        alignas(T) unsigned char   m_storage[sizeof(T)];
+
+        T* value() {return std::launder(reinterpret_cast<T*>(m_storage));}
+    };
+    struct alignas(CACHE_LINE_SIZE) Slot{
+        std::atomic<std::uint64_t> m_state{EMPTY};
+    };
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_head;        // Tag << 32 | node index.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_free;        // The free list, tagged the same way.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_allocated;   // Nodes handed out from the chunks so far.
+    std::atomic<Node*> m_chunks[MAX_CHUNKS];
+    Slot*              m_slots;
+    std::size_t        m_slot_count;
+    NodeAllocator      m_allocator;
+
+    static std::uint32_t index_of(std::uint64_t word) {return std::uint32_t(word);}
+    static std::uint64_t tagged(std::uint64_t old_word, std::uint32_t index){
+        return ((old_word >> 32) + 1) << 32 | index;
+    }
+
+    Node& node(std::uint32_t index) const{
+        std::size_t position = std::size_t(index) + FIRST_CHUNK_SIZE;
+        int bit = 63 - __builtin_clzll(position);
+        return m_chunks[bit - __builtin_ctzll(FIRST_CHUNK_SIZE)].load(std::memory_order_acquire)[position - (std::size_t(1) << bit)];
+    }
+
+    // The tagged Treiber push and pop, shared by the stack itself and by the free list.
+    bool try_link(std::atomic<std::uint64_t>& head, std::uint32_t index){
+        std::uint64_t old_head = head.load(std::memory_order_relaxed);
+        node(index).m_next.store(index_of(old_head), std::memory_order_relaxed);
+        return head.compare_exchange_weak(old_head, tagged(old_head, index), std::memory_order_release, std::memory_order_relaxed);
+    }
+    // try_unlink returns NIL if the list was empty and NIL - 1 if it lost a race.
+    std::uint32_t try_unlink(std::atomic<std::uint64_t>& head){
+        std::uint64_t old_head = head.load(std::memory_order_acquire);
+        std::uint32_t index = index_of(old_head);
+        if(index == NIL){
+            return NIL;
+        }
+        std::uint32_t next = node(index).m_next.load(std::memory_order_relaxed);
+        if(head.compare_exchange_weak(old_head, tagged(old_head, next), std::memory_order_acquire, std::memory_order_relaxed)){
+            return index;
+        }
+        return NIL - 1;
+    }
+
+    std::uint32_t allocate_node();
+    void free_node(std::uint32_t index){
+        while(!try_link(m_free, index)){
+        }
+    }
+
+    // The elimination protocol. Both return true if the operation was completed by pairing with the opposite one.
+    bool eliminate_push(std::uint32_t index);
+    bool eliminate_pop(std::uint32_t& index);
+    Slot& random_slot(){
+        thread_local std::uint64_t state = 0x9e3779b97f4a7c15ull * (thread_index() + 1);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return m_slots[state % m_slot_count];
+    }
+
+public:
+    static constexpr std::size_t DEFAULT_ELIMINATION_SLOTS = 8;
+
+    // elimination_slots is the size of the elimination array; 0 turns elimination off, leaving a plain Treiber stack.
+    explicit LockFreeStack(std::size_t elimination_slots = DEFAULT_ELIMINATION_SLOTS, const Allocator& allocator = Allocator())
+        : m_head(NIL), m_free(NIL), m_allocated(0), m_slots(new Slot[elimination_slots]), m_slot_count(elimination_slots),
+          m_allocator(allocator){
+        for(std::atomic<Node*>& chunk : m_chunks){
+            chunk.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    LockFreeStack(const LockFreeStack&) = delete;
+    LockFreeStack& operator=(const LockFreeStack&) = delete;
+    ~LockFreeStack();
+
+    void push(const T& value){emplace(value);}
+    void push(T&& value){emplace(std::move(value));}
+    template <class... Args>
+    void emplace(Args&&... args);
+    // try_pop returns false if the stack was empty.
+    bool try_pop(T& value);
+
+    // Only a snapshot when other threads are using the stack.
+    bool is_empty() const {return index_of(m_head.load(std::memory_order_acquire)) == NIL;}
+    Allocator get_allocator() const {return Allocator(m_allocator);}
+};
+
+template <class T, class Allocator>
+LockFreeStack<T, Allocator>::~LockFreeStack(){
+    for(std::uint32_t index = index_of(m_head.load(std::memory_order_relaxed)); index != NIL;){
+        Node& current = node(index);
+        current.value()->~T();
+        index = current.m_next.load(std::memory_order_relaxed);
+    }
+    for(std::size_t k = 0; k < MAX_CHUNKS; ++k){
+        if(Node* chunk = m_chunks[k].load(std::memory_order_relaxed)){
+            m_allocator.deallocate(chunk, FIRST_CHUNK_SIZE << k);
+        }
+    }
+    delete[] m_slots;
+}
+
+template <class T, class Allocator>
+std::uint32_t LockFreeStack<T, Allocator>::allocate_node(){
+    while(true){
+        std::uint32_t index = try_unlink(m_free);
+        if(index == NIL){
+            break;
+        }
+        if(index != NIL - 1){
+            return index;
+        }
+    }
+    std::uint32_t index = m_allocated.fetch_add(1, std::memory_order_relaxed);
+    std::size_t position = std::size_t(index) + FIRST_CHUNK_SIZE;
+    int bit = 63 - __builtin_clzll(position);
+    std::size_t k = std::size_t(bit - __builtin_ctzll(FIRST_CHUNK_SIZE));
+    assert(k < MAX_CHUNKS && "LockFreeStack is out of node indices");
+    if(m_chunks[k].load(std::memory_order_acquire) == nullptr){
+        // Every thread that finds the chunk missing allocates one; the first to install it wins and the rest free theirs.
+        Node* chunk = m_allocator.allocate(FIRST_CHUNK_SIZE << k);
+        for(std::size_t i = 0; i < (FIRST_CHUNK_SIZE << k); ++i){
+            ::new (static_cast<void*>(&chunk[i].m_next)) std::atomic<std::uint32_t>(NIL);
+        }
+        Node* expected = nullptr;
+        if(!m_chunks[k].compare_exchange_strong(expected, chunk, std::memory_order_acq_rel)){
+            m_allocator.deallocate(chunk, FIRST_CHUNK_SIZE << k);
+        }
+    }
+    return index;
+}
+
+template <class T, class Allocator>
+bool LockFreeStack<T, Allocator>::eliminate_push(std::uint32_t index){
+    Slot& slot = random_slot();
+    std::uint64_t state = slot.m_state.load(std::memory_order_acquire);
+    if(state == POP){
+        return slot.m_state.compare_exchange_strong(state, HANDED | index, std::memory_order_release, std::memory_order_relaxed);
+    }
+    std::uint64_t offer = PUSH | index;
+    if(state != EMPTY || !slot.m_state.compare_exchange_strong(state, offer, std::memory_order_release, std::memory_order_relaxed)){
+        return false;
+    }
+    for(unsigned spins = 0; spins < ELIMINATION_SPINS; ++spins){
+        if(slot.m_state.load(std::memory_order_acquire) != offer){
+            break;
+        }
+        cpu_relax();
+    }
+    // Withdraw the offer. If that fails a pop has taken the node, and the slot is ours to clear.
+    if(slot.m_state.compare_exchange_strong(offer, EMPTY, std::memory_order_relaxed)){
+        return false;
+    }
+    slot.m_state.store(EMPTY, std::memory_order_release);
+    return true;
+}
+
+template <class T, class Allocator>
+bool LockFreeStack<T, Allocator>::eliminate_pop(std::uint32_t& index){
+    Slot& slot = random_slot();
+    std::uint64_t state = slot.m_state.load(std::memory_order_acquire);
+    if((state & ~std::uint64_t(NIL)) == PUSH){
+        if(slot.m_state.compare_exchange_strong(state, TAKEN, std::memory_order_acquire, std::memory_order_relaxed)){
+            index = index_of(state);
+            return true;
+        }
+        return false;
+    }
+    if(state != EMPTY || !slot.m_state.compare_exchange_strong(state, POP, std::memory_order_relaxed)){
+        return false;
+    }
+    for(unsigned spins = 0; spins < ELIMINATION_SPINS; ++spins){
+        if(slot.m_state.load(std::memory_order_relaxed) != POP){
+            break;
+        }
+        cpu_relax();
+    }
+    std::uint64_t expected = POP;
+    if(slot.m_state.compare_exchange_strong(expected, EMPTY, std::memory_order_relaxed)){
+        return false;
+    }
+    state = slot.m_state.load(std::memory_order_acquire);
+    index = index_of(state);
+    slot.m_state.store(EMPTY, std::memory_order_relaxed);
+    return true;
+}
+
+template <class T, class Allocator>
+template <class... Args>
+void LockFreeStack<T, Allocator>::emplace(Args&&... args){
+    std::uint32_t index = allocate_node();
+    ::new (static_cast<void*>(node(index).m_storage)) T(std::forward<Args>(args)...);
+    while(!try_link(m_head, index)){
+        if(m_slot_count && eliminate_push(index)){
+            return;
+        }
+    }
+}
+
+template <class T, class Allocator>
+bool LockFreeStack<T, Allocator>::try_pop(T& value){
+    std::uint32_t index;
+    while(true){
+        index = try_unlink(m_head);
+        if(index == NIL){
+            return false;
+        }
+        if(index != NIL - 1 || (m_slot_count && eliminate_pop(index))){
+            break;
+        }
+    }
+    T* popped = node(index).value();
+    value = std::move(*popped);
+    popped->~T();
+    free_node(index);
+    return true;
+}
+
+#endif
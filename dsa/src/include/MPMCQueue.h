@@ -0,0 +1,155 @@
+#ifndef MPMCQUEUE
+#define MPMCQUEUE
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "Concurrency.h"
+
+// MPMCQueue is a bounded FIFO that any number of threads can push to and pop from concurrently. It is Dmitry Vyukov's
+// bounded MPMC queue: a power of two ring like Queue, where every cell carries a sequence number that says whose turn it
+// is to use the cell.
+//
+//  - A cell at position pos is free for the producer that claims pos when its sequence equals pos.
+//  - Once written, the producer sets the sequence to pos + 1, which makes it ready for the consumer that claims pos.
+//  - Once read, the consumer sets the sequence to pos + capacity, which frees it for the producer one lap later.
+//
+// Producers claim positions with a single CAS on m_enqueue_pos and consumers with a single CAS on m_dequeue_pos, so
+// producers never contend with consumers, and the hand off of each element is one release store on the cell's sequence
+// matched by an acquire load. Comparing the sequence with the claimed position also tells a thread that the queue is
+// full or empty without looking at the other side's index. There is no lock and nothing is allocated after
+// construction.
+//
+// The cells come from Allocator, rebound to the cell type. Only the constructor and destructor use it, so it needn't be
+// thread safe, and it sits on the read only cache line next to m_cells, where it takes no extra space.
+template <class T, class Allocator = std::allocator<T>>
+class MPMCQueue{
+private:
+    struct Cell{
+        std::atomic<std::size_t> m_sequence;
+        alignas(T) unsigned char m_storage[sizeof(T)];
+
+        T* value() {return std::launder(reinterpret_cast<T*>(m_storage));}
+    };
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Cell> CellAllocator;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_enqueue_pos;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_dequeue_pos;
+    alignas(CACHE_LINE_SIZE) Cell* m_cells;
+    std::size_t   m_mask;
+    CellAllocator m_allocator;
+
+public:
+    // capacity is rounded up to a power of two, with a minimum of two (with a single cell the "free" and "ready"
+    // sequence numbers of consecutive laps would be the same).
+    explicit MPMCQueue(std::size_t capacity, const Allocator& allocator = Allocator())
+        : m_enqueue_pos(0), m_dequeue_pos(0), m_allocator(allocator){
+        std::size_t size = 2;
+        while(size < capacity){
+            size *= 2;
+        }
+        m_mask  = size - 1;
+        m_cells = m_allocator.allocate(size);
+        for(std::size_t i = 0; i < size; ++i){
+            ::new (static_cast<void*>(&m_cells[i].m_sequence)) std::atomic<std::size_t>(i);
+        }
+    }
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+    ~MPMCQueue(){
+        std::size_t end = m_enqueue_pos.load(std::memory_order_relaxed);
+        for(std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed); pos != end; ++pos){
+            m_cells[pos & m_mask].value()->~T();
+        }
+        m_allocator.deallocate(m_cells, m_mask + 1);
+    }
+
+    // try_emplace returns false if the queue is full.
+    template <class... Args>
+    bool try_emplace(Args&&... args){
+        Cell* cell;
+        std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        while(true){
+            cell = &m_cells[pos & m_mask];
+            std::size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = std::intptr_t(sequence) - std::intptr_t(pos);
+            if(diff == 0){
+                if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }else if(diff < 0){
+                return false;
+            }else{
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (static_cast<void*>(cell->m_storage)) T(std::forward<Args>(args)...);
+        cell->m_sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    bool try_push(const T& value){return try_emplace(value);}
+    bool try_push(T&& value){return try_emplace(std::move(value));}
+
+    // try_pop returns false if the queue is empty.
+    bool try_pop(T& out){
+        Cell* cell;
+        std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        while(true){
+            cell = &m_cells[pos & m_mask];
+            std::size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = std::intptr_t(sequence) - std::intptr_t(pos + 1);
+            if(diff == 0){
+                if(m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }else if(diff < 0){
+                return false;
+            }else{
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        T* value = cell->value();
+        out = std::move(*value);
+        value->~T();
+        cell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // push and pop spin until they succeed.
+    void push(const T& value){
+        while(!try_push(value)){
+            cpu_relax();
+        }
+    }
+    void push(T&& value){
+        while(!try_push(std::move(value))){
+            cpu_relax();
+        }
+    }
+    T pop(){
+        T value;
+        while(!try_pop(value)){
+            cpu_relax();
+        }
+        return value;
+    }
+
+    // size is only a snapshot while other threads are running. Elements that have been claimed but not yet written or
+    // read are counted.
+    std::size_t size() const{
+        std::size_t dequeue_pos = m_dequeue_pos.load(std::memory_order_acquire);
+        std::size_t enqueue_pos = m_enqueue_pos.load(std::memory_order_acquire);
+        return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+    }
+    bool is_empty() const {return size() == 0;}
+    std::size_t capacity() const {return m_mask + 1;}
+    Allocator get_allocator() const {return Allocator(m_allocator);}
+};
+
+#endif
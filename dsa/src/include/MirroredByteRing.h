@@ -0,0 +1,126 @@
+#ifndef MIRROREDBYTERING
+#define MIRROREDBYTERING
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// MirroredByteRing is a byte ring buffer for streams (socket input waiting to be parsed, output waiting for write())
+// whose pages are mapped into memory twice, back to back. A byte at offset i of the buffer can be reached at both
+// m_data + i and m_data + capacity + i, so a region that starts near the end of the buffer and wraps around to the start
+// is still one contiguous run of addresses. Every readable and writable region is therefore a single span that can be
+// handed straight to a parser, read() or write(), where a ring on a plain buffer would need either two calls or a copy
+// at the wrap point.
+//
+// The mapping is built from a memfd: reserve 2 * capacity bytes of address space, then map the memfd over each half
+// with MAP_FIXED | MAP_SHARED so both halves are the same physical pages. The capacity is a power of two and a multiple
+// of the page size, and the read and write positions are 64 bit counters that only increase, so the number of readable
+// bytes is just their difference and the offset into the buffer is a mask.
+//
+// Like Queue this is for use by one thread at a time. Failing to set up the mapping throws std::system_error.
+class MirroredByteRing{
+private:
+    char*         m_data;
+    std::size_t   m_capacity;
+    std::uint64_t m_read;
+    std::uint64_t m_write;
+
+    static std::size_t round_capacity(std::size_t capacity){
+        std::size_t size = std::size_t(sysconf(_SC_PAGESIZE));
+        while(size < capacity){
+            size *= 2;
+        }
+        return size;
+    }
+    [[noreturn]] static void fail(const char* what){
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+public:
+    // capacity is rounded up to a power of two that is at least one page.
+    explicit MirroredByteRing(std::size_t capacity);
+    MirroredByteRing(const MirroredByteRing&) = delete;
+    MirroredByteRing& operator=(const MirroredByteRing&) = delete;
+    ~MirroredByteRing(){
+        munmap(m_data, 2 * m_capacity);
+    }
+
+    // The readable bytes, oldest first, as one contiguous span of readable() bytes. consume(count) discards the first
+    // count of them once they have been used.
+    const char* read_data() const {return m_data + (m_read & (m_capacity - 1));}
+    std::size_t readable() const {return std::size_t(m_write - m_read);}
+    void consume(std::size_t count){
+        assert(count <= readable() && "Can't consume more bytes than a MirroredByteRing holds");
+        m_read += count;
+    }
+
+    // The free space, as one contiguous span of writable() bytes. Fill a prefix of it (with read() from a socket, say),
+    // then commit(count) to make those bytes readable.
+    char* write_data() {return m_data + (m_write & (m_capacity - 1));}
+    std::size_t writable() const {return m_capacity - readable();}
+    void commit(std::size_t count){
+        assert(count <= writable() && "Can't commit more bytes than a MirroredByteRing has free");
+        m_write += count;
+    }
+
+    // write copies in as many of the count bytes as fit and read copies out as many as are available, for callers that
+    // have the bytes in a buffer of their own anyway. Both return how many bytes they copied.
+    std::size_t write(const void* bytes, std::size_t count){
+        count = std::min(count, writable());
+        std::memcpy(write_data(), bytes, count);
+        commit(count);
+        return count;
+    }
+    std::size_t read(void* bytes, std::size_t count){
+        count = std::min(count, readable());
+        std::memcpy(bytes, read_data(), count);
+        consume(count);
+        return count;
+    }
+
+    void clear() {m_read = m_write;}
+    bool is_empty() const {return m_read == m_write;}
+    std::size_t capacity() const {return m_capacity;}
+};
+
+inline MirroredByteRing::MirroredByteRing(std::size_t capacity) : m_data(nullptr), m_capacity(round_capacity(capacity)), m_read(0), m_write(0){
+    int fd = memfd_create("MirroredByteRing", MFD_CLOEXEC);
+    if(fd < 0){
+        fail("memfd_create");
+    }
+    if(ftruncate(fd, off_t(m_capacity)) != 0){
+        int error = errno;
+        close(fd);
+        errno = error;
+        fail("ftruncate");
+    }
+    // Reserve the whole range first so that nothing else can be mapped into the second half between the two mmaps.
+    void* base = mmap(nullptr, 2 * m_capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED){
+        int error = errno;
+        close(fd);
+        errno = error;
+        fail("mmap");
+    }
+    char* data = static_cast<char*>(base);
+    bool mapped = mmap(data, m_capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+                  mmap(data + m_capacity, m_capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    int error = errno;
+    // The mappings keep the memory alive, the descriptor isn't needed any more.
+    close(fd);
+    if(!mapped){
+        munmap(base, 2 * m_capacity);
+        errno = error;
+        fail("mmap");
+    }
+    m_data = data;
+}
+
+#endif
@@ -0,0 +1,481 @@
+#ifndef PERSISTENTQUEUE
+#define PERSISTENTQUEUE
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Deque.h"
+#include "Hash.h"
+
+// When a PersistentQueue forces its writes out to disk.
+//
+//  - NONE leaves it to the kernel's normal writeback. Everything enqueued survives the process crashing or being
+//    killed, since the data is already in the page cache, but not the machine crashing.
+//  - GROUP_COMMIT calls msync once every group_commit_records records or group_commit_bytes bytes, whichever comes first,
+//    so a machine crash loses at most one group and the cost of each msync is shared by the whole group.
+//  - EVERY_WRITE calls msync after every enqueue. Nothing acknowledged is ever lost, at the price of one synchronous disk
+//    write per record.
+//
+// commit() can also be called at any time to make everything enqueued so far durable.
+enum class SyncPolicy{NONE, GROUP_COMMIT, EVERY_WRITE};
+
+struct PersistentQueueOptions{
+    std::size_t segment_size         = std::size_t(64) << 20;   // A multiple of the page size.
+    SyncPolicy  sync_policy          = SyncPolicy::GROUP_COMMIT;
+    std::size_t group_commit_records = 256;
+    std::size_t group_commit_bytes   = std::size_t(1) << 20;
+    std::size_t max_spare_segments   = 2;
+};
+
+// PersistentQueue is a FIFO of byte strings kept in a directory on disk, so that its contents survive the process
+// restarting. It has Queue's enqueue, dequeue and peek, except that the elements are records of bytes.
+//
+// Records are appended to fixed size segment files (segment-<index>.log) that are mapped into memory, so an enqueue is
+// a memcpy into the mapping and a dequeue reads straight out of it. Each record is a 16 byte header (length, checksum and
+// a sequence number that increases by one per record) followed by the payload, padded to 8 bytes. When a record doesn't
+// fit in the rest of a segment an end marker is written and the writer moves on to the next segment.
+//
+// The consumer's position is checkpointed on every dequeue into a small mapped checkpoint file, which holds two slots
+// that are written alternately, each with a generation number and a checksum, so a torn checkpoint write falls back to
+// the previous one. Delivery after a restart is exactly once if only the process died, and at least once (from the last
+// durable checkpoint) after a machine crash.
+//
+// Opening a queue reads the checkpoint and scans forward from it, checking each record's checksum and sequence number;
+// the first record that doesn't check out, such as one torn by a crash part way through a write, is where the queue
+// ends and the next enqueue goes. The sequence numbers are what make recycling segments safe. Once the reader has
+// moved past a segment, its file is renamed to a spare (up to max_spare_segments of them) and reused for a later
+// segment instead of creating and sizing a new file. The old records still in it have lower sequence numbers than the
+// ones the scan expects, so they can never be mistaken for live data.
+//
+// Like Queue this is for use by one thread at a time. I/O failures throw std::system_error (std::filesystem_error for
+// directory operations).
+class PersistentQueue{
+private:
+    static constexpr std::uint64_t SEGMENT_MAGIC       = 0x4745535145555150ULL;
+    static constexpr std::uint32_t SEGMENT_END         = 0xffffffff;
+    static constexpr std::size_t   SEGMENT_HEADER_SIZE = 64;
+    static constexpr std::size_t   RECORD_HEADER_SIZE  = 16;
+
+    struct SegmentHeader{
+        std::uint64_t m_magic;
+        std::uint64_t m_index;
+        std::uint64_t m_first_sequence;
+    };
+    struct RecordHeader{
+        std::uint32_t m_length;
+        std::uint32_t m_checksum;
+        std::uint64_t m_sequence;
+    };
+    struct Checkpoint{
+        std::uint64_t m_generation;
+        std::uint64_t m_segment;
+        std::uint64_t m_offset;
+        std::uint64_t m_sequence;
+        std::uint64_t m_checksum;
+    };
+    struct Segment{
+        std::uint64_t m_index;
+        char*         m_data;
+    };
+
+    std::filesystem::path  m_directory;
+    PersistentQueueOptions m_options;
+    std::size_t            m_page_size;
+
+    Deque<Segment>         m_segments;          // Mapped segments, the one being read first and the one being written last.
+    std::vector<std::filesystem::path> m_spares;
+    std::uint64_t          m_next_spare;        // Used to name spare files.
+    Checkpoint*            m_checkpoints;       // The two checkpoint slots, mapped.
+    std::uint64_t          m_generation;
+
+    std::size_t   m_read_offset;                // In m_segments.front().
+    std::uint64_t m_read_sequence;
+    std::size_t   m_write_offset;               // In m_segments.back().
+    std::uint64_t m_write_sequence;
+
+    std::size_t   m_synced_offset;              // Everything in m_segments.back() before this is durable.
+    std::size_t   m_unsynced_records;
+    std::size_t   m_unsynced_bytes;
+    bool          m_directory_dirty;            // A segment file was created or renamed since the last commit.
+
+    [[noreturn]] static void fail(const char* what){
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+    static std::size_t record_size(std::size_t length){
+        return (RECORD_HEADER_SIZE + length + 7) & ~std::size_t(7);
+    }
+    // A zero filled file must never look like a valid record, so the checksum is never zero.
+    static std::uint32_t record_checksum(std::uint32_t length, std::uint64_t sequence, const char* payload, std::size_t size){
+        std::uint32_t checksum = std::uint32_t(hash_bytes(payload, size, sequence ^ (std::uint64_t(length) << 32)));
+        return checksum ? checksum : 1;
+    }
+    static std::uint64_t checkpoint_checksum(const Checkpoint& checkpoint){
+        return hash_bytes(reinterpret_cast<const char*>(&checkpoint), offsetof(Checkpoint, m_checksum));
+    }
+
+    std::filesystem::path segment_path(std::uint64_t index) const{
+        char name[64];
+        std::snprintf(name, sizeof(name), "segment-%016llx.log", static_cast<unsigned long long>(index));
+        return m_directory / name;
+    }
+    char* map_file(const std::filesystem::path& path, std::size_t size, bool resize);
+    void sync_range(char* data, std::size_t begin, std::size_t end, int flags);
+    void sync_directory();
+
+    // Reads the record header at offset in data, and checks that it is the record with the given sequence number (or the
+    // end marker in its place) and that it lies within the segment.
+    bool valid_record(const char* data, std::size_t offset, std::uint64_t sequence, RecordHeader& header) const;
+    bool valid_segment(const char* data, std::uint64_t index, std::uint64_t& first_sequence) const;
+
+    void open_segment(std::uint64_t index, std::uint64_t first_sequence);
+    void retire_segment_file(const std::filesystem::path& path);
+    void roll_segment();
+    void skip_segment_end();
+    void write_checkpoint();
+    void recover();
+
+public:
+    explicit PersistentQueue(const std::string& directory, const PersistentQueueOptions& options = PersistentQueueOptions());
+    PersistentQueue(const PersistentQueue&) = delete;
+    PersistentQueue& operator=(const PersistentQueue&) = delete;
+    ~PersistentQueue();
+
+    void enqueue(const void* data, std::size_t length);
+    void enqueue(std::string_view record){enqueue(record.data(), record.size());}
+    // peek returns the front record in place; the view is valid until the record is dequeued or popped.
+    std::string_view peek();
+    std::string dequeue();
+    // pop removes the front record without copying it out, for callers that have already used it through peek.
+    void pop();
+
+    // commit makes every record enqueued so far, and the consumer's checkpoint, durable on disk.
+    void commit();
+
+    bool is_empty() const {return m_read_sequence == m_write_sequence;}
+    std::size_t size() const {return std::size_t(m_write_sequence - m_read_sequence);}
+    std::size_t segments() const {return m_segments.size();}
+    std::size_t spare_segments() const {return m_spares.size();}
+    // The largest record that fits in a segment, along with the end marker.
+    std::size_t max_record_size() const{
+        return m_options.segment_size - SEGMENT_HEADER_SIZE - 2 * RECORD_HEADER_SIZE - 7;
+    }
+};
+
+inline char* PersistentQueue::map_file(const std::filesystem::path& path, std::size_t size, bool resize){
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0){
+        fail("open");
+    }
+    if(resize && ftruncate(fd, off_t(size)) != 0){
+        int error = errno;
+        close(fd);
+        errno = error;
+        fail("ftruncate");
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if(data == MAP_FAILED){
+        errno = error;
+        fail("mmap");
+    }
+    return static_cast<char*>(data);
+}
+inline void PersistentQueue::sync_range(char* data, std::size_t begin, std::size_t end, int flags){
+    begin &= ~(m_page_size - 1);
+    if(end > begin && msync(data + begin, end - begin, flags) != 0){
+        fail("msync");
+    }
+}
+// A new or renamed file is only durable once the directory entry is, which takes an fsync of the directory itself.
+inline void PersistentQueue::sync_directory(){
+    int fd = open(m_directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0){
+        fail("open");
+    }
+    int result = fsync(fd);
+    int error = errno;
+    close(fd);
+    if(result != 0){
+        errno = error;
+        fail("fsync");
+    }
+    m_directory_dirty = false;
+}
+
+inline bool PersistentQueue::valid_record(const char* data, std::size_t offset, std::uint64_t sequence, RecordHeader& header) const{
+    if(offset + RECORD_HEADER_SIZE > m_options.segment_size){
+        return false;
+    }
+    std::memcpy(&header, data + offset, RECORD_HEADER_SIZE);
+    if(header.m_sequence != sequence){
+        return false;
+    }
+    std::size_t length = header.m_length == SEGMENT_END ? 0 : header.m_length;
+    if(offset + record_size(length) > m_options.segment_size){
+        return false;
+    }
+    return header.m_checksum == record_checksum(header.m_length, sequence, data + offset + RECORD_HEADER_SIZE, length);
+}
+inline bool PersistentQueue::valid_segment(const char* data, std::uint64_t index, std::uint64_t& first_sequence) const{
+    SegmentHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    first_sequence = header.m_first_sequence;
+    return header.m_magic == SEGMENT_MAGIC && header.m_index == index;
+}
+
+// The new segment's file is a spare if there is one, otherwise a new file. Its header is written last so that a crash
+// part way through leaves a segment that recovery ignores.
+inline void PersistentQueue::open_segment(std::uint64_t index, std::uint64_t first_sequence){
+    std::filesystem::path path = segment_path(index);
+    bool resize = true;
+    if(!m_spares.empty()){
+        std::filesystem::rename(m_spares.back(), path);
+        m_spares.pop_back();
+        resize = false;
+    }
+    char* data = map_file(path, m_options.segment_size, resize);
+    SegmentHeader header = {SEGMENT_MAGIC, index, first_sequence};
+    std::memcpy(data, &header, sizeof(header));
+    m_segments.push_back(Segment{index, data});
+    m_directory_dirty = true;
+}
+inline void PersistentQueue::retire_segment_file(const std::filesystem::path& path){
+    if(m_spares.size() < m_options.max_spare_segments){
+        char name[64];
+        std::snprintf(name, sizeof(name), "spare-%llu.log", static_cast<unsigned long long>(m_next_spare++));
+        m_spares.push_back(m_directory / name);
+        std::filesystem::rename(path, m_spares.back());
+    }else{
+        std::filesystem::remove(path);
+    }
+    m_directory_dirty = true;
+}
+
+// Ends the segment being written with an end marker and starts the next one. Under a sync policy the rest of the old
+// segment is flushed now, since commit only looks at the segment being written.
+inline void PersistentQueue::roll_segment(){
+    char* data = m_segments.back().m_data;
+    RecordHeader end = {SEGMENT_END, record_checksum(SEGMENT_END, m_write_sequence, nullptr, 0), m_write_sequence};
+    std::memcpy(data + m_write_offset, &end, RECORD_HEADER_SIZE);
+    bool durable = m_options.sync_policy != SyncPolicy::NONE;
+    sync_range(data, m_synced_offset, m_write_offset + RECORD_HEADER_SIZE, durable ? MS_SYNC : MS_ASYNC);
+
+    open_segment(m_segments.back().m_index + 1, m_write_sequence);
+    m_write_offset  = SEGMENT_HEADER_SIZE;
+    m_synced_offset = 0;
+}
+// Moves the reader past an end marker into the next segment. The checkpoint has to be durable before the old segment's
+// file is recycled, or a crash could leave a checkpoint that points into a file that has been reused.
+inline void PersistentQueue::skip_segment_end(){
+    RecordHeader header;
+    std::memcpy(&header, m_segments.front().m_data + m_read_offset, RECORD_HEADER_SIZE);
+    if(header.m_length != SEGMENT_END){
+        return;
+    }
+    assert(m_segments.size() > 1 && "PersistentQueue end marker in the segment being written");
+    Segment old = m_segments.pop_front();
+    m_read_offset = SEGMENT_HEADER_SIZE;
+    write_checkpoint();
+    if(m_options.sync_policy != SyncPolicy::NONE){
+        sync_range(reinterpret_cast<char*>(m_checkpoints), 0, m_page_size, MS_SYNC);
+    }
+    munmap(old.m_data, m_options.segment_size);
+    retire_segment_file(segment_path(old.m_index));
+}
+inline void PersistentQueue::write_checkpoint(){
+    Checkpoint& slot = m_checkpoints[++m_generation & 1];
+    Checkpoint checkpoint = {m_generation, m_segments.front().m_index, m_read_offset, m_read_sequence, 0};
+    checkpoint.m_checksum = checkpoint_checksum(checkpoint);
+    slot = checkpoint;
+}
+
+inline void PersistentQueue::recover(){
+    // The newest valid checkpoint slot, if any.
+    bool checkpointed = false;
+    Checkpoint checkpoint = {};
+    for(int i = 0; i < 2; ++i){
+        const Checkpoint& slot = m_checkpoints[i];
+        if(slot.m_checksum == checkpoint_checksum(slot) && slot.m_generation != 0 &&
+           (!checkpointed || slot.m_generation > checkpoint.m_generation)){
+            checkpoint   = slot;
+            checkpointed = true;
+        }
+    }
+    m_generation = checkpointed ? checkpoint.m_generation : 0;
+
+    std::vector<std::uint64_t> indices;
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(m_directory)){
+        std::string name = entry.path().filename().string();
+        unsigned long long number;
+        if(std::sscanf(name.c_str(), "segment-%16llx.log", &number) == 1){
+            indices.push_back(number);
+        }else if(std::sscanf(name.c_str(), "spare-%llu.log", &number) == 1){
+            m_spares.push_back(entry.path());
+            m_next_spare = std::max<std::uint64_t>(m_next_spare, number + 1);
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+
+    // Map the run of consecutive, valid segments that starts at the checkpoint (or at the oldest segment). Everything
+    // else is either already consumed or was never completely written, and gets recycled.
+    std::uint64_t start = checkpointed ? checkpoint.m_segment : (indices.empty() ? 0 : indices.front());
+    m_read_offset   = checkpointed ? checkpoint.m_offset : SEGMENT_HEADER_SIZE;
+    m_read_sequence = checkpointed ? checkpoint.m_sequence : 0;
+    for(std::uint64_t index : indices){
+        std::uint64_t first_sequence;
+        bool next = m_segments.is_empty() ? index >= start : index == m_segments.back().m_index + 1;
+        if(next){
+            char* data = map_file(segment_path(index), m_options.segment_size, false);
+            if(valid_segment(data, index, first_sequence)){
+                if(m_segments.is_empty() && (!checkpointed || index != start)){
+                    // Without a checkpoint, or if the checkpointed segment is missing, start from the beginning of the
+                    // oldest segment there is.
+                    m_read_offset   = SEGMENT_HEADER_SIZE;
+                    m_read_sequence = first_sequence;
+                }
+                m_segments.push_back(Segment{index, data});
+                continue;
+            }
+            munmap(data, m_options.segment_size);
+        }
+        retire_segment_file(segment_path(index));
+    }
+    if(m_segments.is_empty()){
+        open_segment(start, m_read_sequence);
+        m_read_offset = SEGMENT_HEADER_SIZE;
+    }
+
+    // Scan forward from the read position to find where the valid records end.
+    std::size_t segment = 0;
+    m_write_offset   = m_read_offset;
+    m_write_sequence = m_read_sequence;
+    RecordHeader header;
+    while(valid_record(m_segments[segment].m_data, m_write_offset, m_write_sequence, header)){
+        if(header.m_length != SEGMENT_END){
+            m_write_offset += record_size(header.m_length);
+            m_write_sequence++;
+            continue;
+        }
+        std::uint64_t first_sequence;
+        if(segment + 1 == m_segments.size() || !valid_segment(m_segments[segment + 1].m_data, m_segments[segment + 1].m_index, first_sequence) ||
+           first_sequence != m_write_sequence){
+            break;
+        }
+        segment++;
+        m_write_offset = SEGMENT_HEADER_SIZE;
+    }
+    while(m_segments.size() > segment + 1){
+        Segment unused = m_segments.pop_back();
+        munmap(unused.m_data, m_options.segment_size);
+        retire_segment_file(segment_path(unused.m_index));
+    }
+    // A record torn by the crash may be left after the write position. It would fail the checks anyway, but zeroing its
+    // header keeps a later scan from having to look at it.
+    if(m_write_offset + RECORD_HEADER_SIZE <= m_options.segment_size){
+        std::memset(m_segments.back().m_data + m_write_offset, 0, RECORD_HEADER_SIZE);
+    }
+    m_synced_offset = m_write_offset;
+    write_checkpoint();
+}
+
+inline PersistentQueue::PersistentQueue(const std::string& directory, const PersistentQueueOptions& options)
+    : m_directory(directory), m_options(options), m_page_size(std::size_t(sysconf(_SC_PAGESIZE))), m_next_spare(0),
+      m_checkpoints(nullptr), m_generation(0), m_read_offset(0), m_read_sequence(0), m_write_offset(0),
+      m_write_sequence(0), m_synced_offset(0), m_unsynced_records(0), m_unsynced_bytes(0), m_directory_dirty(false){
+    assert(options.segment_size % m_page_size == 0 && options.segment_size >= 2 * m_page_size &&
+           "PersistentQueue segment_size must be a multiple of the page size and at least two pages");
+    std::filesystem::create_directories(m_directory);
+    std::filesystem::path checkpoint_path = m_directory / "checkpoint";
+    bool resize = !std::filesystem::exists(checkpoint_path) || std::filesystem::file_size(checkpoint_path) < m_page_size;
+    m_checkpoints = reinterpret_cast<Checkpoint*>(map_file(checkpoint_path, m_page_size, resize));
+    recover();
+    commit();
+}
+// A destructor can't report a failed commit, so callers that need to know should call commit() themselves first.
+inline PersistentQueue::~PersistentQueue(){
+    if(m_options.sync_policy != SyncPolicy::NONE){
+        try{
+            commit();
+        }catch(const std::system_error&){
+        }
+    }
+    while(!m_segments.is_empty()){
+        munmap(m_segments.pop_front().m_data, m_options.segment_size);
+    }
+    munmap(m_checkpoints, m_page_size);
+}
+
+inline void PersistentQueue::enqueue(const void* data, std::size_t length){
+    assert(length <= max_record_size() && "Record is too large for a PersistentQueue segment");
+    std::size_t size = record_size(length);
+    if(m_write_offset + size + RECORD_HEADER_SIZE > m_options.segment_size){
+        roll_segment();
+    }
+    char* at = m_segments.back().m_data + m_write_offset;
+    std::memcpy(at + RECORD_HEADER_SIZE, data, length);
+    RecordHeader header = {std::uint32_t(length), record_checksum(std::uint32_t(length), m_write_sequence, at + RECORD_HEADER_SIZE, length),
+                           m_write_sequence};
+    std::memcpy(at, &header, RECORD_HEADER_SIZE);
+    m_write_offset += size;
+    m_write_sequence++;
+
+    m_unsynced_records++;
+    m_unsynced_bytes += size;
+    if(m_options.sync_policy == SyncPolicy::EVERY_WRITE ||
+       (m_options.sync_policy == SyncPolicy::GROUP_COMMIT &&
+        (m_unsynced_records >= m_options.group_commit_records || m_unsynced_bytes >= m_options.group_commit_bytes))){
+        commit();
+    }
+}
+
+inline std::string_view PersistentQueue::peek(){
+    assert(!is_empty() && "Can't peek at an empty PersistentQueue");
+    skip_segment_end();
+    const char* at = m_segments.front().m_data + m_read_offset;
+    std::uint32_t length;
+    std::memcpy(&length, at, sizeof(length));
+    return std::string_view(at + RECORD_HEADER_SIZE, length);
+}
+inline std::string PersistentQueue::dequeue(){
+    assert(!is_empty() && "PersistentQueue underflow would occur with dequeue");
+    std::string record(peek());
+    pop();
+    return record;
+}
+inline void PersistentQueue::pop(){
+    assert(!is_empty() && "PersistentQueue underflow would occur with pop");
+    skip_segment_end();
+    std::uint32_t length;
+    std::memcpy(&length, m_segments.front().m_data + m_read_offset, sizeof(length));
+    m_read_offset += record_size(length);
+    m_read_sequence++;
+    write_checkpoint();
+}
+
+inline void PersistentQueue::commit(){
+    sync_range(m_segments.back().m_data, m_synced_offset, m_write_offset, MS_SYNC);
+    sync_range(reinterpret_cast<char*>(m_checkpoints), 0, m_page_size, MS_SYNC);
+    if(m_directory_dirty){
+        sync_directory();
+    }
+    m_synced_offset    = m_write_offset;
+    m_unsynced_records = 0;
+    m_unsynced_bytes   = 0;
+}
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef PRIORITYQUEUE
+#define PRIORITYQUEUE
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// PriorityQueue is a d-ary heap stored in a std::vector. Like std::priority_queue, top() is the element that compares
+// greatest under Compare, so the default std::less gives a max heap and std::greater gives a min heap.
+//
+// A node's children are at D * i + 1 ... D * i + D. With D = 4 the tree is half as deep as a binary heap, so a push
+// (which walks up the tree) does half the work, and although a pop compares against four children per level instead of
+// two, those four children are adjacent and usually share a cache line. For most element types this makes D = 4
+// faster than D = 2 overall.
+//
+// The vector gets its memory from Allocator, and copies, moves and swaps pass the allocator on as std::vector does.
+template <class T, class Compare = std::less<T>, std::size_t D = 4, class Allocator = std::allocator<T>>
+class PriorityQueue{
+    static_assert(D >= 2, "PriorityQueue needs at least two children per node");
+
+private:
+    std::vector<T, Allocator> m_heap;
+    Compare        m_compare;
+
+    static std::size_t parent(std::size_t i) {return (i - 1) / D;}
+    static std::size_t first_child(std::size_t i) {return D * i + 1;}
+
+    // The sift functions move a "hole" rather than swapping at every level, so each level costs one move instead of
+    // three.
+    void sift_up(std::size_t i){
+        T value = std::move(m_heap[i]);
+        while(i > 0 && m_compare(m_heap[parent(i)], value)){
+            m_heap[i] = std::move(m_heap[parent(i)]);
+            i = parent(i);
+        }
+        m_heap[i] = std::move(value);
+    }
+    void sift_down(std::size_t i){
+        std::size_t size = m_heap.size();
+        T value = std::move(m_heap[i]);
+        while(true){
+            std::size_t child = first_child(i);
+            if(child >= size){
+                break;
+            }
+            std::size_t last = std::min(child + D, size);
+            std::size_t best = child;
+            for(++child; child < last; ++child){
+                if(m_compare(m_heap[best], m_heap[child])){
+                    best = child;
+                }
+            }
+            if(!m_compare(value, m_heap[best])){
+                break;
+            }
+            m_heap[i] = std::move(m_heap[best]);
+            i = best;
+        }
+        m_heap[i] = std::move(value);
+    }
+    // Floyd's bottom up construction: sift down every internal node from the last one to the root. This is O(n)
+    // rather than the O(n log n) of pushing the elements one at a time.
+    void heapify(){
+        if(m_heap.size() < 2){
+            return;
+        }
+        for(std::size_t i = parent(m_heap.size() - 1) + 1; i-- > 0;){
+            sift_down(i);
+        }
+    }
+
+public:
+    PriorityQueue() = default;
+    explicit PriorityQueue(const Compare& compare, const Allocator& allocator = Allocator())
+        : m_heap(allocator), m_compare(compare){};
+    explicit PriorityQueue(const Allocator& allocator) : m_heap(allocator){};
+    template <class Iterator>
+    PriorityQueue(Iterator first, Iterator last, const Compare& compare = Compare(), const Allocator& allocator = Allocator())
+        : m_heap(first, last, allocator), m_compare(compare){
+        heapify();
+    }
+    explicit PriorityQueue(std::vector<T, Allocator> values, const Compare& compare = Compare())
+        : m_heap(std::move(values)), m_compare(compare){
+        heapify();
+    }
+
+    void push(const T& value){
+        m_heap.push_back(value);
+        sift_up(m_heap.size() - 1);
+    }
+    void push(T&& value){
+        m_heap.push_back(std::move(value));
+        sift_up(m_heap.size() - 1);
+    }
+    template <class... Args>
+    void emplace(Args&&... args){
+        m_heap.emplace_back(std::forward<Args>(args)...);
+        sift_up(m_heap.size() - 1);
+    }
+
+    // push_bulk adds count values. When the batch is at least as large as the heap it is cheaper to append everything
+    // and rebuild the heap in O(n) than to sift each new value up in O(log n).
+    void push_bulk(const T* values, std::size_t count){
+        std::size_t old_size = m_heap.size();
+        m_heap.insert(m_heap.end(), values, values + count);
+        if(count >= old_size){
+            heapify();
+        }else{
+            for(std::size_t i = old_size; i < m_heap.size(); ++i){
+                sift_up(i);
+            }
+        }
+    }
+
+    const T& top() const{
+        assert(!m_heap.empty() && "Can't read the top of an empty PriorityQueue");
+        return m_heap.front();
+    }
+    T pop(){
+        assert(!m_heap.empty() && "PriorityQueue underflow would occur with pop");
+        T top = std::move(m_heap.front());
+        if(m_heap.size() > 1){
+            m_heap.front() = std::move(m_heap.back());
+            m_heap.pop_back();
+            sift_down(0);
+        }else{
+            m_heap.pop_back();
+        }
+        return top;
+    }
+
+    void reserve(std::size_t capacity) {m_heap.reserve(capacity);}
+    void clear() {m_heap.clear();}
+    bool is_empty() const {return m_heap.empty();}
+    std::size_t size() const {return m_heap.size();}
+    Allocator get_allocator() const {return m_heap.get_allocator();}
+};
+
+
+// AddressablePriorityQueue is a d-ary heap where push returns a Handle that stays valid while the element is in the
+// queue, so that an element's priority can be changed in place. This is what Dijkstra's algorithm and most schedulers
+// need: rather than pushing a duplicate entry when a key improves, the existing entry is moved up the heap.
+//
+// Heap entries carry their handle, and m_positions maps a handle to its entry's current index in the heap, updated every
+// time an entry moves. Handles of popped elements are recycled.
+//
+// All three vectors get their memory from Allocator, rebound to what each one holds.
+template <class T, class Compare = std::less<T>, std::size_t D = 4, class Allocator = std::allocator<T>>
+class AddressablePriorityQueue{
+    static_assert(D >= 2, "AddressablePriorityQueue needs at least two children per node");
+
+public:
+    typedef std::uint32_t Handle;
+
+private:
+    static constexpr std::size_t NOT_IN_HEAP = SIZE_MAX;
+
+    struct Entry{
+        T      m_value;
+        Handle m_handle;
+    };
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Entry>       EntryAllocator;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t> PositionAllocator;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Handle>      HandleAllocator;
+
+    std::vector<Entry, EntryAllocator>          m_heap;
+    std::vector<std::size_t, PositionAllocator> m_positions;    // Indexed by handle.
+    std::vector<Handle, HandleAllocator>        m_free;
+    Compare                                     m_compare;
+
+    static std::size_t parent(std::size_t i) {return (i - 1) / D;}
+    static std::size_t first_child(std::size_t i) {return D * i + 1;}
+
+    void place(std::size_t i, Entry&& entry){
+        m_positions[entry.m_handle] = i;
+        m_heap[i] = std::move(entry);
+    }
+    void sift_up(std::size_t i){
+        Entry entry = std::move(m_heap[i]);
+        while(i > 0 && m_compare(m_heap[parent(i)].m_value, entry.m_value)){
+            place(i, std::move(m_heap[parent(i)]));
+            i = parent(i);
+        }
+        place(i, std::move(entry));
+    }
+    void sift_down(std::size_t i){
+        std::size_t size = m_heap.size();
+        Entry entry = std::move(m_heap[i]);
+        while(true){
+            std::size_t child = first_child(i);
+            if(child >= size){
+                break;
+            }
+            std::size_t last = std::min(child + D, size);
+            std::size_t best = child;
+            for(++child; child < last; ++child){
+                if(m_compare(m_heap[best].m_value, m_heap[child].m_value)){
+                    best = child;
+                }
+            }
+            if(!m_compare(entry.m_value, m_heap[best].m_value)){
+                break;
+            }
+            place(i, std::move(m_heap[best]));
+            i = best;
+        }
+        place(i, std::move(entry));
+    }
+
+    Handle new_handle(){
+        if(!m_free.empty()){
+            Handle handle = m_free.back();
+            m_free.pop_back();
+            return handle;
+        }
+        m_positions.push_back(NOT_IN_HEAP);
+        return Handle(m_positions.size() - 1);
+    }
+
+public:
+    AddressablePriorityQueue() = default;
+    explicit AddressablePriorityQueue(const Compare& compare, const Allocator& allocator = Allocator())
+        : m_heap(EntryAllocator(allocator)), m_positions(PositionAllocator(allocator)), m_free(HandleAllocator(allocator)),
+          m_compare(compare){};
+    explicit AddressablePriorityQueue(const Allocator& allocator) : AddressablePriorityQueue(Compare(), allocator){};
+
+    Handle push(const T& value){
+        Handle handle = new_handle();
+        m_heap.push_back(Entry{value, handle});
+        sift_up(m_heap.size() - 1);
+        return handle;
+    }
+
+    bool contains(Handle handle) const{
+        return handle < m_positions.size() && m_positions[handle] != NOT_IN_HEAP;
+    }
+    const T& value(Handle handle) const{
+        assert(contains(handle) && "Handle does not refer to an element in the AddressablePriorityQueue");
+        return m_heap[m_positions[handle]].m_value;
+    }
+
+    // decrease_key gives an element a new value that is at least as high priority as its old one (for a min heap built
+    // with std::greater that means a smaller or equal value), and moves it up the heap to match.
+    void decrease_key(Handle handle, const T& value){
+        assert(contains(handle) && "Handle does not refer to an element in the AddressablePriorityQueue");
+        std::size_t i = m_positions[handle];
+        assert(!m_compare(value, m_heap[i].m_value) && "decrease_key cannot lower an element's priority");
+        m_heap[i].m_value = value;
+        sift_up(i);
+    }
+    // update gives an element any new value, moving it up or down the heap as needed.
+    void update(Handle handle, const T& value){
+        assert(contains(handle) && "Handle does not refer to an element in the AddressablePriorityQueue");
+        std::size_t i = m_positions[handle];
+        bool raised = m_compare(m_heap[i].m_value, value);
+        m_heap[i].m_value = value;
+        if(raised){
+            sift_up(i);
+        }else{
+            sift_down(i);
+        }
+    }
+
+    const T& top() const{
+        assert(!m_heap.empty() && "Can't read the top of an empty AddressablePriorityQueue");
+        return m_heap.front().m_value;
+    }
+    Handle top_handle() const{
+        assert(!m_heap.empty() && "Can't read the top of an empty AddressablePriorityQueue");
+        return m_heap.front().m_handle;
+    }
+    T pop(){
+        assert(!m_heap.empty() && "AddressablePriorityQueue underflow would occur with pop");
+        Entry top = std::move(m_heap.front());
+        m_positions[top.m_handle] = NOT_IN_HEAP;
+        m_free.push_back(top.m_handle);
+        if(m_heap.size() > 1){
+            m_heap.front() = std::move(m_heap.back());
+            m_heap.pop_back();
+            sift_down(0);
+        }else{
+            m_heap.pop_back();
+        }
+        return std::move(top.m_value);
+    }
+
+    void reserve(std::size_t capacity){
+        m_heap.reserve(capacity);
+        m_positions.reserve(capacity);
+    }
+    bool is_empty() const {return m_heap.empty();}
+    std::size_t size() const {return m_heap.size();}
+    Allocator get_allocator() const {return Allocator(m_heap.get_allocator());}
+};
+
+#endif
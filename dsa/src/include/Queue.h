@@ -1,68 +1,304 @@
 #ifndef QUEUE
 #define QUEUE
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
-#define MAX_SIZE 100
+#include "AllocatorHolder.h"
+
+// Queue is a FIFO stored as a circular buffer of T held by value. The capacity is always a power of two so that
+// wrapping an index around the end of the buffer is a mask rather than a branch or a modulo, and the buffer doubles
+// when it fills up. Elements never move while they are in the queue except when the buffer grows, so there is no
+// compaction step and both enqueue and dequeue are O(1) (amortised for enqueue).
+//
+// The buffer comes from Allocator. The queue keeps its own copy of it, which costs no space when it is stateless, and
+// passes it on when copied, assigned or swapped as allocator_traits says, so std::pmr::polymorphic_allocator works as
+// well as std::allocator or SizeClassAllocator.
+template <class T, class Allocator = std::allocator<T>>
+class Queue : private AllocatorHolder<Allocator>{
+    static_assert(std::is_same<typename Allocator::value_type, T>::value, "Queue Allocator must allocate T");
 
-class Queue{
 private:
-    ptrdiff_t* m_arr[MAX_SIZE];
-    ptrdiff_t m_front;
-    ptrdiff_t m_back;
-    int m_size(){
-        return m_back - m_front;
-    };
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+    T*          m_arr;
+    std::size_t m_capacity;
+    std::size_t m_front;        // Index of the front element.
+    std::size_t m_size;
+
+    std::size_t mask() const {return m_capacity - 1;}
+    std::size_t slot(std::size_t offset) const {return (m_front + offset) & mask();}
+
+    T* allocate(std::size_t capacity){
+        return capacity ? this->allocator().allocate(capacity) : nullptr;
+    }
+    void deallocate(T* arr, std::size_t capacity){
+        if(arr != nullptr){
+            this->allocator().deallocate(arr, capacity);
+        }
+    }
+    // Frees the buffer. The queue must be empty.
+    void release(){
+        deallocate(m_arr, m_capacity);
+        m_arr      = nullptr;
+        m_capacity = 0;
+    }
+    // Takes other's buffer, leaving other empty. This queue must have no buffer.
+    void steal(Queue& other) noexcept;
+    // Copies other's elements into the front of the buffer. This queue must be empty, with room for all of them.
+    void copy_elements(const Queue& other);
+
+    std::size_t grown_capacity(std::size_t count) const{
+        std::size_t capacity = std::max(m_capacity, MIN_CAPACITY);
+        while(capacity < m_size + count){
+            capacity *= 2;
+        }
+        return capacity;
+    }
+    // Moves the elements into arr, a new buffer of the given capacity, unwrapping them so the front is at index 0, and
+    // frees the old buffer.
+    void relocate(T* arr, std::size_t capacity);
+    void grow_for(std::size_t count){
+        if(m_size + count > m_capacity){
+            std::size_t capacity = grown_capacity(count);
+            relocate(allocate(capacity), capacity);
+        }
+    }
 
 public:
-    // We initialise the top to -1 since that will be above the first element on the stack.
-    // This allows us to check if the stack is empty.
-    Queue() :  m_front(-1), m_back(-1){};
-
-    template <typename TYPE>
-    void enqueue(TYPE &value);
-    auto dequeue();
-
-    auto peek();
-
-    bool is_empty(){
-        return m_size();
-    };
-    bool is_full(){
-        return m_size() == MAX_SIZE;
-    };
+    Queue() : Queue(Allocator()){};
+    explicit Queue(const Allocator& allocator)
+        : AllocatorHolder<Allocator>(allocator), m_arr(nullptr), m_capacity(0), m_front(0), m_size(0){};
+    Queue(const Queue& other);
+    Queue(Queue&& other) noexcept;
+    Queue& operator=(const Queue& other);
+    Queue& operator=(Queue&& other) noexcept(move_assignment_steals<Allocator>);
+    ~Queue();
+
+    void swap(Queue& other) noexcept{
+        assert(can_swap_storage(this->allocator(), other.allocator()) && "Can't swap Queues with unequal allocators");
+        using std::swap;
+        swap_allocators(this->allocator(), other.allocator());
+        swap(m_arr, other.m_arr);
+        swap(m_capacity, other.m_capacity);
+        swap(m_front, other.m_front);
+        swap(m_size, other.m_size);
+    }
+    Allocator get_allocator() const {return this->allocator();}
+
+    void enqueue(const T& value){emplace(value);}
+    void enqueue(T&& value){emplace(std::move(value));}
+    template <class... Args>
+    T& emplace(Args&&... args);
+    T dequeue();
+
+    // enqueue_bulk copies count values onto the back of the queue. dequeue_bulk moves up to count values off the front
+    // of the queue into out and returns how many it moved. Both work on at most two contiguous runs of the buffer
+    // (before and after the wrap point) rather than element by element.
+    void enqueue_bulk(const T* values, std::size_t count);
+    std::size_t dequeue_bulk(T* out, std::size_t count);
+
+    T& peek(){
+        assert(m_size > 0 && "Can't peek at an empty Queue");
+        return m_arr[m_front];
+    }
+    const T& peek() const{
+        assert(m_size > 0 && "Can't peek at an empty Queue");
+        return m_arr[m_front];
+    }
+
+    void reserve(std::size_t capacity){
+        grow_for(capacity > m_size ? capacity - m_size : 0);
+    }
+    void clear();
+
+    bool is_empty() const {return m_size == 0;}
+    std::size_t size() const {return m_size;}
+    std::size_t capacity() const {return m_capacity;}
 };
 
-template <typename TYPE>
-void Queue::enqueue(TYPE &value){
-    if(m_size() < MAX_SIZE && m_back == MAX_SIZE - 1){
-        ptrdiff_t* tmp_arr[MAX_SIZE];
-        ptrdiff_t size = m_size();
-        for(ptrdiff_t i = 0; i < size; ++i){
-            tmp_arr[i] = m_arr[m_front + 1 + i];
+template <class T, class Allocator>
+void Queue<T, Allocator>::relocate(T* arr, std::size_t capacity){
+    if(std::is_trivially_copyable<T>::value){
+        std::size_t first = std::min(m_size, m_capacity - m_front);
+        if(first){
+            std::memcpy(static_cast<void*>(arr), m_arr + m_front, first * sizeof(T));
+        }
+        if(m_size - first){
+            std::memcpy(static_cast<void*>(arr + first), m_arr, (m_size - first) * sizeof(T));
+        }
+    }else{
+        for(std::size_t i = 0; i < m_size; ++i){
+            T& element = m_arr[slot(i)];
+            ::new (static_cast<void*>(arr + i)) T(std::move_if_noexcept(element));
+            element.~T();
         }
-        m_front = -1;
-        m_back  = size - 1;
-        m_arr = tmp_arr;
     }
+    deallocate(m_arr, m_capacity);
+    m_arr      = arr;
+    m_capacity = capacity;
+    m_front    = 0;
+}
+
+template <class T, class Allocator>
+void Queue<T, Allocator>::steal(Queue& other) noexcept{
+    m_arr      = other.m_arr;
+    m_capacity = other.m_capacity;
+    m_front    = other.m_front;
+    m_size     = other.m_size;
+    other.m_arr      = nullptr;
+    other.m_capacity = 0;
+    other.m_front    = 0;
+    other.m_size     = 0;
+}
+template <class T, class Allocator>
+void Queue<T, Allocator>::copy_elements(const Queue& other){
+    for(std::size_t i = 0; i < other.m_size; ++i){
+        ::new (static_cast<void*>(m_arr + i)) T(other.m_arr[other.slot(i)]);
+        m_size++;
+    }
+}
+
+template <class T, class Allocator>
+Queue<T, Allocator>::Queue(const Queue& other) : Queue(select_copy_allocator(other.allocator())){
+    m_arr      = allocate(other.m_capacity);
+    m_capacity = other.m_capacity;
+    copy_elements(other);
+}
+template <class T, class Allocator>
+Queue<T, Allocator>::Queue(Queue&& other) noexcept : Queue(other.allocator()){
+    steal(other);
+}
+template <class T, class Allocator>
+Queue<T, Allocator>& Queue<T, Allocator>::operator=(const Queue& other){
+    if(this != &other){
+        clear();
+        if(std::allocator_traits<Allocator>::propagate_on_container_copy_assignment::value
+           && !(this->allocator() == other.allocator())){
+            // The buffer has to go back to the allocator that gave it out before that allocator is replaced.
+            release();
+            copy_assign_allocator(this->allocator(), other.allocator());
+        }
+        grow_for(other.m_size);
+        copy_elements(other);
+    }
+    return *this;
+}
+template <class T, class Allocator>
+Queue<T, Allocator>& Queue<T, Allocator>::operator=(Queue&& other) noexcept(move_assignment_steals<Allocator>){
+    if(this != &other){
+        clear();
+        if(can_steal_storage(this->allocator(), other.allocator())){
+            release();
+            move_assign_allocator(this->allocator(), other.allocator());
+            steal(other);
+        }else{
+            // other's buffer belongs to a different allocator, which stays with other, so the elements move over one by
+            // one into this queue's own memory.
+            grow_for(other.m_size);
+            for(std::size_t i = 0; i < other.m_size; ++i){
+                ::new (static_cast<void*>(m_arr + i)) T(std::move(other.m_arr[other.slot(i)]));
+                m_size++;
+            }
+            other.clear();
+        }
+    }
+    return *this;
+}
+template <class T, class Allocator>
+Queue<T, Allocator>::~Queue(){
+    clear();
+    deallocate(m_arr, m_capacity);
+}
 
-    assert(m_back < MAX_SIZE - 1 && "Queue overflow would occur with enqueue");
-    TYPE *store_value = new TYPE(value);
-    m_arr[m_back + 1] = store_value;
-    m_back++;
+template <class T, class Allocator>
+template <class... Args>
+T& Queue<T, Allocator>::emplace(Args&&... args){
+    if(m_size < m_capacity){
+        T* back = m_arr + slot(m_size);
+        ::new (static_cast<void*>(back)) T(std::forward<Args>(args)...);
+        m_size++;
+        return *back;
+    }
+    // args may refer to an element of this queue, as in q.enqueue(q.peek()), so the new element is built in the new
+    // buffer before the old elements are moved out and their buffer freed.
+    std::size_t capacity = grown_capacity(1);
+    T* arr = allocate(capacity);
+    try{
+        ::new (static_cast<void*>(arr + m_size)) T(std::forward<Args>(args)...);
+    }catch(...){
+        deallocate(arr, capacity);
+        throw;
+    }
+    relocate(arr, capacity);
+    return m_arr[m_size++];
 }
-auto Queue::dequeue(){
-    assert(m_size() > 0 && "Queue underflow would occur with dequeue");
-    auto tmp = *m_arr[m_front + 1];
-    delete m_arr[m_front + 1];
-    m_front++;
+template <class T, class Allocator>
+T Queue<T, Allocator>::dequeue(){
+    assert(m_size > 0 && "Queue underflow would occur with dequeue");
+    T& front = m_arr[m_front];
+    T tmp(std::move(front));
+    front.~T();
+    m_front = (m_front + 1) & mask();
+    m_size--;
     return tmp;
 }
 
-auto Queue::peek(){
-    assert(m_back > - 1 && "Can't peek at an empty Queue");
-    return *m_arr[m_front + 1];
+template <class T, class Allocator>
+void Queue<T, Allocator>::enqueue_bulk(const T* values, std::size_t count){
+    if(m_size + count > m_capacity){
+        // As in emplace, values may point into this queue, so they are copied into the new buffer before the old one
+        // is freed.
+        std::size_t capacity = grown_capacity(count);
+        T* arr = allocate(capacity);
+        try{
+            std::uninitialized_copy(values, values + count, arr + m_size);
+        }catch(...){
+            deallocate(arr, capacity);
+            throw;
+        }
+        relocate(arr, capacity);
+        m_size += count;
+        return;
+    }
+    std::size_t back  = slot(m_size);
+    std::size_t first = std::min(count, m_capacity - back);
+    std::uninitialized_copy(values, values + first, m_arr + back);
+    try{
+        std::uninitialized_copy(values + first, values + count, m_arr);
+    }catch(...){
+        // m_size doesn't cover the first run yet, so it has to be destroyed here.
+        std::destroy(m_arr + back, m_arr + back + first);
+        throw;
+    }
+    m_size += count;
+}
+template <class T, class Allocator>
+std::size_t Queue<T, Allocator>::dequeue_bulk(T* out, std::size_t count){
+    count = std::min(count, m_size);
+    std::size_t first = std::min(count, m_capacity - m_front);
+    std::move(m_arr + m_front, m_arr + m_front + first, out);
+    std::destroy(m_arr + m_front, m_arr + m_front + first);
+    std::move(m_arr, m_arr + (count - first), out + first);
+    std::destroy(m_arr, m_arr + (count - first));
+    m_front = count ? (m_front + count) & mask() : m_front;
+    m_size -= count;
+    return count;
+}
+
+template <class T, class Allocator>
+void Queue<T, Allocator>::clear(){
+    for(std::size_t i = 0; i < m_size; ++i){
+        m_arr[slot(i)].~T();
+    }
+    m_front = 0;
+    m_size  = 0;
 }
 
 
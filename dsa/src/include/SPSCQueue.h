@@ -0,0 +1,163 @@
+#ifndef SPSCQUEUE
+#define SPSCQUEUE
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "Concurrency.h"
+
+// SPSCQueue is a bounded FIFO for handing items from exactly one producer thread to exactly one consumer thread. It is
+// the same power of two ring as Queue, but the front and back are atomics owned by one side each, which makes every
+// operation wait free: a push or pop either completes in a fixed number of steps or reports that the queue is full or
+// empty.
+//
+// m_head and m_tail are free running counters (they are masked to get a slot but never wrapped themselves), so the
+// number of elements is always m_tail - m_head. The producer only writes m_tail and the consumer only writes m_head, and
+// the only ordering needed is release on the publishing store and acquire on the load that observes it. No read-modify-
+// write instructions are used at all.
+//
+// Each side also keeps a cached copy of the other side's index. The producer only reloads m_head when its cached copy
+// says the queue is full, and the consumer only reloads m_tail when its copy says the queue is empty, so in the steady
+// state each side mostly touches its own cache line. Producer and consumer fields live on separate cache lines.
+//
+// The buffer comes from Allocator. Only the constructor and destructor use it, so it needn't be thread safe, and it
+// sits on the read only cache line next to m_arr, where it takes no extra space.
+template <class T, class Allocator = std::allocator<T>>
+class SPSCQueue{
+private:
+    // Consumer side.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_head;
+    std::size_t m_cached_tail;
+
+    // Producer side.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail;
+    std::size_t m_cached_head;
+
+    // Read only after construction.
+    alignas(CACHE_LINE_SIZE) T* m_arr;
+    std::size_t m_capacity;
+    Allocator   m_allocator;
+
+    std::size_t mask() const {return m_capacity - 1;}
+
+    // Returns how many slots the producer can fill, reloading m_head only if the cached copy shows fewer than wanted.
+    std::size_t free_slots(std::size_t tail, std::size_t wanted){
+        std::size_t available = m_capacity - (tail - m_cached_head);
+        if(available < wanted){
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            available = m_capacity - (tail - m_cached_head);
+        }
+        return available;
+    }
+    // Returns how many elements the consumer can take, reloading m_tail only if the cached copy shows fewer than wanted.
+    std::size_t ready_slots(std::size_t head, std::size_t wanted){
+        std::size_t available = m_cached_tail - head;
+        if(available < wanted){
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            available = m_cached_tail - head;
+        }
+        return available;
+    }
+
+public:
+    // capacity is rounded up to a power of two.
+    explicit SPSCQueue(std::size_t capacity, const Allocator& allocator = Allocator())
+        : m_head(0), m_cached_tail(0), m_tail(0), m_cached_head(0), m_capacity(1), m_allocator(allocator){
+        assert(capacity > 0 && "SPSCQueue must be created with a capacity of at least one");
+        while(m_capacity < capacity){
+            m_capacity *= 2;
+        }
+        m_arr = m_allocator.allocate(m_capacity);
+    }
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+    ~SPSCQueue(){
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        for(std::size_t i = m_head.load(std::memory_order_relaxed); i != tail; ++i){
+            m_arr[i & mask()].~T();
+        }
+        m_allocator.deallocate(m_arr, m_capacity);
+    }
+
+    // Producer side. The try_ functions return false if the queue is full.
+    template <class... Args>
+    bool try_emplace(Args&&... args){
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if(free_slots(tail, 1) == 0){
+            return false;
+        }
+        ::new (static_cast<void*>(m_arr + (tail & mask()))) T(std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    bool try_push(const T& value){return try_emplace(value);}
+    bool try_push(T&& value){return try_emplace(std::move(value));}
+
+    // push_bulk copies as many of the count values as fit and publishes them all with a single store, so the consumer
+    // sees them together and the producer's cache line is written once per batch rather than once per element. Returns
+    // the number of values pushed.
+    std::size_t push_bulk(const T* values, std::size_t count){
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        count = std::min(count, free_slots(tail, count));
+        for(std::size_t i = 0; i < count; ++i){
+            ::new (static_cast<void*>(m_arr + ((tail + i) & mask()))) T(values[i]);
+        }
+        if(count){
+            m_tail.store(tail + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Consumer side. try_pop returns false if the queue is empty.
+    bool try_pop(T& out){
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if(ready_slots(head, 1) == 0){
+            return false;
+        }
+        T& front = m_arr[head & mask()];
+        out = std::move(front);
+        front.~T();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // pop_bulk moves up to count elements into out and releases their slots back to the producer with a single store.
+    // Returns the number of elements popped.
+    std::size_t pop_bulk(T* out, std::size_t count){
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        count = std::min(count, ready_slots(head, count));
+        for(std::size_t i = 0; i < count; ++i){
+            T& element = m_arr[(head + i) & mask()];
+            out[i] = std::move(element);
+            element.~T();
+        }
+        if(count){
+            m_head.store(head + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // front returns the element at the front of the queue without removing it, or nullptr if the queue is empty.
+    // Only the consumer may call it.
+    T* front(){
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        return ready_slots(head, 1) ? &m_arr[head & mask()] : nullptr;
+    }
+
+    // size is only a snapshot when called while the other side is running.
+    std::size_t size() const{
+        // Loading m_head first means m_tail can only have moved further ahead, so the difference can't underflow.
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        return m_tail.load(std::memory_order_acquire) - head;
+    }
+    bool is_empty() const {return size() == 0;}
+    std::size_t capacity() const {return m_capacity;}
+    Allocator get_allocator() const {return m_allocator;}
+};
+
+#endif
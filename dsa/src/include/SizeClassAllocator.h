@@ -0,0 +1,289 @@
+#ifndef SIZECLASSALLOCATOR
+#define SIZECLASSALLOCATOR
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// SizeClassPool is a small object allocator in the style of tcmalloc: requests up to MAX_SIZE bytes are rounded up to
+// one of a fixed set of size classes, and each class keeps its free objects on singly linked free lists threaded
+// through the objects themselves.
+//
+//  - Every thread has its own cache of free lists, one per class, so the common case of allocate and deallocate is a
+//    pop or push on a thread local list with no atomic operations and no lock.
+//  - When a thread's list runs dry it takes a whole batch of objects from the class's central transfer list, and when
+//    its list grows past two batches it hands one batch back. A batch moves as a single linked list, so the central lock
+//    is taken once per batch rather than once per object, and memory freed on one thread (a consumer) flows back to the
+//    threads that allocate (the producers).
+//  - When the central list is empty too, a new chunk of memory is carved into batches.
+//
+// The size classes are 16 byte steps up to 256 bytes and then eight classes per power of two: 32 byte steps up to 512,
+// 64 up to 1KB, 128 up to 2KB and 256 up to 4KB. A step past 256 is an eighth of the power of two below the request, so
+// rounding loses less than 1/8 of the requested size (the worst case is a request one byte past a power of two, as 2049
+// rounding to 2304), and every object is 16 byte aligned. Chunks are never returned to the system: like malloc's arenas
+// the pool stays at its high water mark, which is what a long running process with a steady allocation pattern wants.
+class SizeClassPool{
+public:
+    static constexpr std::size_t MAX_SIZE    = 4096;
+    static constexpr std::size_t ALIGNMENT   = 16;
+    static constexpr std::size_t NUM_CLASSES = 16 + 4 * 8;
+
+    static std::size_t class_of(std::size_t size){
+        assert(size <= MAX_SIZE && "SizeClassPool request is larger than MAX_SIZE");
+        if(size <= 256){
+            return size <= 16 ? 0 : (size - 1) / 16;
+        }
+        // size - 1 is in [2^power, 2^(power + 1)), whose eight classes are 2^(power - 3) bytes apart.
+        int power = 63 - __builtin_clzll(size - 1);
+        return 16 + std::size_t(power - 8) * 8 + ((size - 1) >> (power - 3)) - 8;
+    }
+    static std::size_t class_size(std::size_t size_class){
+        if(size_class < 16){
+            return (size_class + 1) * 16;
+        }
+        std::size_t base = std::size_t(256) << ((size_class - 16) / 8);
+        return base + ((size_class - 16) % 8 + 1) * (base / 8);
+    }
+    // The number of objects moved between a thread cache and the central list at once: about 8KB worth, but at least 8
+    // and at most 64 objects.
+    static std::size_t batch_size(std::size_t size_class){
+        std::size_t count = 8192 / class_size(size_class);
+        return count < 8 ? 8 : count > 64 ? 64 : count;
+    }
+
+private:
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    struct FreeObject{
+        FreeObject* m_next;
+    };
+    struct FreeList{
+        FreeObject* m_head  = nullptr;
+        std::size_t m_count = 0;
+    };
+    struct Central{
+        std::mutex               m_mutex;
+        std::vector<FreeObject*> m_batches;     // Each one a list of exactly batch_size objects.
+        std::vector<FreeObject*> m_partial;     // Single objects given back by exiting threads.
+    };
+    struct ThreadCache{
+        FreeList m_lists[NUM_CLASSES];
+
+        ~ThreadCache();
+    };
+
+    Central m_central[NUM_CLASSES];
+
+    SizeClassPool() = default;
+
+    // The calling thread's cache, or nullptr while its thread locals are being destroyed, when deallocations go straight
+    // to the central lists.
+    static ThreadCache* thread_cache(){
+        struct Owner{
+            ThreadCache  m_cache;
+            ThreadCache*& m_pointer;
+
+            explicit Owner(ThreadCache*& pointer) : m_pointer(pointer) {m_pointer = &m_cache;}
+            ~Owner() {m_pointer = nullptr;}
+        };
+        thread_local ThreadCache* pointer = nullptr;
+        thread_local bool created = false;
+        if(!created){
+            created = true;
+            thread_local Owner owner(pointer);
+        }
+        return pointer;
+    }
+
+    FreeObject* take_batch(std::size_t size_class);
+    void give_batch(std::size_t size_class, FreeObject* batch);
+    // Gives back a list of objects that isn't a whole batch, which can't go on the central list as it is. The objects
+    // wait on the class's partial list until there are enough of them to make up a batch. This only happens when a
+    // thread exits, so it is kept simple rather than fast.
+    void give_batch_unsized(std::size_t size_class, FreeObject* objects);
+    // Removes a batch from the front of list and returns it.
+    static FreeObject* split_batch(FreeList& list, std::size_t count){
+        FreeObject* batch = list.m_head;
+        FreeObject* last  = batch;
+        for(std::size_t i = 1; i < count; ++i){
+            last = last->m_next;
+        }
+        list.m_head = last->m_next;
+        last->m_next = nullptr;
+        list.m_count -= count;
+        return batch;
+    }
+
+public:
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    // The pool lives for the whole program. It is never destroyed, so that threads (and thread locals) that outlive
+    // static destruction can still free into it.
+    static SizeClassPool& instance(){
+        static SizeClassPool* pool = new SizeClassPool();
+        return *pool;
+    }
+
+    void* allocate(std::size_t size){
+        std::size_t size_class = class_of(size);
+        ThreadCache* cache = thread_cache();
+        if(cache == nullptr){
+            // Only reachable from thread local destructors; take a whole batch and give back the rest.
+            FreeObject* batch = take_batch(size_class);
+            if(batch->m_next != nullptr){
+                give_batch_unsized(size_class, batch->m_next);
+            }
+            return batch;
+        }
+        FreeList& list = cache->m_lists[size_class];
+        if(list.m_head == nullptr){
+            list.m_head  = take_batch(size_class);
+            list.m_count = batch_size(size_class);
+        }
+        FreeObject* object = list.m_head;
+        list.m_head = object->m_next;
+        list.m_count--;
+        return object;
+    }
+    void deallocate(void* ptr, std::size_t size){
+        std::size_t size_class = class_of(size);
+        FreeObject* object = static_cast<FreeObject*>(ptr);
+        ThreadCache* cache = thread_cache();
+        if(cache == nullptr){
+            object->m_next = nullptr;
+            give_batch_unsized(size_class, object);
+            return;
+        }
+        FreeList& list = cache->m_lists[size_class];
+        object->m_next = list.m_head;
+        list.m_head = object;
+        if(++list.m_count >= 2 * batch_size(size_class)){
+            give_batch(size_class, split_batch(list, batch_size(size_class)));
+        }
+    }
+};
+
+inline SizeClassPool::ThreadCache::~ThreadCache(){
+    SizeClassPool& pool = instance();
+    for(std::size_t size_class = 0; size_class < NUM_CLASSES; ++size_class){
+        FreeList& list = m_lists[size_class];
+        std::size_t batch = batch_size(size_class);
+        while(list.m_count >= batch){
+            pool.give_batch(size_class, split_batch(list, batch));
+        }
+        if(list.m_head != nullptr){
+            pool.give_batch_unsized(size_class, list.m_head);
+        }
+        list = FreeList();
+    }
+}
+
+inline SizeClassPool::FreeObject* SizeClassPool::take_batch(std::size_t size_class){
+    Central& central = m_central[size_class];
+    {
+        std::lock_guard<std::mutex> lock(central.m_mutex);
+        if(!central.m_batches.empty()){
+            FreeObject* batch = central.m_batches.back();
+            central.m_batches.pop_back();
+            return batch;
+        }
+    }
+    // Carve a new chunk into batches outside the lock, keep the first and publish the rest.
+    std::size_t size  = class_size(size_class);
+    std::size_t batch = batch_size(size_class);
+    std::size_t batches = CHUNK_SIZE / (size * batch);
+    batches = batches ? batches : 1;
+    unsigned char* chunk = static_cast<unsigned char*>(std::malloc(batches * batch * size));
+    if(chunk == nullptr){
+        throw std::bad_alloc();
+    }
+    std::vector<FreeObject*> carved(batches);
+    for(std::size_t b = 0; b < batches; ++b){
+        unsigned char* first = chunk + b * batch * size;
+        for(std::size_t i = 0; i < batch; ++i){
+            reinterpret_cast<FreeObject*>(first + i * size)->m_next = i + 1 < batch ? reinterpret_cast<FreeObject*>(first + (i + 1) * size) : nullptr;
+        }
+        carved[b] = reinterpret_cast<FreeObject*>(first);
+    }
+    if(batches > 1){
+        std::lock_guard<std::mutex> lock(central.m_mutex);
+        central.m_batches.insert(central.m_batches.end(), carved.begin() + 1, carved.end());
+    }
+    return carved[0];
+}
+
+inline void SizeClassPool::give_batch(std::size_t size_class, FreeObject* batch){
+    Central& central = m_central[size_class];
+    std::lock_guard<std::mutex> lock(central.m_mutex);
+    central.m_batches.push_back(batch);
+}
+
+inline void SizeClassPool::give_batch_unsized(std::size_t size_class, FreeObject* objects){
+    Central& central = m_central[size_class];
+    std::lock_guard<std::mutex> lock(central.m_mutex);
+    std::vector<FreeObject*>& partial = central.m_partial;
+    for(FreeObject* object = objects; object != nullptr;){
+        FreeObject* next = object->m_next;
+        partial.push_back(object);
+        object = next;
+    }
+    std::size_t batch = batch_size(size_class);
+    while(partial.size() >= batch){
+        for(std::size_t i = partial.size() - batch; i + 1 < partial.size(); ++i){
+            partial[i]->m_next = partial[i + 1];
+        }
+        partial.back()->m_next = nullptr;
+        central.m_batches.push_back(partial[partial.size() - batch]);
+        partial.resize(partial.size() - batch);
+    }
+}
+
+
+// SizeClassAllocator is a standard allocator backed by SizeClassPool, for use as the Allocator parameter of the dsa
+// containers (or std ones). Requests larger than SizeClassPool::MAX_SIZE, or for types aligned beyond 16 bytes, go to
+// operator new. It is stateless: every instance can free what any other allocated.
+template <class T>
+class SizeClassAllocator{
+public:
+    typedef T value_type;
+
+    SizeClassAllocator() noexcept{};
+    template <class U>
+    SizeClassAllocator(const SizeClassAllocator<U>&) noexcept{};
+
+    T* allocate(std::size_t count){
+        if(count > SIZE_MAX / sizeof(T)){
+            throw std::bad_array_new_length();
+        }
+        std::size_t size = count * sizeof(T);
+        if(alignof(T) > SizeClassPool::ALIGNMENT){
+            return static_cast<T*>(::operator new(size, std::align_val_t(alignof(T))));
+        }
+        if(size <= SizeClassPool::MAX_SIZE){
+            return static_cast<T*>(SizeClassPool::instance().allocate(size));
+        }
+        return static_cast<T*>(::operator new(size));
+    }
+    void deallocate(T* ptr, std::size_t count) noexcept{
+        std::size_t size = count * sizeof(T);
+        if(alignof(T) > SizeClassPool::ALIGNMENT){
+            ::operator delete(ptr, std::align_val_t(alignof(T)));
+        }else if(size <= SizeClassPool::MAX_SIZE){
+            SizeClassPool::instance().deallocate(ptr, size);
+        }else{
+            ::operator delete(ptr);
+        }
+    }
+
+    template <class U>
+    bool operator==(const SizeClassAllocator<U>&) const noexcept {return true;}
+    template <class U>
+    bool operator!=(const SizeClassAllocator<U>&) const noexcept {return false;}
+};
+
+#endif
@@ -0,0 +1,356 @@
+#ifndef SORT
+#define SORT
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Concurrency.h"
+
+// Sorting for large arrays: radix sorts for integer keys, and a parallel sample sort for anything with a comparison.
+//
+//  - radix_sort is a least significant digit radix sort. It is stable, and needs a scratch array as large as the input.
+//  - radix_sort_in_place is a most significant digit radix sort (American flag sort), which permutes elements into their
+//    buckets by swapping and so needs no scratch array, but is not stable.
+//  - parallel_sample_sort and parallel_stable_sample_sort split the input into buckets by sampled splitters, on several
+//    threads, and sort the buckets independently. Both need a scratch array as large as the input.
+//
+// The radix sorts take a key function that maps an element to an unsigned integer, so key/value pairs sort by passing
+// something like [](const Pair& p){return p.first;}. The default, RadixKey, takes integral elements as their own key,
+// flipping the sign bit of signed ones so that negative numbers order first. The scratch arrays are default constructed
+// T, so elements must be default constructible.
+
+struct RadixKey{
+    template <class T>
+    typename std::make_unsigned<T>::type operator()(T value) const{
+        static_assert(std::is_integral<T>::value, "RadixKey only handles integers; pass a key function for other types");
+        typedef typename std::make_unsigned<T>::type Unsigned;
+        if(std::is_signed<T>::value){
+            return Unsigned(value) ^ (Unsigned(1) << (sizeof(T) * 8 - 1));
+        }
+        return Unsigned(value);
+    }
+};
+
+// Below this size radix_sort hands over to std::stable_sort, whose insertion sort is quicker than even one counting pass
+// over 256 buckets.
+constexpr std::size_t RADIX_SORT_THRESHOLD = 256;
+// Below this size radix_sort_in_place sorts a bucket with std::sort instead of splitting it again.
+constexpr std::size_t RADIX_IN_PLACE_THRESHOLD = 64;
+
+// One counting sort pass of radix_sort: moves from[0, count) to to, in order of the byte of the key at shift. offsets
+// holds each byte value's starting position and is advanced as elements are placed.
+template <class From, class To, class Key>
+inline void radix_scatter(From from, To to, std::size_t count, unsigned shift, std::size_t* offsets, Key& key){
+    for(std::size_t i = 0; i < count; ++i){
+        std::size_t digit = (key(from[i]) >> shift) & 0xFF;
+        to[offsets[digit]++] = std::move(from[i]);
+    }
+}
+
+template <class RandomIt, class Key = RadixKey>
+void radix_sort(RandomIt first, RandomIt last, Key key = Key()){
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    typedef typename std::decay<decltype(key(std::declval<const T&>()))>::type K;
+    static_assert(std::is_unsigned<K>::value, "radix_sort keys must be unsigned integers");
+    constexpr unsigned PASSES = sizeof(K);
+
+    std::size_t count = std::size_t(last - first);
+    if(count < RADIX_SORT_THRESHOLD){
+        std::stable_sort(first, last, [&](const T& a, const T& b){return key(a) < key(b);});
+        return;
+    }
+
+    // The histograms of every byte of the key are counted in one pass over the input rather than one pass per byte:
+    // scattering never changes a key, so they all stay valid. The loop over bytes has a fixed trip count and each byte
+    // updates its own table, so the compiler unrolls it into independent increments with no dependency between them.
+    std::vector<std::size_t> counts(PASSES * 256, 0);
+    for(std::size_t i = 0; i < count; ++i){
+        K value = key(first[i]);
+        for(unsigned pass = 0; pass < PASSES; ++pass){
+            counts[pass * 256 + ((value >> (pass * 8)) & 0xFF)]++;
+        }
+    }
+
+    std::unique_ptr<T[]> buffer;
+    bool in_buffer = false;
+    for(unsigned pass = 0; pass < PASSES; ++pass){
+        std::size_t* offsets = &counts[pass * 256];
+        // A byte that is the same in every key doesn't reorder anything, and for small keys stored in wide integers
+        // (or keys that are all close together) that is most of the high bytes, so those passes are skipped.
+        if(std::find(offsets, offsets + 256, count) != offsets + 256){
+            continue;
+        }
+        std::size_t total = 0;
+        for(unsigned digit = 0; digit < 256; ++digit){
+            std::size_t size = offsets[digit];
+            offsets[digit] = total;
+            total += size;
+        }
+        if(!buffer){
+            buffer.reset(new T[count]);
+        }
+        if(in_buffer){
+            radix_scatter(buffer.get(), first, count, pass * 8, offsets, key);
+        }else{
+            radix_scatter(first, buffer.get(), count, pass * 8, offsets, key);
+        }
+        in_buffer = !in_buffer;
+    }
+    if(in_buffer){
+        std::move(buffer.get(), buffer.get() + count, first);
+    }
+}
+
+template <class RandomIt, class Key>
+void radix_sort_in_place_from(RandomIt first, RandomIt last, Key& key, int shift){
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    std::size_t count = std::size_t(last - first);
+    while(true){
+        if(count < RADIX_IN_PLACE_THRESHOLD){
+            std::sort(first, last, [&](const T& a, const T& b){return key(a) < key(b);});
+            return;
+        }
+        std::size_t counts[256] = {};
+        for(std::size_t i = 0; i < count; ++i){
+            counts[(key(first[i]) >> shift) & 0xFF]++;
+        }
+        // As in radix_sort, a byte every key shares is skipped, here by moving on to the next one without splitting.
+        if(std::find(counts, counts + 256, count) == counts + 256){
+            std::size_t heads[256], tails[256];
+            std::size_t total = 0;
+            for(unsigned digit = 0; digit < 256; ++digit){
+                heads[digit] = total;
+                total += counts[digit];
+                tails[digit] = total;
+            }
+            // Each element at the head of a bucket is swapped to the head of the bucket it belongs in, and the element
+            // found there is carried on, until one that belongs in the current bucket comes back. Every swap puts one
+            // element in its final bucket, so the permutation takes count moves.
+            for(unsigned digit = 0; digit < 256; ++digit){
+                while(heads[digit] < tails[digit]){
+                    T value = std::move(first[heads[digit]]);
+                    std::size_t home = (key(value) >> shift) & 0xFF;
+                    while(home != digit){
+                        std::swap(value, first[heads[home]++]);
+                        home = (key(value) >> shift) & 0xFF;
+                    }
+                    first[heads[digit]++] = std::move(value);
+                }
+            }
+            if(shift == 0){
+                return;
+            }
+            std::size_t begin = 0;
+            for(unsigned digit = 0; digit < 256; ++digit){
+                if(counts[digit] > 1){
+                    radix_sort_in_place_from(first + begin, first + begin + counts[digit], key, shift - 8);
+                }
+                begin += counts[digit];
+            }
+            return;
+        }
+        if(shift == 0){
+            return;
+        }
+        shift -= 8;
+    }
+}
+
+template <class RandomIt, class Key = RadixKey>
+void radix_sort_in_place(RandomIt first, RandomIt last, Key key = Key()){
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    typedef typename std::decay<decltype(key(std::declval<const T&>()))>::type K;
+    static_assert(std::is_unsigned<K>::value, "radix_sort_in_place keys must be unsigned integers");
+    radix_sort_in_place_from(first, last, key, int(sizeof(K) * 8 - 8));
+}
+
+
+// SampleSort is the parallel sample sort behind parallel_sample_sort and parallel_stable_sample_sort.
+//
+// A random sample of the input, sorted, gives BUCKETS_PER_THREAD * threads - 1 splitters that divide the keys into
+// buckets of about equal size. Then, with every thread working on its own contiguous block of the input:
+//
+//  1. Each thread works out every element's bucket with a binary search of the splitters, remembering it in an oracle
+//     array, and counts the elements of each bucket in its block.
+//  2. The counts give each (bucket, thread) pair its own range of the scratch array, ordered by bucket and then by
+//     thread, and each thread moves its block's elements there in order.
+//  3. Threads take whole buckets from a shared counter, sort each one in the scratch array and move it back to the
+//     same place in the input, where it is now in its final position.
+//
+// Step 2 keeps elements of one bucket in their input order, so sorting the buckets with std::stable_sort makes the whole
+// sort stable. There are several buckets per thread so that a thread which draws large buckets doesn't hold up the rest.
+//
+// A key that makes up a large part of the input (common in skewed data) shows up in the sample many times, and would
+// otherwise land in one oversized bucket that a single thread has to sort. Duplicate splitters are removed, and each
+// remaining splitter gets a bucket of its own for the elements equal to it; those buckets are already sorted, so they
+// cost nothing in step 3.
+template <class T, class Compare, bool STABLE>
+class SampleSort{
+private:
+    static constexpr std::size_t BUCKETS_PER_THREAD = 8;
+    static constexpr std::size_t OVERSAMPLING = 16;     // Sampled elements per bucket.
+
+    T*                          m_data;
+    std::size_t                 m_count;
+    std::size_t                 m_threads;
+    Compare                     m_compare;
+    std::vector<T>              m_splitters;
+    std::size_t                 m_buckets;
+    std::unique_ptr<T[]>        m_buffer;
+    std::unique_ptr<std::uint16_t[]> m_oracle;  // Each element's bucket.
+    std::vector<std::size_t>    m_offsets;          // m_threads rows of m_buckets counts, then offsets.
+    std::atomic<std::size_t>    m_next_bucket;
+    std::vector<std::size_t>    m_bucket_begin;     // m_buckets + 1 entries.
+    ThreadBarrier               m_barrier;
+
+    static void sort_range(T* first, T* last, Compare& compare){
+        if(STABLE){
+            std::stable_sort(first, last, compare);
+        }else{
+            std::sort(first, last, compare);
+        }
+    }
+
+    // Buckets alternate: 2 * i for the elements between splitters i - 1 and i, and 2 * i + 1 for those equal to
+    // splitter i.
+    std::size_t bucket_of(const T& value){
+        std::size_t i = std::size_t(std::upper_bound(m_splitters.begin(), m_splitters.end(), value, m_compare) -
+                                    m_splitters.begin());
+        if(i > 0 && !m_compare(m_splitters[i - 1], value)){
+            return 2 * i - 1;
+        }
+        return 2 * i;
+    }
+    bool is_equal_bucket(std::size_t bucket) const {return bucket % 2 == 1;}
+
+    void choose_splitters();
+    void worker(std::size_t index);
+
+public:
+    SampleSort(T* data, std::size_t count, std::size_t threads, const Compare& compare)
+        : m_data(data), m_count(count), m_threads(threads), m_compare(compare), m_buckets(0), m_next_bucket(0),
+          m_barrier(threads){
+        assert(2 * BUCKETS_PER_THREAD * threads <= UINT16_MAX && "SampleSort bucket numbers don't fit the oracle");
+    }
+
+    void run();
+};
+
+template <class T, class Compare, bool STABLE>
+void SampleSort<T, Compare, STABLE>::choose_splitters(){
+    std::size_t target = BUCKETS_PER_THREAD * m_threads;
+    std::vector<T> sample;
+    sample.reserve(target * OVERSAMPLING);
+    std::mt19937_64 rng(m_count);
+    for(std::size_t i = 0; i < target * OVERSAMPLING; ++i){
+        sample.push_back(m_data[rng() % m_count]);
+    }
+    std::sort(sample.begin(), sample.end(), m_compare);
+    for(std::size_t i = 1; i < target; ++i){
+        const T& splitter = sample[i * OVERSAMPLING];
+        if(m_splitters.empty() || m_compare(m_splitters.back(), splitter)){
+            m_splitters.push_back(splitter);
+        }
+    }
+    m_buckets = 2 * m_splitters.size() + 1;
+}
+
+template <class T, class Compare, bool STABLE>
+void SampleSort<T, Compare, STABLE>::run(){
+    choose_splitters();
+    m_buffer.reset(new T[m_count]);
+    m_oracle.reset(new std::uint16_t[m_count]);
+    m_offsets.assign(m_threads * m_buckets, 0);
+    m_bucket_begin.assign(m_buckets + 1, 0);
+    std::vector<std::thread> workers;
+    for(std::size_t t = 1; t < m_threads; ++t){
+        workers.emplace_back(&SampleSort::worker, this, t);
+    }
+    worker(0);
+    for(std::thread& thread : workers){
+        thread.join();
+    }
+}
+
+template <class T, class Compare, bool STABLE>
+void SampleSort<T, Compare, STABLE>::worker(std::size_t index){
+    std::size_t begin = m_count * index / m_threads;
+    std::size_t end = m_count * (index + 1) / m_threads;
+    std::size_t* offsets = &m_offsets[index * m_buckets];
+    for(std::size_t i = begin; i < end; ++i){
+        std::size_t bucket = bucket_of(m_data[i]);
+        m_oracle[i] = std::uint16_t(bucket);
+        offsets[bucket]++;
+    }
+    m_barrier.wait();
+
+    if(index == 0){
+        std::size_t total = 0;
+        for(std::size_t bucket = 0; bucket < m_buckets; ++bucket){
+            m_bucket_begin[bucket] = total;
+            for(std::size_t thread = 0; thread < m_threads; ++thread){
+                std::size_t size = m_offsets[thread * m_buckets + bucket];
+                m_offsets[thread * m_buckets + bucket] = total;
+                total += size;
+            }
+        }
+        m_bucket_begin[m_buckets] = total;
+    }
+    m_barrier.wait();
+
+    for(std::size_t i = begin; i < end; ++i){
+        m_buffer[offsets[m_oracle[i]]++] = std::move(m_data[i]);
+    }
+    m_barrier.wait();
+
+    while(true){
+        std::size_t bucket = m_next_bucket.fetch_add(1, std::memory_order_relaxed);
+        if(bucket >= m_buckets){
+            break;
+        }
+        T* first = m_buffer.get() + m_bucket_begin[bucket];
+        T* last = m_buffer.get() + m_bucket_begin[bucket + 1];
+        if(!is_equal_bucket(bucket)){
+            sort_range(first, last, m_compare);
+        }
+        std::move(first, last, m_data + m_bucket_begin[bucket]);
+    }
+}
+
+// Below this many elements per thread the sample sorts just sort on the calling thread.
+constexpr std::size_t SAMPLE_SORT_THRESHOLD = 1 << 14;
+
+template <class T, class Compare = std::less<T>>
+void parallel_sample_sort(T* first, T* last, std::size_t threads, Compare compare = Compare()){
+    assert(threads > 0 && "parallel_sample_sort needs at least one thread");
+    std::size_t count = std::size_t(last - first);
+    if(count / threads < SAMPLE_SORT_THRESHOLD || threads == 1){
+        std::sort(first, last, compare);
+        return;
+    }
+    SampleSort<T, Compare, false>(first, count, threads, compare).run();
+}
+
+template <class T, class Compare = std::less<T>>
+void parallel_stable_sample_sort(T* first, T* last, std::size_t threads, Compare compare = Compare()){
+    assert(threads > 0 && "parallel_stable_sample_sort needs at least one thread");
+    std::size_t count = std::size_t(last - first);
+    if(count / threads < SAMPLE_SORT_THRESHOLD || threads == 1){
+        std::stable_sort(first, last, compare);
+        return;
+    }
+    SampleSort<T, Compare, true>(first, count, threads, compare).run();
+}
+
+#endif
@@ -1,52 +1,244 @@
 #ifndef STACK
 #define STACK
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
-#define MAX_SIZE 100
+#include "AllocatorHolder.h"
+
+// The default number of elements kept inside the Stack object: as many as fit in 256 bytes, so that a Stack of small
+// values on the C++ stack costs about four cache lines and one of large values doesn't hold any inline at all.
+constexpr std::size_t default_stack_inline_size(std::size_t element_size){
+    return element_size <= 256 ? 256 / element_size : 0;
+}
+
+// Stack is a LIFO of T held by value in one contiguous array. The first INLINE_SIZE elements live in a buffer inside the
+// Stack itself, so a stack that never gets deeper than that never touches the heap; past that the elements move to a
+// heap array which doubles whenever it fills up. Either way push and pop are O(1) (amortised for push) and there is no
+// allocation per element.
+//
+// This is aimed at the explicit stacks of iterative traversals (depth first search, tree walks, expression evaluation),
+// which are usually shallow, are created and destroyed often, and would otherwise spend most of their time in malloc.
+//
+// The heap array, once there is one, comes from Allocator. The stack keeps its own copy of the allocator, free when it
+// is stateless, and passes it on as allocator_traits says, so a polymorphic_allocator over an arena works too.
+template <class T, std::size_t INLINE_SIZE = default_stack_inline_size(sizeof(T)), class Allocator = std::allocator<T>>
+class Stack : private AllocatorHolder<Allocator>{
+    static_assert(std::is_same<typename Allocator::value_type, T>::value, "Stack Allocator must allocate T");
 
-class Stack{
 private:
-    ptrdiff_t* m_arr[MAX_SIZE];
-    ptrdiff_t m_top;
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+    T*          m_arr;          // Either inline_data() or a heap array of m_capacity elements.
+    std::size_t m_size;
+    std::size_t m_capacity;
+    alignas(T) unsigned char m_inline[INLINE_SIZE ? INLINE_SIZE * sizeof(T) : 1];
+
+    T* inline_data() {return reinterpret_cast<T*>(m_inline);}
+
+    // The capacity to grow to for count more elements: m_capacity doubled until they fit.
+    std::size_t grown_capacity(std::size_t count) const{
+        std::size_t capacity = std::max(m_capacity * 2, MIN_CAPACITY);
+        while(capacity < m_size + count){
+            capacity *= 2;
+        }
+        return capacity;
+    }
+    // Moves the elements into arr, a new heap array of the given capacity, and frees the old one.
+    void relocate(T* arr, std::size_t capacity);
+    void grow_for(std::size_t count){
+        if(m_size + count > m_capacity){
+            std::size_t capacity = grown_capacity(count);
+            relocate(this->allocator().allocate(capacity), capacity);
+        }
+    }
+    // Frees the heap array, if there is one, and goes back to the empty inline buffer. The stack must be empty.
+    void release(){
+        if(!is_inline()){
+            this->allocator().deallocate(m_arr, m_capacity);
+        }
+        m_arr      = inline_data();
+        m_capacity = INLINE_SIZE;
+    }
+    // Takes other's elements, leaving other empty. This stack must be empty and inline, and other's heap array, if it
+    // has one, must be one this stack's allocator can free.
+    void steal(Stack& other) noexcept;
+    // Copies other's elements into this stack, which must be empty.
+    void copy_elements(const Stack& other){
+        reserve(other.m_size);
+        std::uninitialized_copy(other.m_arr, other.m_arr + other.m_size, m_arr);
+        m_size = other.m_size;
+    }
+    // emplace on a full stack, kept out of line so that the common case stays small enough to inline.
+    template <class... Args>
+    T& emplace_grow(Args&&... args);
 
 public:
-    // We initialise the top to -1 since that will be above the first element on the stack.
-    // This allows us to check if the stack is empty.
-    Stack() : m_top(-1){};
-
-    template <typename TYPE>
-    void push(TYPE &value);
-    void pop();
-
-    auto peek();
-
-    bool is_empty(){
-        return m_top + 1;
-    };
-    bool is_full(){
-        assert(m_top < MAX_SIZE && "Stack overflow has occured");
-        return m_top == MAX_SIZE - 1;
-    };
-};
+    Stack() : Stack(Allocator()){};
+    explicit Stack(const Allocator& allocator)
+        : AllocatorHolder<Allocator>(allocator), m_arr(inline_data()), m_size(0), m_capacity(INLINE_SIZE){};
+    Stack(const Stack& other) : Stack(select_copy_allocator(other.allocator())){
+        copy_elements(other);
+    }
+    Stack(Stack&& other) noexcept : Stack(other.allocator()){
+        steal(other);
+    }
+    Stack& operator=(const Stack& other);
+    Stack& operator=(Stack&& other) noexcept(move_assignment_steals<Allocator>);
+    ~Stack(){
+        clear();
+        release();
+    }
+
+    void swap(Stack& other) noexcept{
+        assert(can_swap_storage(this->allocator(), other.allocator()) && "Can't swap Stacks with unequal allocators");
+        Stack tmp(std::move(other));
+        swap_allocators(other.allocator(), this->allocator());
+        other.steal(*this);
+        steal(tmp);
+    }
+    Allocator get_allocator() const {return this->allocator();}
 
-template <typename TYPE>
-void Stack::push(TYPE &value){
-    assert(m_top < MAX_SIZE - 1 && "Stack overflow would occur with push");
+    void push(const T& value){emplace(value);}
+    void push(T&& value){emplace(std::move(value));}
+    template <class... Args>
+    T& emplace(Args&&... args){
+        // m_size is read once and written once: T may be std::size_t, and then the compiler has to assume the new
+        // element might alias m_size and reload it after the store.
+        std::size_t size = m_size;
+        if(size == m_capacity){
+            return emplace_grow(std::forward<Args>(args)...);
+        }
+        T* top = ::new (static_cast<void*>(m_arr + size)) T(std::forward<Args>(args)...);
+        m_size = size + 1;
+        return *top;
+    }
+    T pop(){
+        assert(m_size > 0 && "Stack underflow would occur with pop");
+        std::size_t size = m_size - 1;
+        T& top = m_arr[size];
+        T tmp(std::move(top));
+        top.~T();
+        m_size = size;
+        return tmp;
+    }
 
-    TYPE *store_value = new TYPE(value);
-    m_arr[m_top + 1] = store_value;
-    m_top++;
+    T& peek(){
+        assert(m_size > 0 && "Can't peek at an empty Stack");
+        return m_arr[m_size - 1];
+    }
+    const T& peek() const{
+        assert(m_size > 0 && "Can't peek at an empty Stack");
+        return m_arr[m_size - 1];
+    }
+
+    void reserve(std::size_t capacity){
+        grow_for(capacity > m_size ? capacity - m_size : 0);
+    }
+    void clear(){
+        std::destroy(m_arr, m_arr + m_size);
+        m_size = 0;
+    }
+
+    bool is_empty() const {return m_size == 0;}
+    std::size_t size() const {return m_size;}
+    std::size_t capacity() const {return m_capacity;}
+    // is_inline is true while the elements are still in the buffer inside the Stack.
+    bool is_inline() const {return m_arr == reinterpret_cast<const T*>(m_inline);}
+    static constexpr std::size_t inline_size() {return INLINE_SIZE;}
+};
+
+template <class T, std::size_t INLINE_SIZE, class Allocator>
+template <class... Args>
+T& Stack<T, INLINE_SIZE, Allocator>::emplace_grow(Args&&... args){
+    // args may refer to an element of this stack, as in s.push(s.peek()), so the new element is built in the new array
+    // before the old elements are moved out and the old array freed.
+    std::size_t capacity = grown_capacity(1);
+    T* arr = this->allocator().allocate(capacity);
+    try{
+        ::new (static_cast<void*>(arr + m_size)) T(std::forward<Args>(args)...);
+    }catch(...){
+        this->allocator().deallocate(arr, capacity);
+        throw;
+    }
+    relocate(arr, capacity);
+    return m_arr[m_size++];
 }
-void Stack::pop(){
-    assert(m_top > - 1 && "Stack underflow would occur with pop");
-    delete m_arr[m_top];
-    m_top--;
+
+template <class T, std::size_t INLINE_SIZE, class Allocator>
+void Stack<T, INLINE_SIZE, Allocator>::relocate(T* arr, std::size_t capacity){
+    if(std::is_trivially_copyable<T>::value){
+        if(m_size){
+            std::memcpy(static_cast<void*>(arr), m_arr, m_size * sizeof(T));
+        }
+    }else{
+        for(std::size_t i = 0; i < m_size; ++i){
+            ::new (static_cast<void*>(arr + i)) T(std::move_if_noexcept(m_arr[i]));
+            m_arr[i].~T();
+        }
+    }
+    if(!is_inline()){
+        this->allocator().deallocate(m_arr, m_capacity);
+    }
+    m_arr      = arr;
+    m_capacity = capacity;
 }
 
-auto Stack::peek(){
-    assert(m_top > - 1 && "Can't peek at an empty stack");
-    return *m_arr[m_top];
+template <class T, std::size_t INLINE_SIZE, class Allocator>
+Stack<T, INLINE_SIZE, Allocator>& Stack<T, INLINE_SIZE, Allocator>::operator=(const Stack& other){
+    if(this != &other){
+        clear();
+        if(std::allocator_traits<Allocator>::propagate_on_container_copy_assignment::value
+           && !(this->allocator() == other.allocator())){
+            // The heap array has to go back to the allocator that gave it out before that allocator is replaced.
+            release();
+            copy_assign_allocator(this->allocator(), other.allocator());
+        }
+        copy_elements(other);
+    }
+    return *this;
+}
+template <class T, std::size_t INLINE_SIZE, class Allocator>
+Stack<T, INLINE_SIZE, Allocator>& Stack<T, INLINE_SIZE, Allocator>::operator=(Stack&& other) noexcept(move_assignment_steals<Allocator>){
+    if(this != &other){
+        clear();
+        if(can_steal_storage(this->allocator(), other.allocator())){
+            release();
+            move_assign_allocator(this->allocator(), other.allocator());
+            steal(other);
+        }else{
+            // other's heap array belongs to a different allocator, which stays with other, so the elements move over one
+            // by one into this stack's own memory.
+            reserve(other.m_size);
+            std::uninitialized_move(other.m_arr, other.m_arr + other.m_size, m_arr);
+            m_size = other.m_size;
+            other.clear();
+        }
+    }
+    return *this;
 }
+template <class T, std::size_t INLINE_SIZE, class Allocator>
+void Stack<T, INLINE_SIZE, Allocator>::steal(Stack& other) noexcept{
+    if(other.is_inline()){
+        // Inline elements can't change owner, so they are moved one by one. Moving is assumed not to throw, as it is for
+        // any T that is cheap enough to keep in an inline buffer.
+        std::uninitialized_move(other.m_arr, other.m_arr + other.m_size, m_arr);
+        m_size = other.m_size;
+        other.clear();
+    }else{
+        m_arr      = other.m_arr;
+        m_size     = other.m_size;
+        m_capacity = other.m_capacity;
+        other.m_arr      = other.inline_data();
+        other.m_size     = 0;
+        other.m_capacity = INLINE_SIZE;
+    }
+}
+
 #endif
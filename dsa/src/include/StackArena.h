@@ -0,0 +1,210 @@
+#ifndef STACKARENA
+#define STACKARENA
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+
+// StackArena hands out memory with stack discipline: allocation bumps a pointer, and everything allocated after a
+// mark() is freed at once by release_to(mark), in O(1) whatever was allocated. It suits work that builds up temporaries
+// and then drops them all together, such as handling a request or evaluating one node of a recursive computation.
+// Individual allocations are never freed on their own (see ArenaResource for the one exception).
+//
+// Memory comes in blocks chained in a singly linked list, each twice the size of the one before up to MAX_BLOCK_SIZE,
+// and larger if a single allocation needs it. Releasing doesn't free blocks, it only moves the bump pointer back, so the
+// blocks past the mark stay in the chain and are reused by the next allocations. A long running arena therefore settles
+// at the size of its largest peak and stops calling malloc; shrink() frees the unused blocks if that peak was a one off.
+class StackArena{
+private:
+    struct Block{
+        Block*      m_next;
+        std::size_t m_size;         // Usable bytes after the header.
+
+        unsigned char* begin() {return reinterpret_cast<unsigned char*>(this + 1);}
+        unsigned char* end() {return begin() + m_size;}
+    };
+
+    Block*         m_first;
+    Block*         m_current;       // The block being allocated from. Every block before it is in use.
+    unsigned char* m_top;           // The first free byte in m_current.
+    std::size_t    m_next_size;
+
+    static Block* new_block(std::size_t size, Block* next){
+        Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+        if(block == nullptr){
+            throw std::bad_alloc();
+        }
+        block->m_next = next;
+        block->m_size = size;
+        return block;
+    }
+    static unsigned char* align_up(unsigned char* ptr, std::size_t alignment){
+        return reinterpret_cast<unsigned char*>((reinterpret_cast<std::uintptr_t>(ptr) + alignment - 1) & ~(alignment - 1));
+    }
+
+    void* allocate_slow(std::size_t size, std::size_t alignment);
+
+public:
+    static constexpr std::size_t DEFAULT_BLOCK_SIZE = 4096 - sizeof(Block);
+    static constexpr std::size_t MAX_BLOCK_SIZE     = (std::size_t(1) << 20) - sizeof(Block);
+
+    // A position in the arena to release back to.
+    struct Mark{
+        Block*         m_block;
+        unsigned char* m_top;
+    };
+
+    explicit StackArena(std::size_t initial_block_size = DEFAULT_BLOCK_SIZE)
+        : m_first(nullptr), m_current(nullptr), m_top(nullptr), m_next_size(std::max<std::size_t>(initial_block_size, 64)){};
+    StackArena(const StackArena&) = delete;
+    StackArena& operator=(const StackArena&) = delete;
+    ~StackArena(){
+        while(m_first != nullptr){
+            Block* next = m_first->m_next;
+            std::free(m_first);
+            m_first = next;
+        }
+    }
+
+    // alignment must be a power of two.
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)){
+        assert(alignment && (alignment & (alignment - 1)) == 0 && "StackArena alignment must be a power of two");
+        if(m_current != nullptr){
+            unsigned char* ptr = align_up(m_top, alignment);
+            if(ptr <= m_current->end() && size <= std::size_t(m_current->end() - ptr)){
+                m_top = ptr + size;
+                return ptr;
+            }
+        }
+        return allocate_slow(size, alignment);
+    }
+    template <class T>
+    T* allocate_array(std::size_t count){
+        assert(count <= SIZE_MAX / sizeof(T) && "StackArena array size overflows");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    Mark mark() const {return Mark{m_current, m_top};}
+    // release_to frees everything allocated since mark was taken. Marks must be released in LIFO order: releasing to a
+    // mark invalidates every mark taken after it.
+    void release_to(const Mark& mark){
+        if(mark.m_block == nullptr){
+            reset();
+        }else{
+            m_current = mark.m_block;
+            m_top     = mark.m_top;
+        }
+    }
+    void reset(){
+        m_current = m_first;
+        m_top     = m_first != nullptr ? m_first->begin() : nullptr;
+    }
+    // shrink frees the blocks after the current one, which only hold released memory.
+    void shrink();
+
+    // The total size of the blocks the arena holds, in use or not.
+    std::size_t reserved() const;
+    // The bytes between the start of the arena and the bump pointer, including alignment padding and the unused tails of
+    // earlier blocks.
+    std::size_t used() const;
+
+    // Rolls the bump pointer back if ptr is the most recent allocation, so a container that allocates and frees in LIFO
+    // order (a growing vector, say) doesn't leave its old buffers behind. Anything else is left alone.
+    void deallocate(void* ptr, std::size_t size){
+        if(m_current != nullptr && static_cast<unsigned char*>(ptr) + size == m_top && ptr >= m_current->begin()){
+            m_top = static_cast<unsigned char*>(ptr);
+        }
+    }
+};
+
+inline void* StackArena::allocate_slow(std::size_t size, std::size_t alignment){
+    // Padding to the alignment can need up to alignment - 1 bytes more than size, as malloc only guarantees
+    // max_align_t for the block.
+    std::size_t needed = size + (alignment > alignof(std::max_align_t) ? alignment - 1 : 0);
+    Block* previous = m_current;
+    Block* block = m_current != nullptr ? m_current->m_next : m_first;
+    if(block == nullptr || block->m_size < needed){
+        // Splice a new block in here. Any released blocks after it stay in the chain for later.
+        block = new_block(std::max(m_next_size, needed), block);
+        if(m_next_size < MAX_BLOCK_SIZE){
+            // Double the whole malloc request, header included, so blocks stay a power of two in size.
+            m_next_size = std::min((m_next_size + sizeof(Block)) * 2 - sizeof(Block), MAX_BLOCK_SIZE);
+        }
+        (previous != nullptr ? previous->m_next : m_first) = block;
+    }
+    m_current = block;
+    unsigned char* ptr = align_up(block->begin(), alignment);
+    m_top = ptr + size;
+    return ptr;
+}
+
+inline void StackArena::shrink(){
+    Block*& after = m_current != nullptr ? m_current->m_next : m_first;
+    while(after != nullptr){
+        Block* next = after->m_next;
+        std::free(after);
+        after = next;
+    }
+}
+
+inline std::size_t StackArena::reserved() const{
+    std::size_t total = 0;
+    for(Block* block = m_first; block != nullptr; block = block->m_next){
+        total += block->m_size;
+    }
+    return total;
+}
+
+inline std::size_t StackArena::used() const{
+    std::size_t total = 0;
+    for(Block* block = m_first; block != m_current; block = block->m_next){
+        total += block->m_size;
+    }
+    return m_current != nullptr ? total + std::size_t(m_top - m_current->begin()) : 0;
+}
+
+
+// ArenaScope releases the arena to where it was when the scope was entered.
+class ArenaScope{
+private:
+    StackArena&      m_arena;
+    StackArena::Mark m_mark;
+
+public:
+    explicit ArenaScope(StackArena& arena) : m_arena(arena), m_mark(arena.mark()){};
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+    ~ArenaScope() {m_arena.release_to(m_mark);}
+};
+
+
+// ArenaResource lets std::pmr containers, and the dsa containers given a std::pmr::polymorphic_allocator, allocate from
+// a StackArena. Deallocation only gives memory back when it is the most recent allocation, so containers should be
+// destroyed before the arena is released past their memory, and never after. A container that grows allocates its new
+// buffer before freeing the old one, which therefore stays in the arena until it is released; reserving up front avoids
+// that where the final size is known.
+class ArenaResource : public std::pmr::memory_resource{
+private:
+    StackArena& m_arena;
+
+    void* do_allocate(std::size_t size, std::size_t alignment) override{
+        return m_arena.allocate(size, alignment);
+    }
+    void do_deallocate(void* ptr, std::size_t size, std::size_t) override{
+        m_arena.deallocate(ptr, size);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override{
+        return this == &other;
+    }
+
+public:
+    explicit ArenaResource(StackArena& arena) : m_arena(arena){};
+
+    StackArena& arena() {return m_arena;}
+};
+
+#endif
@@ -0,0 +1,262 @@
+#ifndef STRINGHASHMAP
+#define STRINGHASHMAP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Hash.h"
+
+// StringArena is an append-only store for key bytes. Keys are copied into large blocks back to back, so interning a
+// key costs a memcpy rather than a heap allocation, and the bytes never move once written which lets the map hold
+// plain pointers to them. Nothing is freed until the arena itself is cleared or destroyed.
+class StringArena{
+private:
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    char*       m_cursor;
+    std::size_t m_remaining;
+    std::size_t m_reserved;
+
+public:
+    StringArena() : m_cursor(nullptr), m_remaining(0), m_reserved(0){};
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+
+    // Keys larger than a block get a block of their own so that one long key doesn't waste the tail of a block.
+    const char* intern(std::string_view key){
+        if(key.size() > m_remaining){
+            std::size_t block_size = std::max(BLOCK_SIZE, key.size());
+            m_blocks.emplace_back(new char[block_size]);
+            m_cursor    = m_blocks.back().get();
+            m_remaining = block_size;
+            m_reserved += block_size;
+        }
+        char* stored = m_cursor;
+        if(!key.empty()){
+            std::memcpy(stored, key.data(), key.size());
+        }
+        m_cursor    += key.size();
+        m_remaining -= key.size();
+        return stored;
+    }
+
+    void clear(){
+        m_blocks.clear();
+        m_cursor    = nullptr;
+        m_remaining = 0;
+        m_reserved  = 0;
+    }
+
+    std::size_t bytes_reserved() const {return m_reserved;}
+};
+
+
+// StringHashMap maps string keys to values of type V. It is an open addressing, linear probing table like HashTable,
+// with a few changes aimed at string keys:
+//
+//  - Keys are interned into a StringArena, so inserting a key never allocates per key.
+//  - Each slot stores the full 64 bit hash of its key. A probe only touches the key bytes when the stored hash
+//    matches, so a miss or a collision almost never costs a string compare.
+//  - Key pointers and values are kept densely in insertion order in their own vectors and slots hold an index into
+//    them. A slot is then a fixed 16 bytes no matter how large V is, which keeps probe sequences inside as few cache
+//    lines as possible and keeps the empty slots (at least a quarter of the table) cheap.
+//  - Lookups take a std::string_view, so callers holding a char buffer or a std::string never build a temporary key.
+//
+// The capacity is always a power of two so that the slot is the low bits of the hash.
+template <class V>
+class StringHashMap{
+private:
+    static constexpr std::uint32_t EMPTY = UINT32_MAX;
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+    struct Slot{
+        std::uint64_t m_hash;
+        std::uint32_t m_length;
+        std::uint32_t m_index;      // Position of the entry in m_keys and m_values, or EMPTY.
+    };
+
+    std::vector<Slot>          m_slots;
+    std::vector<const char*>   m_keys;
+    std::vector<V>             m_values;
+    std::vector<std::uint32_t> m_value_slots;   // Reverse mapping from m_values back to m_slots, used by erase.
+    StringArena                m_arena;
+    std::size_t                m_mask;
+
+    bool key_equals(const Slot& slot, std::uint64_t hash, std::string_view key) const{
+        return slot.m_hash == hash && slot.m_length == key.size() &&
+               (key.empty() || std::memcmp(m_keys[slot.m_index], key.data(), key.size()) == 0);
+    }
+
+    // Returns the slot holding key, or the empty slot that ends its probe sequence.
+    std::size_t find_slot(std::uint64_t hash, std::string_view key) const{
+        std::size_t position = hash & m_mask;
+        while(m_slots[position].m_index != EMPTY && !key_equals(m_slots[position], hash, key)){
+            position = (position + 1) & m_mask;
+        }
+        return position;
+    }
+
+    void rehash(std::size_t capacity){
+        std::vector<Slot> old_slots(capacity, Slot{0, 0, EMPTY});
+        old_slots.swap(m_slots);
+        m_mask = capacity - 1;
+        for(const Slot& slot : old_slots){
+            if(slot.m_index == EMPTY){
+                continue;
+            }
+            std::size_t position = slot.m_hash & m_mask;
+            while(m_slots[position].m_index != EMPTY){
+                position = (position + 1) & m_mask;
+            }
+            m_slots[position] = slot;
+            m_value_slots[slot.m_index] = position;
+        }
+    }
+
+    // As with HashTable the table is kept at most 3/4 full. Only called once a key is known to be new, so that a lookup
+    // of a present key never rehashes. Returns whether the table grew, which moves every slot.
+    bool grow_if_needed(){
+        if((m_values.size() + 1) * 4 > m_slots.size() * 3){
+            rehash(m_slots.size() * 2);
+            return true;
+        }
+        return false;
+    }
+
+public:
+    explicit StringHashMap(std::size_t expected_size = 0) : m_mask(0){
+        std::size_t capacity = MIN_CAPACITY;
+        while(capacity * 3 < expected_size * 4){
+            capacity *= 2;
+        }
+        m_slots.assign(capacity, Slot{0, 0, EMPTY});
+        m_mask = capacity - 1;
+        m_keys.reserve(expected_size);
+        m_values.reserve(expected_size);
+        m_value_slots.reserve(expected_size);
+    }
+
+    std::size_t size() const {return m_values.size();}
+    bool        empty() const {return m_values.empty();}
+    std::size_t capacity() const {return m_slots.size();}
+
+    // Returns a pointer to the value for key, or nullptr if key isn't in the map.
+    V* find(std::string_view key){
+        std::uint64_t hash = hash_bytes(key.data(), key.size());
+        const Slot& slot = m_slots[find_slot(hash, key)];
+        return slot.m_index == EMPTY ? nullptr : &m_values[slot.m_index];
+    }
+    const V* find(std::string_view key) const{
+        return const_cast<StringHashMap*>(this)->find(key);
+    }
+    bool contains(std::string_view key) const{
+        return find(key) != nullptr;
+    }
+
+    // insert adds key with the given value if key isn't already present. Like std::unordered_map::try_emplace the
+    // value is only constructed when the key is new. The bool is true if an insertion took place.
+    template <class... Args>
+    std::pair<V*, bool> try_emplace(std::string_view key, Args&&... args){
+        std::uint64_t hash = hash_bytes(key.data(), key.size());
+        std::size_t position = find_slot(hash, key);
+        if(m_slots[position].m_index != EMPTY){
+            return {&m_values[m_slots[position].m_index], false};
+        }
+        if(grow_if_needed()){
+            position = find_slot(hash, key);
+        }
+        Slot& slot = m_slots[position];
+        assert(m_values.size() < EMPTY && "StringHashMap cannot hold more than 2^32 - 1 entries");
+        m_values.emplace_back(std::forward<Args>(args)...);
+        m_keys.push_back(m_arena.intern(key));
+        m_value_slots.push_back(position);
+        slot = Slot{hash, std::uint32_t(key.size()), std::uint32_t(m_values.size() - 1)};
+        return {&m_values.back(), true};
+    }
+    std::pair<V*, bool> insert(std::string_view key, const V& value){
+        return try_emplace(key, value);
+    }
+    V& operator[](std::string_view key){
+        return *try_emplace(key).first;
+    }
+
+    // erase removes key and returns whether it was present. The key's bytes stay in the arena until clear(), so a map
+    // with heavy churn of distinct keys should be rebuilt from time to time. The last value is moved into the erased
+    // entry's place to keep m_values dense, which is why erase invalidates pointers to the last value.
+    bool erase(std::string_view key){
+        std::uint64_t hash = hash_bytes(key.data(), key.size());
+        std::size_t hole = find_slot(hash, key);
+        if(m_slots[hole].m_index == EMPTY){
+            return false;
+        }
+
+        std::uint32_t index = m_slots[hole].m_index;
+        std::uint32_t last  = m_values.size() - 1;
+        if(index != last){
+            m_keys[index]   = m_keys[last];
+            m_values[index] = std::move(m_values[last]);
+            m_value_slots[index] = m_value_slots[last];
+            m_slots[m_value_slots[index]].m_index = index;
+        }
+        m_keys.pop_back();
+        m_values.pop_back();
+        m_value_slots.pop_back();
+        m_slots[hole].m_index = EMPTY;
+
+        // Backward shift deletion, see HashTable::remove.
+        std::size_t position = hole;
+        while(true){
+            position = (position + 1) & m_mask;
+            Slot& slot = m_slots[position];
+            if(slot.m_index == EMPTY){
+                break;
+            }
+            std::size_t home = slot.m_hash & m_mask;
+            if(((position - home) & m_mask) >= ((position - hole) & m_mask)){
+                m_slots[hole] = slot;
+                m_value_slots[slot.m_index] = hole;
+                slot.m_index = EMPTY;
+                hole = position;
+            }
+        }
+        return true;
+    }
+
+    void clear(){
+        std::fill(m_slots.begin(), m_slots.end(), Slot{0, 0, EMPTY});
+        m_keys.clear();
+        m_values.clear();
+        m_value_slots.clear();
+        m_arena.clear();
+    }
+
+    // for_each visits every entry in insertion order (modulo erase, which moves the last entry into the gap).
+    template <class F>
+    void for_each(F&& f){
+        for(std::size_t i = 0; i < m_values.size(); ++i){
+            const Slot& slot = m_slots[m_value_slots[i]];
+            f(std::string_view(m_keys[i], slot.m_length), m_values[i]);
+        }
+    }
+
+    // Bytes owned by the map: the slot array, the key and value storage and the key arena.
+    std::size_t memory_usage() const{
+        return m_slots.capacity() * sizeof(Slot) +
+               m_keys.capacity() * sizeof(const char*) +
+               m_values.capacity() * sizeof(V) +
+               m_value_slots.capacity() * sizeof(std::uint32_t) +
+               m_arena.bytes_reserved();
+    }
+};
+
+#endif
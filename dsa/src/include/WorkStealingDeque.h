@@ -0,0 +1,194 @@
+#ifndef WORKSTEALINGDEQUE
+#define WORKSTEALINGDEQUE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "Concurrency.h"
+#include "EpochReclamation.h"
+
+// WorkStealingDeque is the Chase-Lev deque that work-stealing schedulers keep one of per worker thread. Only the thread
+// that owns the deque may push and pop, and it does so at the bottom, LIFO, so it keeps running the task it created
+// most recently (whose data is still in its cache). Any other thread may steal from the top, FIFO, which hands thieves
+// the oldest tasks; in a divide and conquer computation those are the largest pieces of work.
+//
+// The memory orderings are the ones from Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (PPoPP 2013):
+//
+//  - push writes the element, then publishes it with a release store of m_bottom. No read-modify-write.
+//  - pop reserves the bottom element by decrementing m_bottom, then a seq_cst fence orders that store before it reads
+//    m_top. Only when it finds that it is taking the last element, which a thief could be taking at the same moment,
+//    does it race the thieves with a CAS on m_top.
+//  - steal reads m_top, fences, reads m_bottom, reads the element and then claims it with a single CAS on m_top. A thief
+//    that loses the CAS has read an element someone else now owns and just discards its copy.
+//
+// Because a thief can read an element while the owner overwrites that cell, cells are std::atomic<T> and T must be
+// trivially copyable. In practice T is a pointer or index to a task.
+//
+// The buffer is a power of two ring indexed by the ever increasing m_top and m_bottom, and it doubles when the owner
+// pushes into a full one. A thief may still be reading from the old buffer after the owner has switched to the new one,
+// so old buffers can't be freed straight away. steal reads the buffer inside an EpochGuard, and grow retires the old
+// buffer to the deque's EpochDomain, which frees it once every thief that could have loaded it has finished. The owner
+// tries to reclaim after each grow and whenever pop finds the deque empty, which is when a scheduler's worker stops to
+// go stealing, so a deque that grew during a burst gives the smaller buffers back soon after instead of at destruction.
+// The domain is allocated once per deque, which a scheduler creates once per worker.
+//
+// Buffers come from Allocator, rebound to the buffer and cell types. Only the owner allocates and frees them (retired
+// buffers are retired and reclaimed only by the owner thread), so Allocator needn't be thread safe.
+template <class T, class Allocator = std::allocator<T>>
+class WorkStealingDeque{
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque elements must be trivially copyable");
+
+private:
+    struct Buffer{
+        std::int64_t       m_mask;
+        std::atomic<T>*    m_cells;
+        WorkStealingDeque* m_owner;     // For the EpochDomain deleter, which is a plain function pointer.
+
+        std::int64_t capacity() const {return m_mask + 1;}
+        T load(std::int64_t i) const {return m_cells[i & m_mask].load(std::memory_order_relaxed);}
+        void store(std::int64_t i, const T& value) {m_cells[i & m_mask].store(value, std::memory_order_relaxed);}
+    };
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Buffer>         BufferAllocator;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::atomic<T>> CellAllocator;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> m_top;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> m_bottom;
+    std::atomic<Buffer*>         m_buffer;
+    Allocator                    m_allocator;
+    std::unique_ptr<EpochDomain> m_domain;      // Declared after m_allocator, which freeing a retired buffer uses.
+
+    Buffer* new_buffer(std::int64_t capacity);
+    void delete_buffer(Buffer* buffer){
+        CellAllocator(m_allocator).deallocate(buffer->m_cells, std::size_t(buffer->capacity()));
+        BufferAllocator(m_allocator).deallocate(buffer, 1);
+    }
+    static void delete_retired(void* ptr){
+        Buffer* buffer = static_cast<Buffer*>(ptr);
+        buffer->m_owner->delete_buffer(buffer);
+    }
+
+    Buffer* grow(Buffer* buffer, std::int64_t top, std::int64_t bottom){
+        Buffer* bigger = new_buffer(buffer->capacity() * 2);
+        for(std::int64_t i = top; i < bottom; ++i){
+            bigger->store(i, buffer->load(i));
+        }
+        m_buffer.store(bigger, std::memory_order_release);
+        m_domain->retire(buffer, &delete_retired);
+        m_domain->try_reclaim();
+        return bigger;
+    }
+
+public:
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+    // capacity is rounded up to a power of two, with a minimum of MIN_CAPACITY.
+    explicit WorkStealingDeque(std::size_t capacity = MIN_CAPACITY, const Allocator& allocator = Allocator())
+        : m_top(0), m_bottom(0), m_allocator(allocator), m_domain(new EpochDomain()){
+        std::int64_t size = MIN_CAPACITY;
+        while(std::size_t(size) < capacity){
+            size *= 2;
+        }
+        m_buffer.store(new_buffer(size), std::memory_order_relaxed);
+    }
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+    // No thread may be stealing when the deque is destroyed. Destroying the domain frees the buffers still retired.
+    ~WorkStealingDeque(){
+        m_domain.reset();
+        delete_buffer(m_buffer.load(std::memory_order_relaxed));
+    }
+
+    // push and pop may only be called by the owner thread.
+    void push(const T& value){
+        std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        std::int64_t top = m_top.load(std::memory_order_acquire);
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        if(bottom - top > buffer->m_mask){
+            buffer = grow(buffer, top, bottom);
+        }
+        buffer->store(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    // pop returns false if the deque is empty, or if a thief took the last element first.
+    bool pop(T& value){
+        std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if(top > bottom){
+            // Already empty, undo the reservation. The owner is about to go stealing, a good time to free old buffers.
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            if(m_domain->pending() > 0){
+                m_domain->try_reclaim();
+            }
+            return false;
+        }
+        value = buffer->load(bottom);
+        if(top == bottom){
+            // The last element, which thieves are also allowed to take. Whoever moves m_top past it wins.
+            bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // steal may be called by any thread. It returns false if the deque is empty or another thread took the top element
+    // first; a scheduler usually treats both as "try a different victim".
+    bool steal(T& value){
+        EpochGuard guard(*m_domain);
+        std::int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if(top >= bottom){
+            return false;
+        }
+        // The acquire load pairs with the release store in grow, so a new buffer is seen with its contents.
+        Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+        T stolen = buffer->load(top);
+        if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)){
+            return false;
+        }
+        value = stolen;
+        return true;
+    }
+
+    // size and is_empty are exact only when no other thread is using the deque; otherwise they are a snapshot.
+    std::size_t size() const{
+        std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        std::int64_t top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? std::size_t(bottom - top) : 0;
+    }
+    bool is_empty() const {return size() == 0;}
+    std::size_t capacity() const {return std::size_t(m_buffer.load(std::memory_order_relaxed)->capacity());}
+    Allocator get_allocator() const {return m_allocator;}
+};
+
+template <class T, class Allocator>
+typename WorkStealingDeque<T, Allocator>::Buffer* WorkStealingDeque<T, Allocator>::new_buffer(std::int64_t capacity){
+    CellAllocator cell_allocator(m_allocator);
+    std::atomic<T>* cells = cell_allocator.allocate(std::size_t(capacity));
+    for(std::int64_t i = 0; i < capacity; ++i){
+        ::new (static_cast<void*>(cells + i)) std::atomic<T>();
+    }
+    Buffer* buffer;
+    try{
+        buffer = BufferAllocator(m_allocator).allocate(1);
+    }catch(...){
+        cell_allocator.deallocate(cells, std::size_t(capacity));
+        throw;
+    }
+    ::new (static_cast<void*>(buffer)) Buffer{capacity - 1, cells, this};
+    return buffer;
+}
+
+#endif
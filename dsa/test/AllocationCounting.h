@@ -0,0 +1,64 @@
+#ifndef ALLOCATIONCOUNTING
+#define ALLOCATIONCOUNTING
+
+#include <cstdint>
+
+#include "googletest/googletest/include/gtest/gtest.h"
+#include "../bench/AllocCounter.h"
+
+// Test-only allocation counting, for tests that pin down where a container may and may not allocate. It counts through
+// the same global operator new and delete replacements as the benchmarks (AllocCounter.h), so like them it must be
+// included by exactly one translation unit per test program.
+//
+// AllocationScope counts the allocations made, and the heap bytes left live, between its construction and each call.
+// The counters are process wide, so a scope also sees allocations made by other threads while it is open; tests that
+// use one should keep their other threads quiet for its duration.
+class AllocationScope{
+private:
+    std::uint64_t m_allocations;
+    std::int64_t  m_live_bytes;
+
+public:
+    AllocationScope()
+        : m_allocations(AllocCounter::allocations().load()), m_live_bytes(AllocCounter::live_bytes().load()){};
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    std::uint64_t allocations() const {return AllocCounter::allocations().load() - m_allocations;}
+    // Heap bytes allocated and not yet freed since the scope opened, counted as malloc sees them (see AllocCounter). It
+    // is negative if the statement freed memory that was live before it.
+    std::int64_t live_bytes() const {return AllocCounter::live_bytes().load() - m_live_bytes;}
+};
+
+// EXPECT_ALLOCATIONS_AT_MOST(limit, statement) runs statement and fails the test, without stopping it, if statement
+// made more than limit allocations. statement can be a braced block, as in ASSERT_DEATH. ASSERT_ALLOCATIONS_AT_MOST
+// stops the test instead, and EXPECT_NO_ALLOCATIONS(statement) is the same check with a limit of 0. The counts are
+// taken before gtest builds any failure message, so the message's own allocations never count.
+#define DSA_ALLOCATIONS_AT_MOST_(check, limit, ...)                                                                    \
+    do{                                                                                                                \
+        std::uint64_t dsa_allocations_;                                                                                \
+        {                                                                                                              \
+            AllocationScope dsa_scope_;                                                                                \
+            __VA_ARGS__;                                                                                               \
+            dsa_allocations_ = dsa_scope_.allocations();                                                               \
+        }                                                                                                              \
+        check(dsa_allocations_, std::uint64_t(limit)) << "allocations made by " #__VA_ARGS__;                          \
+    }while(0)
+
+#define EXPECT_ALLOCATIONS_AT_MOST(limit, ...) DSA_ALLOCATIONS_AT_MOST_(EXPECT_LE, limit, __VA_ARGS__)
+#define ASSERT_ALLOCATIONS_AT_MOST(limit, ...) DSA_ALLOCATIONS_AT_MOST_(ASSERT_LE, limit, __VA_ARGS__)
+#define EXPECT_NO_ALLOCATIONS(...) DSA_ALLOCATIONS_AT_MOST_(EXPECT_LE, 0, __VA_ARGS__)
+
+// EXPECT_NO_LEAKS(statement) fails if statement leaves more heap bytes live than there were before it ran.
+#define EXPECT_NO_LEAKS(...)                                                                                           \
+    do{                                                                                                                \
+        std::int64_t dsa_live_bytes_;                                                                                  \
+        {                                                                                                              \
+            AllocationScope dsa_scope_;                                                                                \
+            __VA_ARGS__;                                                                                               \
+            dsa_live_bytes_ = dsa_scope_.live_bytes();                                                                 \
+        }                                                                                                              \
+        EXPECT_LE(dsa_live_bytes_, 0) << "heap bytes left live by " #__VA_ARGS__;                                      \
+    }while(0)
+
+#endif
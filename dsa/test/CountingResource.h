@@ -0,0 +1,40 @@
+#ifndef COUNTINGRESOURCE
+#define COUNTINGRESOURCE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+// CountingResource is a std::pmr::memory_resource for tests that check a container really allocates through the
+// Allocator it was given. It passes every request on to upstream and counts the allocations made and the bytes still
+// live. The counters are atomic, so it can be shared by the threads of a concurrent container as long as upstream can.
+class CountingResource : public std::pmr::memory_resource{
+private:
+    std::pmr::memory_resource* m_upstream;
+    std::atomic<std::uint64_t> m_allocations;
+    std::atomic<std::int64_t>  m_live_bytes;
+
+    void* do_allocate(std::size_t size, std::size_t alignment) override{
+        void* ptr = m_upstream->allocate(size, alignment);
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+        m_live_bytes.fetch_add(std::int64_t(size), std::memory_order_relaxed);
+        return ptr;
+    }
+    void do_deallocate(void* ptr, std::size_t size, std::size_t alignment) override{
+        m_live_bytes.fetch_sub(std::int64_t(size), std::memory_order_relaxed);
+        m_upstream->deallocate(ptr, size, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override{
+        return this == &other;
+    }
+
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : m_upstream(upstream), m_allocations(0), m_live_bytes(0){};
+
+    std::uint64_t allocations() const {return m_allocations.load();}
+    std::int64_t live_bytes() const {return m_live_bytes.load();}
+};
+
+#endif
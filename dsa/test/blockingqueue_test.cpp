@@ -0,0 +1,115 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "../src/include/BlockingQueue.h"
+#include "CountingResource.h"
+
+
+TEST(BlockingQueueTest, try_pop_on_empty_queue){
+    BlockingQueue<int> queue;
+    int value;
+    EXPECT_TRUE(queue.is_empty());
+    EXPECT_FALSE(queue.try_pop(value));
+    queue.push(3);
+    EXPECT_EQ(queue.size(), 1u);
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 3);
+}
+TEST(BlockingQueueTest, pop_for_times_out){
+    BlockingQueue<int> queue;
+    int value;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.pop_for(value, std::chrono::milliseconds(20)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+}
+TEST(BlockingQueueTest, pop_waits_for_producer){
+    BlockingQueue<int> queue;
+    std::thread producer([&]{
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        queue.push(7);
+    });
+    EXPECT_EQ(queue.pop(), 7);
+    producer.join();
+}
+TEST(BlockingQueueTest, pop_many_takes_what_is_there){
+    BlockingQueue<int> queue;
+    std::vector<int> values = {1, 2, 3, 4, 5};
+    queue.push_bulk(values.data(), values.size());
+    std::vector<int> out;
+    EXPECT_EQ(queue.pop_many(out, 3), 3u);
+    EXPECT_EQ(queue.pop_many(out, 10), 2u);
+    EXPECT_EQ(out, values);
+}
+TEST(BlockingQueueTest, every_parked_consumer_is_woken){
+    // Several consumers park on an empty queue, then items arrive one push at a time. Only the first push sees the
+    // queue empty, so the rest of the consumers must be woken by the cascade from consumers that found more work.
+    BlockingQueue<int> queue;
+    const int consumers = 4;
+    std::atomic<int> received(0);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < consumers; ++i){
+        threads.emplace_back([&]{
+            queue.pop();
+            received++;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for(int i = 0; i < consumers; ++i){
+        queue.push(i);
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    EXPECT_EQ(received.load(), consumers);
+    EXPECT_TRUE(queue.is_empty());
+}
+TEST(BlockingQueueTest, producers_and_consumers){
+    BlockingQueue<std::uint64_t> queue;
+    const int producers = 3, consumers = 3;
+    const std::uint64_t per_producer = 20000;
+    std::atomic<std::uint64_t> sum(0);
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p){
+        threads.emplace_back([&]{
+            for(std::uint64_t i = 1; i <= per_producer; ++i){
+                queue.push(i);
+            }
+        });
+    }
+    for(int c = 0; c < consumers; ++c){
+        threads.emplace_back([&]{
+            std::vector<std::uint64_t> batch;
+            for(std::uint64_t taken = 0; taken < per_producer;){
+                batch.clear();
+                taken += queue.pop_many(batch, per_producer - taken);
+                for(std::uint64_t value : batch){
+                    sum += value;
+                }
+            }
+        });
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    EXPECT_EQ(sum.load(), producers * per_producer * (per_producer + 1) / 2);
+}
+TEST(BlockingQueueTest, allocates_through_allocator){
+    CountingResource resource;
+    {
+        BlockingQueue<int, std::pmr::polymorphic_allocator<int>> queue(&resource);
+        std::vector<int> values(100, 7);
+        queue.push_bulk(values.data(), values.size());
+        queue.push(8);
+        EXPECT_EQ(queue.get_allocator().resource(), &resource);
+        EXPECT_GT(resource.allocations(), 0u);
+        std::vector<int> out;
+        EXPECT_EQ(queue.pop_many(out, 1000), 101u);
+        EXPECT_EQ(out.back(), 8);
+    }
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
@@ -0,0 +1,125 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "../src/include/BroadcastRing.h"
+#include "CountingResource.h"
+
+
+TEST(BroadcastRingTest, capacity_rounds_up){
+    EXPECT_EQ((BroadcastRing<int>(5).capacity()), 8u);
+    EXPECT_EQ((BroadcastRing<int>(64).capacity()), 64u);
+}
+TEST(BroadcastRingTest, every_consumer_sees_every_event){
+    BroadcastRing<int> ring(8);
+    auto first = ring.add_consumer();
+    auto second = ring.add_consumer();
+    for(int i = 0; i < 5; ++i){
+        ring.push(i);
+    }
+    std::vector<int> seen;
+    auto record = [&](const int& value, std::int64_t){seen.push_back(value);};
+    EXPECT_EQ(first.consume(record), 5u);
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 3, 4}));
+    seen.clear();
+    EXPECT_EQ(second.consume(record, 2), 2u);
+    EXPECT_EQ(second.consume(record), 3u);
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(first.try_consume(record), 0u);
+}
+TEST(BroadcastRingTest, consumers_read_in_place){
+    BroadcastRing<int> ring(4);
+    auto first = ring.add_consumer();
+    auto second = ring.add_consumer();
+    ring.push(42);
+    const int* a = nullptr;
+    const int* b = nullptr;
+    first.consume([&](const int& value, std::int64_t){a = &value;});
+    second.consume([&](const int& value, std::int64_t){b = &value;});
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a, &ring[0]);
+}
+TEST(BroadcastRingTest, producer_is_gated_by_slowest_consumer){
+    BroadcastRing<int> ring(4);
+    auto fast = ring.add_consumer();
+    auto slow = ring.add_consumer();
+    std::int64_t first;
+    EXPECT_TRUE(ring.try_claim(4, first));
+    EXPECT_EQ(first, 0);
+    for(int i = 0; i < 4; ++i){
+        ring[first + i] = i;
+    }
+    ring.publish(first + 3);
+    fast.consume([](const int&, std::int64_t){});
+    EXPECT_FALSE(ring.try_claim(1, first));
+    slow.consume([](const int&, std::int64_t){}, 1);
+    EXPECT_TRUE(ring.try_claim(1, first));
+    EXPECT_EQ(first, 4);
+    EXPECT_FALSE(ring.try_claim(1, first));
+}
+
+template <class WaitStrategy>
+static void run_threads(){
+    const int consumers = 3;
+    const std::uint64_t events = 200000;
+    BroadcastRing<std::uint64_t, WaitStrategy> ring(64);
+    std::vector<typename BroadcastRing<std::uint64_t, WaitStrategy>::Consumer> handles;
+    for(int c = 0; c < consumers; ++c){
+        handles.push_back(ring.add_consumer());
+    }
+    std::vector<std::uint64_t> sums(consumers, 0);
+    std::vector<bool> in_order(consumers, true);
+    std::vector<std::thread> threads;
+    for(int c = 0; c < consumers; ++c){
+        threads.emplace_back([&, c]{
+            std::uint64_t expected = 1;
+            while(expected <= events){
+                handles[c].consume([&](const std::uint64_t& value, std::int64_t){
+                    if(value != expected){
+                        in_order[c] = false;
+                    }
+                    sums[c] += value;
+                    expected++;
+                });
+            }
+        });
+    }
+    for(std::uint64_t value = 1; value <= events;){
+        std::size_t batch = std::min<std::uint64_t>(16, events - value + 1);
+        std::int64_t first = ring.claim(batch);
+        for(std::size_t i = 0; i < batch; ++i){
+            ring[first + std::int64_t(i)] = value++;
+        }
+        ring.publish(first + std::int64_t(batch) - 1);
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    for(int c = 0; c < consumers; ++c){
+        EXPECT_TRUE(in_order[c]);
+        EXPECT_EQ(sums[c], events * (events + 1) / 2);
+    }
+}
+TEST(BroadcastRingTest, threads_with_yielding_wait){
+    run_threads<YieldingWait>();
+}
+TEST(BroadcastRingTest, threads_with_blocking_wait){
+    run_threads<BlockingWait>();
+}
+TEST(BroadcastRingTest, allocates_through_allocator){
+    CountingResource resource;
+    {
+        BroadcastRing<std::vector<int>, YieldingWait, std::pmr::polymorphic_allocator<std::vector<int>>> ring(8, &resource);
+        EXPECT_EQ(ring.get_allocator().resource(), &resource);
+        EXPECT_EQ(resource.allocations(), 1u);
+        auto consumer = ring.add_consumer();
+        ring.push(std::vector<int>{1, 2, 3});
+        std::size_t size = 0;
+        consumer.consume([&](const std::vector<int>& value, std::int64_t){size = value.size();});
+        EXPECT_EQ(size, 3u);
+    }
+    // The slots are destroyed with the ring, so the vector left in one is freed too.
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
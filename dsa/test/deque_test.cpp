@@ -0,0 +1,117 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/include/Deque.h"
+
+
+TEST(DequeTest, create_empty_deque){
+    Deque<int> deque;
+    EXPECT_TRUE(deque.is_empty());
+    EXPECT_EQ(deque.size(), 0u);
+    ASSERT_DEATH({deque.pop_front();}, "Deque underflow would occur with pop_front");
+    ASSERT_DEATH({deque.pop_back();}, "Deque underflow would occur with pop_back");
+}
+TEST(DequeTest, default_block_size){
+    struct Big{char m_bytes[1024];};
+    EXPECT_EQ(Deque<int>::block_size(), 1024u);
+    EXPECT_EQ(Deque<Big>::block_size(), 16u);
+    EXPECT_EQ((Deque<int, 4>::block_size()), 4u);
+}
+TEST(DequeTest, both_ends){
+    Deque<int, 4> deque;
+    for(int i = 0; i < 10; ++i){
+        deque.push_back(i);
+        deque.push_front(-i - 1);
+    }
+    EXPECT_EQ(deque.size(), 20u);
+    for(int i = 0; i < 20; ++i){
+        EXPECT_EQ(deque[i], i - 10);
+    }
+    EXPECT_EQ(deque.front(), -10);
+    EXPECT_EQ(deque.back(), 9);
+    EXPECT_EQ(deque.pop_front(), -10);
+    EXPECT_EQ(deque.pop_back(), 9);
+    EXPECT_EQ(deque.size(), 18u);
+}
+TEST(DequeTest, references_stay_valid){
+    Deque<std::string, 4> deque;
+    deque.push_back("middle");
+    std::string* middle = &deque[0];
+    for(int i = 0; i < 1000; ++i){
+        deque.push_back(std::to_string(i));
+        deque.push_front(std::to_string(-i));
+    }
+    EXPECT_EQ(middle, &deque[1000]);
+    EXPECT_EQ(*middle, "middle");
+    for(int i = 0; i < 1000; ++i){
+        deque.pop_front();
+    }
+    EXPECT_EQ(middle, &deque.front());
+}
+TEST(DequeTest, queue_usage_drifts_through_map){
+    // Pushing at the back and popping at the front walks the elements through the map, which must be recentred rather
+    // than grown without bound.
+    Deque<int, 4> deque;
+    for(int i = 0; i < 100000; ++i){
+        deque.push_back(i);
+        if(i >= 10){
+            EXPECT_EQ(deque.pop_front(), i - 10);
+        }
+    }
+    EXPECT_EQ(deque.size(), 10u);
+    EXPECT_EQ(deque[0], 99990);
+}
+TEST(DequeTest, matches_std_deque){
+    std::mt19937 rng(17);
+    Deque<int, 8> deque;
+    std::deque<int> expected;
+    for(int i = 0; i < 100000; ++i){
+        switch(rng() % 5){
+        case 0: case 1:
+            deque.push_back(i);
+            expected.push_back(i);
+            break;
+        case 2:
+            deque.push_front(i);
+            expected.push_front(i);
+            break;
+        case 3:
+            if(!expected.empty()){
+                EXPECT_EQ(deque.pop_back(), expected.back());
+                expected.pop_back();
+            }
+            break;
+        case 4:
+            if(!expected.empty()){
+                EXPECT_EQ(deque.pop_front(), expected.front());
+                expected.pop_front();
+            }
+            break;
+        }
+        ASSERT_EQ(deque.size(), expected.size());
+    }
+    for(std::size_t i = 0; i < expected.size(); ++i){
+        ASSERT_EQ(deque[i], expected[i]);
+    }
+}
+TEST(DequeTest, copy_move_and_destroy){
+    std::shared_ptr<int> counted = std::make_shared<int>(0);
+    {
+        Deque<std::shared_ptr<int>, 2> deque;
+        for(int i = 0; i < 5; ++i){
+            deque.push_back(counted);
+        }
+        Deque<std::shared_ptr<int>, 2> copy(deque);
+        EXPECT_EQ(counted.use_count(), 11);
+        Deque<std::shared_ptr<int>, 2> moved(std::move(copy));
+        EXPECT_TRUE(copy.is_empty());
+        EXPECT_EQ(moved.size(), 5u);
+        moved.clear();
+        EXPECT_EQ(counted.use_count(), 6);
+    }
+    EXPECT_EQ(counted.use_count(), 1);
+}
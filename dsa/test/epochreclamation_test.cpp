@@ -0,0 +1,158 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../src/include/EpochReclamation.h"
+
+
+// Tracked objects aren't deleted by the domain, only marked as freed, so that a reader which still holds one after it
+// was freed can be detected without reading freed memory, and an object freed twice shows up as a count of two.
+struct Tracked{
+    std::atomic<int> m_frees{0};
+    std::uint64_t    m_value = 0;
+
+    static void mark_freed(void* ptr){
+        static_cast<Tracked*>(ptr)->m_frees++;
+    }
+};
+
+
+TEST(EpochReclamationTest, retired_objects_are_freed_by_reclaim){
+    EpochDomain domain;
+    static int deleted;
+    deleted = 0;
+    struct Counted{
+        ~Counted() {deleted++;}
+    };
+    for(int i = 0; i < 10; ++i){
+        domain.retire(new Counted());
+    }
+    EXPECT_EQ(domain.pending(), 10u);
+    domain.reclaim();
+    EXPECT_EQ(domain.pending(), 0u);
+    EXPECT_EQ(deleted, 10);
+    for(int i = 0; i < 5; ++i){
+        domain.retire(new Counted());
+    }
+    // The domain's destructor frees whatever is still pending.
+}
+TEST(EpochReclamationTest, reader_holds_back_reclamation){
+    EpochDomain domain;
+    Tracked object;
+    std::atomic<int> stage(0);
+    std::thread reader([&]{
+        EpochGuard guard(domain);
+        stage = 1;
+        while(stage.load() != 2){
+            std::this_thread::yield();
+        }
+    });
+    while(stage.load() != 1){
+        std::this_thread::yield();
+    }
+    domain.retire(&object, Tracked::mark_freed);
+    for(int i = 0; i < 10; ++i){
+        domain.try_advance();
+    }
+    // The epoch can move at most one past the reader's, which isn't enough to free the object.
+    EXPECT_EQ(object.m_frees.load(), 0);
+    EXPECT_EQ(domain.pending(), 1u);
+    stage = 2;
+    reader.join();
+    domain.reclaim();
+    EXPECT_EQ(object.m_frees.load(), 1);
+}
+TEST(EpochReclamationTest, nested_guards){
+    EpochDomain domain;
+    Tracked object;
+    std::atomic<int> stage(0);
+    std::thread reader([&]{
+        EpochGuard outer(domain);
+        {
+            EpochGuard inner(domain);
+        }
+        // Leaving the inner guard must not end the critical section.
+        stage = 1;
+        while(stage.load() != 2){
+            std::this_thread::yield();
+        }
+    });
+    while(stage.load() != 1){
+        std::this_thread::yield();
+    }
+    domain.retire(&object, Tracked::mark_freed);
+    for(int i = 0; i < 10; ++i){
+        domain.try_advance();
+    }
+    EXPECT_EQ(object.m_frees.load(), 0);
+    stage = 2;
+    reader.join();
+    domain.reclaim();
+    EXPECT_EQ(object.m_frees.load(), 1);
+}
+TEST(EpochReclamationTest, readers_never_see_freed_objects){
+    // Declared before the domain so the objects outlive the domain's final frees.
+    std::vector<std::unique_ptr<Tracked>> all;
+    std::mutex all_mutex;
+    EpochDomain domain;
+    auto make = [&](std::uint64_t value){
+        Tracked* object = new Tracked();
+        object->m_value = value;
+        std::lock_guard<std::mutex> lock(all_mutex);
+        all.emplace_back(object);
+        return object;
+    };
+    std::atomic<Tracked*> shared(make(0));
+    std::atomic<bool> done(false);
+    std::atomic<std::uint64_t> violations(0), reads(0);
+    std::vector<std::thread> threads;
+    for(int r = 0; r < 4; ++r){
+        threads.emplace_back([&]{
+            while(!done.load(std::memory_order_relaxed)){
+                {
+                    EpochGuard guard(domain);
+                    Tracked* object = shared.load(std::memory_order_acquire);
+                    for(int i = 0; i < 10; ++i){
+                        if(object->m_frees.load() != 0){
+                            violations++;
+                        }
+                    }
+                    reads++;
+                }
+                // Readers spend time outside critical sections too, which is when the epoch can move on.
+                std::this_thread::yield();
+            }
+        });
+    }
+    for(int w = 0; w < 2; ++w){
+        threads.emplace_back([&, w]{
+            for(std::uint64_t i = 1; i <= 20000; ++i){
+                EpochGuard guard(domain);
+                Tracked* old = shared.exchange(make(std::uint64_t(w) << 32 | i), std::memory_order_acq_rel);
+                domain.retire(old, Tracked::mark_freed);
+            }
+            // Outside the guard, so this waits only for the readers' current critical sections.
+            domain.reclaim();
+        });
+    }
+    for(std::size_t t = 4; t < threads.size(); ++t){
+        threads[t].join();
+    }
+    done = true;
+    for(int r = 0; r < 4; ++r){
+        threads[std::size_t(r)].join();
+    }
+    EXPECT_EQ(violations.load(), 0u);
+    EXPECT_GT(domain.epoch(), 0u);
+    // Each writer reclaimed its own retirements before exiting, so every one of the 40000 replaced objects has been
+    // freed, exactly once, and the object still published has not.
+    ASSERT_EQ(all.size(), 40001u);
+    Tracked* current = shared.load();
+    for(const std::unique_ptr<Tracked>& object : all){
+        EXPECT_EQ(object->m_frees.load(), object.get() == current ? 0 : 1) << object->m_value;
+    }
+}
@@ -0,0 +1,248 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../src/include/ExternalSort.h"
+
+
+struct Record{
+    std::uint64_t m_key;
+    std::uint64_t m_value;
+};
+
+static bool key_less(const Record& a, const Record& b) {return a.m_key < b.m_key;}
+typedef bool (*RecordCompare)(const Record&, const Record&);
+
+class ExternalSortFiles{
+public:
+    std::filesystem::path m_directory;
+
+    ExternalSortFiles(){
+        m_directory = std::filesystem::temp_directory_path() /
+                      ("dsa_external_sort_test_" + std::to_string(getpid()));
+        std::filesystem::remove_all(m_directory);
+        std::filesystem::create_directories(m_directory);
+    }
+    ~ExternalSortFiles(){
+        std::filesystem::remove_all(m_directory);
+    }
+
+    std::string path(const char* name) const {return (m_directory / name).string();}
+    std::size_t file_count() const{
+        return std::size_t(std::distance(std::filesystem::directory_iterator(m_directory),
+                                         std::filesystem::directory_iterator()));
+    }
+};
+
+// Records with keys in [0, range) and each value its position in the file, so a stable sort leaves values increasing
+// within a key.
+static std::vector<Record> write_records(const std::string& path, std::size_t count, std::uint64_t range){
+    std::mt19937_64 rng(count);
+    std::vector<Record> records(count);
+    for(std::size_t i = 0; i < count; ++i){
+        records[i] = Record{rng() % range, i};
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(records.data()), std::streamsize(count * sizeof(Record)));
+    return records;
+}
+
+static std::vector<Record> read_records(const std::string& path){
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    std::size_t bytes = std::size_t(file.tellg());
+    std::vector<Record> records(bytes / sizeof(Record));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(records.data()), std::streamsize(bytes));
+    return records;
+}
+
+static bool same_records(const std::vector<Record>& a, const std::vector<Record>& b){
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const Record& x, const Record& y){
+        return x.m_key == y.m_key && x.m_value == y.m_value;
+    });
+}
+
+
+TEST(ExternalSortTest, loser_tree_merges){
+    std::mt19937 rng(1);
+    for(std::size_t sources : {1, 2, 3, 5, 8, 13}){
+        std::vector<std::vector<int>> sequences(sources);
+        std::vector<int> expected;
+        for(std::vector<int>& sequence : sequences){
+            // Some sequences are empty, and values repeat across sequences.
+            sequence.resize(rng() % 50);
+            for(int& value : sequence){
+                value = int(rng() % 40);
+            }
+            std::sort(sequence.begin(), sequence.end());
+            expected.insert(expected.end(), sequence.begin(), sequence.end());
+        }
+        std::sort(expected.begin(), expected.end());
+
+        LoserTree<int> tree(sources);
+        std::vector<std::size_t> positions(sources, 0);
+        for(std::size_t i = 0; i < sources; ++i){
+            tree.set(i, sequences[i].empty() ? nullptr : &sequences[i][0]);
+        }
+        tree.build();
+        std::vector<int> merged;
+        std::size_t previous_source = 0;
+        while(!tree.is_empty()){
+            std::size_t source = tree.winner();
+            // Ties go to the lowest numbered sequence.
+            if(!merged.empty() && merged.back() == *tree.top()){
+                EXPECT_GE(source, previous_source);
+            }
+            merged.push_back(*tree.top());
+            previous_source = source;
+            std::size_t next = ++positions[source];
+            tree.replace(next < sequences[source].size() ? &sequences[source][next] : nullptr);
+        }
+        EXPECT_EQ(merged, expected) << sources << " sequences";
+    }
+}
+TEST(ExternalSortTest, async_io_round_trip){
+    ExternalSortFiles files;
+    int fd = open(files.path("io").c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    AsyncIo io;
+    std::vector<char> out(100000, 'x'), in(200000, 0);
+    std::future<std::size_t> written = io.write(fd, out.data(), out.size(), 0);
+    // Requests run in order, so the read sees the write, and stops short at the end of the file.
+    std::future<std::size_t> read = io.read(fd, in.data(), in.size(), 0);
+    EXPECT_EQ(written.get(), out.size());
+    EXPECT_EQ(read.get(), out.size());
+    EXPECT_EQ(std::count(in.begin(), in.end(), 'x'), std::ptrdiff_t(out.size()));
+    close(fd);
+
+    std::future<std::size_t> failed = io.read(-5, in.data(), 16, 0);
+    EXPECT_THROW(failed.get(), std::system_error);
+}
+TEST(ExternalSortTest, run_reader_and_writer){
+    ExternalSortFiles files;
+    int fd = open(files.path("run").c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    AsyncIo io;
+    {
+        RunWriter<std::uint32_t> writer(io, fd, 0, 7);
+        for(std::uint32_t i = 0; i < 1000; ++i){
+            writer.push(i);
+        }
+        writer.finish();
+    }
+    RunReader<std::uint32_t> reader(io, fd, 40, 500, 7);
+    for(std::uint32_t i = 10; i < 510; ++i){
+        ASSERT_NE(reader.current(), nullptr);
+        EXPECT_EQ(*reader.current(), i);
+        reader.advance();
+    }
+    EXPECT_EQ(reader.current(), nullptr);
+    close(fd);
+}
+TEST(ExternalSortTest, fits_in_memory){
+    ExternalSortFiles files;
+    std::vector<Record> records = write_records(files.path("input"), 10000, 1000);
+    ExternalSortOptions options;
+    options.memory_budget = 1 << 20;
+    options.temp_directory = files.m_directory.string();
+    ExternalSortStats stats = external_sort<Record, RecordCompare>(files.path("input"), files.path("output"), options,
+                                                                   key_less);
+    EXPECT_EQ(stats.records, 10000u);
+    EXPECT_EQ(stats.runs, 1u);
+    EXPECT_EQ(stats.merge_passes, 0u);
+    std::vector<Record> sorted = read_records(files.path("output"));
+    ASSERT_EQ(sorted.size(), records.size());
+    EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end(), key_less));
+    EXPECT_EQ(files.file_count(), 2u);
+}
+TEST(ExternalSortTest, one_merge_pass){
+    ExternalSortFiles files;
+    std::vector<Record> records = write_records(files.path("input"), 12000, std::uint64_t(1) << 62);
+    ExternalSortOptions options;
+    options.memory_budget = 64 << 10;
+    options.block_size = 4 << 10;
+    options.temp_directory = files.m_directory.string();
+    ExternalSorter<Record, RecordCompare> sorter(options, key_less);
+    EXPECT_EQ(sorter.fan_in(), 7u);
+    ExternalSortStats stats = sorter.sort(files.path("input"), files.path("output"));
+    // The input doesn't fit in one run, so runs are 64K / (2 * 16) = 2048 records. The keys are all distinct, so the
+    // output is exactly a sort of the input.
+    EXPECT_EQ(stats.runs, 6u);
+    EXPECT_EQ(stats.merge_passes, 1u);
+    EXPECT_EQ(stats.bytes_written, 2 * 12000 * sizeof(Record));
+    std::stable_sort(records.begin(), records.end(), key_less);
+    EXPECT_TRUE(same_records(read_records(files.path("output")), records));
+    // Temporary files were unlinked.
+    EXPECT_EQ(files.file_count(), 2u);
+}
+TEST(ExternalSortTest, several_merge_passes){
+    ExternalSortFiles files;
+    // Few distinct keys, so ties are common.
+    std::vector<Record> records = write_records(files.path("input"), 90000, 50);
+    ExternalSortOptions options;
+    options.memory_budget = 64 << 10;
+    options.block_size = 4 << 10;
+    options.temp_directory = files.m_directory.string();
+    ExternalSortStats stats = external_sort<Record, RecordCompare>(files.path("input"), files.path("output"), options,
+                                                                   key_less);
+    // 44 runs of 2048 records with a fan in of 7 take ceil(log7(44)) = 2 passes. The first merge takes (44 - 2) % 6 + 2
+    // = 2 runs, so that the 43 left merge as 6 full merges and a last one of 6 + 1.
+    EXPECT_EQ(stats.runs, 44u);
+    EXPECT_EQ(stats.fan_in, 7u);
+    EXPECT_EQ(stats.merge_passes, 2u);
+    std::vector<Record> sorted = read_records(files.path("output"));
+    ASSERT_EQ(sorted.size(), records.size());
+    EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end(), key_less));
+    std::sort(sorted.begin(), sorted.end(), [](const Record& a, const Record& b){return a.m_value < b.m_value;});
+    EXPECT_TRUE(same_records(sorted, records));
+    EXPECT_EQ(files.file_count(), 2u);
+}
+TEST(ExternalSortTest, parallel_run_sorting){
+    ExternalSortFiles files;
+    std::vector<std::uint64_t> keys(300000);
+    std::mt19937_64 rng(5);
+    for(std::uint64_t& key : keys){
+        key = rng();
+    }
+    std::ofstream(files.path("input"), std::ios::binary)
+        .write(reinterpret_cast<const char*>(keys.data()), std::streamsize(keys.size() * sizeof(std::uint64_t)));
+    ExternalSortOptions options;
+    // Runs of 4M / (2 * 8 + 10) = 161319 records, enough for parallel_sample_sort to split between the threads.
+    options.memory_budget = 4 << 20;
+    options.threads = 2;
+    options.temp_directory = files.m_directory.string();
+    ExternalSortStats stats = external_sort<std::uint64_t>(files.path("input"), files.path("output"), options);
+    EXPECT_EQ(stats.runs, 2u);
+    std::vector<std::uint64_t> sorted(keys.size());
+    std::ifstream(files.path("output"), std::ios::binary)
+        .read(reinterpret_cast<char*>(sorted.data()), std::streamsize(sorted.size() * sizeof(std::uint64_t)));
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(sorted, keys);
+}
+TEST(ExternalSortTest, empty_and_bad_input){
+    ExternalSortFiles files;
+    std::ofstream(files.path("empty"));
+    ExternalSortOptions options;
+    options.temp_directory = files.m_directory.string();
+    ExternalSortStats stats = external_sort<Record, RecordCompare>(files.path("empty"), files.path("output"), options,
+                                                                   key_less);
+    EXPECT_EQ(stats.records, 0u);
+    EXPECT_TRUE(read_records(files.path("output")).empty());
+
+    std::ofstream(files.path("ragged")) << "not a whole record";
+    EXPECT_THROW((external_sort<Record, RecordCompare>(files.path("ragged"), files.path("output"), options, key_less)),
+                 std::invalid_argument);
+    EXPECT_THROW((external_sort<Record, RecordCompare>(files.path("missing"), files.path("output"), options,
+                                                       key_less)),
+                 std::system_error);
+}
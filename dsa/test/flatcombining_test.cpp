@@ -0,0 +1,98 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "../src/include/FlatCombining.h"
+
+
+TEST(FlatCombiningTest, thread_indices_are_unique_and_reused){
+    std::size_t main_index = thread_index();
+    EXPECT_EQ(thread_index(), main_index);
+    std::vector<std::size_t> indices(8);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 8; ++i){
+        threads.emplace_back([&, i]{indices[i] = thread_index();});
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    // The threads may have run one after another and reused each other's index, but never the main thread's.
+    for(std::size_t index : indices){
+        EXPECT_NE(index, main_index);
+        EXPECT_LT(index, thread_index_limit().load());
+    }
+    std::size_t reused;
+    std::thread([&]{reused = thread_index();}).join();
+    std::thread([&]{EXPECT_EQ(thread_index(), reused);}).join();
+}
+TEST(FlatCombiningTest, queue_is_fifo){
+    FlatCombiningQueue<int> queue;
+    int value;
+    EXPECT_FALSE(queue.try_dequeue(value));
+    for(int i = 0; i < 100; ++i){
+        queue.enqueue(i);
+    }
+    for(int i = 0; i < 100; ++i){
+        EXPECT_TRUE(queue.try_dequeue(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.try_dequeue(value));
+}
+TEST(FlatCombiningTest, stack_is_lifo){
+    FlatCombiningStack<int> stack;
+    int value;
+    EXPECT_FALSE(stack.try_pop(value));
+    for(int i = 0; i < 100; ++i){
+        stack.push(i);
+    }
+    for(int i = 99; i >= 0; --i){
+        EXPECT_TRUE(stack.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(stack.try_pop(value));
+}
+
+template <class Structure, class Push, class Pop>
+static void hammer(Structure& structure, Push push, Pop pop){
+    const int threads = 8;
+    const std::uint64_t per_thread = 20000;
+    std::atomic<std::uint64_t> pushed_sum(0), popped_sum(0), popped(0);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&, t]{
+            for(std::uint64_t i = 1; i <= per_thread; ++i){
+                std::uint64_t value = std::uint64_t(t) * per_thread + i;
+                push(structure, value);
+                pushed_sum += value;
+                std::uint64_t out;
+                if(pop(structure, out)){
+                    popped_sum += out;
+                    popped++;
+                }
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    std::uint64_t out;
+    while(pop(structure, out)){
+        popped_sum += out;
+        popped++;
+    }
+    EXPECT_EQ(popped.load(), threads * per_thread);
+    EXPECT_EQ(popped_sum.load(), pushed_sum.load());
+}
+TEST(FlatCombiningTest, concurrent_queue){
+    FlatCombiningQueue<std::uint64_t> queue;
+    hammer(queue, [](FlatCombiningQueue<std::uint64_t>& q, std::uint64_t v){q.enqueue(v);},
+                  [](FlatCombiningQueue<std::uint64_t>& q, std::uint64_t& v){return q.try_dequeue(v);});
+}
+TEST(FlatCombiningTest, concurrent_stack){
+    FlatCombiningStack<std::uint64_t> stack;
+    hammer(stack, [](FlatCombiningStack<std::uint64_t>& s, std::uint64_t v){s.push(v);},
+                  [](FlatCombiningStack<std::uint64_t>& s, std::uint64_t& v){return s.try_pop(v);});
+}
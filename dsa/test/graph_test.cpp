@@ -0,0 +1,173 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "../src/include/Graph.h"
+
+
+typedef CsrGraph::Vertex Vertex;
+
+static std::vector<CsrGraph::Edge> random_edges(Vertex vertices, std::size_t count, std::uint32_t max_weight,
+                                                unsigned seed){
+    std::mt19937 rng(seed);
+    std::vector<CsrGraph::Edge> edges(count);
+    for(CsrGraph::Edge& edge : edges){
+        edge.m_from = Vertex(rng() % vertices);
+        edge.m_to = Vertex(rng() % vertices);
+        edge.m_weight = 1 + std::uint32_t(rng() % max_weight);
+    }
+    return edges;
+}
+
+// Recursive depth first search, to check the iterative one against.
+static void recursive_order(const CsrGraph& graph, Vertex vertex, std::vector<bool>& visited,
+                            std::vector<Vertex>& order){
+    visited[vertex] = true;
+    order.push_back(vertex);
+    for(Vertex next : graph.neighbors(vertex)){
+        if(!visited[next]){
+            recursive_order(graph, next, visited, order);
+        }
+    }
+}
+
+static std::vector<std::uint64_t> bellman_ford(const CsrGraph& graph, Vertex source){
+    std::vector<std::uint64_t> distances(graph.vertex_count(), INFINITE_DISTANCE);
+    distances[source] = 0;
+    for(bool changed = true; changed;){
+        changed = false;
+        for(Vertex v = 0; v < graph.vertex_count(); ++v){
+            if(distances[v] == INFINITE_DISTANCE){
+                continue;
+            }
+            for(CsrGraph::EdgeIndex edge = graph.first_edge(v); edge < graph.end_edge(v); ++edge){
+                if(distances[v] + graph.weight(edge) < distances[graph.target(edge)]){
+                    distances[graph.target(edge)] = distances[v] + graph.weight(edge);
+                    changed = true;
+                }
+            }
+        }
+    }
+    return distances;
+}
+
+
+TEST(GraphTest, build_from_edges){
+    CsrGraph graph(4, {{0, 1}, {0, 2}, {2, 3}, {1, 2}, {0, 3}});
+    EXPECT_EQ(graph.vertex_count(), 4u);
+    EXPECT_EQ(graph.edge_count(), 5u);
+    EXPECT_FALSE(graph.is_weighted());
+    EXPECT_EQ(graph.degree(0), 3u);
+    EXPECT_EQ(graph.degree(3), 0u);
+    // Each vertex keeps its edges in the order they were given.
+    std::vector<Vertex> zero(graph.neighbors(0).begin(), graph.neighbors(0).end());
+    EXPECT_EQ(zero, (std::vector<Vertex>{1, 2, 3}));
+    EXPECT_EQ(graph.weight(graph.first_edge(0)), 1u);
+
+    CsrGraph empty;
+    EXPECT_EQ(empty.vertex_count(), 0u);
+    EXPECT_EQ(empty.edge_count(), 0u);
+}
+TEST(GraphTest, symmetric_and_weighted){
+    CsrGraph graph(3, {{0, 1, 5}, {1, 2, 7}}, CsrGraph::SYMMETRIC | CsrGraph::WEIGHTED);
+    EXPECT_EQ(graph.edge_count(), 4u);
+    EXPECT_TRUE(graph.is_weighted());
+    ASSERT_EQ(graph.degree(1), 2u);
+    EXPECT_EQ(graph.target(graph.first_edge(1)), 0u);
+    EXPECT_EQ(graph.weight(graph.first_edge(1)), 5u);
+    EXPECT_EQ(graph.target(graph.first_edge(1) + 1), 2u);
+    EXPECT_EQ(graph.weight(graph.first_edge(1) + 1), 7u);
+}
+TEST(GraphTest, transpose){
+    CsrGraph graph(500, random_edges(500, 3000, 9, 1), CsrGraph::WEIGHTED);
+    CsrGraph reversed = graph.transpose();
+    ASSERT_EQ(reversed.edge_count(), graph.edge_count());
+    std::vector<std::tuple<Vertex, Vertex, std::uint32_t>> forward, backward;
+    for(Vertex v = 0; v < graph.vertex_count(); ++v){
+        for(CsrGraph::EdgeIndex edge = graph.first_edge(v); edge < graph.end_edge(v); ++edge){
+            forward.emplace_back(v, graph.target(edge), graph.weight(edge));
+        }
+        for(CsrGraph::EdgeIndex edge = reversed.first_edge(v); edge < reversed.end_edge(v); ++edge){
+            backward.emplace_back(reversed.target(edge), v, reversed.weight(edge));
+        }
+    }
+    std::sort(forward.begin(), forward.end());
+    std::sort(backward.begin(), backward.end());
+    EXPECT_EQ(forward, backward);
+}
+TEST(GraphTest, breadth_first_search){
+    //  0 -> 1 -> 2 -> 3
+    //  0 -> 4 -> 3,  5 unreachable
+    CsrGraph graph(6, {{0, 1}, {1, 2}, {2, 3}, {0, 4}, {4, 3}, {5, 0}});
+    std::vector<std::uint32_t> depths = breadth_first_search(graph, 0);
+    EXPECT_EQ(depths, (std::vector<std::uint32_t>{0, 1, 2, 2, 1, UNREACHED}));
+    ASSERT_DEATH({breadth_first_search(graph, 6);}, "breadth_first_search source out of range");
+}
+TEST(GraphTest, depth_first_order_matches_recursion){
+    CsrGraph graph(2000, random_edges(2000, 5000, 1, 2));
+    std::vector<bool> visited(graph.vertex_count(), false);
+    std::vector<Vertex> expected;
+    recursive_order(graph, 0, visited, expected);
+    EXPECT_EQ(depth_first_order(graph, 0), expected);
+}
+TEST(GraphTest, depth_first_order_long_path){
+    // Deep enough that a recursive search would be at risk of running out of stack.
+    const Vertex vertices = 1000000;
+    std::vector<CsrGraph::Edge> edges;
+    for(Vertex v = 0; v + 1 < vertices; ++v){
+        edges.push_back(CsrGraph::Edge{v, v + 1});
+    }
+    std::vector<Vertex> order = depth_first_order(CsrGraph(vertices, edges), 0);
+    ASSERT_EQ(order.size(), vertices);
+    EXPECT_EQ(order.back(), vertices - 1);
+}
+TEST(GraphTest, dijkstra_matches_bellman_ford){
+    for(unsigned seed = 0; seed < 5; ++seed){
+        CsrGraph graph(300, random_edges(300, 1500, 100, seed), CsrGraph::WEIGHTED);
+        EXPECT_EQ(dijkstra(graph, 0), bellman_ford(graph, 0));
+    }
+    // Unweighted, Dijkstra is breadth first search.
+    CsrGraph graph(300, random_edges(300, 900, 1, 7));
+    std::vector<std::uint32_t> depths = breadth_first_search(graph, 0);
+    std::vector<std::uint64_t> distances = dijkstra(graph, 0);
+    for(Vertex v = 0; v < graph.vertex_count(); ++v){
+        EXPECT_EQ(distances[v], depths[v] == UNREACHED ? INFINITE_DISTANCE : depths[v]);
+    }
+}
+TEST(GraphTest, parallel_matches_serial_directed){
+    CsrGraph graph(20000, random_edges(20000, 160000, 1, 3));
+    CsrGraph reversed = graph.transpose();
+    std::vector<std::uint32_t> expected = breadth_first_search(graph, 0);
+    for(std::size_t threads : {1, 2, 4}){
+        EXPECT_EQ(parallel_breadth_first_search(graph, reversed, 0, threads), expected) << threads << " threads";
+        EXPECT_EQ(parallel_breadth_first_search(graph, reversed, 0, threads, false), expected) << threads << " threads";
+    }
+}
+TEST(GraphTest, parallel_matches_serial_symmetric){
+    // Dense enough that the middle levels run bottom up, and sized so the last bitmap word is partial.
+    CsrGraph graph(30001, random_edges(30001, 300000, 1, 4), CsrGraph::SYMMETRIC);
+    for(Vertex source : {Vertex(0), Vertex(30000)}){
+        std::vector<std::uint32_t> expected = breadth_first_search(graph, source);
+        for(std::size_t threads : {1, 2, 4}){
+            EXPECT_EQ(parallel_breadth_first_search(graph, source, threads), expected) << threads << " threads";
+        }
+    }
+    // A path never gets a big enough frontier to go bottom up.
+    std::vector<CsrGraph::Edge> edges;
+    for(Vertex v = 0; v + 1 < 1000; ++v){
+        edges.push_back(CsrGraph::Edge{v, v + 1});
+    }
+    CsrGraph path(1000, edges, CsrGraph::SYMMETRIC);
+    EXPECT_EQ(parallel_breadth_first_search(path, 500, 3), breadth_first_search(path, 500));
+}
+TEST(GraphTest, parallel_search_reuse){
+    CsrGraph graph(5000, random_edges(5000, 40000, 1, 5), CsrGraph::SYMMETRIC);
+    ParallelBreadthFirstSearch search(graph, graph, 2);
+    for(Vertex source : {Vertex(1), Vertex(2), Vertex(4999)}){
+        EXPECT_EQ(search.run(source), breadth_first_search(graph, source));
+    }
+}
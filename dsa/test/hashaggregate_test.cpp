@@ -0,0 +1,128 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../src/include/HashAggregate.h"
+
+
+// Reference result computed the obvious way, one row at a time into a std::map.
+static std::map<std::int64_t, HashAggregator::Group> reference(const std::vector<std::int64_t>& keys,
+                                                                const std::vector<std::int64_t>& values){
+    std::map<std::int64_t, HashAggregator::Group> groups;
+    for(std::size_t i = 0; i < keys.size(); ++i){
+        auto it = groups.find(keys[i]);
+        if(it == groups.end()){
+            groups[keys[i]] = HashAggregator::Group{keys[i], 1, values[i], values[i], values[i]};
+        }else{
+            it->second.m_count++;
+            it->second.m_sum += values[i];
+            it->second.m_min  = std::min(it->second.m_min, values[i]);
+            it->second.m_max  = std::max(it->second.m_max, values[i]);
+        }
+    }
+    return groups;
+}
+
+static void make_rows(std::size_t rows, std::int64_t cardinality, std::vector<std::int64_t>& keys,
+                      std::vector<std::int64_t>& values){
+    std::mt19937_64 rng(7);
+    keys.resize(rows);
+    values.resize(rows);
+    for(std::size_t i = 0; i < rows; ++i){
+        keys[i]   = std::int64_t(rng() % cardinality) - cardinality / 2;
+        values[i] = std::int64_t(rng() % 2001) - 1000;
+    }
+}
+
+static void expect_group(const HashAggregator::Group& actual, const HashAggregator::Group& expected){
+    EXPECT_EQ(actual.m_key,   expected.m_key);
+    EXPECT_EQ(actual.m_count, expected.m_count);
+    EXPECT_EQ(actual.m_sum,   expected.m_sum);
+    EXPECT_EQ(actual.m_min,   expected.m_min);
+    EXPECT_EQ(actual.m_max,   expected.m_max);
+}
+
+
+TEST(HashAggregateTest, empty_aggregator){
+    HashAggregator aggregator;
+    EXPECT_EQ(aggregator.size(), 0u);
+    EXPECT_EQ(aggregator.find(1), -1);
+}
+TEST(HashAggregateTest, small_group_by){
+    std::vector<std::int64_t> keys   = {1, 2, 1, 3, 1, 2};
+    std::vector<std::int64_t> values = {5, -1, 7, 0, -2, 4};
+    HashAggregator aggregator;
+    aggregator.add(keys.data(), values.data(), keys.size());
+    EXPECT_EQ(aggregator.size(), 3u);
+    expect_group(aggregator.group(aggregator.find(1)), HashAggregator::Group{1, 3, 10, -2, 7});
+    expect_group(aggregator.group(aggregator.find(2)), HashAggregator::Group{2, 2, 3, -1, 4});
+    expect_group(aggregator.group(aggregator.find(3)), HashAggregator::Group{3, 1, 0, 0, 0});
+}
+TEST(HashAggregateTest, matches_reference_across_batches){
+    std::vector<std::int64_t> keys, values;
+    make_rows(100000, 5000, keys, values);
+    HashAggregator aggregator;
+    aggregator.add(keys.data(), values.data(), keys.size());
+
+    auto expected = reference(keys, values);
+    ASSERT_EQ(aggregator.size(), expected.size());
+    for(const auto& entry : expected){
+        std::ptrdiff_t index = aggregator.find(entry.first);
+        ASSERT_NE(index, -1);
+        expect_group(aggregator.group(index), entry.second);
+    }
+}
+TEST(HashAggregateTest, merge){
+    std::vector<std::int64_t> keys, values;
+    make_rows(20000, 300, keys, values);
+    std::size_t half = keys.size() / 2;
+    HashAggregator first, second;
+    first.add(keys.data(), values.data(), half);
+    second.add(keys.data() + half, values.data() + half, keys.size() - half);
+    first.merge(second);
+
+    auto expected = reference(keys, values);
+    ASSERT_EQ(first.size(), expected.size());
+    for(const auto& entry : expected){
+        expect_group(first.group(first.find(entry.first)), entry.second);
+    }
+}
+TEST(HashAggregateTest, partitioned_matches_reference){
+    std::vector<std::int64_t> keys, values;
+    make_rows(100000, 20000, keys, values);
+    PartitionedHashAggregate aggregate(3);
+    EXPECT_EQ(aggregate.partitions().size(), 4u);
+    aggregate.add(keys.data(), values.data(), keys.size());
+
+    auto expected = reference(keys, values);
+    ASSERT_EQ(aggregate.size(), expected.size());
+    for(const auto& entry : expected){
+        HashAggregator::Group group;
+        ASSERT_TRUE(aggregate.find(entry.first, group));
+        expect_group(group, entry.second);
+    }
+    HashAggregator::Group group;
+    EXPECT_FALSE(aggregate.find(1 << 30, group));
+}
+TEST(HashAggregateTest, partitioned_add_merges_into_earlier_groups){
+    std::vector<std::int64_t> keys, values;
+    make_rows(60000, 5000, keys, values);
+    PartitionedHashAggregate aggregate(4);
+    // The second add merges into partitions that already hold groups, and an empty add changes nothing.
+    aggregate.add(keys.data(), values.data(), 40000);
+    aggregate.add(keys.data() + 40000, values.data() + 40000, 20000);
+    aggregate.add(keys.data(), values.data(), 0);
+
+    auto expected = reference(keys, values);
+    ASSERT_EQ(aggregate.size(), expected.size());
+    for(const auto& entry : expected){
+        HashAggregator::Group group;
+        ASSERT_TRUE(aggregate.find(entry.first, group));
+        expect_group(group, entry.second);
+    }
+    for(const HashAggregator& partition : aggregate.partitions()){
+        EXPECT_GT(partition.size(), 0u);
+    }
+}
@@ -0,0 +1,139 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <sstream>
+#include <string>
+
+#include "../src/include/HashTable.h"
+#include "AllocationCounting.h"
+
+
+TEST(HashTableTest, search_empty_table){
+    HashTable table(8);
+    EXPECT_EQ(table.size(), 0);
+    EXPECT_EQ(table.search(3), -1);
+}
+TEST(HashTableTest, insert_and_search){
+    HashTable table(8);
+    table.insert(3);
+    table.insert(11);
+    table.insert(-5);
+    EXPECT_EQ(table.size(), 3);
+    EXPECT_EQ(table.search(3), 3);
+    EXPECT_EQ(table.search(11), 4);
+    EXPECT_NE(table.search(-5), -1);
+    EXPECT_EQ(table.search(19), -1);
+}
+TEST(HashTableTest, insert_duplicate){
+    HashTable table(8);
+    table.insert(3);
+    table.insert(3);
+    EXPECT_EQ(table.size(), 1);
+}
+TEST(HashTableTest, resize_keeps_elements){
+    HashTable table(4);
+    for(int i = 0; i < 100; ++i){
+        table.insert(i * 7);
+    }
+    EXPECT_EQ(table.size(), 100);
+    EXPECT_GE(table.capacity(), 128);
+    EXPECT_LE(table.load_factor(), 0.75);
+    for(int i = 0; i < 100; ++i){
+        EXPECT_NE(table.search(i * 7), -1);
+    }
+}
+TEST(HashTableTest, remove_keeps_cluster_reachable){
+    HashTable table(16);
+    // 1, 17 and 33 all hash to slot 1 and 2 hashes into the middle of their cluster.
+    table.insert(1);
+    table.insert(17);
+    table.insert(2);
+    table.insert(33);
+    table.remove(17);
+    EXPECT_EQ(table.size(), 3);
+    EXPECT_EQ(table.search(17), -1);
+    EXPECT_NE(table.search(1), -1);
+    EXPECT_NE(table.search(2), -1);
+    EXPECT_NE(table.search(33), -1);
+    table.remove(42);
+    EXPECT_EQ(table.size(), 3);
+}
+TEST(HashTableTest, remove_wraps_around){
+    HashTable table(8);
+    table.insert(7);
+    table.insert(15);
+    table.insert(23);
+    table.remove(7);
+    EXPECT_NE(table.search(15), -1);
+    EXPECT_NE(table.search(23), -1);
+}
+
+#ifdef DSA_HASHTABLE_STATS
+TEST(HashTableStatsTest, records_probe_lengths){
+    HashTable table(16);
+    table.insert(1);
+    table.insert(17);
+    table.search(1);
+    table.search(17);
+    table.search(33);
+    const HashTableStats& stats = table.stats();
+    EXPECT_EQ(stats.m_hit_histogram[1], 1u);
+    EXPECT_EQ(stats.m_hit_histogram[2], 1u);
+    EXPECT_EQ(stats.m_miss_histogram[3], 1u);
+    EXPECT_EQ(stats.m_max_displacement, 1);
+    // The duplicate checks of insert and the lookup of remove aren't searches.
+    table.insert(17);
+    table.remove(1);
+    EXPECT_EQ(HashTableStats::total(stats.m_hit_histogram), 2u);
+    EXPECT_EQ(HashTableStats::total(stats.m_miss_histogram), 1u);
+}
+TEST(HashTableStatsTest, records_resizes){
+    HashTable table(4);
+    for(int i = 0; i < 16; ++i){
+        table.insert(i);
+    }
+    const HashTableStats& stats = table.stats();
+    EXPECT_EQ(stats.m_resize_count, 3u);
+    // One sample for the first insert (the interval counts inserts only) and one either side of each resize.
+    EXPECT_EQ(stats.m_load_samples.size(), 7u);
+
+    std::ostringstream os;
+    table.dump_stats(os);
+    EXPECT_NE(os.str().find("hashtable.resizes 3"), std::string::npos);
+}
+#else
+TEST(HashTableStatsTest, disabled_by_default){
+    HashTable table(4);
+    std::ostringstream os;
+    table.dump_stats(os);
+    EXPECT_NE(os.str().find("disabled"), std::string::npos);
+}
+#endif
+
+#ifndef DSA_HASHTABLE_STATS
+// The instrumented build records samples into growing vectors, so these only hold for the plain build.
+TEST(HashTableTest, allocates_only_to_resize){
+    HashTable table(16);
+    // 16 slots hold 12 elements; 1000 elements take 7 doublings to 2048 slots.
+    EXPECT_ALLOCATIONS_AT_MOST(7, {
+        for(int i = 0; i < 1000; ++i){
+            table.insert(i * 7);
+        }
+    });
+    EXPECT_NO_ALLOCATIONS({
+        for(int i = 0; i < 2000; ++i){
+            table.search(i * 7);
+        }
+        for(int i = 0; i < 1000; i += 2){
+            table.remove(i * 7);
+        }
+        for(int i = 0; i < 1000; i += 2){
+            table.insert(i * 7);
+        }
+    });
+    EXPECT_NO_LEAKS({
+        HashTable scoped(4);
+        for(int i = 0; i < 100; ++i){
+            scoped.insert(i);
+        }
+    });
+}
+#endif
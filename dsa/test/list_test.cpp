@@ -1,7 +1,10 @@
 #include "googletest/googletest/include/gtest/gtest.h"
 #include <iostream>
+#include <memory>
+#include <string>
 
 #include "../src/include/List.h"
+#include "AllocationCounting.h"
 
 
 TEST(ListTest, create_empty_list){
@@ -62,3 +65,40 @@ TEST(ListTest, pop_back){
     list.pop_back();
     EXPECT_EQ(list.size(), 0);
 }
+
+TEST(ListTest, allocates_one_node_per_element){
+    EXPECT_ALLOCATIONS_AT_MOST(5, List<int> list(5, 0));
+    List<int> list;
+    EXPECT_ALLOCATIONS_AT_MOST(1, list.push_back(1));
+    EXPECT_ALLOCATIONS_AT_MOST(1, list.insert_back(2, 0));
+    EXPECT_NO_ALLOCATIONS(list.pop_front());
+    EXPECT_NO_ALLOCATIONS(list.at(0));
+    EXPECT_NO_LEAKS({
+        List<int> scoped(100, 7);
+        scoped.pop_front();
+        scoped.push_back(8);
+    });
+}
+TEST(ListTest, copy_and_move){
+    List<std::string> list(3, "abcdefghijklmnopqrstuvwxyz");
+    list.push_back("end");
+    // A copy allocates a Node (and a string) per element; a move hands the Nodes over.
+    std::unique_ptr<List<std::string>> copy;
+    EXPECT_ALLOCATIONS_AT_MOST(1 + 2 * 4, copy.reset(new List<std::string>(list)));
+    EXPECT_EQ(copy->size(), 4);
+    EXPECT_EQ(copy->at(3), "end");
+    std::unique_ptr<List<std::string>> moved;
+    EXPECT_ALLOCATIONS_AT_MOST(1, moved.reset(new List<std::string>(std::move(list))));
+    EXPECT_EQ(list.size(), 0);
+    EXPECT_EQ(moved->size(), 4);
+    EXPECT_EQ(moved->at(0), "abcdefghijklmnopqrstuvwxyz");
+    EXPECT_NO_ALLOCATIONS(list = std::move(*moved));
+    EXPECT_EQ(list.size(), 4);
+    EXPECT_EQ(moved->size(), 0);
+    EXPECT_NO_LEAKS({
+        List<std::string> first(2, "x");
+        List<std::string> second(first);
+        second = first;
+        first = std::move(second);
+    });
+}
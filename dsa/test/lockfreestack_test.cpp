@@ -0,0 +1,150 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "../src/include/LockFreeStack.h"
+#include "CountingResource.h"
+
+
+TEST(LockFreeStackTest, lifo){
+    LockFreeStack<int> stack;
+    int value;
+    EXPECT_TRUE(stack.is_empty());
+    EXPECT_FALSE(stack.try_pop(value));
+    for(int i = 0; i < 10000; ++i){
+        stack.push(i);
+    }
+    EXPECT_FALSE(stack.is_empty());
+    for(int i = 9999; i >= 0; --i){
+        ASSERT_TRUE(stack.try_pop(value));
+        ASSERT_EQ(value, i);
+    }
+    EXPECT_FALSE(stack.try_pop(value));
+}
+TEST(LockFreeStackTest, nodes_are_reused){
+    LockFreeStack<int> stack;
+    int value;
+    for(int round = 0; round < 1000; ++round){
+        for(int i = 0; i < 10; ++i){
+            stack.push(i);
+        }
+        for(int i = 9; i >= 0; --i){
+            ASSERT_TRUE(stack.try_pop(value));
+            ASSERT_EQ(value, i);
+        }
+    }
+}
+TEST(LockFreeStackTest, move_only_values_and_destruction){
+    std::shared_ptr<int> shared = std::make_shared<int>(1);
+    {
+        LockFreeStack<std::shared_ptr<int>> stack;
+        for(int i = 0; i < 5; ++i){
+            stack.push(shared);
+        }
+        std::shared_ptr<int> out;
+        EXPECT_TRUE(stack.try_pop(out));
+        EXPECT_EQ(out, shared);
+        EXPECT_EQ(shared.use_count(), 6);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+
+    LockFreeStack<std::unique_ptr<int>> stack;
+    stack.emplace(new int(7));
+    std::unique_ptr<int> out;
+    EXPECT_TRUE(stack.try_pop(out));
+    EXPECT_EQ(*out, 7);
+}
+
+// Every thread pushes distinct values and pops as many times, so with or without elimination every value must come out
+// exactly once.
+static void hammer(std::size_t elimination_slots){
+    const int threads = 8;
+    const std::uint64_t per_thread = 50000;
+    LockFreeStack<std::uint64_t> stack(elimination_slots);
+    std::vector<std::vector<std::uint64_t>> popped(threads);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&, t]{
+            for(std::uint64_t i = 0; i < per_thread; ++i){
+                stack.push(std::uint64_t(t) * per_thread + i);
+                std::uint64_t value;
+                if(stack.try_pop(value)){
+                    popped[t].push_back(value);
+                }
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    std::vector<bool> seen(threads * per_thread);
+    std::uint64_t value;
+    while(stack.try_pop(value)){
+        popped[0].push_back(value);
+    }
+    std::size_t count = 0;
+    for(const std::vector<std::uint64_t>& values : popped){
+        for(std::uint64_t v : values){
+            ASSERT_FALSE(seen[v]);
+            seen[v] = true;
+            count++;
+        }
+    }
+    EXPECT_EQ(count, threads * per_thread);
+}
+TEST(LockFreeStackTest, concurrent_with_elimination){
+    hammer(LockFreeStack<std::uint64_t>::DEFAULT_ELIMINATION_SLOTS);
+}
+TEST(LockFreeStackTest, concurrent_without_elimination){
+    hammer(0);
+}
+TEST(LockFreeStackTest, concurrent_producers_and_consumers){
+    // Separate pushing and popping threads, so that pops often find the stack empty and elimination pairs a push on one
+    // thread with a pop on another.
+    LockFreeStack<std::uint64_t> stack(1);
+    const std::uint64_t per_thread = 50000;
+    std::atomic<std::uint64_t> popped(0), sum(0);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < 4; ++t){
+        workers.emplace_back([&]{
+            for(std::uint64_t i = 1; i <= per_thread; ++i){
+                stack.push(i);
+            }
+        });
+        workers.emplace_back([&]{
+            std::uint64_t value;
+            while(popped.load() < 4 * per_thread){
+                if(stack.try_pop(value)){
+                    sum += value;
+                    popped++;
+                }
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    EXPECT_EQ(popped.load(), 4 * per_thread);
+    EXPECT_EQ(sum.load(), 4 * per_thread * (per_thread + 1) / 2);
+    EXPECT_TRUE(stack.is_empty());
+}
+TEST(LockFreeStackTest, allocates_through_allocator){
+    std::pmr::synchronized_pool_resource pool;
+    CountingResource resource(&pool);
+    {
+        LockFreeStack<int, std::pmr::polymorphic_allocator<int>> stack(LockFreeStack<int>::DEFAULT_ELIMINATION_SLOTS, &resource);
+        EXPECT_EQ(stack.get_allocator().resource(), &resource);
+        for(int i = 0; i < 1000; ++i){
+            stack.push(i);
+        }
+        EXPECT_GT(resource.allocations(), 0u);
+        int value;
+        EXPECT_TRUE(stack.try_pop(value));
+        EXPECT_EQ(value, 999);
+    }
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
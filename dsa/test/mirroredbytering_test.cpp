@@ -0,0 +1,52 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "../src/include/MirroredByteRing.h"
+
+
+TEST(MirroredByteRingTest, capacity_is_whole_pages){
+    std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+    MirroredByteRing ring(1);
+    EXPECT_EQ(ring.capacity(), page);
+    EXPECT_EQ(MirroredByteRing(page + 1).capacity(), 2 * page);
+    EXPECT_TRUE(ring.is_empty());
+    EXPECT_EQ(ring.writable(), page);
+}
+TEST(MirroredByteRingTest, write_then_read){
+    MirroredByteRing ring(4096);
+    EXPECT_EQ(ring.write("hello world", 11), 11u);
+    EXPECT_EQ(ring.readable(), 11u);
+    EXPECT_EQ(std::string(ring.read_data(), 5), "hello");
+    ring.consume(6);
+    char out[16];
+    EXPECT_EQ(ring.read(out, sizeof(out)), 5u);
+    EXPECT_EQ(std::string(out, 5), "world");
+    EXPECT_TRUE(ring.is_empty());
+}
+TEST(MirroredByteRingTest, spans_are_contiguous_across_the_wrap){
+    MirroredByteRing ring(4096);
+    std::size_t capacity = ring.capacity();
+    std::string filler(capacity - 3, 'x');
+    ring.write(filler.data(), filler.size());
+    ring.consume(filler.size());
+
+    // The write position is three bytes from the end, but the whole buffer is writable as one span.
+    EXPECT_EQ(ring.writable(), capacity);
+    std::memcpy(ring.write_data(), "across the wrap", 15);
+    ring.commit(15);
+    EXPECT_EQ(std::string(ring.read_data(), ring.readable()), "across the wrap");
+    // The bytes after the wrap are the same memory as the start of the buffer.
+    EXPECT_EQ(std::memcmp(ring.read_data() + 3, ring.read_data() + 3 - capacity, 12), 0);
+}
+TEST(MirroredByteRingTest, full_ring){
+    MirroredByteRing ring(4096);
+    std::string data(ring.capacity() + 10, 'y');
+    EXPECT_EQ(ring.write(data.data(), data.size()), ring.capacity());
+    EXPECT_EQ(ring.writable(), 0u);
+    EXPECT_EQ(ring.write("z", 1), 0u);
+    ASSERT_DEATH({ring.commit(1);}, "Can't commit more bytes than a MirroredByteRing has free");
+    ring.clear();
+    EXPECT_TRUE(ring.is_empty());
+}
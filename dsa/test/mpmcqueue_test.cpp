@@ -0,0 +1,108 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "../src/include/MPMCQueue.h"
+#include "CountingResource.h"
+
+
+TEST(MPMCQueueTest, capacity_rounds_up){
+    EXPECT_EQ(MPMCQueue<int>(1).capacity(), 2u);
+    EXPECT_EQ(MPMCQueue<int>(100).capacity(), 128u);
+}
+TEST(MPMCQueueTest, full_and_empty){
+    MPMCQueue<int> queue(4);
+    int value;
+    EXPECT_FALSE(queue.try_pop(value));
+    for(int i = 0; i < 4; ++i){
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(4));
+    EXPECT_EQ(queue.size(), 4u);
+    for(int lap = 0; lap < 3; ++lap){
+        for(int i = 0; i < 4; ++i){
+            EXPECT_TRUE(queue.try_pop(value));
+            EXPECT_EQ(value, i);
+            EXPECT_TRUE(queue.try_push(i));
+        }
+    }
+}
+TEST(MPMCQueueTest, destroys_remaining_elements){
+    std::shared_ptr<int> counted = std::make_shared<int>(0);
+    {
+        MPMCQueue<std::shared_ptr<int>> queue(4);
+        queue.push(counted);
+        queue.push(counted);
+        queue.pop();
+        queue.push(counted);
+        EXPECT_EQ(counted.use_count(), 3);
+    }
+    EXPECT_EQ(counted.use_count(), 1);
+}
+TEST(MPMCQueueTest, many_producers_many_consumers){
+    const int producers = 4, consumers = 4;
+    const std::uint64_t per_producer = 50000;
+    MPMCQueue<std::uint64_t> queue(64);
+
+    // Each item is (producer << 32 | sequence). Every consumer must see each producer's items in increasing order, and
+    // between them the consumers must see every item exactly once.
+    std::vector<std::thread> threads;
+    std::vector<std::vector<std::uint64_t>> last_seen(consumers, std::vector<std::uint64_t>(producers, 0));
+    std::vector<std::uint64_t> received(consumers, 0), sums(consumers, 0);
+    std::vector<bool> in_order(consumers, true);
+    std::atomic<std::uint64_t> remaining(producers * per_producer);
+
+    for(int p = 0; p < producers; ++p){
+        threads.emplace_back([&, p]{
+            for(std::uint64_t i = 1; i <= per_producer; ++i){
+                queue.push((std::uint64_t(p) << 32) | i);
+            }
+        });
+    }
+    for(int c = 0; c < consumers; ++c){
+        threads.emplace_back([&, c]{
+            std::uint64_t item;
+            while(remaining.load() > 0){
+                if(!queue.try_pop(item)){
+                    std::this_thread::yield();
+                    continue;
+                }
+                remaining.fetch_sub(1);
+                std::uint64_t producer = item >> 32, sequence = item & 0xffffffff;
+                if(sequence <= last_seen[c][producer]){
+                    in_order[c] = false;
+                }
+                last_seen[c][producer] = sequence;
+                sums[c] += sequence;
+                received[c]++;
+            }
+        });
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+
+    std::uint64_t total = 0, sum = 0;
+    for(int c = 0; c < consumers; ++c){
+        EXPECT_TRUE(in_order[c]);
+        total += received[c];
+        sum   += sums[c];
+    }
+    EXPECT_EQ(total, producers * per_producer);
+    EXPECT_EQ(sum, producers * per_producer * (per_producer + 1) / 2);
+    EXPECT_TRUE(queue.is_empty());
+}
+TEST(MPMCQueueTest, allocates_through_allocator){
+    CountingResource resource;
+    {
+        MPMCQueue<std::shared_ptr<int>, std::pmr::polymorphic_allocator<std::shared_ptr<int>>> queue(64, &resource);
+        EXPECT_EQ(queue.get_allocator().resource(), &resource);
+        EXPECT_EQ(resource.allocations(), 1u);
+        queue.push(std::make_shared<int>(3));
+        EXPECT_EQ(*queue.pop(), 3);
+    }
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
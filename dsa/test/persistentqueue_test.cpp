@@ -0,0 +1,157 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "../src/include/PersistentQueue.h"
+
+
+// Each test gets an empty directory of its own.
+static std::string fresh_directory(const char* name){
+    std::string directory = testing::TempDir() + "persistentqueue_test_" + std::to_string(getpid()) + "_" + name;
+    std::filesystem::remove_all(directory);
+    return directory;
+}
+static PersistentQueueOptions small_segments(SyncPolicy policy = SyncPolicy::NONE){
+    PersistentQueueOptions options;
+    options.segment_size = 2 * std::size_t(sysconf(_SC_PAGESIZE));
+    options.sync_policy = policy;
+    return options;
+}
+static std::string record(int i){
+    return "record " + std::to_string(i) + std::string(std::size_t(i % 50), '.');
+}
+
+
+TEST(PersistentQueueTest, fifo){
+    std::string directory = fresh_directory("fifo");
+    PersistentQueue queue(directory);
+    EXPECT_TRUE(queue.is_empty());
+    queue.enqueue("first");
+    queue.enqueue("second");
+    queue.enqueue(std::string_view());
+    EXPECT_EQ(queue.size(), 3u);
+    EXPECT_EQ(queue.peek(), "first");
+    EXPECT_EQ(queue.dequeue(), "first");
+    EXPECT_EQ(queue.dequeue(), "second");
+    EXPECT_EQ(queue.dequeue(), "");
+    EXPECT_TRUE(queue.is_empty());
+    ASSERT_DEATH({queue.dequeue();}, "PersistentQueue underflow would occur with dequeue");
+    std::filesystem::remove_all(directory);
+}
+TEST(PersistentQueueTest, survives_reopening){
+    std::string directory = fresh_directory("reopen");
+    {
+        PersistentQueue queue(directory, small_segments());
+        for(int i = 0; i < 500; ++i){
+            queue.enqueue(record(i));
+        }
+        for(int i = 0; i < 123; ++i){
+            EXPECT_EQ(queue.dequeue(), record(i));
+        }
+    }
+    {
+        // The checkpoint puts the reader back where it was, and new records go after the old ones.
+        PersistentQueue queue(directory, small_segments());
+        EXPECT_EQ(queue.size(), 377u);
+        EXPECT_EQ(queue.peek(), record(123));
+        queue.enqueue(record(500));
+    }
+    PersistentQueue queue(directory, small_segments());
+    for(int i = 123; i <= 500; ++i){
+        ASSERT_EQ(queue.dequeue(), record(i));
+    }
+    EXPECT_TRUE(queue.is_empty());
+    std::filesystem::remove_all(directory);
+}
+TEST(PersistentQueueTest, segments_are_recycled){
+    std::string directory = fresh_directory("recycle");
+    PersistentQueueOptions options = small_segments(SyncPolicy::GROUP_COMMIT);
+    options.max_spare_segments = 2;
+    {
+        PersistentQueue queue(directory, options);
+        for(int round = 0; round < 20; ++round){
+            for(int i = 0; i < 200; ++i){
+                queue.enqueue(record(i));
+            }
+            EXPECT_GT(queue.segments(), 1u);
+            for(int i = 0; i < 200; ++i){
+                ASSERT_EQ(queue.dequeue(), record(i));
+            }
+            EXPECT_LE(queue.spare_segments(), 2u);
+        }
+        // Only the segment being written, the spares and the checkpoint are left on disk.
+        std::size_t files = 0;
+        for(const auto& entry : std::filesystem::directory_iterator(directory)){
+            (void)entry;
+            files++;
+        }
+        EXPECT_EQ(files, queue.segments() + queue.spare_segments() + 1);
+    }
+    std::filesystem::remove_all(directory);
+}
+TEST(PersistentQueueTest, torn_record_is_dropped){
+    std::string directory = fresh_directory("torn");
+    std::string last_segment;
+    {
+        PersistentQueue queue(directory, small_segments());
+        for(int i = 0; i < 10; ++i){
+            queue.enqueue(record(i));
+        }
+    }
+    for(const auto& entry : std::filesystem::directory_iterator(directory)){
+        if(entry.path().filename().string().rfind("segment-", 0) == 0){
+            last_segment = entry.path().string();
+        }
+    }
+    // Flip a byte in the payload of the last record, as if the crash happened while it was being written.
+    std::size_t offset = 64;
+    for(int i = 0; i < 9; ++i){
+        offset += (16 + record(i).size() + 7) & ~std::size_t(7);
+    }
+    {
+        std::fstream file(last_segment, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(std::streamoff(offset + 16));
+        file.put('X');
+    }
+    PersistentQueue queue(directory, small_segments());
+    EXPECT_EQ(queue.size(), 9u);
+    queue.enqueue("after the crash");
+    for(int i = 0; i < 9; ++i){
+        EXPECT_EQ(queue.dequeue(), record(i));
+    }
+    EXPECT_EQ(queue.dequeue(), "after the crash");
+    std::filesystem::remove_all(directory);
+}
+TEST(PersistentQueueTest, every_policy_round_trips){
+    for(SyncPolicy policy : {SyncPolicy::NONE, SyncPolicy::GROUP_COMMIT, SyncPolicy::EVERY_WRITE}){
+        std::string directory = fresh_directory("policy");
+        {
+            PersistentQueue queue(directory, small_segments(policy));
+            for(int i = 0; i < 100; ++i){
+                queue.enqueue(record(i));
+            }
+            queue.commit();
+        }
+        {
+            PersistentQueue queue(directory, small_segments(policy));
+            EXPECT_EQ(queue.size(), 100u);
+            EXPECT_EQ(queue.dequeue(), record(0));
+        }
+        std::filesystem::remove_all(directory);
+    }
+}
+TEST(PersistentQueueTest, record_too_large){
+    std::string directory = fresh_directory("large");
+    PersistentQueue queue(directory, small_segments());
+    std::string largest(queue.max_record_size(), 'L');
+    queue.enqueue(largest);
+    queue.enqueue(largest);
+    EXPECT_EQ(queue.dequeue(), largest);
+    EXPECT_EQ(queue.dequeue(), largest);
+    std::string too_large(queue.max_record_size() + 1, 'L');
+    ASSERT_DEATH({queue.enqueue(too_large);}, "Record is too large for a PersistentQueue segment");
+    std::filesystem::remove_all(directory);
+}
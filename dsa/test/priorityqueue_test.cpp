@@ -0,0 +1,165 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <algorithm>
+#include <functional>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/include/PriorityQueue.h"
+#include "CountingResource.h"
+
+
+// Pops everything and checks that it comes out in the order Compare says.
+template <class Q>
+static std::vector<int> drain(Q& queue){
+    std::vector<int> out;
+    while(!queue.is_empty()){
+        out.push_back(queue.pop());
+    }
+    return out;
+}
+
+static std::vector<int> random_values(std::size_t count){
+    std::mt19937 rng(11);
+    std::vector<int> values(count);
+    for(int& value : values){
+        value = int(rng() % 1000);
+    }
+    return values;
+}
+
+
+TEST(PriorityQueueTest, create_empty_queue){
+    PriorityQueue<int> queue;
+    EXPECT_TRUE(queue.is_empty());
+    ASSERT_DEATH({queue.pop();}, "PriorityQueue underflow would occur with pop");
+}
+TEST(PriorityQueueTest, max_heap_by_default){
+    PriorityQueue<int> queue;
+    for(int value : {3, 1, 4, 1, 5, 9, 2, 6}){
+        queue.push(value);
+    }
+    EXPECT_EQ(queue.top(), 9);
+    EXPECT_EQ(drain(queue), (std::vector<int>{9, 6, 5, 4, 3, 2, 1, 1}));
+}
+TEST(PriorityQueueTest, min_heap_with_greater){
+    std::vector<int> values = random_values(1000);
+    PriorityQueue<int, std::greater<int>> queue;
+    for(int value : values){
+        queue.push(value);
+    }
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(drain(queue), values);
+}
+TEST(PriorityQueueTest, arity_does_not_change_order){
+    std::vector<int> values = random_values(777);
+    PriorityQueue<int, std::less<int>, 2> binary(values.begin(), values.end());
+    PriorityQueue<int, std::less<int>, 8> octal(values.begin(), values.end());
+    std::sort(values.rbegin(), values.rend());
+    EXPECT_EQ(drain(binary), values);
+    EXPECT_EQ(drain(octal), values);
+}
+TEST(PriorityQueueTest, push_bulk){
+    std::vector<int> values = random_values(500);
+    PriorityQueue<int> queue;
+    queue.push_bulk(values.data(), 10);         // Rebuilds, the heap was empty.
+    queue.push_bulk(values.data() + 10, 400);   // Rebuilds, the batch is larger than the heap.
+    queue.push_bulk(values.data() + 410, 90);   // Sifts each value up.
+    EXPECT_EQ(queue.size(), 500u);
+    std::sort(values.rbegin(), values.rend());
+    EXPECT_EQ(drain(queue), values);
+}
+TEST(PriorityQueueTest, move_only_values){
+    PriorityQueue<std::string> queue;
+    queue.emplace("b");
+    queue.push(std::string("c"));
+    queue.emplace("a");
+    EXPECT_EQ(queue.pop(), "c");
+    EXPECT_EQ(queue.pop(), "b");
+    EXPECT_EQ(queue.pop(), "a");
+}
+
+TEST(AddressablePriorityQueueTest, decrease_key){
+    AddressablePriorityQueue<int, std::greater<int>> queue;
+    auto a = queue.push(10);
+    auto b = queue.push(20);
+    auto c = queue.push(30);
+    EXPECT_EQ(queue.top_handle(), a);
+    queue.decrease_key(c, 5);
+    EXPECT_EQ(queue.top_handle(), c);
+    EXPECT_EQ(queue.value(b), 20);
+    ASSERT_DEATH({queue.decrease_key(b, 25);}, "decrease_key cannot lower an element's priority");
+    EXPECT_EQ(queue.pop(), 5);
+    EXPECT_FALSE(queue.contains(c));
+    EXPECT_EQ(queue.pop(), 10);
+    EXPECT_EQ(queue.pop(), 20);
+}
+TEST(AddressablePriorityQueueTest, update_moves_both_ways){
+    AddressablePriorityQueue<int> queue;
+    std::vector<AddressablePriorityQueue<int>::Handle> handles;
+    for(int i = 0; i < 100; ++i){
+        handles.push_back(queue.push(i));
+    }
+    queue.update(handles[99], -1);
+    queue.update(handles[0], 1000);
+    EXPECT_EQ(queue.pop(), 1000);
+    EXPECT_EQ(queue.pop(), 98);
+    std::vector<int> rest = drain(queue);
+    EXPECT_EQ(rest.back(), -1);
+    EXPECT_TRUE(std::is_sorted(rest.rbegin(), rest.rend()));
+}
+TEST(AddressablePriorityQueueTest, handles_are_recycled){
+    AddressablePriorityQueue<int> queue;
+    auto a = queue.push(1);
+    queue.pop();
+    auto b = queue.push(2);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(queue.value(b), 2);
+}
+TEST(AddressablePriorityQueueTest, matches_sort_under_random_updates){
+    std::mt19937 rng(5);
+    AddressablePriorityQueue<int, std::greater<int>> queue;
+    std::vector<AddressablePriorityQueue<int, std::greater<int>>::Handle> handles;
+    std::vector<int> values(2000);
+    for(std::size_t i = 0; i < values.size(); ++i){
+        values[i] = int(rng() % 100000);
+        handles.push_back(queue.push(values[i]));
+    }
+    for(int i = 0; i < 5000; ++i){
+        std::size_t index = rng() % values.size();
+        values[index] -= int(rng() % 100);
+        queue.decrease_key(handles[index], values[index]);
+    }
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(drain(queue), values);
+}
+TEST(PriorityQueueTest, allocates_through_allocator){
+    CountingResource resource;
+    {
+        PriorityQueue<int, std::less<int>, 4, std::pmr::polymorphic_allocator<int>> queue(&resource);
+        std::vector<int> values = random_values(1000);
+        queue.push_bulk(values.data(), values.size());
+        EXPECT_EQ(queue.get_allocator().resource(), &resource);
+        EXPECT_GT(resource.allocations(), 0u);
+        std::sort(values.rbegin(), values.rend());
+        EXPECT_EQ(drain(queue), values);
+    }
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
+TEST(AddressablePriorityQueueTest, allocates_through_allocator){
+    CountingResource resource;
+    {
+        AddressablePriorityQueue<int, std::greater<int>, 4, std::pmr::polymorphic_allocator<int>> queue(&resource);
+        std::vector<AddressablePriorityQueue<int>::Handle> handles;
+        for(int i = 0; i < 100; ++i){
+            handles.push_back(queue.push(1000 + i));
+        }
+        queue.decrease_key(handles[50], 1);
+        EXPECT_EQ(queue.get_allocator().resource(), &resource);
+        EXPECT_GT(resource.allocations(), 0u);
+        EXPECT_EQ(queue.pop(), 1);
+        EXPECT_EQ(queue.pop(), 1000);
+    }
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
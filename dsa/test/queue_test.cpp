@@ -0,0 +1,251 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/include/Queue.h"
+#include "AllocationCounting.h"
+
+
+// Counts live instances, and throws from the copy constructor once copies_left runs out.
+struct CopyThrows{
+    static int live;
+    static int copies_left;
+    int m_value;
+
+    explicit CopyThrows(int value) : m_value(value) {live++;}
+    CopyThrows(const CopyThrows& other) : m_value(other.m_value){
+        if(copies_left-- == 0){
+            throw std::runtime_error("copy failed");
+        }
+        live++;
+    }
+    ~CopyThrows() {live--;}
+};
+int CopyThrows::live = 0;
+int CopyThrows::copies_left = 1 << 30;
+
+TEST(QueueTest, create_empty_queue){
+    Queue<int> queue;
+    EXPECT_TRUE(queue.is_empty());
+    EXPECT_EQ(queue.size(), 0u);
+    ASSERT_DEATH({queue.dequeue();}, "Queue underflow would occur with dequeue");
+    ASSERT_DEATH({queue.peek();}, "Can't peek at an empty Queue");
+}
+TEST(QueueTest, enqueue_dequeue_in_order){
+    Queue<int> queue;
+    for(int i = 0; i < 5; ++i){
+        queue.enqueue(i);
+    }
+    EXPECT_FALSE(queue.is_empty());
+    EXPECT_EQ(queue.size(), 5u);
+    EXPECT_EQ(queue.peek(), 0);
+    for(int i = 0; i < 5; ++i){
+        EXPECT_EQ(queue.dequeue(), i);
+    }
+    EXPECT_TRUE(queue.is_empty());
+}
+TEST(QueueTest, grows_past_initial_capacity){
+    Queue<int> queue;
+    for(int i = 0; i < 1000; ++i){
+        queue.enqueue(i);
+    }
+    EXPECT_EQ(queue.size(), 1000u);
+    EXPECT_EQ(queue.capacity(), 1024u);
+    for(int i = 0; i < 1000; ++i){
+        EXPECT_EQ(queue.dequeue(), i);
+    }
+}
+TEST(QueueTest, wraps_around_without_growing){
+    Queue<int> queue;
+    queue.reserve(16);
+    int next_in = 0, next_out = 0;
+    for(int round = 0; round < 100; ++round){
+        while(queue.size() < 12){
+            queue.enqueue(next_in++);
+        }
+        while(queue.size() > 3){
+            EXPECT_EQ(queue.dequeue(), next_out++);
+        }
+    }
+    EXPECT_EQ(queue.capacity(), 16u);
+}
+TEST(QueueTest, grows_while_wrapped){
+    Queue<std::string> queue;
+    for(int i = 0; i < 10; ++i){
+        queue.enqueue(std::to_string(i));
+    }
+    for(int i = 0; i < 8; ++i){
+        queue.dequeue();
+    }
+    for(int i = 10; i < 40; ++i){
+        queue.enqueue(std::to_string(i));
+    }
+    for(int i = 8; i < 40; ++i){
+        EXPECT_EQ(queue.dequeue(), std::to_string(i));
+    }
+}
+TEST(QueueTest, enqueue_own_element_while_full){
+    // The argument refers into the buffer that growing frees, so it must be copied before the old buffer goes. Wrapping
+    // first puts the front in the middle of the buffer.
+    Queue<std::string> queue;
+    for(int i = 0; i < 20; ++i){
+        queue.enqueue(std::string(30, char('a' + i)));
+    }
+    for(int i = 0; i < 20; ++i){
+        queue.enqueue(queue.dequeue());
+    }
+    while(queue.size() < queue.capacity()){
+        queue.enqueue("filler");
+    }
+    std::size_t capacity = queue.capacity();
+    queue.enqueue(queue.peek());
+    EXPECT_GT(queue.capacity(), capacity);
+    std::size_t size = queue.size();
+    for(std::size_t i = 0; i + 1 < size; ++i){
+        queue.dequeue();
+    }
+    EXPECT_EQ(queue.dequeue(), std::string(30, 'a'));
+
+    Queue<long> numbers;
+    for(long i = 0; i < 16; ++i){
+        numbers.enqueue(i + 100);
+    }
+    numbers.enqueue(numbers.peek());
+    for(long i = 0; i < 16; ++i){
+        EXPECT_EQ(numbers.dequeue(), i + 100);
+    }
+    EXPECT_EQ(numbers.dequeue(), 100);
+}
+TEST(QueueTest, emplace_and_move_only_types){
+    Queue<std::unique_ptr<int>> queue;
+    queue.emplace(new int(1));
+    queue.enqueue(std::make_unique<int>(2));
+    EXPECT_EQ(*queue.peek(), 1);
+    std::unique_ptr<int> front = queue.dequeue();
+    EXPECT_EQ(*front, 1);
+    EXPECT_EQ(*queue.dequeue(), 2);
+}
+TEST(QueueTest, bulk_operations_across_wrap){
+    Queue<int> queue;
+    queue.reserve(16);
+    std::vector<int> values(10);
+    for(int i = 0; i < 10; ++i){
+        values[i] = i;
+    }
+    queue.enqueue_bulk(values.data(), values.size());
+    std::vector<int> out(16);
+    EXPECT_EQ(queue.dequeue_bulk(out.data(), 8), 8u);
+    // The back is now at index 10, so this run wraps around the end of the buffer.
+    queue.enqueue_bulk(values.data(), values.size());
+    EXPECT_EQ(queue.capacity(), 16u);
+    EXPECT_EQ(queue.dequeue_bulk(out.data(), out.size()), 12u);
+    std::vector<int> expected = {8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(std::vector<int>(out.begin(), out.begin() + 12), expected);
+    EXPECT_TRUE(queue.is_empty());
+}
+TEST(QueueTest, enqueue_bulk_own_elements_while_growing){
+    Queue<std::string> queue;
+    for(int i = 0; i < 16; ++i){
+        queue.enqueue(std::string(30, char('a' + i)));
+    }
+    ASSERT_EQ(queue.size(), queue.capacity());
+    // The sixteen elements are contiguous from the front, and all of them are copied into the grown buffer.
+    queue.enqueue_bulk(&queue.peek(), 16);
+    EXPECT_EQ(queue.size(), 32u);
+    for(int i = 0; i < 32; ++i){
+        EXPECT_EQ(queue.dequeue(), std::string(30, char('a' + i % 16)));
+    }
+}
+TEST(QueueTest, enqueue_bulk_rolls_back_a_failed_copy){
+    {
+        Queue<CopyThrows> queue;
+        queue.reserve(16);
+        for(int i = 0; i < 10; ++i){
+            queue.emplace(i);
+        }
+        for(int i = 0; i < 8; ++i){
+            queue.dequeue();
+        }
+        std::vector<CopyThrows> values;
+        values.reserve(10);
+        for(int i = 0; i < 10; ++i){
+            values.emplace_back(100 + i);
+        }
+        // The back is at index 10, so six copies land before the wrap and the eighth copy throws after it.
+        CopyThrows::copies_left = 7;
+        EXPECT_THROW(queue.enqueue_bulk(values.data(), values.size()), std::runtime_error);
+        EXPECT_EQ(queue.size(), 2u);
+        EXPECT_EQ(CopyThrows::live, 12);
+        // A throw while growing leaves the queue as it was too.
+        CopyThrows::copies_left = 1 << 30;
+        for(int i = 0; i < 14; ++i){
+            queue.emplace(i);
+        }
+        CopyThrows::copies_left = 3;
+        EXPECT_THROW(queue.enqueue_bulk(values.data(), values.size()), std::runtime_error);
+        EXPECT_EQ(queue.size(), 16u);
+        EXPECT_EQ(queue.capacity(), 16u);
+        EXPECT_EQ(CopyThrows::live, 26);
+        CopyThrows::copies_left = 1 << 30;
+    }
+    EXPECT_EQ(CopyThrows::live, 0);
+}
+TEST(QueueTest, copy_and_move){
+    Queue<std::string> queue;
+    queue.enqueue("a");
+    queue.enqueue("b");
+    Queue<std::string> copy(queue);
+    Queue<std::string> moved(std::move(queue));
+    EXPECT_TRUE(queue.is_empty());
+    EXPECT_EQ(copy.dequeue(), "a");
+    EXPECT_EQ(moved.dequeue(), "a");
+    EXPECT_EQ(moved.dequeue(), "b");
+    copy = moved;
+    EXPECT_TRUE(copy.is_empty());
+}
+TEST(QueueTest, enqueue_does_not_allocate_per_element){
+    Queue<int> queue;
+    // Growing to 1000 elements reallocates once per doubling from MIN_CAPACITY.
+    EXPECT_ALLOCATIONS_AT_MOST(7, {
+        for(int i = 0; i < 1000; ++i){
+            queue.enqueue(i);
+        }
+    });
+    // Once the buffer is big enough, a queue that stays below its capacity never allocates, however far it wraps.
+    EXPECT_NO_ALLOCATIONS({
+        for(int i = 0; i < 100000; ++i){
+            queue.enqueue(queue.dequeue());
+        }
+    });
+    queue.clear();
+    EXPECT_NO_ALLOCATIONS({
+        for(int i = 0; i < 1000; ++i){
+            queue.enqueue(i);
+        }
+    });
+    std::vector<int> values(500, 1);
+    Queue<int> reserved;
+    EXPECT_ALLOCATIONS_AT_MOST(1, reserved.reserve(1000));
+    EXPECT_NO_ALLOCATIONS({
+        reserved.enqueue_bulk(values.data(), values.size());
+        reserved.enqueue_bulk(values.data(), values.size());
+        reserved.dequeue_bulk(values.data(), values.size());
+    });
+}
+TEST(QueueTest, move_does_not_allocate){
+    Queue<std::string> queue;
+    queue.enqueue("abcdefghijklmnopqrstuvwxyz");
+    std::unique_ptr<Queue<std::string>> moved;
+    EXPECT_ALLOCATIONS_AT_MOST(1, moved.reset(new Queue<std::string>(std::move(queue))));
+    EXPECT_NO_ALLOCATIONS(queue = std::move(*moved));
+    EXPECT_EQ(queue.peek(), "abcdefghijklmnopqrstuvwxyz");
+    EXPECT_NO_LEAKS({
+        Queue<std::string> scoped;
+        for(int i = 0; i < 100; ++i){
+            scoped.enqueue(std::string(40, 'x'));
+        }
+        Queue<std::string> copy(scoped);
+    });
+}
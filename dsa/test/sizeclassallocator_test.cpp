@@ -0,0 +1,133 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/include/SizeClassAllocator.h"
+#include "../src/include/Deque.h"
+#include "../src/include/List.h"
+#include "../src/include/Queue.h"
+#include "../src/include/Stack.h"
+
+
+TEST(SizeClassAllocatorTest, size_classes_cover_every_size){
+    for(std::size_t size = 1; size <= SizeClassPool::MAX_SIZE; ++size){
+        std::size_t size_class = SizeClassPool::class_of(size);
+        ASSERT_LT(size_class, SizeClassPool::NUM_CLASSES);
+        EXPECT_GE(SizeClassPool::class_size(size_class), size);
+        EXPECT_EQ(SizeClassPool::class_size(size_class) % SizeClassPool::ALIGNMENT, 0u);
+        if(size_class > 0){
+            EXPECT_LT(SizeClassPool::class_size(size_class - 1), size);
+        }
+        if(size > 256){
+            EXPECT_LT((SizeClassPool::class_size(size_class) - size) * 8, size) << size;
+        }
+    }
+    EXPECT_EQ(SizeClassPool::class_size(SizeClassPool::NUM_CLASSES - 1), SizeClassPool::MAX_SIZE);
+    ASSERT_DEATH({SizeClassPool::class_of(SizeClassPool::MAX_SIZE + 1);}, "SizeClassPool request is larger than MAX_SIZE");
+}
+TEST(SizeClassAllocatorTest, freed_objects_are_reused){
+    SizeClassPool& pool = SizeClassPool::instance();
+    void* first = pool.allocate(40);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % SizeClassPool::ALIGNMENT, 0u);
+    pool.deallocate(first, 40);
+    // 40 and 48 bytes share a class, and the thread's list is LIFO.
+    void* second = pool.allocate(48);
+    EXPECT_EQ(first, second);
+    pool.deallocate(second, 48);
+}
+TEST(SizeClassAllocatorTest, live_objects_are_distinct){
+    SizeClassPool& pool = SizeClassPool::instance();
+    std::vector<void*> objects;
+    std::set<void*> seen;
+    for(std::size_t i = 0; i < 10000; ++i){
+        std::size_t size = 1 + i % 700;
+        unsigned char* object = static_cast<unsigned char*>(pool.allocate(size));
+        object[0] = object[size - 1] = static_cast<unsigned char>(i);
+        EXPECT_TRUE(seen.insert(object).second);
+        objects.push_back(object);
+    }
+    for(std::size_t i = 0; i < objects.size(); ++i){
+        pool.deallocate(objects[i], 1 + i % 700);
+    }
+}
+TEST(SizeClassAllocatorTest, objects_freed_on_another_thread){
+    // A producer allocates and a consumer frees, so the memory has to travel back through the central lists. Run a few
+    // rounds so the producer's cache is refilled from batches the consumer handed back.
+    SizeClassAllocator<std::uint64_t> allocator;
+    for(int round = 0; round < 4; ++round){
+        std::vector<std::uint64_t*> objects;
+        std::thread producer([&]{
+            for(std::uint64_t i = 0; i < 20000; ++i){
+                std::uint64_t* object = allocator.allocate(1);
+                *object = i;
+                objects.push_back(object);
+            }
+        });
+        producer.join();
+        std::thread consumer([&]{
+            for(std::uint64_t i = 0; i < objects.size(); ++i){
+                EXPECT_EQ(*objects[i], i);
+                allocator.deallocate(objects[i], 1);
+            }
+        });
+        consumer.join();
+    }
+}
+TEST(SizeClassAllocatorTest, large_and_overaligned_requests_fall_back){
+    struct alignas(64) Overaligned{
+        char m_bytes[64];
+    };
+    SizeClassAllocator<Overaligned> overaligned;
+    Overaligned* object = overaligned.allocate(3);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(object) % 64, 0u);
+    overaligned.deallocate(object, 3);
+
+    SizeClassAllocator<char> bytes;
+    char* large = bytes.allocate(SizeClassPool::MAX_SIZE + 1);
+    large[SizeClassPool::MAX_SIZE] = 'x';
+    bytes.deallocate(large, SizeClassPool::MAX_SIZE + 1);
+
+    EXPECT_TRUE(overaligned == bytes);
+}
+TEST(SizeClassAllocatorTest, dsa_containers){
+    Queue<std::string, SizeClassAllocator<std::string>> queue;
+    Stack<int, 0, SizeClassAllocator<int>> stack;
+    Deque<int, 64, SizeClassAllocator<int>> deque;
+    List<int, SizeClassAllocator<int>> list;
+    for(int i = 0; i < 1000; ++i){
+        queue.enqueue(std::to_string(i));
+        stack.push(i);
+        deque.push_front(i);
+    }
+    for(int i = 0; i < 10; ++i){
+        list.push_back(i);
+    }
+    EXPECT_FALSE(stack.is_inline());
+    for(int i = 0; i < 1000; ++i){
+        EXPECT_EQ(queue.dequeue(), std::to_string(i));
+        EXPECT_EQ(stack.pop(), 999 - i);
+        EXPECT_EQ(deque.pop_back(), i);
+    }
+    list.pop_front();
+    EXPECT_EQ(list.size(), 9);
+    for(int i = 0; i < 9; ++i){
+        EXPECT_EQ(list.at(i), i + 1);
+    }
+
+    Queue<std::string, SizeClassAllocator<std::string>> copy;
+    copy.enqueue("a");
+    Queue<std::string, SizeClassAllocator<std::string>> moved(std::move(copy));
+    EXPECT_EQ(moved.dequeue(), "a");
+}
+TEST(SizeClassAllocatorTest, std_containers){
+    std::vector<int, SizeClassAllocator<int>> vector;
+    for(int i = 0; i < 5000; ++i){
+        vector.push_back(i);
+    }
+    for(int i = 0; i < 5000; ++i){
+        EXPECT_EQ(vector[i], i);
+    }
+}
@@ -0,0 +1,133 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/include/Sort.h"
+
+
+typedef std::pair<std::uint32_t, std::uint32_t> KeyValue;
+
+static std::vector<std::uint64_t> random_keys(std::size_t count, std::uint64_t range, unsigned seed){
+    std::mt19937_64 rng(seed);
+    std::vector<std::uint64_t> keys(count);
+    for(std::uint64_t& key : keys){
+        key = range == 0 ? rng() : rng() % range;
+    }
+    return keys;
+}
+
+// Pairs with few distinct keys, each value its original position, so a stable sort leaves values increasing within a
+// key.
+static std::vector<KeyValue> random_pairs(std::size_t count, std::uint32_t range, unsigned seed){
+    std::mt19937 rng(seed);
+    std::vector<KeyValue> pairs(count);
+    for(std::size_t i = 0; i < count; ++i){
+        pairs[i] = KeyValue(std::uint32_t(rng() % range), std::uint32_t(i));
+    }
+    return pairs;
+}
+
+static bool key_less(const KeyValue& a, const KeyValue& b) {return a.first < b.first;}
+
+
+TEST(SortTest, radix_sort_matches_std_sort){
+    for(std::size_t count : {0, 1, 2, 100, 255, 256, 1000, 100000}){
+        for(std::uint64_t range : {std::uint64_t(0), std::uint64_t(10), std::uint64_t(1) << 20}){
+            std::vector<std::uint64_t> keys = random_keys(count, range, unsigned(count));
+            std::vector<std::uint64_t> expected = keys, in_place = keys;
+            std::sort(expected.begin(), expected.end());
+            radix_sort(keys.begin(), keys.end());
+            radix_sort_in_place(in_place.begin(), in_place.end());
+            EXPECT_EQ(keys, expected) << count << " keys in range " << range;
+            EXPECT_EQ(in_place, expected) << count << " keys in range " << range;
+        }
+    }
+}
+TEST(SortTest, radix_sort_signed_and_narrow_keys){
+    std::mt19937 rng(1);
+    std::vector<std::int32_t> ints(50000);
+    for(std::int32_t& value : ints){
+        value = std::int32_t(rng());
+    }
+    ints.push_back(INT32_MIN);
+    ints.push_back(INT32_MAX);
+    std::vector<std::int32_t> expected = ints, in_place = ints;
+    std::sort(expected.begin(), expected.end());
+    radix_sort(ints.data(), ints.data() + ints.size());
+    radix_sort_in_place(in_place.data(), in_place.data() + in_place.size());
+    EXPECT_EQ(ints, expected);
+    EXPECT_EQ(in_place, expected);
+
+    std::vector<std::int8_t> bytes(1000);
+    for(std::size_t i = 0; i < bytes.size(); ++i){
+        bytes[i] = std::int8_t(rng());
+    }
+    std::vector<std::int8_t> sorted_bytes = bytes;
+    std::sort(sorted_bytes.begin(), sorted_bytes.end());
+    radix_sort_in_place(bytes.begin(), bytes.end());
+    EXPECT_EQ(bytes, sorted_bytes);
+}
+TEST(SortTest, radix_sort_is_stable){
+    for(std::size_t count : {100, 100000}){
+        std::vector<KeyValue> pairs = random_pairs(count, 50, 2);
+        std::vector<KeyValue> expected = pairs;
+        std::stable_sort(expected.begin(), expected.end(), key_less);
+        radix_sort(pairs.begin(), pairs.end(), [](const KeyValue& pair){return pair.first;});
+        EXPECT_EQ(pairs, expected);
+    }
+}
+TEST(SortTest, radix_sort_in_place_key_value){
+    std::vector<KeyValue> pairs = random_pairs(100000, 1000, 3);
+    radix_sort_in_place(pairs.begin(), pairs.end(), [](const KeyValue& pair){return pair.first;});
+    EXPECT_TRUE(std::is_sorted(pairs.begin(), pairs.end(), key_less));
+    // Every value is still there, with its own key.
+    std::vector<KeyValue> original = random_pairs(100000, 1000, 3);
+    std::sort(pairs.begin(), pairs.end(), [](const KeyValue& a, const KeyValue& b){return a.second < b.second;});
+    EXPECT_EQ(pairs, original);
+}
+TEST(SortTest, sample_sort_matches_std_sort){
+    for(std::size_t threads : {1, 2, 3, 4}){
+        for(std::uint64_t range : {std::uint64_t(0), std::uint64_t(3), std::uint64_t(1000)}){
+            std::vector<std::uint64_t> keys = random_keys(300000, range, unsigned(threads));
+            std::vector<std::uint64_t> expected = keys;
+            std::sort(expected.begin(), expected.end());
+            parallel_sample_sort(keys.data(), keys.data() + keys.size(), threads);
+            EXPECT_EQ(keys, expected) << threads << " threads, range " << range;
+        }
+    }
+    std::vector<std::uint64_t> descending(200000);
+    for(std::size_t i = 0; i < descending.size(); ++i){
+        descending[i] = descending.size() - i;
+    }
+    parallel_sample_sort(descending.data(), descending.data() + descending.size(), 4, std::greater<std::uint64_t>());
+    EXPECT_TRUE(std::is_sorted(descending.begin(), descending.end(), std::greater<std::uint64_t>()));
+}
+TEST(SortTest, stable_sample_sort_is_stable){
+    for(std::size_t threads : {1, 2, 4}){
+        // A skewed key distribution: half of the pairs have key 0, so it gets buckets of its own.
+        std::vector<KeyValue> pairs = random_pairs(200000, 100, unsigned(threads));
+        for(std::size_t i = 0; i < pairs.size(); i += 2){
+            pairs[i].first = 0;
+        }
+        std::vector<KeyValue> expected = pairs;
+        std::stable_sort(expected.begin(), expected.end(), key_less);
+        parallel_stable_sample_sort(pairs.data(), pairs.data() + pairs.size(), threads, key_less);
+        EXPECT_EQ(pairs, expected) << threads << " threads";
+    }
+}
+TEST(SortTest, sample_sort_strings){
+    std::mt19937 rng(4);
+    std::vector<std::string> strings(100000);
+    for(std::string& string : strings){
+        string = std::to_string(rng() % 5000) + "-" + std::to_string(rng());
+    }
+    std::vector<std::string> expected = strings;
+    std::sort(expected.begin(), expected.end());
+    parallel_sample_sort(strings.data(), strings.data() + strings.size(), 3);
+    EXPECT_EQ(strings, expected);
+}
@@ -0,0 +1,89 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "../src/include/SPSCQueue.h"
+#include "CountingResource.h"
+
+
+TEST(SPSCQueueTest, capacity_rounds_up){
+    SPSCQueue<int> queue(5);
+    EXPECT_EQ(queue.capacity(), 8u);
+    EXPECT_TRUE(queue.is_empty());
+}
+TEST(SPSCQueueTest, push_until_full){
+    SPSCQueue<int> queue(4);
+    for(int i = 0; i < 4; ++i){
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(4));
+    EXPECT_EQ(queue.size(), 4u);
+    int value;
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.try_push(4));
+    for(int i = 1; i <= 4; ++i){
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+}
+TEST(SPSCQueueTest, bulk_operations){
+    SPSCQueue<int> queue(8);
+    std::vector<int> in = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(queue.push_bulk(in.data(), in.size()), 8u);
+    std::vector<int> out(10);
+    EXPECT_EQ(queue.pop_bulk(out.data(), 5), 5u);
+    EXPECT_EQ(queue.push_bulk(in.data() + 8, 2), 2u);
+    EXPECT_EQ(queue.pop_bulk(out.data() + 5, 10), 5u);
+    EXPECT_EQ(out, in);
+}
+TEST(SPSCQueueTest, destroys_remaining_elements){
+    std::shared_ptr<int> counted = std::make_shared<int>(0);
+    {
+        SPSCQueue<std::shared_ptr<int>> queue(4);
+        queue.try_push(counted);
+        queue.try_push(counted);
+        EXPECT_EQ(counted.use_count(), 3);
+        EXPECT_EQ(queue.front()->get(), counted.get());
+    }
+    EXPECT_EQ(counted.use_count(), 1);
+}
+TEST(SPSCQueueTest, two_threads_preserve_order){
+    const std::uint64_t items = 200000;
+    SPSCQueue<std::uint64_t> queue(64);
+    std::thread producer([&]{
+        for(std::uint64_t i = 0; i < items;){
+            if(i % 3 == 0){
+                std::uint64_t batch[5] = {i, i + 1, i + 2, i + 3, i + 4};
+                i += queue.push_bulk(batch, std::min<std::uint64_t>(5, items - i));
+            }else if(queue.try_push(i)){
+                i++;
+            }
+        }
+    });
+    std::uint64_t expected = 0;
+    std::uint64_t out[7];
+    while(expected < items){
+        std::size_t count = queue.pop_bulk(out, 7);
+        for(std::size_t i = 0; i < count; ++i){
+            ASSERT_EQ(out[i], expected++);
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(queue.is_empty());
+}
+TEST(SPSCQueueTest, allocates_through_allocator){
+    CountingResource resource;
+    {
+        SPSCQueue<std::shared_ptr<int>, std::pmr::polymorphic_allocator<std::shared_ptr<int>>> queue(64, &resource);
+        EXPECT_EQ(queue.get_allocator().resource(), &resource);
+        EXPECT_EQ(resource.allocations(), 1u);
+        EXPECT_TRUE(queue.try_push(std::make_shared<int>(3)));
+        EXPECT_EQ(**queue.front(), 3);
+    }
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
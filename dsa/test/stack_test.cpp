@@ -0,0 +1,186 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../src/include/Stack.h"
+#include "AllocationCounting.h"
+
+
+TEST(StackTest, create_empty_stack){
+    Stack<int> stack;
+    EXPECT_TRUE(stack.is_empty());
+    EXPECT_EQ(stack.size(), 0u);
+    EXPECT_TRUE(stack.is_inline());
+    ASSERT_DEATH({stack.pop();}, "Stack underflow would occur with pop");
+    ASSERT_DEATH({stack.peek();}, "Can't peek at an empty Stack");
+}
+TEST(StackTest, push_pop_in_reverse_order){
+    Stack<int> stack;
+    for(int i = 0; i < 5; ++i){
+        stack.push(i);
+    }
+    EXPECT_FALSE(stack.is_empty());
+    EXPECT_EQ(stack.size(), 5u);
+    EXPECT_EQ(stack.peek(), 4);
+    for(int i = 4; i >= 0; --i){
+        EXPECT_EQ(stack.pop(), i);
+    }
+    EXPECT_TRUE(stack.is_empty());
+}
+TEST(StackTest, stays_inline_until_full){
+    Stack<int, 8> stack;
+    for(int i = 0; i < 8; ++i){
+        stack.push(i);
+    }
+    EXPECT_TRUE(stack.is_inline());
+    EXPECT_EQ(stack.capacity(), 8u);
+    stack.push(8);
+    EXPECT_FALSE(stack.is_inline());
+    EXPECT_EQ(stack.capacity(), 16u);
+    for(int i = 9; i < 1000; ++i){
+        stack.push(i);
+    }
+    EXPECT_EQ(stack.capacity(), 1024u);
+    for(int i = 999; i >= 0; --i){
+        ASSERT_EQ(stack.pop(), i);
+    }
+}
+TEST(StackTest, without_inline_storage){
+    Stack<std::string, 0> stack;
+    EXPECT_EQ(stack.capacity(), 0u);
+    for(int i = 0; i < 100; ++i){
+        stack.push(std::to_string(i));
+    }
+    EXPECT_FALSE(stack.is_inline());
+    for(int i = 99; i >= 0; --i){
+        EXPECT_EQ(stack.pop(), std::to_string(i));
+    }
+}
+TEST(StackTest, push_own_element_while_full){
+    // The argument refers into the array that growing frees, both when moving from heap to heap and from inline to heap.
+    Stack<long, 0> heap;
+    for(long i = 0; i < 16; ++i){
+        heap.push(i + 100);
+    }
+    ASSERT_EQ(heap.size(), heap.capacity());
+    heap.push(heap.peek());
+    EXPECT_EQ(heap.pop(), 115);
+    EXPECT_EQ(heap.pop(), 115);
+
+    Stack<std::string, 4> strings;
+    for(int i = 0; i < 4; ++i){
+        strings.push(std::string(30, char('a' + i)));
+    }
+    ASSERT_TRUE(strings.is_inline());
+    strings.push(strings.peek());
+    EXPECT_FALSE(strings.is_inline());
+    EXPECT_EQ(strings.pop(), std::string(30, 'd'));
+    EXPECT_EQ(strings.pop(), std::string(30, 'd'));
+    EXPECT_EQ(strings.size(), 3u);
+}
+TEST(StackTest, emplace_and_move_only_types){
+    Stack<std::unique_ptr<int>, 2> stack;
+    stack.emplace(new int(1));
+    stack.push(std::make_unique<int>(2));
+    stack.push(std::make_unique<int>(3));
+    EXPECT_EQ(*stack.peek(), 3);
+    EXPECT_EQ(*stack.pop(), 3);
+    EXPECT_EQ(*stack.pop(), 2);
+    EXPECT_EQ(*stack.pop(), 1);
+}
+TEST(StackTest, copy_and_move_inline_and_heap){
+    for(int count : {3, 50}){
+        Stack<std::string, 4> stack;
+        for(int i = 0; i < count; ++i){
+            stack.push(std::to_string(i));
+        }
+        Stack<std::string, 4> copy(stack);
+        EXPECT_EQ(copy.size(), std::size_t(count));
+        Stack<std::string, 4> moved(std::move(stack));
+        EXPECT_TRUE(stack.is_empty());
+        EXPECT_EQ(moved.is_inline(), count <= 4);
+        Stack<std::string, 4> assigned;
+        assigned.push("overwritten");
+        assigned = copy;
+        for(int i = count - 1; i >= 0; --i){
+            EXPECT_EQ(copy.pop(), std::to_string(i));
+            EXPECT_EQ(moved.pop(), std::to_string(i));
+            EXPECT_EQ(assigned.pop(), std::to_string(i));
+        }
+        // The moved from stack is still usable.
+        stack.push("again");
+        EXPECT_EQ(stack.pop(), "again");
+    }
+}
+TEST(StackTest, swap_inline_with_heap){
+    Stack<int, 4> small, large;
+    small.push(1);
+    for(int i = 0; i < 20; ++i){
+        large.push(i);
+    }
+    small.swap(large);
+    EXPECT_EQ(small.size(), 20u);
+    EXPECT_EQ(small.peek(), 19);
+    EXPECT_EQ(large.size(), 1u);
+    EXPECT_TRUE(large.is_inline());
+    EXPECT_EQ(large.pop(), 1);
+}
+TEST(StackTest, clear_and_reserve){
+    Stack<std::shared_ptr<int>, 4> stack;
+    std::shared_ptr<int> shared = std::make_shared<int>(7);
+    for(int i = 0; i < 10; ++i){
+        stack.push(shared);
+    }
+    EXPECT_EQ(shared.use_count(), 11);
+    stack.clear();
+    EXPECT_TRUE(stack.is_empty());
+    EXPECT_EQ(shared.use_count(), 1);
+    stack.reserve(100);
+    EXPECT_GE(stack.capacity(), 100u);
+}
+TEST(StackTest, inline_stack_does_not_allocate){
+    EXPECT_NO_ALLOCATIONS({
+        Stack<int, 32> stack;
+        for(int i = 0; i < 32; ++i){
+            stack.push(i);
+        }
+        Stack<int, 32> copy(stack);
+        Stack<int, 32> moved(std::move(copy));
+        while(!moved.is_empty()){
+            moved.pop();
+        }
+    });
+}
+TEST(StackTest, heap_stack_allocates_per_growth){
+    Stack<int, 0> stack;
+    // Growing to 1000 elements reallocates once per doubling from MIN_CAPACITY.
+    EXPECT_ALLOCATIONS_AT_MOST(7, {
+        for(int i = 0; i < 1000; ++i){
+            stack.push(i);
+        }
+    });
+    EXPECT_NO_ALLOCATIONS({
+        for(int i = 0; i < 1000; ++i){
+            stack.pop();
+        }
+        for(int i = 0; i < 1000; ++i){
+            stack.push(i);
+        }
+    });
+    std::unique_ptr<Stack<int, 0>> moved;
+    EXPECT_ALLOCATIONS_AT_MOST(1, moved.reset(new Stack<int, 0>(std::move(stack))));
+    Stack<int, 0> reserved;
+    EXPECT_ALLOCATIONS_AT_MOST(1, reserved.reserve(1000));
+    EXPECT_NO_ALLOCATIONS({
+        for(int i = 0; i < 1000; ++i){
+            reserved.push(i);
+        }
+    });
+    EXPECT_NO_LEAKS({
+        Stack<std::string, 2> scoped;
+        for(int i = 0; i < 100; ++i){
+            scoped.push(std::string(40, 'x'));
+        }
+    });
+}
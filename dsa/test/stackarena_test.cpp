@@ -0,0 +1,208 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "../src/include/Deque.h"
+#include "../src/include/List.h"
+#include "../src/include/Queue.h"
+#include "../src/include/Stack.h"
+#include "../src/include/StackArena.h"
+#include "AllocationCounting.h"
+
+
+TEST(StackArenaTest, allocations_are_aligned_and_disjoint){
+    StackArena arena;
+    std::vector<std::pair<unsigned char*, std::size_t>> allocations;
+    for(std::size_t i = 0; i < 1000; ++i){
+        std::size_t size = 1 + i % 200, alignment = std::size_t(1) << (i % 7);
+        unsigned char* ptr = static_cast<unsigned char*>(arena.allocate(size, alignment));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % alignment, 0u);
+        std::memset(ptr, int(i), size);
+        allocations.emplace_back(ptr, size);
+    }
+    for(std::size_t i = 0; i < allocations.size(); ++i){
+        for(std::size_t j = 0; j < allocations[i].second; ++j){
+            ASSERT_EQ(allocations[i].first[j], (unsigned char)i);
+        }
+    }
+    EXPECT_GE(arena.used(), 1000u);
+    EXPECT_GE(arena.reserved(), arena.used());
+}
+TEST(StackArenaTest, release_to_mark_reuses_memory){
+    StackArena arena;
+    arena.allocate(100);
+    StackArena::Mark mark = arena.mark();
+    std::size_t used = arena.used();
+    void* first = arena.allocate(64);
+    for(int i = 0; i < 1000; ++i){
+        arena.allocate(1000);
+    }
+    std::size_t reserved = arena.reserved();
+    arena.release_to(mark);
+    EXPECT_EQ(arena.used(), used);
+    EXPECT_EQ(arena.allocate(64), first);
+    // The blocks past the mark were kept, so doing the same again doesn't grow the arena.
+    for(int i = 0; i < 1000; ++i){
+        arena.allocate(1000);
+    }
+    EXPECT_EQ(arena.reserved(), reserved);
+    arena.release_to(mark);
+    arena.shrink();
+    EXPECT_LT(arena.reserved(), reserved);
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+}
+TEST(StackArenaTest, nested_scopes){
+    StackArena arena;
+    StackArena::Mark outer = arena.mark();
+    {
+        ArenaScope scope(arena);
+        arena.allocate(10);
+        std::size_t used = arena.used();
+        {
+            ArenaScope inner(arena);
+            arena.allocate(100000);
+        }
+        EXPECT_EQ(arena.used(), used);
+    }
+    EXPECT_EQ(arena.used(), 0u);
+    arena.release_to(outer);
+    EXPECT_EQ(arena.used(), 0u);
+}
+TEST(StackArenaTest, oversized_and_overaligned){
+    StackArena arena(64);
+    void* large = arena.allocate(1 << 22);
+    std::memset(large, 1, 1 << 22);
+    void* aligned = arena.allocate(10, 4096);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 4096, 0u);
+}
+TEST(StackArenaTest, deallocate_rolls_back_only_the_last_allocation){
+    StackArena arena;
+    void* a = arena.allocate(32);
+    void* b = arena.allocate(32);
+    arena.deallocate(a, 32);
+    EXPECT_NE(arena.allocate(32), a);
+    std::size_t used = arena.used();
+    void* c = arena.allocate(32);
+    arena.deallocate(c, 32);
+    EXPECT_EQ(arena.used(), used);
+    (void)b;
+}
+TEST(StackArenaTest, pmr_containers){
+    StackArena arena;
+    ArenaResource resource(arena);
+    {
+        std::pmr::vector<std::pmr::string> strings(&resource);
+        for(int i = 0; i < 1000; ++i){
+            strings.emplace_back("a string long enough to need its own allocation " + std::to_string(i));
+        }
+        EXPECT_EQ(strings[999], "a string long enough to need its own allocation 999");
+        EXPECT_EQ(strings.get_allocator().resource(), &resource);
+        EXPECT_EQ(strings[0].get_allocator().resource(), &resource);
+    }
+    EXPECT_GT(arena.used(), 1000u * 50);
+    arena.reset();
+}
+TEST(StackArenaTest, dsa_containers_on_polymorphic_allocator){
+    StackArena arena;
+    ArenaResource resource(arena);
+    Stack<long, 0, std::pmr::polymorphic_allocator<long>> stack(&resource);
+    Queue<long, std::pmr::polymorphic_allocator<long>> queue(&resource);
+    Deque<long, 16, std::pmr::polymorphic_allocator<long>> deque(&resource);
+    List<long, std::pmr::polymorphic_allocator<long>> list(&resource);
+    // Every allocation goes to the arena, which gets its blocks from malloc rather than operator new.
+    EXPECT_NO_ALLOCATIONS({
+        for(long i = 0; i < 1000; ++i){
+            stack.push(i);
+            queue.enqueue(i);
+            deque.push_front(i);
+        }
+        for(long i = 0; i < 100; ++i){
+            list.push_back(i);
+        }
+    });
+    EXPECT_EQ(stack.get_allocator().resource(), &resource);
+    EXPECT_EQ(queue.get_allocator().resource(), &resource);
+    EXPECT_EQ(deque.get_allocator().resource(), &resource);
+    EXPECT_EQ(list.get_allocator().resource(), &resource);
+    EXPECT_GT(arena.used(), 3 * 1000 * sizeof(long));
+    EXPECT_EQ(stack.peek(), 999);
+    EXPECT_EQ(queue.peek(), 0);
+    EXPECT_EQ(deque.front(), 999);
+    EXPECT_EQ(list.at(99), 99);
+
+    // A copy gets select_on_container_copy_construction's allocator, which for polymorphic_allocator is the default
+    // resource, while a move keeps the arena.
+    Queue<long, std::pmr::polymorphic_allocator<long>> copy(queue);
+    EXPECT_EQ(copy.get_allocator().resource(), std::pmr::get_default_resource());
+    EXPECT_EQ(copy.size(), 1000u);
+    List<long, std::pmr::polymorphic_allocator<long>> moved(std::move(list));
+    EXPECT_EQ(moved.get_allocator().resource(), &resource);
+    EXPECT_EQ(moved.at(99), 99);
+
+    // polymorphic_allocator doesn't propagate on assignment, so assigning between resources moves or copies the
+    // elements into memory from the target's own resource.
+    StackArena other_arena;
+    ArenaResource other_resource(other_arena);
+    Stack<long, 0, std::pmr::polymorphic_allocator<long>> other_stack(&other_resource);
+    other_stack = std::move(stack);
+    EXPECT_EQ(other_stack.get_allocator().resource(), &other_resource);
+    EXPECT_EQ(other_stack.size(), 1000u);
+    EXPECT_EQ(other_stack.peek(), 999);
+    EXPECT_TRUE(stack.is_empty());
+    Deque<long, 16, std::pmr::polymorphic_allocator<long>> other_deque(&other_resource);
+    other_deque = deque;
+    EXPECT_EQ(other_deque.get_allocator().resource(), &other_resource);
+    EXPECT_EQ(other_deque.size(), 1000u);
+    EXPECT_EQ(other_deque.back(), 0);
+    EXPECT_GT(other_arena.used(), 2 * 1000 * sizeof(long));
+    queue = std::move(copy);
+    EXPECT_EQ(queue.get_allocator().resource(), &resource);
+    EXPECT_EQ(queue.dequeue(), 0);
+}
+TEST(StackArenaTest, dsa_containers_in_arena_scopes){
+    // One block holds everything, so used() doesn't count the unused tail of a block the arena has moved past.
+    StackArena arena(1 << 16);
+    ArenaResource resource(arena);
+    std::size_t reserved = 0;
+    for(int round = 0; round < 10; ++round){
+        {
+            ArenaScope scope(arena);
+            Stack<int, 0, std::pmr::polymorphic_allocator<int>> stack(&resource);
+            Queue<int, std::pmr::polymorphic_allocator<int>> queue(&resource);
+            Deque<int, 64, std::pmr::polymorphic_allocator<int>> deque(&resource);
+            for(int i = 0; i < 1000; ++i){
+                stack.push(i);
+                queue.enqueue(i);
+                deque.push_back(i);
+            }
+            for(int i = 0; i < 1000; ++i){
+                ASSERT_EQ(stack.pop(), 999 - i);
+                ASSERT_EQ(queue.dequeue(), i);
+                ASSERT_EQ(deque.pop_front(), i);
+            }
+        }
+        // Leaving the scope gives everything back, so every round after the first reuses the same blocks.
+        EXPECT_EQ(arena.used(), 0u);
+        if(round == 0){
+            reserved = arena.reserved();
+        }
+        EXPECT_EQ(arena.reserved(), reserved);
+    }
+
+    // A reserved container allocates its buffer once, where growing would have left each outgrown buffer behind.
+    std::size_t used = arena.used();
+    {
+        Queue<int, std::pmr::polymorphic_allocator<int>> queue(&resource);
+        queue.reserve(1024);
+        for(int i = 0; i < 1024; ++i){
+            queue.enqueue(i);
+        }
+        EXPECT_LE(arena.used() - used, 1024 * sizeof(int) + alignof(std::max_align_t));
+    }
+    // It was the most recent allocation, so destroying the queue rolls it back too.
+    EXPECT_EQ(arena.used(), used);
+}
@@ -0,0 +1,104 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <string>
+#include <string_view>
+
+#include "../src/include/StringHashMap.h"
+
+
+TEST(StringHashMapTest, create_empty_map){
+    StringHashMap<int> map;
+    EXPECT_EQ(map.size(), 0u);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find("missing"), nullptr);
+}
+TEST(StringHashMapTest, insert_and_find){
+    StringHashMap<int> map;
+    EXPECT_TRUE(map.insert("one", 1).second);
+    EXPECT_TRUE(map.insert("two", 2).second);
+    EXPECT_FALSE(map.insert("one", 3).second);
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(*map.find("one"), 1);
+    EXPECT_EQ(*map.find(std::string("two")), 2);
+}
+TEST(StringHashMapTest, keys_are_copied){
+    StringHashMap<int> map;
+    std::string key = "temporary";
+    map.insert(key, 1);
+    key[0] = 'X';
+    EXPECT_NE(map.find("temporary"), nullptr);
+    EXPECT_EQ(map.find(key), nullptr);
+}
+TEST(StringHashMapTest, empty_and_long_keys){
+    StringHashMap<int> map;
+    std::string long_key(100000, 'k');
+    map[""] = 1;
+    map[long_key] = 2;
+    EXPECT_EQ(*map.find(""), 1);
+    EXPECT_EQ(*map.find(long_key), 2);
+}
+TEST(StringHashMapTest, grows_past_initial_capacity){
+    StringHashMap<int> map;
+    for(int i = 0; i < 10000; ++i){
+        map[std::to_string(i)] = i;
+    }
+    EXPECT_EQ(map.size(), 10000u);
+    EXPECT_LE(map.size() * 4, map.capacity() * 3);
+    for(int i = 0; i < 10000; ++i){
+        ASSERT_NE(map.find(std::to_string(i)), nullptr);
+        EXPECT_EQ(*map.find(std::to_string(i)), i);
+    }
+}
+TEST(StringHashMapTest, present_keys_never_grow_the_table){
+    StringHashMap<int> map;
+    // 12 keys fill 16 slots to exactly 3/4, so the next new key has to grow the table but existing ones must not.
+    for(int i = 0; i < 12; ++i){
+        map[std::to_string(i)] = i;
+    }
+    ASSERT_EQ(map.capacity(), 16u);
+    for(int i = 0; i < 12; ++i){
+        map[std::to_string(i)]++;
+        EXPECT_FALSE(map.insert(std::to_string(i), -1).second);
+        EXPECT_FALSE(map.try_emplace(std::to_string(i), -1).second);
+    }
+    EXPECT_EQ(map.capacity(), 16u);
+    // The new key is placed after the rehash, where it can be found.
+    EXPECT_TRUE(map.insert("new", 100).second);
+    EXPECT_EQ(map.capacity(), 32u);
+    EXPECT_EQ(*map.find("new"), 100);
+    for(int i = 0; i < 12; ++i){
+        EXPECT_EQ(*map.find(std::to_string(i)), i + 1);
+    }
+}
+TEST(StringHashMapTest, erase){
+    StringHashMap<int> map;
+    for(int i = 0; i < 1000; ++i){
+        map[std::to_string(i)] = i;
+    }
+    for(int i = 0; i < 1000; i += 2){
+        EXPECT_TRUE(map.erase(std::to_string(i)));
+    }
+    EXPECT_FALSE(map.erase("0"));
+    EXPECT_EQ(map.size(), 500u);
+    for(int i = 0; i < 1000; ++i){
+        if(i % 2){
+            ASSERT_NE(map.find(std::to_string(i)), nullptr);
+            EXPECT_EQ(*map.find(std::to_string(i)), i);
+        }else{
+            EXPECT_EQ(map.find(std::to_string(i)), nullptr);
+        }
+    }
+}
+TEST(StringHashMapTest, for_each_visits_every_entry){
+    StringHashMap<int> map;
+    map["a"] = 1;
+    map["b"] = 2;
+    map["c"] = 3;
+    int sum = 0;
+    std::string keys;
+    map.for_each([&](std::string_view key, int& value){
+        keys += key;
+        sum += value;
+    });
+    EXPECT_EQ(keys, "abc");
+    EXPECT_EQ(sum, 6);
+}
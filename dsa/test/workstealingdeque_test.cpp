@@ -0,0 +1,168 @@
+#include "googletest/googletest/include/gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "../src/include/WorkStealingDeque.h"
+#include "CountingResource.h"
+
+
+TEST(WorkStealingDequeTest, empty_deque){
+    WorkStealingDeque<int> deque;
+    int value;
+    EXPECT_TRUE(deque.is_empty());
+    EXPECT_FALSE(deque.pop(value));
+    EXPECT_FALSE(deque.steal(value));
+    EXPECT_TRUE(deque.is_empty());
+}
+TEST(WorkStealingDequeTest, owner_is_lifo_thieves_are_fifo){
+    WorkStealingDeque<int> deque;
+    int value;
+    for(int i = 0; i < 5; ++i){
+        deque.push(i);
+    }
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 4);
+    EXPECT_TRUE(deque.steal(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(deque.steal(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 3);
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(deque.pop(value));
+    EXPECT_EQ(deque.size(), 0u);
+}
+TEST(WorkStealingDequeTest, grows_and_keeps_order){
+    WorkStealingDeque<int> deque(4);
+    EXPECT_EQ(deque.capacity(), WorkStealingDeque<int>::MIN_CAPACITY);
+    int value;
+    // Move the indices off zero first so that the copy into the bigger buffer has to handle wrapping.
+    for(int i = 0; i < 10; ++i){
+        deque.push(i);
+        deque.steal(value);
+    }
+    for(int i = 0; i < 1000; ++i){
+        deque.push(i);
+    }
+    EXPECT_EQ(deque.size(), 1000u);
+    EXPECT_GE(deque.capacity(), 1000u);
+    for(int i = 0; i < 500; ++i){
+        EXPECT_TRUE(deque.steal(value));
+        EXPECT_EQ(value, i);
+    }
+    for(int i = 999; i >= 500; --i){
+        EXPECT_TRUE(deque.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_TRUE(deque.is_empty());
+}
+TEST(WorkStealingDequeTest, stress_every_item_taken_once){
+    // The owner pushes items in bursts and pops some of them back while thieves steal continuously, so the deque keeps
+    // growing, draining to empty and racing over its last element. Every item must be taken exactly once.
+    const int thieves = 3;
+    const std::uint32_t items = 200000;
+    WorkStealingDeque<std::uint32_t> deque;
+    std::unique_ptr<std::atomic<int>[]> taken(new std::atomic<int>[items]);
+    for(std::uint32_t i = 0; i < items; ++i){
+        taken[i].store(0);
+    }
+    std::atomic<std::uint32_t> remaining(items);
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < thieves; ++t){
+        threads.emplace_back([&]{
+            std::uint32_t item;
+            while(!done.load()){
+                if(deque.steal(item)){
+                    taken[item]++;
+                    remaining--;
+                }else{
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::uint32_t item, next = 0;
+    while(next < items){
+        for(int i = 0; i < 64 && next < items; ++i){
+            deque.push(next++);
+        }
+        for(int i = 0; i < 40 && deque.pop(item); ++i){
+            taken[item]++;
+            remaining--;
+        }
+    }
+    while(deque.pop(item)){
+        taken[item]++;
+        remaining--;
+    }
+    while(remaining.load() > 0){
+        std::this_thread::yield();
+    }
+    done = true;
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+
+    std::uint32_t wrong = 0;
+    for(std::uint32_t i = 0; i < items; ++i){
+        wrong += taken[i].load() != 1;
+    }
+    EXPECT_EQ(wrong, 0u);
+    EXPECT_TRUE(deque.is_empty());
+}
+TEST(WorkStealingDequeTest, allocates_through_allocator){
+    CountingResource resource;
+    {
+        WorkStealingDeque<int, std::pmr::polymorphic_allocator<int>> deque(16, &resource);
+        EXPECT_EQ(deque.get_allocator().resource(), &resource);
+        std::uint64_t initial = resource.allocations();
+        for(int i = 0; i < 1000; ++i){
+            deque.push(i);
+        }
+        EXPECT_GT(resource.allocations(), initial);
+        int value;
+        EXPECT_TRUE(deque.steal(value));
+        EXPECT_EQ(value, 0);
+    }
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
+TEST(WorkStealingDequeTest, old_buffers_are_freed_before_destruction){
+    CountingResource resource;
+    WorkStealingDeque<int, std::pmr::polymorphic_allocator<int>> deque(16, &resource);
+    std::int64_t initial = resource.live_bytes();
+    for(int i = 0; i < 1000; ++i){
+        deque.push(i);
+    }
+    ASSERT_EQ(deque.capacity(), 1024u);
+    int value;
+    while(deque.pop(value)){
+    }
+    // With no thief in a critical section nothing holds the smaller buffers back, so once the owner finds its deque
+    // empty only the current buffer is left: its cells plus the same header as the initial buffer.
+    std::int64_t cells = std::int64_t(sizeof(std::atomic<int>));
+    EXPECT_EQ(resource.live_bytes(), initial + (1024 - 16) * cells);
+
+    // Buffers retired while a thief is stealing may have to wait for it, but they are freed once it has stopped.
+    std::atomic<bool> stealing(true);
+    std::thread thief([&]{
+        while(stealing.load()){
+            int stolen;
+            deque.steal(stolen);
+        }
+    });
+    for(int i = 0; i < 5000; ++i){
+        deque.push(i);
+    }
+    stealing = false;
+    thief.join();
+    while(deque.pop(value)){
+    }
+    EXPECT_EQ(resource.live_bytes(), initial + std::int64_t(deque.capacity() - 16) * cells);
+}